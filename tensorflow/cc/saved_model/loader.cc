@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
@@ -33,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
@@ -46,6 +50,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 
 namespace tensorflow {
@@ -266,6 +271,81 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
                  nullptr /* outputs */, &run_metadata, session);
 }
 
+// Reads the variables data files of a SavedModel on background threads, so
+// that the restore op finds them in the page cache. This overlaps the
+// checkpoint I/O with parsing and importing the graph. Destruction stops the
+// reads and waits for the threads.
+class VariablesPrefetcher {
+ public:
+  VariablesPrefetcher(const string& export_dir, int num_threads) {
+    std::vector<string> data_files;
+    const string pattern =
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                     strings::StrCat(kSavedModelVariablesFilename, ".data-*"));
+    if (!Env::Default()->GetMatchingPaths(pattern, &data_files).ok() ||
+        data_files.empty()) {
+      return;
+    }
+    start_microseconds_ = Env::Default()->NowMicros();
+    pending_files_ = data_files.size();
+    pool_ = std::make_unique<thread::ThreadPool>(
+        Env::Default(), "saved_model_prefetch",
+        std::min<int>(num_threads, data_files.size()));
+    for (const string& data_file : data_files) {
+      pool_->Schedule([this, data_file]() { Prefetch(data_file); });
+    }
+  }
+
+  ~VariablesPrefetcher() {
+    cancelled_ = true;
+    pool_.reset();
+  }
+
+ private:
+  static constexpr size_t kChunkSize = 8 << 20;
+
+  void Prefetch(const string& filename) {
+    std::unique_ptr<RandomAccessFile> file;
+    if (Env::Default()->NewRandomAccessFile(filename, &file).ok()) {
+      std::unique_ptr<char[]> scratch(new char[kChunkSize]);
+      uint64 offset = 0;
+      while (!cancelled_) {
+        StringPiece result;
+        const Status s =
+            file->Read(offset, kChunkSize, &result, scratch.get());
+        offset += result.size();
+        if (!s.ok() || result.size() < kChunkSize) break;
+      }
+    }
+    // Also recorded when the load finished first, so that every prefetch
+    // shows up in the metrics.
+    if (--pending_files_ == 0) {
+      metrics::SavedModelLoadPhaseDuration("prefetch_variables")
+          .Add(GetLatencyMicroseconds(start_microseconds_));
+    }
+  }
+
+  uint64 start_microseconds_ = 0;
+  std::atomic<bool> cancelled_{false};
+  std::atomic<int> pending_files_{0};
+  std::unique_ptr<thread::ThreadPool> pool_;
+};
+
+// Starts prefetching the variables of "export_dir" if
+// TF_SAVED_MODEL_PREFETCH_THREADS is set to a positive number of threads.
+// Prefetching is off by default since on remote file systems it reads the
+// variables twice.
+std::unique_ptr<VariablesPrefetcher> MaybePrefetchVariables(
+    const string& export_dir) {
+  int64_t num_threads;
+  if (!ReadInt64FromEnvVar("TF_SAVED_MODEL_PREFETCH_THREADS", 0, &num_threads)
+           .ok() ||
+      num_threads <= 0) {
+    return nullptr;
+  }
+  return std::make_unique<VariablesPrefetcher>(export_dir, num_threads);
+}
+
 }  // namespace
 
 SavedModelBundleInterface::~SavedModelBundleInterface() = default;
@@ -285,12 +365,25 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
                               SavedModelBundle* const bundle) {
+  // The variables don't depend on the MetaGraphDef, so reading them can start
+  // right away.
+  const std::unique_ptr<VariablesPrefetcher> prefetcher =
+      MaybePrefetchVariables(export_dir);
+
+  const uint64 read_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  metrics::SavedModelLoadPhaseDuration("read_meta_graph")
+      .Add(GetLatencyMicroseconds(read_start_microseconds));
+
+  const uint64 session_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
       session_options, bundle->meta_graph_def, &bundle->session));
+  metrics::SavedModelLoadPhaseDuration("create_session")
+      .Add(GetLatencyMicroseconds(session_start_microseconds));
+
   TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
                                     export_dir, &bundle->session));
   return OkStatus();
@@ -464,11 +557,16 @@ Status RestoreSession(const RunOptions& run_options,
       internal::GetInitOp(export_dir, meta_graph, &init_op_name));
   TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, meta_graph,
                                asset_file_defs, session->get(), init_op_name));
+  const uint64 graph_init_walltime =
+      GetLatencyMicroseconds(graph_init_start_microseconds);
   load_latency_by_stage->GetCell(export_dir, "restore_graph")
       ->Add(restore_graph_walltime);
   // Record wall time spent in init op.
   load_latency_by_stage->GetCell(export_dir, "init_graph")
-      ->Add(GetLatencyMicroseconds(graph_init_start_microseconds));
+      ->Add(graph_init_walltime);
+  metrics::SavedModelLoadPhaseDuration("restore_variables")
+      .Add(restore_graph_walltime);
+  metrics::SavedModelLoadPhaseDuration("run_init_op").Add(graph_init_walltime);
   return OkStatus();
 }
 
@@ -105,6 +105,14 @@ ParseSavedModelPathAndSingleprint(std::string path_and_singleprint);
 // found when loading the SavedModel.
 monitoring::GaugeCell<std::string>& SavedModelFoundFingerprintOnLoad();
 
+// Returns "/tensorflow/core/saved_model/read/load_phase_durations" cell
+// belonging to field `phase`, e.g. "read_meta_graph", "create_session",
+// "restore_variables", "run_init_op" or "prefetch_variables". Phases may
+// overlap, so their durations need not add up to the total load time. The
+// prefetch ends when all variables were read or when the load finished,
+// whichever comes first.
+monitoring::SamplerCell& SavedModelLoadPhaseDuration(absl::string_view phase);
+
 // Returns "/tensorflow/core/checkpoint/read/read_durations" cell belonging to
 // field `api_label`.
 monitoring::SamplerCell& CheckpointReadDuration(absl::string_view api_label);
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 
@@ -384,6 +385,55 @@ TEST_F(LoaderTest, UpdateMetricsV1) {
   EXPECT_EQ(metrics::SavedModelReadApi(kCCLoadLabel).value(), api_count + 1);
 }
 
+TEST_F(LoaderTest, PrefetchVariablesAndPhaseMetrics) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const int create_session_count =
+      metrics::SavedModelLoadPhaseDuration("create_session").value().num();
+  const int restore_count =
+      metrics::SavedModelLoadPhaseDuration("restore_variables").value().num();
+  const int prefetch_count =
+      metrics::SavedModelLoadPhaseDuration("prefetch_variables").value().num();
+  tensorflow::setenv("TF_SAVED_MODEL_PREFETCH_THREADS", "2", /*overwrite=*/1);
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const Status status = LoadSavedModel(session_options, run_options,
+                                       export_dir, {kSavedModelTagServe},
+                                       &bundle);
+  tensorflow::unsetenv("TF_SAVED_MODEL_PREFETCH_THREADS");
+  TF_ASSERT_OK(status);
+  CheckSavedModelBundle(export_dir, bundle);
+
+  EXPECT_EQ(
+      metrics::SavedModelLoadPhaseDuration("create_session").value().num(),
+      create_session_count + 1);
+  EXPECT_EQ(
+      metrics::SavedModelLoadPhaseDuration("restore_variables").value().num(),
+      restore_count + 1);
+  // The load waits for the prefetch threads, so the prefetch has ended.
+  EXPECT_EQ(
+      metrics::SavedModelLoadPhaseDuration("prefetch_variables").value().num(),
+      prefetch_count + 1);
+}
+
+TEST_F(LoaderTest, NoPrefetchByDefault) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const int prefetch_count =
+      metrics::SavedModelLoadPhaseDuration("prefetch_variables").value().num();
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &bundle));
+  EXPECT_EQ(
+      metrics::SavedModelLoadPhaseDuration("prefetch_variables").value().num(),
+      prefetch_count);
+}
+
 TEST_F(LoaderTest, UpdateFingerprintMetrics) {
   SavedModelBundle bundle;
   SessionOptions session_options;
@@ -699,6 +699,25 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  // CPU all-reduces can opt into reducing within each task before running
+  // the ring across tasks.
+  if (cp->instance.type == REDUCTION_COLLECTIVE &&
+      cp->group.device_type == DEVICE_CPU &&
+      cp->instance.impl_details.communication_hint == "hierarchical_ring") {
+    cp->instance.impl_details.collective_name = "HierarchicalRingReduce";
+  }
+  // CPU float ring all-reduces can trade precision for bandwidth. The choice
+  // only depends on the instance, so every member makes the same one.
+  cp->instance.impl_details.wire_dtype = DT_INVALID;
+  if (cp->instance.impl_details.collective_name == "RingReduce" &&
+      cp->group.device_type == DEVICE_CPU &&
+      cp->instance.data_type == DT_FLOAT) {
+    if (cp->instance.impl_details.communication_hint == "ring_bf16") {
+      cp->instance.impl_details.wire_dtype = DT_BFLOAT16;
+    } else if (cp->instance.impl_details.communication_hint == "ring_fp16") {
+      cp->instance.impl_details.wire_dtype = DT_HALF;
+    }
+  }
   VLOG(1) << "AssignCollectiveType "
           << cp->instance.impl_details.collective_name;
 }
@@ -208,6 +208,65 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
   }
 }
 
+TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReductionWireDtype) {
+  struct TestCase {
+    string communication_hint;
+    DataType data_type;
+    DataType wire_dtype;
+  };
+  const std::vector<TestCase> test_cases = {
+      {"", DT_FLOAT, DT_INVALID},
+      {"ring_bf16", DT_FLOAT, DT_BFLOAT16},
+      {"ring_fp16", DT_FLOAT, DT_HALF},
+      // Only float reductions are sent in reduced precision.
+      {"ring_bf16", DT_DOUBLE, DT_INVALID},
+  };
+  int instance_key = 100;
+  for (const TestCase& test_case : test_cases) {
+    CollectiveParams* cps[NUM_DEVS];
+    Status statuses[NUM_DEVS];
+    Notification note[NUM_DEVS];
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      cps[i] = new CollectiveParams();
+      CollectiveParams* cp = cps[i];
+      cp->group.group_key = 1;
+      cp->group.group_size = 3;
+      cp->group.device_type = DeviceType("CPU");
+      cp->group.num_tasks = 1;
+      cp->instance.instance_key = instance_key;
+      cp->instance.type = REDUCTION_COLLECTIVE;
+      cp->instance.data_type = test_case.data_type;
+      cp->instance.shape = TensorShape({5});
+      cp->instance.impl_details.subdiv_offsets.push_back(0);
+      cp->instance.impl_details.communication_hint =
+          test_case.communication_hint;
+      cp->is_source = false;
+      Env::Default()->SchedClosure([this, i, cp, &note, &statuses]() {
+        string device =
+            strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", i);
+        prl_->CompleteParamsAsync(GetDeviceAttributes(device), cp,
+                                  nullptr /*CancellationManager*/,
+                                  [&statuses, &note, i](const Status& s) {
+                                    statuses[i] = s;
+                                    note[i].Notify();
+                                  });
+      });
+    }
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      note[i].WaitForNotification();
+    }
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      TF_ASSERT_OK(statuses[i]);
+      EXPECT_EQ(cps[i]->instance.impl_details.collective_name, "RingReduce");
+      EXPECT_EQ(cps[i]->instance.impl_details.wire_dtype, test_case.wire_dtype)
+          << "hint: " << test_case.communication_hint
+          << ", data type: " << DataTypeString(test_case.data_type);
+      cps[i]->Unref();
+    }
+    ++instance_key;
+  }
+}
+
 void InitializeCollectiveParamsForBroadcast(int instance_key, int device_idx,
                                             bool is_source,
                                             CollectiveParams* cp) {
@@ -0,0 +1,346 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// Every ring transfer should stay large enough to amortize its fixed cost,
+// and a few buckets in flight suffice to hide the reductions.
+constexpr int64_t kMinTransferBytes = 256 << 10;
+constexpr int kMaxBuckets = 4;
+
+// Counts outstanding transfers and waits for all of them to complete.
+class PendingTransfers {
+ public:
+  explicit PendingTransfers(std::function<void(const Status&)> on_error)
+      : on_error_(std::move(on_error)) {}
+
+  StatusCallback Add() {
+    mutex_lock l(mu_);
+    ++pending_;
+    return [this](const Status& s) {
+      if (!s.ok()) on_error_(s);
+      mutex_lock lock(mu_);
+      status_.Update(s);
+      if (--pending_ == 0) cv_.notify_all();
+    };
+  }
+
+  Status Wait() {
+    mutex_lock l(mu_);
+    while (pending_ > 0) cv_.wait(l);
+    return status_;
+  }
+
+ private:
+  const std::function<void(const Status&)> on_error_;
+  mutex mu_;
+  condition_variable cv_;
+  int pending_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+int HierarchicalRingReducer::NumBuckets(int64_t total_bytes, int num_leaders) {
+  const int64_t buckets =
+      total_bytes / std::max(num_leaders, 1) / kMinTransferBytes;
+  return static_cast<int>(std::clamp<int64_t>(buckets, 1, kMaxBuckets));
+}
+
+Status HierarchicalRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::InvalidArgument(
+        "HierarchicalRingReduce only implements all-reduce");
+  }
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::Unimplemented(
+        "HierarchicalRingReduce only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  return OkStatus();
+}
+
+Status HierarchicalRingReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params.get();
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalRingReducer::InitTopology() {
+  const std::vector<CollGroupMember>& members = col_params_->group.members;
+  const string& task = members[col_params_->default_rank].task;
+  std::unordered_set<string> seen_tasks;
+  local_members_.clear();
+  leaders_.clear();
+  leader_idx_ = -1;
+  for (int i = 0; i < members.size(); ++i) {
+    if (members[i].task == task) local_members_.push_back(i);
+    if (seen_tasks.insert(members[i].task).second) {
+      if (i == col_params_->default_rank) leader_idx_ = leaders_.size();
+      leaders_.push_back(i);
+    }
+  }
+}
+
+void HierarchicalRingReducer::StartAbort(const Status& s) {
+  {
+    mutex_lock l(status_mu_);
+    if (!status_.ok()) return;
+    LOG(ERROR) << "Aborting HierarchicalRingReduce with " << s;
+    status_ = s;
+  }
+  CancellationManager* cancel_mgr = col_ctx_->op_ctx->cancellation_manager();
+  if (cancel_mgr == nullptr ||
+      (!cancel_mgr->IsCancelled() && !cancel_mgr->IsCancelling())) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+Status HierarchicalRingReducer::status() {
+  mutex_lock l(status_mu_);
+  return status_;
+}
+
+string HierarchicalRingReducer::BufKey(const char* phase, int step, int bucket,
+                                       int rank) const {
+  return strings::StrCat("HierarchicalRingReduce(", col_ctx_->exec_key, "):",
+                         phase, ":", step, ":", bucket, ":", rank);
+}
+
+void HierarchicalRingReducer::Send(const string& key, int member,
+                                   const Tensor* tensor,
+                                   const StatusCallback& done) {
+  const CollGroupMember& peer = col_params_->group.members[member];
+  col_ctx_->col_exec->remote_access()->PostToPeer(
+      peer.device.name(), peer.task, key, col_ctx_->device,
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), tensor,
+      col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
+      done);
+}
+
+void HierarchicalRingReducer::Recv(const string& key, int member,
+                                   Tensor* tensor,
+                                   const StatusCallback& done) {
+  const CollGroupMember& peer = col_params_->group.members[member];
+  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+      peer.device.name(), peer.task, peer.is_local, key, col_ctx_->device,
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), tensor,
+      col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/,
+      col_ctx_->op_ctx->cancellation_manager(), done);
+}
+
+void HierarchicalRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like RingReduce, this doesn't require non-overlapping collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+  InitTopology();
+
+  Status s;
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &s](const Status& copy_status) {
+          s.Update(copy_status);
+          note.Notify();
+        });
+    note.WaitForNotification();
+  }
+  if (s.ok() && col_ctx_->output->NumElements() > 0) {
+    profiler::TraceMe activity("HierarchicalRingReduce",
+                               profiler::TraceMeLevel::kInfo);
+    s = ReduceWithinTask();
+    if (s.ok() && leader_idx_ >= 0) s = RingAllReduce();
+    if (s.ok()) s = BroadcastWithinTask();
+  }
+  if (!s.ok()) StartAbort(s);
+  done(status());
+}
+
+Status HierarchicalRingReducer::ReduceWithinTask() {
+  const int leader = local_members_[0];
+  Tensor* output = col_ctx_->output;
+  PendingTransfers transfers([this](const Status& s) { StartAbort(s); });
+  if (leader_idx_ < 0) {
+    Send(BufKey("local", 0, 0, col_params_->default_rank), leader, output,
+         transfers.Add());
+    return transfers.Wait();
+  }
+
+  // Receive from all local members at once and reduce in rank order as the
+  // values arrive.
+  const int num_peers = local_members_.size() - 1;
+  Allocator* allocator =
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0));
+  std::vector<Tensor> values;
+  std::vector<std::unique_ptr<PendingTransfers>> recvs;
+  values.reserve(num_peers);
+  for (int i = 0; i < num_peers; ++i) {
+    const int member = local_members_[i + 1];
+    values.emplace_back(allocator, output->dtype(), output->shape());
+    recvs.push_back(std::make_unique<PendingTransfers>(
+        [this](const Status& s) { StartAbort(s); }));
+    Recv(BufKey("local", 0, 0, member), member, &values.back(),
+         recvs.back()->Add());
+  }
+  Status s;
+  for (int i = 0; i < num_peers; ++i) {
+    s.Update(recvs[i]->Wait());
+    if (s.ok()) {
+      s = collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                        col_ctx_->device, col_params_->merge_op,
+                                        output, &values[i]);
+      if (!s.ok()) StartAbort(s);
+    }
+  }
+  return s;
+}
+
+Status HierarchicalRingReducer::RunRingPhase(bool reduce_scatter,
+                                             int num_buckets,
+                                             CollectiveAdapter* ca) {
+  const int num_leaders = leaders_.size();
+  const int next = leaders_[(leader_idx_ + 1) % num_leaders];
+  const int prev_idx = (leader_idx_ + num_leaders - 1) % num_leaders;
+  const int prev = leaders_[prev_idx];
+  const char* phase = reduce_scatter ? "scatter" : "gather";
+  auto on_error = [this](const Status& s) { StartAbort(s); };
+
+  for (int step = 0; step < num_leaders - 1; ++step) {
+    // In step s of the reduce-scatter phase leader r sends chunk r - s and
+    // reduces chunk r - s - 1. It then holds the sum of chunk r + 1, which
+    // the all-gather phase passes on in the same way.
+    const int send_chunk =
+        (leader_idx_ + (reduce_scatter ? 0 : 1) - step + num_leaders) %
+        num_leaders;
+    const int recv_chunk = (send_chunk + num_leaders - 1) % num_leaders;
+
+    std::vector<Tensor> send_chunks(num_buckets);
+    std::vector<Tensor> recv_chunks(num_buckets);
+    std::vector<Tensor> received(num_buckets);
+    std::vector<std::unique_ptr<PendingTransfers>> recvs;
+    PendingTransfers sends(on_error);
+    for (int b = 0; b < num_buckets; ++b) {
+      send_chunks[b] = ca->ChunkAlias(b * num_leaders + send_chunk);
+      recv_chunks[b] = ca->ChunkAlias(b * num_leaders + recv_chunk);
+      Tensor* dst = &recv_chunks[b];
+      if (reduce_scatter) {
+        received[b] = ca->TempChunk(b * num_leaders + recv_chunk);
+        dst = &received[b];
+      }
+      recvs.push_back(std::make_unique<PendingTransfers>(on_error));
+      Recv(BufKey(phase, step, b, prev_idx), prev, dst, recvs.back()->Add());
+      Send(BufKey(phase, step, b, leader_idx_), next, &send_chunks[b],
+           sends.Add());
+    }
+    // Reduce bucket b while the transfers of the later buckets are still in
+    // flight.
+    Status s;
+    for (int b = 0; b < num_buckets; ++b) {
+      s.Update(recvs[b]->Wait());
+      if (s.ok() && reduce_scatter) {
+        s = collective_util::ComputeBinOp(
+            col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+            col_params_->merge_op, &recv_chunks[b], &received[b]);
+        if (!s.ok()) StartAbort(s);
+      }
+    }
+    s.Update(sends.Wait());
+    TF_RETURN_IF_ERROR(s);
+  }
+  return OkStatus();
+}
+
+Status HierarchicalRingReducer::RingAllReduce() {
+  Tensor* output = col_ctx_->output;
+  const int num_leaders = leaders_.size();
+  const int num_buckets =
+      num_leaders > 1 ? NumBuckets(output->TotalBytes(), num_leaders) : 1;
+  std::unique_ptr<CollectiveAdapter> ca(MakeCollectiveAdapter(
+      output, num_buckets * num_leaders,
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0))));
+  Status s;
+  if (num_leaders > 1) {
+    s = RunRingPhase(/*reduce_scatter=*/true, num_buckets, ca.get());
+    if (s.ok()) {
+      s = RunRingPhase(/*reduce_scatter=*/false, num_buckets, ca.get());
+    }
+  }
+  Tensor group_size = ca->Scalar(col_params_->group.group_size);
+  ca->ConsumeFinalValue(output);
+  if (s.ok() && col_params_->final_op) {
+    s = collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                      col_ctx_->device, col_params_->final_op,
+                                      output, &group_size);
+  }
+  return s;
+}
+
+Status HierarchicalRingReducer::BroadcastWithinTask() {
+  Tensor* output = col_ctx_->output;
+  PendingTransfers transfers([this](const Status& s) { StartAbort(s); });
+  if (leader_idx_ < 0) {
+    Recv(BufKey("result", 0, 0, col_params_->default_rank), local_members_[0],
+         output, transfers.Add());
+  } else {
+    for (int i = 1; i < local_members_.size(); ++i) {
+      Send(BufKey("result", 0, 0, local_members_[i]), local_members_[i],
+           output, transfers.Add());
+    }
+  }
+  return transfers.Wait();
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalRingReduce, HierarchicalRingReducer);
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+// Two-level implementation of collective all-reduce for CPU groups.
+//
+// The members of each task first reduce into the task's lowest ranked member
+// (its leader) through local memory. The leaders then run a ring all-reduce
+// among themselves and finally hand the result back to the other members of
+// their task. Unlike RingReduce, only one member per task sends data over the
+// network, and the ring has one position per task instead of one per device,
+// which matters most for the many small all-reduces of CPU data-parallel
+// training.
+//
+// The ring runs over several buckets of the tensor at once, so that reducing
+// the chunk just received for bucket k overlaps with the transfers of the
+// following buckets. The number of buckets is derived from the tensor size.
+//
+// Selected with communication_hint "hierarchical_ring".
+class HierarchicalRingReducer : public CollectiveImplementationInterface {
+ public:
+  ~HierarchicalRingReducer() override = default;
+
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+  // Returns the number of buckets the ring splits a tensor of `total_bytes`
+  // into when it has `num_leaders` positions.
+  static int NumBuckets(int64_t total_bytes, int num_leaders);
+
+ private:
+  // Computes local_members_, leaders_ and leader_idx_ from the group.
+  void InitTopology();
+
+  // Records the first error and aborts the outstanding transfers of this
+  // collective, so that every pending callback gets invoked.
+  void StartAbort(const Status& s);
+  Status status();
+
+  string BufKey(const char* phase, int step, int bucket, int rank) const;
+  void Send(const string& key, int member, const Tensor* tensor,
+            const StatusCallback& done);
+  void Recv(const string& key, int member, Tensor* tensor,
+            const StatusCallback& done);
+
+  // Runs one phase of the ring: in the reduce-scatter phase received chunks
+  // are reduced into the output, in the all-gather phase they overwrite it.
+  Status RunRingPhase(bool reduce_scatter, int num_buckets,
+                      CollectiveAdapter* ca);
+
+  Status ReduceWithinTask();
+  Status RingAllReduce();
+  Status BroadcastWithinTask();
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  // Members of this member's task in rank order. The first is the leader.
+  std::vector<int> local_members_;
+  // The leader of every task, in the order of the tasks' first members.
+  std::vector<int> leaders_;
+  // Position of this member in leaders_, or -1 if it is not a leader.
+  int leader_idx_ = -1;
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
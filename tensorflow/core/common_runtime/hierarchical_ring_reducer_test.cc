@@ -0,0 +1,144 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  TF_CHECK_OK(NodeDefBuilder(op + "_node", op)
+                  .Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+class HierarchicalRingReducerTest : public ::testing::Test {
+ protected:
+  struct Member {
+    Tensor tensor;
+    Device* device;
+    core::RefCountPtr<CollectiveParams> col_params;
+    std::unique_ptr<OpKernel> merge_op;
+    std::unique_ptr<OpKernel> final_op;
+    Status status;
+  };
+
+  // Reduces tensors of `num_elements` floats across `num_workers` tasks with
+  // `num_devices` devices each, and checks that every member ends up with
+  // the mean.
+  void RunTest(int num_workers, int num_devices, int num_elements) {
+    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, DEVICE_CPU);
+    const int group_size = num_workers * num_devices;
+    std::vector<float> expected(num_elements, 0);
+    std::vector<std::unique_ptr<Member>> members;
+    for (int rank = 0; rank < group_size; ++rank) {
+      auto member = std::make_unique<Member>();
+      member->col_params = CreateCollectiveParams(
+          *test_env_, rank, "HierarchicalRingReduce", REDUCTION_COLLECTIVE,
+          DT_FLOAT, TensorShape({num_elements}));
+      TF_CHECK_OK(test_env_->device_mgr->LookupDevice(
+          member->col_params->group.members[rank].device.name(),
+          &member->device));
+      member->merge_op = GetBinOp("Add", DT_FLOAT, member->device);
+      member->final_op = GetBinOp("Div", DT_FLOAT, member->device);
+      member->col_params->merge_op = member->merge_op.get();
+      member->col_params->final_op = member->final_op.get();
+      member->tensor = Tensor(DT_FLOAT, TensorShape({num_elements}));
+      for (int i = 0; i < num_elements; ++i) {
+        const float value = rank * 10 + i % 7;
+        member->tensor.flat<float>()(i) = value;
+        expected[i] += value;
+      }
+      members.push_back(std::move(member));
+    }
+    for (float& value : expected) value /= group_size;
+
+    std::atomic<int> done(0);
+    for (auto& member : members) {
+      SchedClosure([this, &member, &done] {
+        member->status =
+            RunCollective(test_env_.get(), member->col_params.get(),
+                          member->device, &member->tensor, &member->tensor);
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (auto& member : members) {
+      TF_EXPECT_OK(member->status);
+      test::ExpectTensorEqual<float>(test::AsTensor<float>(expected),
+                                     member->tensor);
+    }
+  }
+
+  std::unique_ptr<CollectiveTestEnv> test_env_;
+};
+
+TEST_F(HierarchicalRingReducerTest, SingleTask) { RunTest(1, 4, 1001); }
+
+TEST_F(HierarchicalRingReducerTest, SingleDevicePerTask) {
+  RunTest(3, 1, 1001);
+}
+
+TEST_F(HierarchicalRingReducerTest, MultipleTasks) { RunTest(2, 3, 1001); }
+
+TEST_F(HierarchicalRingReducerTest, SmallerThanRing) { RunTest(4, 2, 3); }
+
+TEST_F(HierarchicalRingReducerTest, MultipleBuckets) {
+  const int num_elements = 1 << 20;
+  ASSERT_GT(HierarchicalRingReducer::NumBuckets(num_elements * sizeof(float),
+                                                /*num_leaders=*/3),
+            1);
+  RunTest(3, 2, num_elements);
+}
+
+TEST(HierarchicalRingReducerNumBucketsTest, GrowsWithTensorSize) {
+  EXPECT_EQ(1, HierarchicalRingReducer::NumBuckets(4, 2));
+  EXPECT_EQ(1, HierarchicalRingReducer::NumBuckets(1 << 20, 4));
+  EXPECT_EQ(2, HierarchicalRingReducer::NumBuckets(2 << 20, 4));
+  EXPECT_EQ(4, HierarchicalRingReducer::NumBuckets(1 << 30, 4));
+}
+
+}  // namespace
+}  // namespace tensorflow
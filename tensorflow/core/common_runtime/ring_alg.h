@@ -75,14 +75,19 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    Tensor wire_chunk;  // chunk in the wire format, if it differs
     Status status;
     string DebugString() const;
   };
   virtual void InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
                              int field_idx);
   void AdvanceToSecondPass(RingField* rf);
-  void DispatchSend(RingField* rf, const StatusCallback& done);
-  void DispatchRecv(RingField* rf, const StatusCallback& done);
+  // Sends rf->chunk, or `tensor` if given.
+  void DispatchSend(RingField* rf, const StatusCallback& done,
+                    const Tensor* tensor = nullptr);
+  // Receives into rf->tmp_chunk or rf->chunk, or into `tensor` if given.
+  void DispatchRecv(RingField* rf, const StatusCallback& done,
+                    Tensor* tensor = nullptr);
 
   // For constructing log messages for debugging.
   string FieldState();
@@ -42,6 +42,23 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
+namespace {
+
+// Rounds the float `chunk` to T, storing the result in `wire` and the rounded
+// values back into `chunk`.
+template <typename T>
+void ToWireFormat(Tensor* chunk, Tensor* wire) {
+  auto wire_flat = wire->flat<T>();
+  wire_flat = chunk->flat<float>().cast<T>();
+  chunk->flat<float>() = wire_flat.template cast<float>();
+}
+
+template <typename T>
+void FromWireFormat(const Tensor& wire, Tensor* chunk) {
+  chunk->flat<float>() = wire.flat<T>().template cast<float>();
+}
+
+}  // namespace
 
 RingReducer::~RingReducer() { group_size_tensor_ready_.WaitForNotification(); }
 
@@ -64,6 +81,13 @@ void RingReducer::Run(StatusCallback done) {
   num_subdivs_ = static_cast<int>(
       col_params_->instance.impl_details.subdiv_permutations.size());
   CHECK_GT(num_subdivs_, 0);
+  const DataType wire_dtype = col_params_->instance.impl_details.wire_dtype;
+  wire_dtype_ = DT_INVALID;
+  if ((wire_dtype == DT_BFLOAT16 || wire_dtype == DT_HALF) &&
+      col_params_->group.device_type == DEVICE_CPU &&
+      col_ctx_->output->dtype() == DT_FLOAT) {
+    wire_dtype_ = wire_dtype;
+  }
 
   if (VLOG_IS_ON(1)) {
     string buf;
@@ -167,6 +191,47 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   if (rf->do_recv) {
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
   }
+  if (wire_dtype_ != DT_INVALID && (rf->do_send || rf->do_recv)) {
+    rf->wire_chunk = Tensor(col_ctx_->device->GetAllocator(
+                                col_ctx_->op_ctx->output_alloc_attr(0)),
+                            wire_dtype_, rf->chunk.shape());
+  }
+}
+
+void RingReducer::SendChunk(RingField* rf, const StatusCallback& done) {
+  if (wire_dtype_ == DT_INVALID) {
+    DispatchSend(rf, done);
+    return;
+  }
+  if (wire_dtype_ == DT_BFLOAT16) {
+    ToWireFormat<bfloat16>(&rf->chunk, &rf->wire_chunk);
+  } else {
+    ToWireFormat<Eigen::half>(&rf->chunk, &rf->wire_chunk);
+  }
+  DispatchSend(rf, done, &rf->wire_chunk);
+}
+
+void RingReducer::RecvChunk(RingField* rf, const StatusCallback& done) {
+  if (wire_dtype_ == DT_INVALID) {
+    DispatchRecv(rf, done);
+    return;
+  }
+  Tensor* dst = (!rf->second_pass && (col_params_->merge_op != nullptr))
+                    ? &rf->tmp_chunk
+                    : &rf->chunk;
+  DispatchRecv(
+      rf,
+      [this, rf, dst, done](const Status& s) {
+        if (s.ok()) {
+          if (wire_dtype_ == DT_BFLOAT16) {
+            FromWireFormat<bfloat16>(rf->wire_chunk, dst);
+          } else {
+            FromWireFormat<Eigen::half>(rf->wire_chunk, dst);
+          }
+        }
+        done(s);
+      },
+      &rf->wire_chunk);
 }
 
 // At the beginning of the algorithm initialize a RingField struct for
@@ -242,7 +307,7 @@ bool RingReducer::RunAsyncParts() {
                 }
                 ready_queue.Enqueue(rf);
               };
-              DispatchRecv(rf, requeue);
+              RecvChunk(rf, requeue);
               dispatched = true;
               ++recv_pending_count;
             } else {
@@ -294,7 +359,7 @@ bool RingReducer::RunAsyncParts() {
                 }
                 ready_queue.Enqueue(rf);
               };
-              DispatchSend(rf, send_complete);
+              SendChunk(rf, send_complete);
               dispatched = true;
               ++send_pending_count;
             } else {
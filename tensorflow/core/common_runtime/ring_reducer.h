@@ -28,6 +28,11 @@ namespace tensorflow {
 class Device;
 
 // Ring-algorithm implementation of collective all-reduce.
+//
+// For float reductions on CPU, CollImplDetails::wire_dtype may ask for the
+// chunks to travel as bfloat16 or half, which halves the bytes sent per step.
+// A chunk is rounded to the wire type before it is sent so that every member
+// ends up with the same result.
 class RingReducer : public RingAlg {
  public:
   RingReducer() : RingAlg(REDUCTION_COLLECTIVE, "Reduce") {}
@@ -49,6 +54,15 @@ class RingReducer : public RingAlg {
   void ContinueAfterInputCopy();
   bool RunAsyncParts();
 
+  // Like DispatchSend/DispatchRecv, but go through rf->wire_chunk if
+  // wire_dtype_ is set.
+  void SendChunk(RingField* rf, const StatusCallback& done);
+  void RecvChunk(RingField* rf, const StatusCallback& done);
+
+  // Type of the transferred chunks if it differs from the tensor's, or
+  // DT_INVALID.
+  DataType wire_dtype_ = DT_INVALID;
+
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
 
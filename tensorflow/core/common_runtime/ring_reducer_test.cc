@@ -427,6 +427,36 @@ DEF_TEST(INT64, CPU, 2, 8, 3, 4095, 0)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 1)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
+
+TEST_F(RingReducerTest, ReducedPrecisionWireFormat) {
+  for (DataType wire_dtype : {DT_BFLOAT16, DT_HALF}) {
+    instances_.clear();
+    const int tensor_len = 1001;
+    Init(2, 3, DT_FLOAT, TensorShape({tensor_len}), DEVICE_CPU, 1, 0);
+    std::vector<float> expected(tensor_len);
+    for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+      instances_[di]->col_params_->instance.impl_details.wire_dtype =
+          wire_dtype;
+      instances_[di]->InitTensor([&expected, di](Tensor* t) {
+        for (int i = 0; i < t->NumElements(); ++i) {
+          const float value = (di + 1) * 0.37f + i % 13;
+          t->flat<float>()(i) = value;
+          expected[i] += value / 6;
+        }
+      });
+    }
+    Reduce(0);
+    for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+      TF_EXPECT_OK(instances_[di]->status_);
+      test::ExpectClose(test::AsTensor<float>(expected),
+                        instances_[di]->tensor(), /*atol=*/0.05,
+                        /*rtol=*/0.02);
+      // Rounding happens before a chunk is sent, so all members agree.
+      test::ExpectTensorEqual<float>(instances_[0]->tensor(),
+                                     instances_[di]->tensor());
+    }
+  }
+}
 #endif
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -131,11 +131,26 @@ Status DataServiceDispatcherClient::GetSplit(int64_t iteration_id,
                                              int64_t split_provider_index,
                                              Tensor& split,
                                              bool& end_of_splits) {
+  int64_t split_index = 0;
+  return GetSplit(iteration_id, repetition, split_provider_index,
+                  /*worker_address=*/"", /*acked_split_indices=*/{}, split,
+                  split_index, end_of_splits);
+}
+
+Status DataServiceDispatcherClient::GetSplit(
+    int64_t iteration_id, int64_t repetition, int64_t split_provider_index,
+    const std::string& worker_address,
+    const std::vector<int64_t>& acked_split_indices, Tensor& split,
+    int64_t& split_index, bool& end_of_splits) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   GetSplitRequest req;
   req.set_iteration_id(iteration_id);
   req.set_repetition(repetition);
   req.set_split_provider_index(split_provider_index);
+  req.set_worker_address(worker_address);
+  for (int64_t acked_split_index : acked_split_indices) {
+    req.add_acked_split_indices(acked_split_index);
+  }
   GetSplitResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->GetSplit(&client_ctx, req, &resp);
@@ -143,6 +158,7 @@ Status DataServiceDispatcherClient::GetSplit(int64_t iteration_id,
     return grpc_util::WrapError("Failed to get split", status);
   }
   end_of_splits = resp.end_of_splits();
+  split_index = resp.split_index();
   if (!end_of_splits) {
     if (!split.FromProto(resp.split())) {
       return errors::Internal("Failed to parse split tensor proto");
@@ -62,10 +62,18 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   Status GetDatasetDef(const std::string& dataset_id, DatasetDef& dataset_def);
 
   // Gets the next split for the specified iteration id, repetition, and split
-  // provider index.
+  // provider index. `worker_address` identifies the worker reading the split,
+  // if any, and `acked_split_indices` lists the `split_index`es of splits the
+  // worker has finished reading. `split_index` is set to the index of the
+  // returned split, or 0 if the dispatcher does not track it.
   Status GetSplit(int64_t iteration_id, int64_t repetition,
                   int64_t split_provider_index, Tensor& split,
                   bool& end_of_splits);
+  Status GetSplit(int64_t iteration_id, int64_t repetition,
+                  int64_t split_provider_index,
+                  const std::string& worker_address,
+                  const std::vector<int64_t>& acked_split_indices,
+                  Tensor& split, int64_t& split_index, bool& end_of_splits);
 
   // Gets the next split for the specified source of a stream of the snapshot in
   // `base_path`. If `end_of_splits` returns true, then there are no more splits
@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/data/service/common.pb.h"
@@ -52,6 +53,7 @@ using ::tensorflow::data::testing::EqualsProto;
 using ::tensorflow::data::testing::InfiniteDataset;
 using ::tensorflow::data::testing::LocalTempFilename;
 using ::tensorflow::data::testing::RangeDataset;
+using ::tensorflow::testing::IsOkAndHolds;
 using ::tensorflow::testing::StatusIs;
 using ::testing::AllOf;
 using ::testing::HasSubstr;
@@ -74,9 +76,11 @@ DataServiceMetadata GetDefaultMetadata() {
 
 class DispatcherClientTest : public ::testing::Test {
  protected:
-  Status SetUpTfDataService(int64_t num_workers) {
+  Status SetUpTfDataService(int64_t num_workers,
+                            bool reassign_lost_splits = false) {
     TestCluster::Config config;
     config.num_workers = num_workers;
+    config.reassign_lost_splits = reassign_lost_splits;
     config.work_dir = tsl::io::JoinPath(tsl::testing::TmpDir(), "work_dir");
     test_cluster_ = std::make_unique<TestCluster>(config);
     TF_RETURN_IF_ERROR(test_cluster_->Initialize());
@@ -95,6 +99,62 @@ class DispatcherClientTest : public ::testing::Test {
     return dataset_id;
   }
 
+  // Creates a dynamically sharded iteration over `range(10)` and returns the
+  // iteration ID.
+  StatusOr<int64_t> CreateDynamicShardingIteration() {
+    TF_ASSIGN_OR_RETURN(
+        const std::string dataset_id,
+        RegisterDataset(RangeDataset(10), GetDefaultMetadata()));
+    ProcessingModeDef processing_mode;
+    processing_mode.set_sharding_policy(ProcessingModeDef::DYNAMIC);
+    int64_t job_id = 0;
+    TF_RETURN_IF_ERROR(dispatcher_client_->GetOrCreateJob(
+        dataset_id, processing_mode, /*job_name=*/std::nullopt,
+        /*num_consumers=*/std::nullopt,
+        /*use_cross_trainer_cache=*/false, TARGET_WORKERS_AUTO, job_id));
+    int64_t iteration_client_id = 0;
+    TF_RETURN_IF_ERROR(dispatcher_client_->GetOrCreateIteration(
+        job_id, /*repetition=*/0, iteration_client_id));
+    ClientHeartbeatRequest request;
+    request.set_iteration_client_id(iteration_client_id);
+    ClientHeartbeatResponse response;
+    TF_RETURN_IF_ERROR(dispatcher_client_->ClientHeartbeat(request, response));
+    if (response.task_info().empty()) {
+      return errors::Internal("The iteration has no tasks.");
+    }
+    return response.task_info(0).iteration_id();
+  }
+
+  // Gets the next split of `iteration_id` for `worker_address`, which has
+  // finished reading the splits in `acked_split_indices`. Sets `split_index`
+  // to the index of the split if it is not null.
+  StatusOr<int64_t> GetSplit(
+      int64_t iteration_id, const std::string& worker_address,
+      const std::vector<int64_t>& acked_split_indices = {},
+      int64_t* split_index = nullptr) {
+    Tensor split;
+    int64_t index = 0;
+    bool end_of_splits = false;
+    TF_RETURN_IF_ERROR(dispatcher_client_->GetSplit(
+        iteration_id, /*repetition=*/0, /*split_provider_index=*/0,
+        worker_address, acked_split_indices, split, index, end_of_splits));
+    if (split_index != nullptr) {
+      *split_index = index;
+    }
+    if (end_of_splits) {
+      return errors::OutOfRange("End of splits.");
+    }
+    return split.scalar<int64_t>()();
+  }
+
+  // Tells the dispatcher that the worker at `worker_address` is shutting down.
+  Status ShutDownWorker(const std::string& worker_address) {
+    WorkerHeartbeatRequest request;
+    request.set_worker_address(worker_address);
+    request.set_shutting_down(true);
+    return dispatcher_client_->WorkerHeartbeat(request).status();
+  }
+
   // Starts snapshots and returns the directories.
   StatusOr<absl::flat_hash_set<std::string>> StartDummySnapshots() {
     DistributedSnapshotMetadata metadata =
@@ -247,6 +307,83 @@ TEST_F(DispatcherClientTest, GetSnapshotSplitMultipleStreams) {
   }
 }
 
+TEST_F(DispatcherClientTest, ReassignSplitsOfLostWorker) {
+  TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1,
+                                  /*reassign_lost_splits=*/true));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_id,
+                          CreateDynamicShardingIteration());
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a"), IsOkAndHolds(0));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a"), IsOkAndHolds(1));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(2));
+
+  // Both splits worker_a was reading are handed out again, in order.
+  TF_ASSERT_OK(ShutDownWorker("worker_a"));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(0));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_c"), IsOkAndHolds(1));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(3));
+}
+
+TEST_F(DispatcherClientTest, AckedSplitsAreNotReassigned) {
+  TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1,
+                                  /*reassign_lost_splits=*/true));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_id,
+                          CreateDynamicShardingIteration());
+  int64_t split_index_0 = 0, split_index_1 = 0;
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a", /*acked_split_indices=*/{},
+                       &split_index_0),
+              IsOkAndHolds(0));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a", /*acked_split_indices=*/{},
+                       &split_index_1),
+              IsOkAndHolds(1));
+  EXPECT_NE(split_index_0, 0);
+  EXPECT_NE(split_index_1, 0);
+  EXPECT_NE(split_index_0, split_index_1);
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a", {split_index_0}),
+              IsOkAndHolds(2));
+
+  TF_ASSERT_OK(ShutDownWorker("worker_a"));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(1));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(2));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(3));
+}
+
+TEST_F(DispatcherClientTest, ReassignSplitsAfterEndOfSplits) {
+  TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1,
+                                  /*reassign_lost_splits=*/true));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_id,
+                          CreateDynamicShardingIteration());
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_THAT(GetSplit(iteration_id, "worker_a"), IsOkAndHolds(i));
+  }
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"),
+              StatusIs(error::OUT_OF_RANGE));
+
+  // The repetition has ended, but its lost splits are still handed out.
+  TF_ASSERT_OK(ShutDownWorker("worker_a"));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(0));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(1));
+}
+
+TEST_F(DispatcherClientTest, UntrackedSplitsHaveNoIndex) {
+  TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_id,
+                          CreateDynamicShardingIteration());
+  int64_t split_index = -1;
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a", /*acked_split_indices=*/{},
+                       &split_index),
+              IsOkAndHolds(0));
+  EXPECT_EQ(split_index, 0);
+}
+
+TEST_F(DispatcherClientTest, LostSplitsAreNotReassignedByDefault) {
+  TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_id,
+                          CreateDynamicShardingIteration());
+  EXPECT_THAT(GetSplit(iteration_id, "worker_a"), IsOkAndHolds(0));
+  TF_ASSERT_OK(ShutDownWorker("worker_a"));
+  EXPECT_THAT(GetSplit(iteration_id, "worker_b"), IsOkAndHolds(1));
+}
+
 TEST_F(DispatcherClientTest, RegisterDatasetWithExplicitId) {
   TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1));
   DataServiceMetadata metadata = GetDefaultMetadata();
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <string>
@@ -102,6 +103,7 @@ constexpr absl::Duration kDefaultIterationGcCheckInterval = absl::Minutes(10);
 constexpr absl::Duration kDefaultIterationGcTimeout = absl::Minutes(5);
 constexpr absl::Duration kDefaultClientTimeout = absl::Minutes(5);
 constexpr absl::Duration kDefaultWorkerTimeout = absl::Minutes(10);
+constexpr int64_t kDefaultJournalCheckpointIntervalUpdates = 100000;
 
 constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "HashTable",
@@ -181,6 +183,10 @@ DispatcherConfig ApplyConfigDefaults(const DispatcherConfig& config) {
     new_config.set_worker_max_concurrent_snapshots(
         kDefaultWorkerMaxConcurrentSnapshots);
   }
+  if (new_config.journal_checkpoint_interval_updates() == 0) {
+    new_config.set_journal_checkpoint_interval_updates(
+        kDefaultJournalCheckpointIntervalUpdates);
+  }
   return new_config;
 }
 }  // namespace
@@ -245,6 +251,7 @@ Status DataServiceDispatcherImpl::Start() {
     int64_t start = env_->NowMicros();
     while (!end_of_journal) {
       TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
+      ++updates_since_journal_checkpoint_;
       TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
     }
     absl::Duration duration = absl::Microseconds(env_->NowMicros() - start);
@@ -411,6 +418,13 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
   TF_RETURN_IF_ERROR(CheckStarted());
   VLOG(3) << "Received worker heartbeat request from worker "
           << request->worker_address();
+  if (request->shutting_down()) {
+    mutex_lock l(mu_);
+    LOG(INFO) << "Lost worker " << request->worker_address()
+              << " since it is shutting down";
+    RemoveLostWorker(request->worker_address());
+    return OkStatus();
+  }
   {
     mutex_lock l(mu_);
     const std::string& worker_address = request->worker_address();
@@ -484,6 +498,11 @@ Status DataServiceDispatcherImpl::WorkerUpdate(
       TF_RETURN_IF_ERROR(Apply(update));
       VLOG(3) << "Task " << task_id << " from iteration "
               << task->iteration->iteration_id << " completed";
+      // The task has read all of its splits.
+      ReleaseSplits(task->iteration->iteration_id,
+                    task->iteration->finished
+                        ? std::nullopt
+                        : std::optional<std::string>(task->worker_address));
     }
   }
   return OkStatus();
@@ -510,11 +529,19 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
   VLOG(3) << "Received GetSplit request for iteration " << iteration_id
           << ", repetition " << repetition << ", split provider index "
           << provider_index;
+  const std::pair<int64_t, int64_t> split_provider_key(iteration_id,
+                                                       provider_index);
+  const std::string& worker_address = request->worker_address();
+  const bool track_splits =
+      config_.reassign_lost_splits() && !worker_address.empty();
   mutex_lock l(get_split_mu_);
   int64_t current_repetition = 0;
   SplitProvider* split_provider = nullptr;
   {
     mutex_lock l(mu_);
+    if (track_splits) {
+      AckSplits(worker_address, request->acked_split_indices());
+    }
     std::shared_ptr<const Iteration> iteration;
     TF_RETURN_IF_ERROR(state_.IterationFromId(iteration_id, iteration));
     if (!iteration->distributed_epoch_state.has_value()) {
@@ -524,6 +551,18 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
     }
     current_repetition =
         iteration->distributed_epoch_state.value().repetitions[provider_index];
+    // Splits of lost workers are handed out even after the split provider
+    // moved past their repetition.
+    Tensor lost_split;
+    if (TakeLostSplit(split_provider_key, repetition, lost_split)) {
+      if (track_splits) {
+        TrackSplit(worker_address, split_provider_key, repetition, lost_split,
+                   *response);
+      }
+      lost_split.AsProtoTensorContent(response->mutable_split());
+      VLOG(3) << "Returning split " << lost_split << " of a lost worker";
+      return OkStatus();
+    }
     if (request->repetition() < current_repetition) {
       response->set_end_of_splits(true);
       VLOG(3) << "Returning end_of_splits since current repetition "
@@ -551,6 +590,11 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
     TF_RETURN_IF_ERROR(split_provider->Reset());
   } else {
     split.AsProtoTensorContent(response->mutable_split());
+    if (track_splits) {
+      mutex_lock l(mu_);
+      TrackSplit(worker_address, split_provider_key, repetition, split,
+                 *response);
+    }
   }
   VLOG(3) << "Returning from GetSplit, split=" << split
           << ", end_of_splits=" << end_of_splits;
@@ -1349,50 +1393,101 @@ Status DataServiceDispatcherImpl::ApplyWithoutJournaling(const Update& update)
 Status DataServiceDispatcherImpl::Apply(const Update& update)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   if (journal_writer_.has_value()) {
-    TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+    // RPC handlers call `SyncJournal` before responding, which makes the
+    // update durable together with those of concurrent requests.
+    TF_RETURN_IF_ERROR(journal_writer_.value()->Append(update));
+    ++updates_since_journal_checkpoint_;
   }
   return state_.Apply(update);
 }
 
+Status DataServiceDispatcherImpl::SyncJournal() TF_LOCKS_EXCLUDED(mu_) {
+  JournalWriter* journal_writer = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (!journal_writer_.has_value()) {
+      return OkStatus();
+    }
+    journal_writer = journal_writer_.value().get();
+  }
+  return journal_writer->Sync();
+}
+
 void DataServiceDispatcherImpl::MaintenanceThread() {
   int64_t next_check_micros = 0;
   while (true) {
-    mutex_lock l(mu_);
-    while (!cancelled_ && env_->NowMicros() < next_check_micros) {
-      int64_t remaining_micros = next_check_micros - env_->NowMicros();
-      maintenance_thread_cv_.wait_for(
-          l, std::chrono::microseconds(remaining_micros));
-    }
-    if (cancelled_) {
-      return;
-    }
+    std::optional<int64_t> checkpoint_sequence_number;
     {
-      Status s = ReleaseMissingClients();
-      if (!s.ok()) {
-        LOG(WARNING) << "Error releasing missing clients: " << s;
+      mutex_lock l(mu_);
+      while (!cancelled_ && env_->NowMicros() < next_check_micros) {
+        int64_t remaining_micros = next_check_micros - env_->NowMicros();
+        maintenance_thread_cv_.wait_for(
+            l, std::chrono::microseconds(remaining_micros));
+      }
+      if (cancelled_) {
+        return;
+      }
+      {
+        Status s = ReleaseMissingClients();
+        if (!s.ok()) {
+          LOG(WARNING) << "Error releasing missing clients: " << s;
+        }
+      }
+      {
+        Status s = auto_scaler_.UpdateOptimalNumberOfWorkersMetric(
+            state_.GetNumberOfRegisteredWorkers());
+        if (!s.ok()) {
+          LOG(WARNING) << "Error updating the optimal number of workers "
+                          "metric in tf.data service AutoScaler: "
+                       << s;
+        }
+      }
+      {
+        Status s = GcOldIterations();
+        if (!s.ok()) {
+          LOG(WARNING) << "Error garbage collecting old iterations: " << s;
+        }
       }
+      DetectMissingWorkers();
+      next_check_micros =
+          env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
+      checkpoint_sequence_number = MaybeRotateJournal();
     }
     {
-      Status s = auto_scaler_.UpdateOptimalNumberOfWorkersMetric(
-          state_.GetNumberOfRegisteredWorkers());
+      Status s = SyncJournal();
       if (!s.ok()) {
-        LOG(WARNING) << "Error updating the optimal number of workers metric "
-                        "in tf.data service AutoScaler: "
-                     << s;
+        LOG(WARNING) << "Error syncing the journal: " << s;
       }
     }
-    {
-      Status s = GcOldIterations();
+    // Checkpoints without holding `mu_`, since it only reads complete journal
+    // files.
+    if (checkpoint_sequence_number.has_value()) {
+      Status s = CheckpointJournal(env_, JournalDir(config_.work_dir()),
+                                   *checkpoint_sequence_number);
       if (!s.ok()) {
-        LOG(WARNING) << "Error garbage collecting old iterations: " << s;
+        LOG(WARNING) << "Error checkpointing the journal: " << s;
       }
     }
-    DetectMissingWorkers();
-    next_check_micros =
-        env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
   }
 }
 
+std::optional<int64_t> DataServiceDispatcherImpl::MaybeRotateJournal()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (!journal_writer_.has_value() ||
+      config_.journal_checkpoint_interval_updates() < 0 ||
+      updates_since_journal_checkpoint_ <
+          config_.journal_checkpoint_interval_updates()) {
+    return std::nullopt;
+  }
+  StatusOr<int64_t> sequence_number = journal_writer_.value()->Rotate();
+  if (!sequence_number.ok()) {
+    LOG(WARNING) << "Error rotating the journal: " << sequence_number.status();
+    return std::nullopt;
+  }
+  updates_since_journal_checkpoint_ = 0;
+  return *sequence_number;
+}
+
 void DataServiceDispatcherImpl::RemoveClientFromAutoScaler(int64_t client_id)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   std::shared_ptr<const Iteration> iteration;
@@ -1460,14 +1555,123 @@ void DataServiceDispatcherImpl::RemoveWorkerFromAutoScaler(
 void DataServiceDispatcherImpl::DetectMissingWorkers()
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   int64_t now = env_->NowMicros();
-  for (auto it = latest_worker_heartbeats_time_.begin();
-       it != latest_worker_heartbeats_time_.end();) {
+  std::vector<std::string> lost_workers;
+  for (const auto& [worker_address, heartbeat_time] :
+       latest_worker_heartbeats_time_) {
     if (absl::FromUnixMicros(now) >
-        it->second + absl::Milliseconds(config_.worker_timeout_ms())) {
-      LOG(INFO) << "Lost worker " << it->first << " due to timeout";
-      RemoveWorkerFromAutoScaler(it->first);
+        heartbeat_time + absl::Milliseconds(config_.worker_timeout_ms())) {
+      LOG(INFO) << "Lost worker " << worker_address << " due to timeout";
+      lost_workers.push_back(worker_address);
+    }
+  }
+  for (const std::string& worker_address : lost_workers) {
+    RemoveLostWorker(worker_address);
+  }
+}
 
-      latest_worker_heartbeats_time_.erase(it++);
+void DataServiceDispatcherImpl::RemoveLostWorker(
+    const std::string& worker_address) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  RemoveWorkerFromAutoScaler(worker_address);
+  latest_worker_heartbeats_time_.erase(worker_address);
+  auto it = outstanding_splits_.find(worker_address);
+  if (it == outstanding_splits_.end()) {
+    return;
+  }
+  // Requeued in the order they were handed out.
+  for (auto& [unused, outstanding_split] : it->second) {
+    VLOG(1) << "Requeueing split " << outstanding_split.split
+            << " of lost worker " << worker_address << " for iteration "
+            << outstanding_split.split_provider_key.first
+            << ", split provider "
+            << outstanding_split.split_provider_key.second;
+    lost_splits_[outstanding_split.split_provider_key].push_back(
+        std::move(outstanding_split));
+  }
+  outstanding_splits_.erase(it);
+}
+
+void DataServiceDispatcherImpl::TrackSplit(
+    const std::string& worker_address,
+    const std::pair<int64_t, int64_t>& split_provider_key, int64_t repetition,
+    const Tensor& split, GetSplitResponse& response)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64_t split_index = next_split_index_++;
+  outstanding_splits_[worker_address][split_index] = {split_provider_key,
+                                                      repetition, split};
+  response.set_split_index(split_index);
+}
+
+void DataServiceDispatcherImpl::AckSplits(
+    const std::string& worker_address,
+    const google::protobuf::RepeatedField<int64_t>& split_indices)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (split_indices.empty()) {
+    return;
+  }
+  auto it = outstanding_splits_.find(worker_address);
+  if (it == outstanding_splits_.end()) {
+    return;
+  }
+  for (int64_t split_index : split_indices) {
+    it->second.erase(split_index);
+  }
+  if (it->second.empty()) {
+    outstanding_splits_.erase(it);
+  }
+}
+
+bool DataServiceDispatcherImpl::TakeLostSplit(
+    const std::pair<int64_t, int64_t>& split_provider_key, int64_t repetition,
+    Tensor& split) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  auto it = lost_splits_.find(split_provider_key);
+  if (it == lost_splits_.end()) {
+    return false;
+  }
+  std::deque<OutstandingSplit>& splits = it->second;
+  auto split_it =
+      absl::c_find_if(splits, [repetition](const OutstandingSplit& lost) {
+        return lost.repetition == repetition;
+      });
+  if (split_it == splits.end()) {
+    return false;
+  }
+  split = std::move(split_it->split);
+  splits.erase(split_it);
+  if (splits.empty()) {
+    lost_splits_.erase(it);
+  }
+  return true;
+}
+
+void DataServiceDispatcherImpl::ReleaseSplits(
+    int64_t iteration_id, std::optional<std::string> worker_address)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  for (auto it = outstanding_splits_.begin();
+       it != outstanding_splits_.end();) {
+    if (worker_address.has_value() && it->first != *worker_address) {
+      ++it;
+      continue;
+    }
+    auto& splits = it->second;
+    for (auto split_it = splits.begin(); split_it != splits.end();) {
+      if (split_it->second.split_provider_key.first == iteration_id) {
+        splits.erase(split_it++);
+      } else {
+        ++split_it;
+      }
+    }
+    if (splits.empty()) {
+      outstanding_splits_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  if (worker_address.has_value()) {
+    return;
+  }
+  for (auto it = lost_splits_.begin(); it != lost_splits_.end();) {
+    if (it->first.first == iteration_id) {
+      lost_splits_.erase(it++);
     } else {
       ++it;
     }
@@ -1487,6 +1691,7 @@ Status DataServiceDispatcherImpl::GcOldIterations()
     update.mutable_garbage_collect_iteration()->set_iteration_id(
         iteration->iteration_id);
     TF_RETURN_IF_ERROR(state_.Apply(update));
+    ReleaseSplits(iteration->iteration_id, /*worker_address=*/std::nullopt);
     Status auto_scaler_status =
         auto_scaler_.UnregisterIteration(iteration->iteration_id);
     if (!auto_scaler_status.ok()) {
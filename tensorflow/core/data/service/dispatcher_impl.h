@@ -17,9 +17,12 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERVICE_DISPATCHER_IMPL_H_
 
 #include <cstdint>
+#include <deque>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -36,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/task_remover.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -148,6 +152,11 @@ class DataServiceDispatcherImpl {
   // Returns the number of active iterations.
   size_t NumActiveIterations() TF_LOCKS_EXCLUDED(mu_);
 
+  // Waits until the state updates made so far are durably journaled. The RPC
+  // methods below only append their updates to the journal, so this must be
+  // called before responding to a request.
+  Status SyncJournal() TF_LOCKS_EXCLUDED(mu_);
+
   // See dispatcher.proto for API documentation.
 
   /// Worker-facing API.
@@ -316,6 +325,10 @@ class DataServiceDispatcherImpl {
       TF_LOCKS_EXCLUDED(mu_);
   // Applies a state update, updating both the journal and the in-memory state.
   Status Apply(const Update& update) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Starts a new journal file once enough updates were journaled since the
+  // last checkpoint. Returns the sequence number of the new file, before which
+  // the journal should be checkpointed.
+  std::optional<int64_t> MaybeRotateJournal() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, but doesn't update the journal. Only meant to be
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
@@ -332,6 +345,31 @@ class DataServiceDispatcherImpl {
   // Checks for workers that haven't heartbeated recently and alerts the
   // snapshot managers.
   void DetectMissingWorkers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Forgets the worker with `worker_address`, which timed out or is shutting
+  // down, and queues its outstanding splits to be handed to other workers.
+  void RemoveLostWorker(const std::string& worker_address)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Records that `split` was handed to the worker with `worker_address` and
+  // sets its index in `response`.
+  void TrackSplit(const std::string& worker_address,
+                  const std::pair<int64_t, int64_t>& split_provider_key,
+                  int64_t repetition, const Tensor& split,
+                  GetSplitResponse& response) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Forgets the splits the worker with `worker_address` finished reading.
+  void AckSplits(const std::string& worker_address,
+                 const google::protobuf::RepeatedField<int64_t>& split_indices)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // If a lost worker left a split of `repetition` for the given split
+  // provider, moves it to `split` and returns true.
+  bool TakeLostSplit(const std::pair<int64_t, int64_t>& split_provider_key,
+                     int64_t repetition, Tensor& split)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Forgets the outstanding splits of iteration `iteration_id` held by the
+  // worker with `worker_address`, or all of its outstanding and lost splits
+  // if `worker_address` is not set.
+  void ReleaseSplits(int64_t iteration_id,
+                     std::optional<std::string> worker_address)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Scans for old iterations and marks them as finished.
   Status GcOldIterations() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Returns true if an iteration should be garbage collected.
@@ -380,6 +418,26 @@ class DataServiceDispatcherImpl {
   absl::flat_hash_map<std::string, absl::Time> latest_worker_heartbeats_time_
       TF_GUARDED_BY(mu_);
 
+  // Splits handed out by `GetSplit`, tracked when
+  // `config_.reassign_lost_splits()` is set. Split providers are keyed by
+  // (iteration id, split provider index).
+  struct OutstandingSplit {
+    std::pair<int64_t, int64_t> split_provider_key;
+    int64_t repetition;
+    Tensor split;
+  };
+  // Map from worker address to the splits the worker has not acknowledged,
+  // keyed by split index. A worker may read several splits of a provider at
+  // once, and holds them until it acknowledges them or its task completes.
+  absl::flat_hash_map<std::string, std::map<int64_t, OutstandingSplit>>
+      outstanding_splits_ TF_GUARDED_BY(mu_);
+  // Index of the next tracked split. 0 means untracked.
+  int64_t next_split_index_ TF_GUARDED_BY(mu_) = 1;
+  // Outstanding splits of lost workers, handed out before new splits.
+  absl::flat_hash_map<std::pair<int64_t, int64_t>,
+                      std::deque<OutstandingSplit>>
+      lost_splits_ TF_GUARDED_BY(mu_);
+
   // TODO(mpcallanan): Don't recover completed snapshots.
   // TODO(mpcallanan): Garbage collect completed snapshots.
   // A manager for each snapshot resumed or started during the lifetime of this
@@ -391,6 +449,8 @@ class DataServiceDispatcherImpl {
 
   std::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
+  // Number of updates in the journal since its latest checkpoint.
+  int64_t updates_since_journal_checkpoint_ TF_GUARDED_BY(mu_) = 0;
   DispatcherState state_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the gc thread.
   condition_variable maintenance_thread_cv_;
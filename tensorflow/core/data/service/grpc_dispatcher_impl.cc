@@ -45,11 +45,15 @@ DispatcherStateExport GrpcDispatcherImpl::ExportState() const {
   return impl_.ExportState();
 }
 
+// Syncs the journal before responding, so that the response never reflects
+// state which could be lost on restart.
 #define HANDLER(method)                                                   \
   grpc::Status GrpcDispatcherImpl::method(ServerContext* context,         \
                                           const method##Request* request, \
                                           method##Response* response) {   \
-    return ToGrpcStatus(impl_.method(request, response));                 \
+    Status s = impl_.method(request, response);                           \
+    s.Update(impl_.SyncJournal());                                        \
+    return ToGrpcStatus(s);                                               \
   }
 HANDLER(WorkerHeartbeat);
 HANDLER(WorkerUpdate);
@@ -16,17 +16,24 @@ limitations under the License.
 #include "tensorflow/core/data/service/journal.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/regexp.h"
 
@@ -35,15 +42,60 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kCheckpoint = "checkpoint";
+// Prefix of checkpoints which are still being written.
+constexpr StringPiece kTemporaryPrefix = "tmp_";
 
-Status ParseSequenceNumber(const std::string& journal_file,
-                           int64_t* sequence_number) {
-  if (!RE2::FullMatch(journal_file, ".*_(\\d+)", sequence_number)) {
+// Parses the name of a journal or checkpoint file.
+Status ParseJournalFileName(const std::string& journal_file,
+                            bool& is_checkpoint, int64_t& sequence_number) {
+  std::string type;
+  if (!RE2::FullMatch(journal_file, "(journal|checkpoint)_(\\d+)", &type,
+                      &sequence_number)) {
     return errors::InvalidArgument("Failed to parse journal file name: ",
                                    journal_file);
   }
+  is_checkpoint = type == kCheckpoint;
   return OkStatus();
 }
+
+// Lists the sequence numbers of the journal files and checkpoints in
+// `journal_dir`.
+Status ListJournalFiles(Env* env, const std::string& journal_dir,
+                        std::vector<int64_t>& journals,
+                        std::vector<int64_t>& checkpoints) {
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  for (const std::string& file : files) {
+    if (absl::StartsWith(file, kTemporaryPrefix)) {
+      continue;
+    }
+    bool is_checkpoint = false;
+    int64_t sequence_number = 0;
+    TF_RETURN_IF_ERROR(
+        ParseJournalFileName(file, is_checkpoint, sequence_number));
+    (is_checkpoint ? checkpoints : journals).push_back(sequence_number);
+  }
+  return OkStatus();
+}
+
+// Deletes the checkpoints left behind by a dispatcher which stopped while
+// writing them.
+Status DeleteTemporaryFiles(Env* env, const std::string& journal_dir) {
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  for (const std::string& file : files) {
+    if (absl::StartsWith(file, kTemporaryPrefix)) {
+      LOG(INFO) << "Deleting incomplete journal checkpoint " << file;
+      TF_RETURN_IF_ERROR(env->DeleteFile(io::JoinPath(journal_dir, file)));
+    }
+  }
+  return OkStatus();
+}
+
+int64_t NumSplits(const ProduceSplitUpdate& produce_split) {
+  return std::max<int64_t>(produce_split.num_splits(), 1);
+}
 }  // namespace
 
 std::string DataServiceJournalFile(const std::string& journal_dir,
@@ -52,54 +104,243 @@ std::string DataServiceJournalFile(const std::string& journal_dir,
                       absl::StrCat(kJournal, "_", sequence_number));
 }
 
+std::string DataServiceJournalCheckpointFile(const std::string& journal_dir,
+                                             int64_t sequence_number) {
+  return io::JoinPath(journal_dir,
+                      absl::StrCat(kCheckpoint, "_", sequence_number));
+}
+
 FileJournalWriter::FileJournalWriter(Env* env, const std::string& journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
 Status FileJournalWriter::EnsureInitialized() {
+  mutex_lock l(mu_);
+  return EnsureInitializedLocked();
+}
+
+Status FileJournalWriter::EnsureInitializedLocked() {
   if (writer_) {
     return OkStatus();
   }
-  std::vector<std::string> journal_files;
   TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(journal_dir_));
-  TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
-  int64_t latest_sequence_number = -1;
-  for (const auto& file : journal_files) {
-    int64_t sequence_number;
-    TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
-    latest_sequence_number = std::max(latest_sequence_number, sequence_number);
+  if (sequence_number_ < 0) {
+    TF_RETURN_IF_ERROR(DeleteTemporaryFiles(env_, journal_dir_));
+  }
+  std::vector<int64_t> journals;
+  std::vector<int64_t> checkpoints;
+  TF_RETURN_IF_ERROR(
+      ListJournalFiles(env_, journal_dir_, journals, checkpoints));
+  // A checkpoint replaces the journal files before it, so the next journal
+  // file is numbered after the latest journal file and at least as high as
+  // the latest checkpoint.
+  int64_t sequence_number = 0;
+  for (int64_t journal : journals) {
+    sequence_number = std::max(sequence_number, journal + 1);
+  }
+  for (int64_t checkpoint : checkpoints) {
+    sequence_number = std::max(sequence_number, checkpoint);
   }
+  return OpenFile(sequence_number);
+}
+
+Status FileJournalWriter::OpenFile(int64_t sequence_number) {
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
+      DataServiceJournalFile(journal_dir_, sequence_number);
   TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
   writer_ = std::make_unique<io::RecordWriter>(file_.get());
+  sequence_number_ = sequence_number;
   VLOG(1) << "Created journal writer to write to " << journal_file;
   return OkStatus();
 }
 
 Status FileJournalWriter::Write(const Update& update) {
-  TF_RETURN_IF_ERROR(EnsureInitialized());
+  TF_RETURN_IF_ERROR(Append(update));
+  return Sync();
+}
+
+Status FileJournalWriter::Append(const Update& update) {
   std::string s = update.SerializeAsString();
   if (s.empty()) {
     return errors::Internal("Failed to serialize update ", update.DebugString(),
                             " to string");
   }
+  mutex_lock l(mu_);
+  TF_RETURN_IF_ERROR(EnsureInitializedLocked());
   TF_RETURN_IF_ERROR(writer_->WriteRecord(s));
-  TF_RETURN_IF_ERROR(writer_->Flush());
-  TF_RETURN_IF_ERROR(file_->Sync());
+  ++num_appended_;
   if (VLOG_IS_ON(4)) {
     VLOG(4) << "Wrote journal entry: " << update.DebugString();
   }
   return OkStatus();
 }
 
-FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
-    : env_(env), journal_dir_(journal_dir) {}
+Status FileJournalWriter::Sync() {
+  // Threads that appended while another thread was syncing wait here, and the
+  // first of them syncs the updates of all of them.
+  mutex_lock sync_lock(sync_mu_);
+  WritableFile* file = nullptr;
+  int64_t num_appended = 0;
+  {
+    mutex_lock l(mu_);
+    if (num_synced_ == num_appended_) {
+      return OkStatus();
+    }
+    if (!writer_) {
+      return errors::DataLoss(
+          "The journal file was closed before its updates were synced.");
+    }
+    TF_RETURN_IF_ERROR(writer_->Flush());
+    file = file_.get();
+    num_appended = num_appended_;
+  }
+  // Other threads keep appending while the file syncs. `file` stays open,
+  // since only `Rotate` closes it and it holds `sync_mu_`.
+  TF_RETURN_IF_ERROR(file->Sync());
+  mutex_lock l(mu_);
+  num_synced_ = std::max(num_synced_, num_appended);
+  return OkStatus();
+}
+
+StatusOr<int64_t> FileJournalWriter::Rotate() {
+  mutex_lock sync_lock(sync_mu_);
+  std::unique_ptr<WritableFile> file;
+  int64_t num_appended = 0;
+  int64_t sequence_number = 0;
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(EnsureInitializedLocked());
+    // The writer can't be used once it is closed, even if closing fails. The
+    // next update then starts a new journal file.
+    std::unique_ptr<io::RecordWriter> writer = std::move(writer_);
+    file = std::move(file_);
+    num_appended = num_appended_;
+    TF_RETURN_IF_ERROR(writer->Close());
+    TF_RETURN_IF_ERROR(OpenFile(sequence_number_ + 1));
+    sequence_number = sequence_number_;
+  }
+  TF_RETURN_IF_ERROR(file->Sync());
+  TF_RETURN_IF_ERROR(file->Close());
+  mutex_lock l(mu_);
+  num_synced_ = std::max(num_synced_, num_appended);
+  return sequence_number;
+}
+
+Status CheckpointJournal(Env* env, const std::string& journal_dir,
+                         int64_t end_sequence_number) {
+  if (end_sequence_number <= 0) {
+    return errors::InvalidArgument(
+        "Journal checkpoints must replace at least one journal file, got "
+        "end sequence number ",
+        end_sequence_number);
+  }
+  std::vector<Update> updates;
+  // Map from (iteration id, split provider index) to the position in `updates`
+  // of the last `ProduceSplitUpdate` of the split provider, while the split
+  // provider hasn't finished the repetition.
+  absl::flat_hash_map<std::pair<int64_t, int64_t>, size_t> split_updates;
+  int64_t num_read = 0;
+  FileJournalReader reader(env, journal_dir, end_sequence_number);
+  while (true) {
+    Update update;
+    bool end_of_journal = false;
+    TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
+    if (end_of_journal) {
+      break;
+    }
+    ++num_read;
+    if (!update.has_produce_split()) {
+      updates.push_back(std::move(update));
+      continue;
+    }
+    const ProduceSplitUpdate& produce_split = update.produce_split();
+    const std::pair<int64_t, int64_t> key(produce_split.iteration_id(),
+                                          produce_split.split_provider_index());
+    auto it = split_updates.find(key);
+    if (!produce_split.finished() && it != split_updates.end()) {
+      ProduceSplitUpdate* merged = updates[it->second].mutable_produce_split();
+      if (merged->repetition() == produce_split.repetition()) {
+        merged->set_num_splits(NumSplits(*merged) + NumSplits(produce_split));
+        continue;
+      }
+    }
+    if (produce_split.finished()) {
+      split_updates.erase(key);
+    } else {
+      split_updates[key] = updates.size();
+    }
+    updates.push_back(std::move(update));
+  }
+
+  // Write the checkpoint under a temporary name, so that readers never see a
+  // partial checkpoint.
+  const std::string checkpoint_file =
+      DataServiceJournalCheckpointFile(journal_dir, end_sequence_number);
+  const std::string temporary_file = io::JoinPath(
+      journal_dir,
+      absl::StrCat(kTemporaryPrefix, kCheckpoint, "_", end_sequence_number));
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env->NewWritableFile(temporary_file, &file));
+    io::RecordWriter writer(file.get());
+    for (const Update& update : updates) {
+      TF_RETURN_IF_ERROR(writer.WriteRecord(update.SerializeAsString()));
+    }
+    TF_RETURN_IF_ERROR(writer.Close());
+    TF_RETURN_IF_ERROR(file->Sync());
+    TF_RETURN_IF_ERROR(file->Close());
+  }
+  TF_RETURN_IF_ERROR(env->RenameFile(temporary_file, checkpoint_file));
+
+  std::vector<int64_t> journals;
+  std::vector<int64_t> checkpoints;
+  TF_RETURN_IF_ERROR(ListJournalFiles(env, journal_dir, journals, checkpoints));
+  for (int64_t journal : journals) {
+    if (journal < end_sequence_number) {
+      TF_RETURN_IF_ERROR(
+          env->DeleteFile(DataServiceJournalFile(journal_dir, journal)));
+    }
+  }
+  for (int64_t checkpoint : checkpoints) {
+    if (checkpoint < end_sequence_number) {
+      TF_RETURN_IF_ERROR(env->DeleteFile(
+          DataServiceJournalCheckpointFile(journal_dir, checkpoint)));
+    }
+  }
+  LOG(INFO) << "Checkpointed " << num_read << " journal updates as "
+            << updates.size() << " updates in " << checkpoint_file;
+  return OkStatus();
+}
+
+FileJournalReader::FileJournalReader(
+    Env* env, StringPiece journal_dir,
+    std::optional<int64_t> end_sequence_number)
+    : env_(env),
+      journal_dir_(journal_dir),
+      end_sequence_number_(end_sequence_number) {}
 
 Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return OkStatus();
   }
-  return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  std::vector<int64_t> journals;
+  std::vector<int64_t> checkpoints;
+  TF_RETURN_IF_ERROR(
+      ListJournalFiles(env_, journal_dir_, journals, checkpoints));
+  std::optional<int64_t> checkpoint;
+  for (int64_t sequence_number : checkpoints) {
+    if (end_sequence_number_.has_value() &&
+        sequence_number > *end_sequence_number_) {
+      continue;
+    }
+    checkpoint = std::max(checkpoint.value_or(0), sequence_number);
+  }
+  if (!checkpoint.has_value()) {
+    return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  }
+  // After the checkpoint, continue with the journal file of the same number.
+  sequence_number_ = *checkpoint - 1;
+  return UpdateFile(
+      DataServiceJournalCheckpointFile(journal_dir_, *checkpoint));
 }
 
 Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
@@ -109,6 +350,11 @@ Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
     Status s = reader_->ReadRecord(&record);
     if (absl::IsOutOfRange(s)) {
       sequence_number_++;
+      if (end_sequence_number_.has_value() &&
+          sequence_number_ >= *end_sequence_number_) {
+        end_of_journal = true;
+        return OkStatus();
+      }
       std::string next_journal_file =
           DataServiceJournalFile(journal_dir_, sequence_number_);
       if (absl::IsNotFound(env_->FileExists(next_journal_file))) {
@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "tensorflow/core/data/service/journal.pb.h"
@@ -23,6 +25,9 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace data {
@@ -31,32 +36,52 @@ namespace data {
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number);
 
+// Returns the location of the checkpoint which replaces the journal files
+// before `sequence_number`.
+std::string DataServiceJournalCheckpointFile(const std::string& journal_dir,
+                                             int64_t sequence_number);
+
 // Interface for writing to a journal.
 class JournalWriter {
  public:
   virtual ~JournalWriter() = default;
   // Writes and syncs an update to the journal.
   virtual Status Write(const Update& update) = 0;
+  // Writes an update to the journal without waiting for it to be durable.
+  virtual Status Append(const Update& update) = 0;
+  // Waits until all appended updates are durable.
+  virtual Status Sync() = 0;
+  // Syncs the current journal file and starts a new one. Returns the sequence
+  // number of the new file.
+  virtual StatusOr<int64_t> Rotate() = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
 };
 
-// FileJournalWriter is not thread-safe, requiring external synchronization when
-// used by multiple threads.
+// FileJournalWriter is thread-safe.
 //
 // FileJournalWriter writes journal files to a configured journal directory. The
 // directory is laid out in the following format:
 //
 // journal_dir/
-//   journal_0
-//   journal_1
+//   checkpoint_2
+//   journal_2
+//   journal_3
 //   ...
 //
 // When the writer is created, it lists the directory to find the next available
 // journal file name. For example, if the journal directory contains
 // "journal_0", "journal_1", and "journal_2", the writer will write to
-// "journal_3". The writer will flush updates as they are written, so that they
-// can be stored durably in case of machine failure.
+// "journal_3". `Write` syncs each update, so that it is stored durably in case
+// of machine failure. Alternatively, updates can be `Append`ed by several
+// threads, and each thread calls `Sync` before acknowledging its update. One
+// `Sync` then covers all updates appended before it (group commit), so
+// concurrent updates share the cost of a file sync. Updates are appended while
+// an earlier `Sync` is in progress, which requires a file system that allows
+// appending to a file while it syncs, like POSIX file systems do.
+//
+// When the writer is first initialized, it deletes the temporary files of
+// checkpoints that were not completed.
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -67,15 +92,38 @@ class FileJournalWriter : public JournalWriter {
   FileJournalWriter& operator=(const FileJournalWriter&) = delete;
 
   Status Write(const Update& update) override;
+  Status Append(const Update& update) override;
+  Status Sync() override;
+  StatusOr<int64_t> Rotate() override;
   Status EnsureInitialized() override;
 
  private:
+  Status EnsureInitializedLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status OpenFile(int64_t sequence_number) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Env* env_;
   const std::string journal_dir_;
-  std::unique_ptr<WritableFile> file_;
-  std::unique_ptr<io::RecordWriter> writer_;
+  // Held while syncing or rotating, so that one thread syncs at a time. Not
+  // held while appending, so updates are appended while the file syncs.
+  mutex sync_mu_ TF_ACQUIRED_BEFORE(mu_);
+  mutex mu_;
+  int64_t sequence_number_ TF_GUARDED_BY(mu_) = -1;
+  // Only closed by `Rotate`, with `sync_mu_` held.
+  std::unique_ptr<WritableFile> file_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<io::RecordWriter> writer_ TF_GUARDED_BY(mu_);
+  int64_t num_appended_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_synced_ TF_GUARDED_BY(mu_) = 0;
 };
 
+// Replaces the journal files before `end_sequence_number`, and the checkpoint
+// they start from, with a new checkpoint. The checkpoint holds the same updates
+// except that runs of `ProduceSplitUpdate`s for the same split provider and
+// repetition are merged into one update, which makes up most of the journal
+// of dynamically sharded iterations. All journal files before
+// `end_sequence_number` must be complete.
+Status CheckpointJournal(Env* env, const std::string& journal_dir,
+                         int64_t end_sequence_number);
+
 // Interface for reading from a journal.
 class JournalReader {
  public:
@@ -88,11 +136,15 @@ class JournalReader {
 // JournalReader is not thread-safe, requiring external synchronization when
 // used by multiple threads.
 //
-// The journal reader reads through all journal files in the configured journal
-// directory, in order of their sequence numbers. See FileJournalWriter above.
+// The journal reader reads the latest checkpoint in the configured journal
+// directory, if any, followed by the journal files after it, in order of their
+// sequence numbers. See FileJournalWriter above. If `end_sequence_number` is
+// set, the reader stops before that journal file.
 class FileJournalReader : public JournalReader {
  public:
-  explicit FileJournalReader(Env* env, StringPiece journal_dir);
+  explicit FileJournalReader(
+      Env* env, StringPiece journal_dir,
+      std::optional<int64_t> end_sequence_number = std::nullopt);
   FileJournalReader(const FileJournalReader&) = delete;
   FileJournalReader& operator=(const FileJournalReader&) = delete;
 
@@ -106,6 +158,7 @@ class FileJournalReader : public JournalReader {
 
   Env* env_;
   const std::string journal_dir_;
+  const std::optional<int64_t> end_sequence_number_;
   // Sequence number of current journal file.
   int64_t sequence_number_ = 0;
   std::unique_ptr<RandomAccessFile> file_;
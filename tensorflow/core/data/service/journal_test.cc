@@ -23,8 +23,10 @@ limitations under the License.
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
 
@@ -67,6 +69,18 @@ Update MakeRegisterDatasetUpdate() {
   return update;
 }
 
+Update MakeProduceSplitUpdate(int64_t split_provider_index, int64_t repetition,
+                              bool finished = false, int64_t num_splits = 0) {
+  Update update;
+  ProduceSplitUpdate* produce_split = update.mutable_produce_split();
+  produce_split->set_iteration_id(8);
+  produce_split->set_split_provider_index(split_provider_index);
+  produce_split->set_repetition(repetition);
+  produce_split->set_finished(finished);
+  produce_split->set_num_splits(num_splits);
+  return update;
+}
+
 Status CheckJournalContent(StringPiece journal_dir,
                            const std::vector<Update>& expected) {
   FileJournalReader reader(Env::Default(), journal_dir);
@@ -115,6 +129,134 @@ TEST(Journal, AppendExistingJournal) {
   TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
 }
 
+TEST(Journal, GroupCommit) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  std::vector<Update> updates = {MakeCreateIterationUpdate(),
+                                 MakeRegisterDatasetUpdate(),
+                                 MakeFinishTaskUpdate()};
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  for (const auto& update : updates) {
+    TF_EXPECT_OK(writer.Append(update));
+  }
+  TF_EXPECT_OK(writer.Sync());
+  TF_EXPECT_OK(writer.Sync());
+
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
+}
+
+TEST(Journal, Checkpoint) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  for (const auto& update : {
+           MakeCreateIterationUpdate(),
+           MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0),
+           MakeProduceSplitUpdate(/*split_provider_index=*/1, /*repetition=*/0),
+           MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0),
+           MakeFinishTaskUpdate(),
+           MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0),
+       }) {
+    TF_ASSERT_OK(writer.Write(update));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(int64_t sequence_number, writer.Rotate());
+  for (const auto& update : {
+           MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0),
+           MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0,
+                                  /*finished=*/true),
+           MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/1),
+       }) {
+    TF_ASSERT_OK(writer.Write(update));
+  }
+  TF_ASSERT_OK(writer.Rotate().status());
+  TF_ASSERT_OK(CheckpointJournal(Env::Default(), journal_dir, sequence_number));
+  EXPECT_TRUE(absl::IsNotFound(Env::Default()->FileExists(
+      DataServiceJournalFile(journal_dir, /*sequence_number=*/0))));
+  TF_ASSERT_OK(
+      CheckpointJournal(Env::Default(), journal_dir, sequence_number + 1));
+  TF_ASSERT_OK(writer.Write(MakeRegisterDatasetUpdate()));
+
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir,
+      {MakeCreateIterationUpdate(),
+       MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0,
+                              /*finished=*/false, /*num_splits=*/4),
+       MakeProduceSplitUpdate(/*split_provider_index=*/1, /*repetition=*/0),
+       MakeFinishTaskUpdate(),
+       MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/0,
+                              /*finished=*/true),
+       MakeProduceSplitUpdate(/*split_provider_index=*/0, /*repetition=*/1),
+       MakeRegisterDatasetUpdate()}));
+}
+
+TEST(Journal, AppendAfterCheckpoint) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  int64_t sequence_number = 0;
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_ASSERT_OK(writer.Write(MakeCreateIterationUpdate()));
+    TF_ASSERT_OK_AND_ASSIGN(sequence_number, writer.Rotate());
+  }
+  TF_ASSERT_OK(CheckpointJournal(Env::Default(), journal_dir, sequence_number));
+  // Remove the empty journal file after the checkpoint, as if the dispatcher
+  // stopped before writing to it.
+  TF_ASSERT_OK(Env::Default()->DeleteFile(
+      DataServiceJournalFile(journal_dir, sequence_number)));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_ASSERT_OK(writer.Write(MakeFinishTaskUpdate()));
+  }
+
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeCreateIterationUpdate(), MakeFinishTaskUpdate()}));
+}
+
+TEST(Journal, ConcurrentAppendAndSync) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  constexpr int kNumThreads = 8;
+  constexpr int kNumUpdates = 50;
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumThreads; ++i) {
+      threads.push_back(absl::WrapUnique(Env::Default()->StartThread(
+          ThreadOptions(), "journal_writer", [&writer]() {
+            for (int j = 0; j < kNumUpdates; ++j) {
+              TF_EXPECT_OK(writer.Append(MakeFinishTaskUpdate()));
+              TF_EXPECT_OK(writer.Sync());
+            }
+          })));
+    }
+  }
+
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, std::vector<Update>(kNumThreads * kNumUpdates,
+                                       MakeFinishTaskUpdate())));
+}
+
+TEST(Journal, DeletesIncompleteCheckpoints) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_ASSERT_OK(writer.Write(MakeCreateIterationUpdate()));
+  }
+  // As if the dispatcher stopped while writing a checkpoint.
+  const std::string temporary_file =
+      io::JoinPath(journal_dir, "tmp_checkpoint_1");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), temporary_file, "partial"));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_ASSERT_OK(writer.Write(MakeFinishTaskUpdate()));
+  }
+
+  EXPECT_TRUE(absl::IsNotFound(Env::Default()->FileExists(temporary_file)));
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeCreateIterationUpdate(), MakeFinishTaskUpdate()}));
+}
+
 TEST(Journal, MissingFile) {
   std::string journal_dir;
   EXPECT_TRUE(NewJournalDir(journal_dir));
@@ -41,15 +41,22 @@ Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits)
     dispatcher_ =
         std::make_unique<DataServiceDispatcherClient>(address_, protocol_);
   }
+  int64_t split_index = 0;
   TF_RETURN_IF_ERROR(grpc_util::Retry(
-      [this, split, end_of_splits]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        return dispatcher_->GetSplit(iteration_id_, repetition_,
-                                     split_provider_index_, *split,
-                                     *end_of_splits);
-      },
+      [this, split, &split_index, end_of_splits]()
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            return dispatcher_->GetSplit(
+                iteration_id_, repetition_, split_provider_index_,
+                worker_address_, acked_split_indices_, *split, split_index,
+                *end_of_splits);
+          },
       "get next split",
       /*deadline_micros=*/Env::Default()->NowMicros() +
           (timeout_ms_ * EnvTime::kMillisToMicros)));
+  acked_split_indices_.clear();
+  if (split_index != 0) {
+    split_indices_.push_back(split_index);
+  }
   if (*end_of_splits) {
     VLOG(1) << "Reached end of splits for iteration_id=" << iteration_id_
             << ", repetition=" << repetition_;
@@ -64,6 +71,11 @@ Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits)
 Status DataServiceSplitProvider::Reset() TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   repetition_++;
+  // The iterator reached the end of the repetition, so it has finished
+  // reading its splits.
+  acked_split_indices_.insert(acked_split_indices_.end(),
+                              split_indices_.begin(), split_indices_.end());
+  split_indices_.clear();
   return OkStatus();
 }
 
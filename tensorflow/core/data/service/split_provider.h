@@ -33,16 +33,22 @@ namespace tensorflow {
 namespace data {
 
 // SplitProvider which reads splits from a tf.data service dispatcher over RPC.
+// `worker_address` is the address of the worker reading the splits, which
+// lets the dispatcher reassign them if the worker is lost. The splits of a
+// repetition are acknowledged to the dispatcher, with the next request, once
+// the provider is reset for the next repetition.
 class DataServiceSplitProvider : public SplitProvider {
  public:
   DataServiceSplitProvider(const std::string& address,
                            const std::string& protocol, int64_t iteration_id,
-                           int64_t split_provider_index, int64_t timeout_ms)
+                           int64_t split_provider_index, int64_t timeout_ms,
+                           const std::string& worker_address = "")
       : address_(address),
         protocol_(protocol),
         iteration_id_(iteration_id),
         split_provider_index_(split_provider_index),
-        timeout_ms_(timeout_ms) {}
+        timeout_ms_(timeout_ms),
+        worker_address_(worker_address) {}
 
   Status GetNext(Tensor* split, bool* end_of_splits) override;
   Status Reset() override;
@@ -57,9 +63,15 @@ class DataServiceSplitProvider : public SplitProvider {
   const int64_t iteration_id_;
   const int64_t split_provider_index_;
   const int64_t timeout_ms_;
+  const std::string worker_address_;
 
   mutex mu_;
   int64_t repetition_ TF_GUARDED_BY(mu_) = 0;
+  // Indices of the splits read in the current repetition.
+  std::vector<int64_t> split_indices_ TF_GUARDED_BY(mu_);
+  // Indices of the splits of earlier repetitions, to acknowledge with the
+  // next request.
+  std::vector<int64_t> acked_split_indices_ TF_GUARDED_BY(mu_);
   std::unique_ptr<DataServiceDispatcherClient> dispatcher_ TF_GUARDED_BY(mu_);
 };
 
@@ -201,9 +201,11 @@ void DataServiceWorkerImpl::Stop() {
   absl::flat_hash_map<SnapshotTask, std::unique_ptr<SnapshotStreamWriter>,
                       absl::Hash<SnapshotTask>>
       snapshot_writers;
+  bool registered = false;
   {
     mutex_lock l(mu_);
     cancelled_ = true;
+    registered = registered_;
     tasks.swap(tasks_);
     snapshot_writers.swap(snapshot_writers_);
   }
@@ -213,6 +215,21 @@ void DataServiceWorkerImpl::Stop() {
   for (const auto& [unused, snapshot_writer] : snapshot_writers) {
     snapshot_writer->Cancel();
   }
+  if (registered) {
+    // Tell the dispatcher that this worker is leaving, so that it doesn't wait
+    // for the worker's heartbeats to time out. This is best effort: if it
+    // fails, the dispatcher still finds out through the timeout.
+    WorkerHeartbeatRequest request;
+    request.set_worker_address(worker_address_);
+    request.set_shutting_down(true);
+    StatusOr<WorkerHeartbeatResponse> response =
+        dispatcher_->WorkerHeartbeat(request);
+    if (!response.ok()) {
+      LOG(WARNING) << "Failed to notify the dispatcher that worker "
+                   << worker_address_
+                   << " is shutting down: " << response.status();
+    }
+  }
   // At this point there are no outstanding requests in this RPC handler.
   // However, requests successfully returned from this RPC handler may still be
   // in progress within the gRPC server. If we shut down the gRPC server
@@ -448,7 +465,8 @@ DataServiceWorkerImpl::MakeDatasetIterator(standalone::Dataset& dataset,
     for (int i = 0; i < task_def.num_split_providers(); ++i) {
       split_providers.push_back(std::make_unique<DataServiceSplitProvider>(
           config_.dispatcher_address(), config_.protocol(),
-          task_def.iteration_id(), i, config_.dispatcher_timeout_ms()));
+          task_def.iteration_id(), i, config_.dispatcher_timeout_ms(),
+          worker_address_));
     }
     TF_RETURN_IF_ERROR(
         dataset.MakeIterator(std::move(split_providers), &iterator));
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
 
 #include "grpcpp/generic/generic_stub.h"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/shared_memory_transport.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
@@ -66,6 +69,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        lookuprows_(Method(GrpcWorkerMethod::kLookupRows)),
         logger_(logger),
         target_(target) {}
 
@@ -197,6 +201,12 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, getstepsequence_, std::move(done));
   }
 
+  void LookupRowsAsync(CallOptions* call_opts, const LookupRowsRequest* request,
+                       LookupRowsResponse* response,
+                       StatusCallback done) override {
+    IssueRequest(request, response, lookuprows_, std::move(done), call_opts);
+  }
+
   void RecvTensorAsync(CallOptions* call_opts, const RecvTensorRequest* request,
                        TensorResponse* response, StatusCallback done) override {
     VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
@@ -204,8 +214,29 @@ class GrpcRemoteWorker : public WorkerInterface {
     // Type-specialized logging for this method.
     bool logging_active = logger_->LoggingActive() || VLOG_IS_ON(2);
 
-    auto callback = [this, request, response, done, start_usec,
-                     logging_active](Status s) {
+    // Tasks on the same host can hand over large tensors through shared
+    // memory. The sender decides whether it actually does.
+    std::shared_ptr<RecvTensorRequest> shm_request;
+    if (use_shared_memory_.load(std::memory_order_relaxed) &&
+        response->on_host() && !request->has_transport_options()) {
+      shm_request = std::make_shared<RecvTensorRequest>(*request);
+      RequestSharedMemoryTransport(shm_request.get());
+    }
+
+    auto callback = [this, call_opts, request, response, done, start_usec,
+                     logging_active, shm_request](Status s) {
+      if (s.ok() && shm_request != nullptr) {
+        s = ReceiveTensorFromSharedMemory(response);
+        if (!s.ok()) {
+          LOG(WARNING) << "Disabling shared memory transport from " << target_
+                       << ": " << s;
+          use_shared_memory_.store(false, std::memory_order_relaxed);
+          // The sender keeps the tensor in its response cache until we ack,
+          // so asking again with the same request id gets it inline.
+          RecvTensorAsync(call_opts, request, response, done);
+          return;
+        }
+      }
       if (logging_active) {
         if (logger_->LoggingActive()) {
           int64_t end_usec = Env::Default()->NowMicros();
@@ -255,7 +286,8 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    IssueRequest(shm_request != nullptr ? shm_request.get() : request,
+                 response, recvtensor_, callback, call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -333,11 +365,16 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string lookuprows_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
   const string target_;
 
+  // Cleared if a tensor could not be received through shared memory, e.g.
+  // because the sender's segments are not visible to this process.
+  std::atomic<bool> use_shared_memory_{SharedMemoryTransportEnabled()};
+
   GrpcRemoteWorker(const GrpcRemoteWorker&) = delete;
   void operator=(const GrpcRemoteWorker&) = delete;
 };
@@ -17,6 +17,10 @@ limitations under the License.
 
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -100,4 +104,65 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+class CpuDevice : public DeviceBase {
+ public:
+  CpuDevice() : DeviceBase(Env::Default()) { attr_.set_device_type("CPU"); }
+
+  const DeviceAttributes& attributes() const override { return attr_; }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+ private:
+  DeviceAttributes attr_;
+};
+
+TEST_F(GrpcTensorCodingTest, ParseSharesAlignedSlices) {
+  CpuDevice cpu_device;
+  for (int64_t elems : {4, 4096}) {
+    Tensor t(DT_FLOAT, TensorShape({elems}));
+    test::FillFn<float>(&t, [](int i) { return i * 0.5f; });
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorToByteBuffer(false, t, false, &buf);
+
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    ASSERT_TRUE(GrpcMaybeParseTensorResponse(&buf, &response));
+    test::ExpectTensorEqual<float>(t, response.tensor());
+    // Large tensors are sent in their own slice, which the parsed tensor
+    // adopts. Small ones are copied.
+    EXPECT_EQ(elems == 4096,
+              response.tensor().tensor_data().data() == t.tensor_data().data());
+
+    // The parsed tensor keeps the shared bytes alive on its own.
+    Tensor expected(DT_FLOAT, TensorShape({elems}));
+    test::FillFn<float>(&expected, [](int i) { return i * 0.5f; });
+    buf.Clear();
+    t = Tensor();
+    test::ExpectTensorEqual<float>(expected, response.tensor());
+  }
+}
+
+TEST_F(GrpcTensorCodingTest, ParseCopiesForGpuOrNicCompatibleMemory) {
+  CpuDevice cpu_device;
+  Tensor t(DT_FLOAT, TensorShape({4096}));
+  test::FillFn<float>(&t, [](int i) { return i * 0.5f; });
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, false, &buf);
+  for (bool gpu : {false, true}) {
+    AllocatorAttributes attrs;
+    if (gpu) {
+      attrs.set_gpu_compatible(true);
+    } else {
+      attrs.set_nic_compatible(true);
+    }
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, attrs);
+    ASSERT_TRUE(GrpcMaybeParseTensorResponse(&buf, &response));
+    test::ExpectTensorEqual<float>(t, response.tensor());
+    EXPECT_NE(response.tensor().tensor_data().data(), t.tensor_data().data());
+  }
+}
+
 }  // namespace tensorflow
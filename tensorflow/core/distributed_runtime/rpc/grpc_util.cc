@@ -15,10 +15,63 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 
+#include <cstdint>
+
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 
 namespace tensorflow {
 
+namespace {
+
+// A TensorBuffer that points into a received gRPC slice, which it keeps
+// alive. The slice may be shared with other owners (in-process it can even be
+// the sender's tensor), so the buffer never claims to own its memory and ops
+// don't forward it for in-place updates.
+class GrpcSliceTensorBuffer : public TensorBuffer {
+ public:
+  GrpcSliceTensorBuffer(const grpc_slice& slice, const void* data, size_t size)
+      : TensorBuffer(const_cast<void*>(data)),
+        slice_(slice, ::grpc::Slice::ADD_REF),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  bool OwnsMemory() const override { return false; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("GrpcSlice");
+  }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t size_;
+};
+
+}  // namespace
+
+core::RefCountPtr<TensorBuffer> GrpcByteSource::ShareBuffer(const void* data,
+                                                            size_t num_bytes) {
+  if (stream_ == nullptr) return nullptr;
+  const grpc_slice* slice = stream_->current_slice();
+  // Inlined slices have no reference count to keep their bytes alive.
+  if (slice == nullptr || slice->refcount == nullptr) return nullptr;
+  const uint8_t* begin = GRPC_SLICE_START_PTR(*slice);
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  // The bytes must lie within the slice.
+  if (bytes < begin || bytes + num_bytes > begin + GRPC_SLICE_LENGTH(*slice)) {
+    return nullptr;
+  }
+#if EIGEN_MAX_ALIGN_BYTES > 0
+  if (reinterpret_cast<uintptr_t>(bytes) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return nullptr;
+  }
+#endif
+  return core::RefCountPtr<TensorBuffer>(
+      new GrpcSliceTensorBuffer(*slice, data, num_bytes));
+}
+
 bool GrpcMaybeParseTensorResponse(::grpc::ByteBuffer* src,
                                   TensorResponse* dst) {
   ::tensorflow::GrpcByteSource byte_source(src);
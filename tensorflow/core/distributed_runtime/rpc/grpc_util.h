@@ -42,7 +42,22 @@ class GrpcByteSource : public TensorResponse::Source {
   explicit GrpcByteSource(::grpc::ByteBuffer* buffer) : buffer_(buffer) {}
   ~GrpcByteSource() override { DeleteStream(); }
 
-  typedef ::grpc::ProtoBufferReader Reader;
+  // Exposes the slice that the last call to Next() returned data from.
+  class Reader : public ::grpc::ProtoBufferReader {
+   public:
+    using ::grpc::ProtoBufferReader::ProtoBufferReader;
+
+    bool Next(const void** data, int* size) override {
+      if (!::grpc::ProtoBufferReader::Next(data, size)) return false;
+      has_slice_ = true;
+      return true;
+    }
+
+    const grpc_slice* current_slice() { return has_slice_ ? slice() : nullptr; }
+
+   private:
+    bool has_slice_ = false;
+  };
 
   protobuf::io::ZeroCopyInputStream* contents() override {
     DeleteStream();
@@ -50,6 +65,12 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the bytes if they lie within the slice the contents stream is
+  // reading and are suitably aligned. The returned buffer holds a reference
+  // to that slice.
+  core::RefCountPtr<TensorBuffer> ShareBuffer(const void* data,
+                                              size_t num_bytes) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/rpc_response_cache.h"
+#include "tensorflow/core/distributed_runtime/rpc/shared_memory_transport.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -148,6 +149,7 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
+    SETUP_FOR_REQUEST(LookupRows, 100, false);
 
     // TODO(ncteisen): Determine a better policy for enqueuing the
     // appropriate number of each request type.
@@ -239,6 +241,21 @@ class GrpcWorkerServiceThread {
     ENQUEUE_REQUEST(MarkRecvFinished, false);
   }
 
+  void LookupRowsHandler(
+      WorkerCall<LookupRowsRequest, LookupRowsResponse>* call) {
+    Schedule([this, call]() {
+      worker_->LookupRowsAsync(
+          /*opts=*/nullptr, &call->request, &call->response,
+          [call](const Status& s) {
+            if (!s.ok()) {
+              VLOG(3) << "Bad response from LookupRows:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    ENQUEUE_REQUEST(LookupRows, false);
+  }
+
   void RunGraphHandler(WorkerCall<RunGraphRequest, RunGraphResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -447,11 +464,24 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  SharedMemorySegments* shm_segments = &shm_segments_;
+  auto do_response = [request, response, done, cache_enabled, shm_segments](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      // Shared memory needs the response cache: a receiver that can't map
+      // the segment asks again, and gets the cached tensor inline.
+      RecvTensorResponse shm_response;
+      if (cache_enabled && !is_dead &&
+          MaybeSendTensorThroughSharedMemory(*request, tensor, shm_segments,
+                                             &shm_response)) {
+        shm_response.set_send_start_micros(Env::Default()->NowMicros());
+        shm_response.set_require_ack(true);
+        grpc::EncodeRecvTensorResponseToByteBuffer(shm_response, response);
+      } else {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
     }
     done(status);
   };
@@ -22,6 +22,7 @@ limitations under the License.
 #include "grpcpp/server_builder.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/rpc_response_cache.h"
+#include "tensorflow/core/distributed_runtime/rpc/shared_memory_transport.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 #include "tsl/distributed_runtime/rpc/async_service_interface.h"
@@ -69,6 +70,9 @@ class GrpcWorker : public Worker {
 
  private:
   std::unique_ptr<RpcResponseCache> response_cache_;
+  // Segments sent through shared memory that no receiver picked up yet.
+  // Destroying the worker unlinks them.
+  SharedMemorySegments shm_segments_;
   const int32 recv_buf_max_chunk_;
 };
 
@@ -60,6 +60,8 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/GetStepSequence";
     case GrpcWorkerMethod::kMarkRecvFinished:
       return "/tensorflow.WorkerService/MarkRecvFinished";
+    case GrpcWorkerMethod::kLookupRows:
+      return "/tensorflow.WorkerService/LookupRows";
   }
   // Shouldn't be reached.
   LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
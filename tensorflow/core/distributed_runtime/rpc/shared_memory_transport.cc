@@ -0,0 +1,294 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/shared_memory_transport.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/str_util.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Segments not picked up within this time (e.g. because the RPC failed or
+// the receiver died) are unlinked by the sender.
+constexpr int64_t kSegmentTimeoutMicros = 60 * 1000 * 1000;
+
+#if defined(__linux__)
+
+// Tensors smaller than this are cheaper to send inline than to create, map
+// and unlink a segment for.
+int64_t SharedMemoryMinBytes() {
+  static const int64_t min_bytes = [] {
+    int64_t value;
+    const Status s = ReadInt64FromEnvVar("TF_GRPC_SHARED_MEMORY_MIN_BYTES",
+                                         64 << 10, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << "Not sending tensors through shared memory: " << s;
+      return std::numeric_limits<int64_t>::max();
+    }
+    return value;
+  }();
+  return min_bytes;
+}
+
+// A tensor buffer backed by a shared memory mapping that only this process
+// can still reach, since the segment was unlinked on receipt.
+class SharedMemoryTensorBuffer : public TensorBuffer {
+ public:
+  SharedMemoryTensorBuffer(void* data, size_t size)
+      : TensorBuffer(data), size_(size) {}
+  ~SharedMemoryTensorBuffer() override { munmap(data(), size_); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("SharedMemory");
+  }
+
+ private:
+  const size_t size_;
+};
+
+string ComputeHostId() {
+  string boot_id;
+  if (!ReadFileToString(Env::Default(), "/proc/sys/kernel/random/boot_id",
+                        &boot_id)
+           .ok()) {
+    return "";
+  }
+  // shm_open() names live in the tmpfs mounted at /dev/shm, which may differ
+  // between containers on the same machine.
+  struct stat st;
+  if (stat("/dev/shm", &st) != 0) return "";
+  return strings::StrCat(str_util::StripTrailingWhitespace(boot_id), ":",
+                         st.st_dev, ":", st.st_ino);
+}
+
+// Writes `data` through the file descriptor rather than a mapping: a full
+// /dev/shm then fails the write with ENOSPC instead of raising SIGBUS.
+Status WriteSegment(const string& name, StringPiece data) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return errors::Unavailable("shm_open(", name,
+                               ") failed: ", strerror(errno));
+  }
+  Status s;
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n = write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      s = errors::Unavailable("write(", name, ") failed: ", strerror(errno));
+      break;
+    }
+    written += n;
+  }
+  close(fd);
+  if (!s.ok()) shm_unlink(name.c_str());
+  return s;
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace
+
+SharedMemorySegments::~SharedMemorySegments() {
+  std::unique_ptr<Thread> thread;
+  {
+    mutex_lock l(mu_);
+    shutdown_ = true;
+    cond_.notify_all();
+    thread = std::move(thread_);
+  }
+  // Joins the thread.
+  thread.reset();
+  UnlinkAll();
+}
+
+void SharedMemorySegments::Add(string name) {
+  const uint64 now = Env::Default()->NowMicros();
+  mutex_lock l(mu_);
+  segments_.emplace_back(now, std::move(name));
+  if (thread_ == nullptr && !shutdown_) {
+    thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "shm_segment_janitor", [this]() { Run(); }));
+  }
+}
+
+void SharedMemorySegments::UnlinkAll() {
+  mutex_lock l(mu_);
+#if defined(__linux__)
+  for (const auto& segment : segments_) {
+    shm_unlink(segment.second.c_str());
+  }
+#endif  // defined(__linux__)
+  segments_.clear();
+}
+
+void SharedMemorySegments::Run() {
+  mutex_lock l(mu_);
+  while (!shutdown_) {
+#if defined(__linux__)
+    const uint64 now = Env::Default()->NowMicros();
+    while (!segments_.empty() &&
+           segments_.front().first + kSegmentTimeoutMicros < now) {
+      shm_unlink(segments_.front().second.c_str());
+      segments_.pop_front();
+    }
+#endif  // defined(__linux__)
+    cond_.wait_for(l, std::chrono::microseconds(kSegmentTimeoutMicros / 2));
+  }
+}
+
+bool SharedMemoryTransportEnabled() {
+  static const bool enabled = [] {
+    bool value;
+    const Status s =
+        ReadBoolFromEnvVar("TF_GRPC_SHARED_MEMORY_TRANSPORT", false, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << "Disabling shared memory transport: " << s;
+      return false;
+    }
+    return value && !SharedMemoryHostId().empty();
+  }();
+  return enabled;
+}
+
+const string& SharedMemoryHostId() {
+#if defined(__linux__)
+  static const string* host_id = new string(ComputeHostId());
+#else
+  static const string* host_id = new string;
+#endif  // defined(__linux__)
+  return *host_id;
+}
+
+void RequestSharedMemoryTransport(RecvTensorRequest* request) {
+  SharedMemoryRecvTensorOptions options;
+  options.set_host_id(SharedMemoryHostId());
+  request->mutable_transport_options()->PackFrom(options);
+}
+
+bool MaybeSendTensorThroughSharedMemory(const RecvTensorRequest& request,
+                                        const Tensor& val,
+                                        SharedMemorySegments* segments,
+                                        RecvTensorResponse* response) {
+#if defined(__linux__)
+  if (!request.has_transport_options() ||
+      !DataTypeCanUseMemcpy(val.dtype()) || val.TotalBytes() == 0 ||
+      static_cast<int64_t>(val.TotalBytes()) < SharedMemoryMinBytes()) {
+    return false;
+  }
+  SharedMemoryRecvTensorOptions options;
+  if (!request.transport_options().UnpackTo(&options) ||
+      options.host_id().empty() || options.host_id() != SharedMemoryHostId()) {
+    return false;
+  }
+  static std::atomic<int64_t> next_segment{0};
+  const string name = strings::StrCat("/tf_recv_", getpid(), "_",
+                                      next_segment.fetch_add(1));
+  Status s = WriteSegment(name, val.tensor_data());
+  if (!s.ok()) {
+    LOG_EVERY_N(WARNING, 1000)
+        << "Sending tensor over gRPC instead of shared memory: " << s;
+    return false;
+  }
+  segments->Add(name);
+
+  TensorProto* tensor = response->mutable_tensor();
+  tensor->set_dtype(val.dtype());
+  val.shape().AsProto(tensor->mutable_tensor_shape());
+  SharedMemoryTensorContent content;
+  content.set_name(name);
+  content.set_size(val.TotalBytes());
+  response->mutable_transport_options()->PackFrom(content);
+  return true;
+#else
+  return false;
+#endif  // defined(__linux__)
+}
+
+Status ReceiveTensorFromSharedMemory(TensorResponse* response) {
+  const RecvTensorResponse& meta = response->metadata();
+  if (!meta.has_transport_options() ||
+      !meta.transport_options().Is<SharedMemoryTensorContent>()) {
+    return OkStatus();
+  }
+  SharedMemoryTensorContent content;
+  if (!meta.transport_options().UnpackTo(&content)) {
+    return errors::Internal("Cannot parse shared memory transport options");
+  }
+  const Tensor& skeleton = response->tensor();
+  if (!DataTypeCanUseMemcpy(skeleton.dtype()) ||
+      content.size() != static_cast<int64_t>(skeleton.shape().num_elements() *
+                                             DataTypeSize(skeleton.dtype()))) {
+    return errors::Internal("Shared memory segment ", content.name(),
+                            " does not match the received tensor");
+  }
+#if defined(__linux__)
+  int fd = shm_open(content.name().c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return errors::Unavailable("Cannot open shared memory segment ",
+                               content.name(), ": ", strerror(errno));
+  }
+  // The mapping keeps the memory alive; nobody else needs the name.
+  shm_unlink(content.name().c_str());
+  struct stat st;
+  void* addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size == content.size()) {
+    addr = mmap(nullptr, content.size(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+  }
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return errors::Unavailable("Cannot map shared memory segment ",
+                               content.name());
+  }
+  core::RefCountPtr<TensorBuffer> buffer(
+      new SharedMemoryTensorBuffer(addr, content.size()));
+  response->set_tensor(
+      Tensor(skeleton.dtype(), skeleton.shape(), std::move(buffer)));
+  return OkStatus();
+#else
+  return errors::Unimplemented("Shared memory transport is not supported");
+#endif  // defined(__linux__)
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,106 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_SHARED_MEMORY_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_SHARED_MEMORY_TRANSPORT_H_
+
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+// Shared memory transport for RecvTensor between tasks on the same host.
+//
+// Loopback gRPC copies every tensor through the kernel's socket buffers and
+// is limited by the TCP stack rather than memory bandwidth. When enabled
+// (TF_GRPC_SHARED_MEMORY_TRANSPORT=1 on the receiving task), the receiver
+// advertises in RecvTensorRequest.transport_options that it can read shared
+// memory. A sender on the same host then writes large POD tensors into a
+// POSIX shared memory segment and only returns the tensor metadata and the
+// segment name over gRPC. The receiver maps the segment and adopts it as the
+// tensor buffer, so the contents are copied once in total.
+//
+// The RPC itself still carries the request and signals completion, and any
+// tensor that doesn't qualify (small, non-POD, dead, or requested from another
+// host) is sent over gRPC as before. The sender only uses shared memory if it
+// caches RecvTensor responses (RPCOptions.cache_rpc_response): a receiver
+// that can't read a segment then asks for the tensor again without shared
+// memory and gets it inline from the cache.
+namespace tensorflow {
+
+// The shared memory segments one sender created that no receiver consumed
+// yet. A background thread unlinks the ones that are older than 60s, and the
+// rest are unlinked by UnlinkAll() and on destruction. Unlinking a segment
+// that the receiver already consumed is a no-op. Thread-safe.
+class SharedMemorySegments {
+ public:
+  SharedMemorySegments() = default;
+  ~SharedMemorySegments();
+
+  SharedMemorySegments(const SharedMemorySegments&) = delete;
+  SharedMemorySegments& operator=(const SharedMemorySegments&) = delete;
+
+  void Add(string name);
+  void UnlinkAll();
+
+ private:
+  void Run();
+
+  mutex mu_;
+  condition_variable cond_;
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+  // Creation time in microseconds and name, oldest first.
+  std::deque<std::pair<uint64, string>> segments_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<Thread> thread_ TF_GUARDED_BY(mu_);
+};
+
+// Returns true if the receiving side of this process should request shared
+// memory transport (TF_GRPC_SHARED_MEMORY_TRANSPORT).
+bool SharedMemoryTransportEnabled();
+
+// Returns an identifier of the shared memory filesystem visible to this
+// process. Two processes with the same id can exchange segments by name.
+// Returns an empty string if shared memory is unsupported.
+const string& SharedMemoryHostId();
+
+// Asks the sender of `request` to use shared memory if possible.
+void RequestSharedMemoryTransport(RecvTensorRequest* request);
+
+// Writes the contents of `val` into a new shared memory segment if `request`
+// asked for it from this host and `val` is a large enough POD tensor. On
+// success adds the segment to `segments`, sets the tensor metadata and
+// transport options of `response` and returns true. Returns false if the
+// tensor must be sent inline.
+bool MaybeSendTensorThroughSharedMemory(const RecvTensorRequest& request,
+                                        const Tensor& val,
+                                        SharedMemorySegments* segments,
+                                        RecvTensorResponse* response);
+
+// If the metadata of `response` refers to a shared memory segment, maps the
+// segment, makes it the tensor buffer of `response` and unlinks it. Does
+// nothing if the tensor was sent inline.
+Status ReceiveTensorFromSharedMemory(TensorResponse* response);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_SHARED_MEMORY_TRANSPORT_H_
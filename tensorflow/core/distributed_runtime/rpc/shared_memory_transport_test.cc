@@ -0,0 +1,160 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/shared_memory_transport.h"
+
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+namespace {
+
+class CpuDevice : public DeviceBase {
+ public:
+  CpuDevice() : DeviceBase(Env::Default()) { attr_.set_device_type("CPU"); }
+
+  const DeviceAttributes& attributes() const override { return attr_; }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+ private:
+  DeviceAttributes attr_;
+};
+
+class SharedMemoryTransportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (SharedMemoryHostId().empty()) {
+      GTEST_SKIP() << "Shared memory is not supported";
+    }
+  }
+
+  // Parses `proto` the way the receiving worker would.
+  Status Receive(RecvTensorResponse proto, TensorResponse* response) {
+    response->InitAlloc(&cpu_device_, AllocatorAttributes());
+    TF_RETURN_IF_ERROR(response->InitFrom(&proto));
+    return ReceiveTensorFromSharedMemory(response);
+  }
+
+  CpuDevice cpu_device_;
+  SharedMemorySegments segments_;
+};
+
+TEST_F(SharedMemoryTransportTest, RoundTrip) {
+  Tensor t(DT_FLOAT, TensorShape({64, 1024}));
+  test::FillFn<float>(&t, [](int i) { return i * 0.5f; });
+  RecvTensorRequest request;
+  RequestSharedMemoryTransport(&request);
+
+  RecvTensorResponse proto;
+  ASSERT_TRUE(
+      MaybeSendTensorThroughSharedMemory(request, t, &segments_, &proto));
+  EXPECT_TRUE(proto.tensor().tensor_content().empty());
+  SharedMemoryTensorContent content;
+  ASSERT_TRUE(proto.transport_options().UnpackTo(&content));
+  EXPECT_EQ(t.TotalBytes(), content.size());
+
+  TensorResponse response;
+  TF_ASSERT_OK(Receive(proto, &response));
+  test::ExpectTensorEqual<float>(t, response.tensor());
+
+  // The receiver consumed the segment.
+  TensorResponse again;
+  EXPECT_FALSE(Receive(proto, &again).ok());
+}
+
+TEST_F(SharedMemoryTransportTest, UnlinkPendingSegments) {
+  Tensor t(DT_FLOAT, TensorShape({64, 1024}));
+  test::FillFn<float>(&t, [](int i) { return i; });
+  RecvTensorRequest request;
+  RequestSharedMemoryTransport(&request);
+  RecvTensorResponse proto;
+  ASSERT_TRUE(
+      MaybeSendTensorThroughSharedMemory(request, t, &segments_, &proto));
+
+  segments_.UnlinkAll();
+  // The receiver then has to ask for the tensor again.
+  TensorResponse response;
+  EXPECT_TRUE(errors::IsUnavailable(Receive(proto, &response)));
+}
+
+TEST_F(SharedMemoryTransportTest, SendersUnlinkOnlyTheirOwnSegments) {
+  Tensor t(DT_FLOAT, TensorShape({64, 1024}));
+  test::FillFn<float>(&t, [](int i) { return i; });
+  RecvTensorRequest request;
+  RequestSharedMemoryTransport(&request);
+  RecvTensorResponse kept;
+  ASSERT_TRUE(
+      MaybeSendTensorThroughSharedMemory(request, t, &segments_, &kept));
+  RecvTensorResponse dropped;
+  {
+    SharedMemorySegments other;
+    ASSERT_TRUE(
+        MaybeSendTensorThroughSharedMemory(request, t, &other, &dropped));
+  }
+
+  TensorResponse response;
+  EXPECT_TRUE(errors::IsUnavailable(Receive(dropped, &response)));
+  TF_ASSERT_OK(Receive(kept, &response));
+  test::ExpectTensorEqual<float>(t, response.tensor());
+}
+
+TEST_F(SharedMemoryTransportTest, SendsInline) {
+  Tensor large(DT_FLOAT, TensorShape({64, 1024}));
+  test::FillFn<float>(&large, [](int i) { return i; });
+  RecvTensorRequest request;
+  RecvTensorResponse proto;
+  // Not requested.
+  EXPECT_FALSE(MaybeSendTensorThroughSharedMemory(request, large, &segments_,
+                                                  &proto));
+
+  // Requested from another host.
+  SharedMemoryRecvTensorOptions options;
+  options.set_host_id("elsewhere");
+  request.mutable_transport_options()->PackFrom(options);
+  EXPECT_FALSE(MaybeSendTensorThroughSharedMemory(request, large, &segments_,
+                                                  &proto));
+
+  // Too small or not POD.
+  RequestSharedMemoryTransport(&request);
+  EXPECT_FALSE(MaybeSendTensorThroughSharedMemory(
+      request, test::AsTensor<float>({1, 2, 3}), &segments_, &proto));
+  Tensor strings(DT_STRING, TensorShape({64, 1024}));
+  EXPECT_FALSE(MaybeSendTensorThroughSharedMemory(request, strings, &segments_,
+                                                  &proto));
+  EXPECT_FALSE(proto.has_transport_options());
+}
+
+TEST_F(SharedMemoryTransportTest, InlineResponseIsUnchanged) {
+  Tensor t = test::AsTensor<int32>({1, 2, 3, 4});
+  RecvTensorResponse proto;
+  t.AsProtoTensorContent(proto.mutable_tensor());
+  TensorResponse response;
+  TF_ASSERT_OK(Receive(proto, &response));
+  test::ExpectTensorEqual<int32>(t, response.tensor());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,305 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/sharded_row_lookup.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+struct ShardedRowLookup::LookupState {
+  int64_t version;
+  Tensor* rows;
+  StatusCallback done;
+
+  // Distinct ids of the lookup, and for every requested id the index of its
+  // distinct id.
+  std::vector<int64_t> unique_ids;
+  std::vector<int> slots;
+  // Rows of the distinct ids, each of shape [1] + row shape.
+  std::vector<Tensor> unique_rows;
+
+  // Per shard: the request, the response, the received rows, and the index
+  // of the distinct id each requested row belongs to.
+  std::vector<LookupRowsRequest> requests;
+  std::vector<LookupRowsResponse> responses;
+  std::vector<Tensor> shard_rows;
+  std::vector<std::vector<int>> request_slots;
+
+  std::atomic<int> pending{0};
+  mutex mu;
+  Status status TF_GUARDED_BY(mu);
+};
+
+ShardedRowLookup::ShardedRowLookup(WorkerCacheInterface* worker_cache,
+                                   std::vector<Shard> shards, Options options)
+    : worker_cache_(worker_cache),
+      shards_(std::move(shards)),
+      options_(std::move(options)) {
+  shard_starts_.reserve(shards_.size() + 1);
+  int64_t start = 0;
+  for (const Shard& shard : shards_) {
+    shard_starts_.push_back(start);
+    start += shard.num_rows;
+  }
+  shard_starts_.push_back(start);
+}
+
+Status ShardedRowLookup::Locate(int64_t id, int* shard, int64_t* row) const {
+  const int num_shards = shards_.size();
+  if (id >= 0 && options_.strategy == PartitionStrategy::kMod) {
+    *shard = id % num_shards;
+    *row = id / num_shards;
+    if (*row < shards_[*shard].num_rows) return OkStatus();
+  } else if (id >= 0 && id < shard_starts_.back()) {
+    *shard = std::upper_bound(shard_starts_.begin(), shard_starts_.end(), id) -
+             shard_starts_.begin() - 1;
+    *row = id - shard_starts_[*shard];
+    return OkStatus();
+  }
+  return errors::InvalidArgument("Id ", id, " is not in [0, ",
+                                 shard_starts_.back(), ")");
+}
+
+bool ShardedRowLookup::CacheLookup(int64_t id, int64_t version, Tensor* row) {
+  mutex_lock l(mu_);
+  auto it = cache_.find({id, version});
+  if (it == cache_.end()) {
+    ++cache_misses_;
+    return false;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second);
+  *row = it->second->row;
+  ++cache_hits_;
+  return true;
+}
+
+void ShardedRowLookup::CacheInsert(int64_t id, int64_t version,
+                                   const Tensor& row) {
+  mutex_lock l(mu_);
+  auto it = cache_.find({id, version});
+  if (it != cache_.end()) {
+    lru_.erase(it->second);
+    cache_.erase(it);
+  }
+  lru_.push_front(CacheEntry{id, version, row});
+  cache_[{id, version}] = lru_.begin();
+  while (static_cast<int64_t>(lru_.size()) > options_.cache_capacity) {
+    cache_.erase({lru_.back().id, lru_.back().version});
+    lru_.pop_back();
+  }
+}
+
+int64_t ShardedRowLookup::cache_hits() const {
+  mutex_lock l(mu_);
+  return cache_hits_;
+}
+
+int64_t ShardedRowLookup::cache_misses() const {
+  mutex_lock l(mu_);
+  return cache_misses_;
+}
+
+void ShardedRowLookup::LookupAsync(const std::vector<int64_t>& ids,
+                                   int64_t version, Tensor* rows,
+                                   StatusCallback done) {
+  if (shards_.empty()) {
+    done(errors::InvalidArgument("ShardedRowLookup has no shards"));
+    return;
+  }
+  auto* state = new LookupState;
+  state->version = version;
+  state->rows = rows;
+  state->done = std::move(done);
+
+  absl::flat_hash_map<int64_t, int> slot_of_id;
+  state->slots.reserve(ids.size());
+  for (int64_t id : ids) {
+    auto [it, inserted] = slot_of_id.try_emplace(id, state->unique_ids.size());
+    if (inserted) state->unique_ids.push_back(id);
+    state->slots.push_back(it->second);
+  }
+
+  const int num_unique = state->unique_ids.size();
+  state->unique_rows.resize(num_unique);
+  state->requests.resize(shards_.size());
+  state->responses.resize(shards_.size());
+  state->shard_rows.resize(shards_.size());
+  state->request_slots.resize(shards_.size());
+  for (int slot = 0; slot < num_unique; ++slot) {
+    const int64_t id = state->unique_ids[slot];
+    if (options_.cache_capacity > 0 &&
+        CacheLookup(id, version, &state->unique_rows[slot])) {
+      continue;
+    }
+    int shard;
+    int64_t row;
+    Status s = Locate(id, &shard, &row);
+    if (!s.ok()) {
+      state->done(s);
+      delete state;
+      return;
+    }
+    state->requests[shard].add_ids(row);
+    state->request_slots[shard].push_back(slot);
+  }
+
+  std::vector<int> shards_to_call;
+  for (int i = 0; i < static_cast<int>(shards_.size()); ++i) {
+    if (!state->request_slots[i].empty()) shards_to_call.push_back(i);
+  }
+  if (num_unique == 0) {
+    // Nothing to look up, but the dtype and row shape of the output still
+    // have to come from somewhere.
+    shards_to_call.push_back(0);
+  }
+  if (shards_to_call.empty()) {
+    Finish(state);
+    return;
+  }
+  state->pending = shards_to_call.size();
+  for (int shard : shards_to_call) {
+    IssueRequest(state, shard);
+  }
+}
+
+Status ShardedRowLookup::Lookup(const std::vector<int64_t>& ids,
+                                int64_t version, Tensor* rows) {
+  Status status;
+  Notification n;
+  LookupAsync(ids, version, rows, [&status, &n](const Status& s) {
+    status = s;
+    n.Notify();
+  });
+  n.WaitForNotification();
+  return status;
+}
+
+void ShardedRowLookup::IssueRequest(LookupState* state, int shard) {
+  const Shard& target = shards_[shard];
+  LookupRowsRequest* request = &state->requests[shard];
+  request->set_session_handle(options_.session_handle);
+  request->set_device(target.device);
+  request->set_container(target.container);
+  request->set_var_name(target.var_name);
+
+  auto on_done = [this, state, shard](const Status& s) {
+    Status status = s;
+    if (status.ok()) status = ReceiveRows(state, shard);
+    if (!status.ok()) {
+      mutex_lock l(state->mu);
+      state->status.Update(status);
+    }
+    if (state->pending.fetch_sub(1) == 1) Finish(state);
+  };
+  WorkerInterface* worker = worker_cache_->GetOrCreateWorker(target.task);
+  if (worker == nullptr) {
+    on_done(errors::Internal("No worker known as ", target.task));
+    return;
+  }
+  worker->LookupRowsAsync(
+      /*opts=*/nullptr, request, &state->responses[shard],
+      [this, worker, task = target.task, on_done](const Status& s) {
+        worker_cache_->ReleaseWorker(task, worker);
+        on_done(s);
+      });
+}
+
+Status ShardedRowLookup::ReceiveRows(LookupState* state, int shard) {
+  Tensor& rows = state->shard_rows[shard];
+  if (!rows.FromProto(state->responses[shard].rows())) {
+    return errors::Internal("Cannot parse the rows received from ",
+                            shards_[shard].task);
+  }
+  const std::vector<int>& slots = state->request_slots[shard];
+  const int num_rows = slots.size();
+  if (rows.dims() < 1 || rows.dim_size(0) != num_rows) {
+    return errors::Internal(shards_[shard].task, " returned rows of shape ",
+                            rows.shape().DebugString(), " for ", num_rows,
+                            " ids");
+  }
+  for (int i = 0; i < num_rows; ++i) {
+    Tensor row = rows.Slice(i, i + 1);
+    state->unique_rows[slots[i]] = row;
+    if (options_.cache_capacity > 0) {
+      // Copy, so that the cache does not pin the whole response.
+      CacheInsert(state->unique_ids[slots[i]], state->version,
+                  tensor::DeepCopy(row));
+    }
+  }
+  return OkStatus();
+}
+
+void ShardedRowLookup::Finish(LookupState* state) {
+  Status s;
+  {
+    mutex_lock l(state->mu);
+    s = state->status;
+  }
+  if (s.ok()) s = Assemble(state);
+  state->done(s);
+  delete state;
+}
+
+Status ShardedRowLookup::Assemble(LookupState* state) {
+  const Tensor* first = nullptr;
+  if (!state->unique_rows.empty()) {
+    first = &state->unique_rows[0];
+  } else {
+    for (const Tensor& rows : state->shard_rows) {
+      if (rows.dims() >= 1) first = &rows;
+    }
+  }
+  if (first == nullptr) return errors::Internal("No rows were received");
+  const DataType dtype = first->dtype();
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    return errors::Unimplemented("Cannot look up rows of type ",
+                                 DataTypeString(dtype));
+  }
+  TensorShape row_shape = first->shape();
+  row_shape.RemoveDim(0);
+  TensorShape one_row({1});
+  one_row.AppendShape(row_shape);
+  TensorShape shape({static_cast<int64_t>(state->slots.size())});
+  shape.AppendShape(row_shape);
+
+  *state->rows = Tensor(dtype, shape);
+  const size_t row_bytes = row_shape.num_elements() * DataTypeSize(dtype);
+  char* dst = static_cast<char*>(state->rows->data());
+  for (const Tensor& row : state->unique_rows) {
+    if (row.dtype() != dtype || row.shape() != one_row) {
+      return errors::Internal("Shards disagree on the type or shape of rows: ",
+                              DataTypeString(row.dtype()),
+                              row.shape().DebugString(), " vs. ",
+                              DataTypeString(dtype), one_row.DebugString());
+    }
+  }
+  for (int slot : state->slots) {
+    memcpy(dst, state->unique_rows[slot].tensor_data().data(), row_bytes);
+    dst += row_bytes;
+  }
+  return OkStatus();
+}
+
+}  // namespace tensorflow
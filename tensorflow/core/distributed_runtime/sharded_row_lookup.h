@@ -0,0 +1,131 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARDED_ROW_LOOKUP_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARDED_ROW_LOOKUP_H_
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Looks up rows of a variable whose first dimension is partitioned across
+// parameter server tasks, e.g. an embedding table, with the LookupRows RPC.
+//
+// The ids of a lookup are deduplicated and grouped by shard, so each lookup
+// sends at most one RPC per shard and transfers every row once. Rows can
+// also be kept in an LRU cache. Cached rows are keyed by id and by the
+// version the caller passes to Lookup() (e.g. the version of the model being
+// served), so changing the version after the variable was updated
+// invalidates the cache. Rows of different versions are cached side by side,
+// so lookups that alternate between versions don't evict each other's rows;
+// rows of versions no longer used age out of the LRU.
+class ShardedRowLookup {
+ public:
+  // One partition of the variable.
+  struct Shard {
+    // Worker holding the partition, e.g. "/job:ps/replica:0/task:0".
+    string task;
+    // Device, resource container and shared name of the partition.
+    string device;
+    string container;
+    string var_name;
+    // Size of the first dimension of the partition.
+    int64_t num_rows = 0;
+  };
+
+  // How ids map to shards, as in tf.nn.embedding_lookup().
+  enum class PartitionStrategy {
+    // Id i is row i / num_shards of shard i % num_shards.
+    kMod,
+    // The shards hold consecutive ranges of ids, in order.
+    kDiv,
+  };
+
+  struct Options {
+    // Session the variables belong to. Empty for the legacy session.
+    string session_handle;
+    PartitionStrategy strategy = PartitionStrategy::kDiv;
+    // Maximum number of rows kept in the cache. 0 disables caching.
+    int64_t cache_capacity = 0;
+  };
+
+  // `worker_cache` must outlive this object.
+  ShardedRowLookup(WorkerCacheInterface* worker_cache,
+                   std::vector<Shard> shards, Options options);
+
+  // Sets `*rows` to the rows for `ids`. Its shape is the row shape of the
+  // variable with a leading dimension of ids.size().
+  void LookupAsync(const std::vector<int64_t>& ids, int64_t version,
+                   Tensor* rows, StatusCallback done);
+  Status Lookup(const std::vector<int64_t>& ids, int64_t version,
+                Tensor* rows);
+
+  int64_t cache_hits() const;
+  int64_t cache_misses() const;
+
+ private:
+  struct LookupState;
+  struct CacheEntry {
+    int64_t id;
+    int64_t version;
+    Tensor row;  // Shape [1] + row shape.
+  };
+
+  // Returns the shard holding `id` and the row of `id` within it.
+  Status Locate(int64_t id, int* shard, int64_t* row) const;
+
+  bool CacheLookup(int64_t id, int64_t version, Tensor* row);
+  void CacheInsert(int64_t id, int64_t version, const Tensor& row);
+
+  void IssueRequest(LookupState* state, int shard);
+  // Hands the rows received from `shard` to the lookup and the cache.
+  Status ReceiveRows(LookupState* state, int shard);
+  // Copies the rows into the output and runs the callback.
+  static void Finish(LookupState* state);
+  static Status Assemble(LookupState* state);
+
+  WorkerCacheInterface* const worker_cache_;  // Not owned.
+  const std::vector<Shard> shards_;
+  const Options options_;
+  // For kDiv, the first id of every shard, plus the total number of rows.
+  std::vector<int64_t> shard_starts_;
+
+  mutable mutex mu_;
+  // Most recently used entries first.
+  std::list<CacheEntry> lru_ TF_GUARDED_BY(mu_);
+  // Keyed by (id, version).
+  absl::flat_hash_map<std::pair<int64_t, int64_t>,
+                      std::list<CacheEntry>::iterator>
+      cache_ TF_GUARDED_BY(mu_);
+  int64_t cache_hits_ TF_GUARDED_BY(mu_) = 0;
+  int64_t cache_misses_ TF_GUARDED_BY(mu_) = 0;
+
+  ShardedRowLookup(const ShardedRowLookup&) = delete;
+  void operator=(const ShardedRowLookup&) = delete;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARDED_ROW_LOOKUP_H_
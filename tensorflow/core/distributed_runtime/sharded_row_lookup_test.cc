@@ -0,0 +1,237 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/sharded_row_lookup.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kDim = 3;
+
+// Serves the rows of a [num_rows, kDim] table where row r of the shard that
+// holds global ids `ids` is filled with ids[r].
+class FakeShardWorker : public TestWorkerInterface {
+ public:
+  explicit FakeShardWorker(std::vector<int64_t> ids) : ids_(std::move(ids)) {}
+
+  void LookupRowsAsync(CallOptions* opts, const LookupRowsRequest* request,
+                       LookupRowsResponse* response,
+                       StatusCallback done) override {
+    ++num_requests_;
+    Tensor rows(DT_FLOAT, TensorShape({request->ids_size(), kDim}));
+    for (int i = 0; i < request->ids_size(); ++i) {
+      const int64_t row = request->ids(i);
+      if (row < 0 || row >= static_cast<int64_t>(ids_.size())) {
+        done(errors::InvalidArgument("Bad row ", row));
+        return;
+      }
+      requested_rows_.push_back(row);
+      for (int j = 0; j < kDim; ++j) {
+        rows.matrix<float>()(i, j) = ids_[row];
+      }
+    }
+    rows.AsProtoTensorContent(response->mutable_rows());
+    done(OkStatus());
+  }
+
+  int num_requests() const { return num_requests_; }
+  const std::vector<int64_t>& requested_rows() const { return requested_rows_; }
+
+ private:
+  const std::vector<int64_t> ids_;
+  int num_requests_ = 0;
+  std::vector<int64_t> requested_rows_;
+};
+
+class ShardedRowLookupTest : public ::testing::Test {
+ protected:
+  // Creates one fake worker per entry of `shard_sizes`.
+  std::unique_ptr<ShardedRowLookup> Create(
+      ShardedRowLookup::PartitionStrategy strategy,
+      const std::vector<int64_t>& shard_sizes, int64_t cache_capacity = 0) {
+    const int num_shards = shard_sizes.size();
+    const bool mod = strategy == ShardedRowLookup::PartitionStrategy::kMod;
+    std::vector<std::vector<int64_t>> shard_ids(num_shards);
+    int64_t next_id = 0;
+    for (int s = 0; s < num_shards; ++s) {
+      for (int64_t r = 0; r < shard_sizes[s]; ++r) {
+        shard_ids[s].push_back(mod ? r * num_shards + s : next_id++);
+      }
+    }
+    std::vector<ShardedRowLookup::Shard> shards;
+    for (int s = 0; s < num_shards; ++s) {
+      const string task = strings::StrCat("/job:ps/replica:0/task:", s);
+      workers_.push_back(std::make_unique<FakeShardWorker>(shard_ids[s]));
+      worker_cache_.AddWorker(task, workers_.back().get());
+      ShardedRowLookup::Shard shard;
+      shard.task = task;
+      shard.device = strings::StrCat(task, "/device:CPU:0");
+      shard.var_name = strings::StrCat("embedding/part_", s);
+      shard.num_rows = shard_sizes[s];
+      shards.push_back(shard);
+    }
+    ShardedRowLookup::Options options;
+    options.strategy = strategy;
+    options.cache_capacity = cache_capacity;
+    return std::make_unique<ShardedRowLookup>(&worker_cache_, shards, options);
+  }
+
+  void ExpectRows(const std::vector<int64_t>& ids, const Tensor& rows) {
+    Tensor expected(DT_FLOAT, TensorShape({static_cast<int64_t>(ids.size()),
+                                           kDim}));
+    for (int i = 0; i < static_cast<int>(ids.size()); ++i) {
+      for (int j = 0; j < kDim; ++j) expected.matrix<float>()(i, j) = ids[i];
+    }
+    test::ExpectTensorEqual<float>(expected, rows);
+  }
+
+  int TotalRequests() const {
+    int total = 0;
+    for (const auto& worker : workers_) total += worker->num_requests();
+    return total;
+  }
+
+  TestWorkerCache worker_cache_;
+  std::vector<std::unique_ptr<FakeShardWorker>> workers_;
+};
+
+TEST_F(ShardedRowLookupTest, DivStrategy) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {4, 3, 3});
+  const std::vector<int64_t> ids = {9, 0, 4, 3, 7, 5};
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup(ids, /*version=*/1, &rows));
+  ExpectRows(ids, rows);
+  EXPECT_EQ(3, TotalRequests());
+  EXPECT_EQ(std::vector<int64_t>({0, 3}), workers_[0]->requested_rows());
+  EXPECT_EQ(std::vector<int64_t>({0, 1}), workers_[1]->requested_rows());
+  EXPECT_EQ(std::vector<int64_t>({2, 0}), workers_[2]->requested_rows());
+}
+
+TEST_F(ShardedRowLookupTest, ModStrategy) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kMod, {4, 3, 3});
+  const std::vector<int64_t> ids = {9, 0, 4, 3, 7, 5};
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup(ids, /*version=*/1, &rows));
+  ExpectRows(ids, rows);
+  EXPECT_EQ(std::vector<int64_t>({3, 0, 1}), workers_[0]->requested_rows());
+  EXPECT_EQ(std::vector<int64_t>({1, 2}), workers_[1]->requested_rows());
+  EXPECT_EQ(std::vector<int64_t>({1}), workers_[2]->requested_rows());
+}
+
+TEST_F(ShardedRowLookupTest, DeduplicatesIds) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {5, 5});
+  const std::vector<int64_t> ids = {2, 2, 7, 2, 7, 7, 1};
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup(ids, /*version=*/1, &rows));
+  ExpectRows(ids, rows);
+  EXPECT_EQ(std::vector<int64_t>({2, 1}), workers_[0]->requested_rows());
+  EXPECT_EQ(std::vector<int64_t>({2}), workers_[1]->requested_rows());
+}
+
+TEST_F(ShardedRowLookupTest, SkipsShardsWithoutIds) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {5, 5, 5});
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup({11, 12}, /*version=*/1, &rows));
+  ExpectRows({11, 12}, rows);
+  EXPECT_EQ(0, workers_[0]->num_requests());
+  EXPECT_EQ(0, workers_[1]->num_requests());
+  EXPECT_EQ(1, workers_[2]->num_requests());
+}
+
+TEST_F(ShardedRowLookupTest, EmptyLookup) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {5, 5});
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup({}, /*version=*/1, &rows));
+  EXPECT_EQ(TensorShape({0, kDim}), rows.shape());
+}
+
+TEST_F(ShardedRowLookupTest, IdOutOfRange) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {5, 5});
+  Tensor rows;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(lookup->Lookup({3, 10}, /*version=*/1, &rows)));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(lookup->Lookup({-1}, /*version=*/1, &rows)));
+  EXPECT_EQ(0, TotalRequests());
+}
+
+TEST_F(ShardedRowLookupTest, CachesRowsPerVersion) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kMod, {5, 5},
+                       /*cache_capacity=*/100);
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup({1, 2, 3}, /*version=*/1, &rows));
+  EXPECT_EQ(2, TotalRequests());
+
+  // All cached.
+  TF_ASSERT_OK(lookup->Lookup({3, 1, 2, 1}, /*version=*/1, &rows));
+  ExpectRows({3, 1, 2, 1}, rows);
+  EXPECT_EQ(2, TotalRequests());
+  EXPECT_EQ(3, lookup->cache_hits());
+
+  // Only the missing row is fetched.
+  TF_ASSERT_OK(lookup->Lookup({2, 4}, /*version=*/1, &rows));
+  ExpectRows({2, 4}, rows);
+  EXPECT_EQ(3, TotalRequests());
+
+  // A new version invalidates the cached rows.
+  TF_ASSERT_OK(lookup->Lookup({1, 2}, /*version=*/2, &rows));
+  ExpectRows({1, 2}, rows);
+  EXPECT_EQ(5, TotalRequests());
+}
+
+TEST_F(ShardedRowLookupTest, KeepsRowsOfEveryVersion) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {10},
+                       /*cache_capacity=*/10);
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/2, &rows));
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/1, &rows));
+  EXPECT_EQ(2, TotalRequests());
+  // Fetching the row of the older version did not evict the newer one.
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/2, &rows));
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/1, &rows));
+  ExpectRows({1}, rows);
+  EXPECT_EQ(2, TotalRequests());
+  EXPECT_EQ(2, lookup->cache_hits());
+}
+
+TEST_F(ShardedRowLookupTest, EvictsLeastRecentlyUsedRows) {
+  auto lookup = Create(ShardedRowLookup::PartitionStrategy::kDiv, {10},
+                       /*cache_capacity=*/2);
+  Tensor rows;
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/1, &rows));
+  TF_ASSERT_OK(lookup->Lookup({2}, /*version=*/1, &rows));
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/1, &rows));
+  EXPECT_EQ(2, TotalRequests());
+  // Evicts 2, the least recently used row.
+  TF_ASSERT_OK(lookup->Lookup({3}, /*version=*/1, &rows));
+  TF_ASSERT_OK(lookup->Lookup({1}, /*version=*/1, &rows));
+  EXPECT_EQ(3, TotalRequests());
+  TF_ASSERT_OK(lookup->Lookup({2}, /*version=*/1, &rows));
+  EXPECT_EQ(4, TotalRequests());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -23,8 +23,17 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Tensor contents smaller than this are copied even if they could be shared,
+// so that small tensors don't keep large receive buffers alive.
+static constexpr size_t kMinSharedTensorBytes = 1024;
+
 TensorResponse::Source::~Source() {}
 
+core::RefCountPtr<TensorBuffer> TensorResponse::Source::ShareBuffer(
+    const void* data, size_t num_bytes) {
+  return nullptr;
+}
+
 void TensorResponse::Clear() {
   on_host_ = false;
   device_ = nullptr;
@@ -144,7 +153,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -195,12 +205,30 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (static_cast<size_t>(num_bytes) !=
+            shape.num_elements() * DataTypeSize(tensor_meta->dtype())) {
+          return false;
+        }
+        // Adopts the received bytes as the tensor's buffer if they are in
+        // one chunk of the input and the source can share them. Tensors that
+        // must be in GPU- or NIC-registered memory are always copied into
+        // memory from allocator_.
+        const void* data;
+        int size;
+        if (static_cast<size_t>(num_bytes) >= kMinSharedTensorBytes &&
+            !alloc_attrs_.gpu_compatible() && !alloc_attrs_.nic_compatible() &&
+            input->GetDirectBufferPointer(&data, &size) && size >= num_bytes) {
+          core::RefCountPtr<TensorBuffer> shared =
+              source->ShareBuffer(data, num_bytes);
+          if (shared) {
+            if (!input->Skip(num_bytes)) return false;
+            tensor_ = Tensor(tensor_meta->dtype(), std::move(shape),
+                             std::move(shared));
+            break;
+          }
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
-        if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -233,7 +261,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
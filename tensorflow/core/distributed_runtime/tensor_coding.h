@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
 
+#include <utility>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -63,6 +65,15 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a buffer that shares the `num_bytes` bytes at `data`, so that
+    // host tensor contents can be adopted without a copy. `data` points into
+    // the chunk that contents() returned last. Returns nullptr if the bytes
+    // can't be kept alive or are not aligned for a Tensor. The default
+    // implementation never shares memory. Not called for tensors whose
+    // allocator attributes ask for GPU- or NIC-compatible memory.
+    virtual core::RefCountPtr<TensorBuffer> ShareBuffer(const void* data,
+                                                        size_t num_bytes);
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -87,11 +98,20 @@ class TensorResponse {
   // modified.
   const RecvTensorResponse& metadata() const { return meta_; }
 
+  // Replaces the parsed tensor, e.g. with one whose contents the transport
+  // delivered outside of the response (see
+  // RecvTensorResponse.transport_options).
+  void set_tensor(Tensor tensor) { tensor_ = std::move(tensor); }
+
+  // Returns true if the tensor is received into host memory.
+  bool on_host() const { return on_host_; }
+
   // Return pointer to the device hosting the tensor.
   DeviceBase* device() const { return device_; }
 
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
@@ -118,6 +118,12 @@ class TestWorkerInterface : public WorkerInterface {
                             StatusCallback done) override {
     done(errors::Unimplemented("GetStepSequenceAsync"));
   }
+
+  void LookupRowsAsync(CallOptions* opts, const LookupRowsRequest* request,
+                       LookupRowsResponse* response,
+                       StatusCallback done) override {
+    done(errors::Unimplemented("LookupRowsAsync"));
+  }
 };
 
 class TestWorkerCache : public WorkerCacheInterface {
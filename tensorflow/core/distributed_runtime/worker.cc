@@ -27,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
 #include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/profiler/lib/device_profiler_session.h"
 #include "tsl/protobuf/distributed_runtime_payloads.pb.h"
@@ -467,6 +469,61 @@ void Worker::GetStepSequenceAsync(const GetStepSequenceRequest* request,
   }
 }
 
+void Worker::LookupRowsAsync(CallOptions* opts,
+                             const LookupRowsRequest* request,
+                             LookupRowsResponse* response,
+                             StatusCallback done) {
+  done(LookupRows(request, response));
+}
+
+Status Worker::LookupRows(const LookupRowsRequest* request,
+                          LookupRowsResponse* response) {
+  std::shared_ptr<WorkerSession> session;
+  TF_RETURN_IF_ERROR(env_->session_mgr->WorkerSessionForSession(
+      request->session_handle(), &session));
+  Device* device;
+  TF_RETURN_IF_ERROR(session->device_mgr()->LookupDevice(
+      DeviceNameUtils::LocalName(request->device()), &device));
+  if (device->tensorflow_accelerator_device_info() != nullptr) {
+    return errors::Unimplemented("LookupRows only serves variables in host ",
+                                 "memory, not on ", request->device());
+  }
+  Var* var;
+  TF_RETURN_IF_ERROR(device->resource_manager()->Lookup(
+      request->container(), request->var_name(), &var));
+  core::ScopedUnref unref_var(var);
+
+  tf_shared_lock l(*var->mu());
+  if (!var->is_initialized) {
+    return errors::FailedPrecondition("Variable ", request->var_name(),
+                                      " is not initialized");
+  }
+  const Tensor& params = *var->tensor();
+  if (params.dims() < 1 || !DataTypeCanUseMemcpy(params.dtype())) {
+    return errors::InvalidArgument(
+        "Cannot look up rows of variable ", request->var_name(), " with type ",
+        DataTypeString(params.dtype()), " and shape ",
+        params.shape().DebugString());
+  }
+  const int64_t num_rows = params.dim_size(0);
+  const int64_t row_bytes = num_rows == 0 ? 0 : params.TotalBytes() / num_rows;
+  TensorShape rows_shape = params.shape();
+  rows_shape.set_dim(0, request->ids_size());
+  Tensor rows(params.dtype(), rows_shape);
+  const char* src = static_cast<const char*>(params.data());
+  char* dst = static_cast<char*>(rows.data());
+  for (int i = 0; i < request->ids_size(); ++i) {
+    const int64_t id = request->ids(i);
+    if (id < 0 || id >= num_rows) {
+      return errors::InvalidArgument("Row ", id, " is not in [0, ", num_rows,
+                                     ") for variable ", request->var_name());
+    }
+    memcpy(dst + i * row_bytes, src + id * row_bytes, row_bytes);
+  }
+  rows.AsProtoTensorContent(response->mutable_rows());
+  return OkStatus();
+}
+
 // Helper for RecvTensor. Validates "key" and returns the source
 // device in "*src_dev".
 Status Worker::PrepareRecvTensor(const Rendezvous::ParsedKey& parsed,
@@ -108,6 +108,10 @@ class Worker : public WorkerInterface {
                             GetStepSequenceResponse* response,
                             StatusCallback done) override;
 
+  void LookupRowsAsync(CallOptions* opts, const LookupRowsRequest* request,
+                       LookupRowsResponse* response,
+                       StatusCallback done) override;
+
  protected:
   WorkerEnv* const env_;  // Not owned.
   RecentRequestIds recent_request_ids_;
@@ -134,6 +138,9 @@ class Worker : public WorkerInterface {
                          MutableRunGraphResponseWrapper* response,
                          StatusCallback done);
 
+  Status LookupRows(const LookupRowsRequest* request,
+                    LookupRowsResponse* response);
+
   Worker(const Worker&) = delete;
   void operator=(const Worker&) = delete;
 };
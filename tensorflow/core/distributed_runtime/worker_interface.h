@@ -129,6 +129,11 @@ class WorkerInterface {
                                     GetStepSequenceResponse* response,
                                     StatusCallback done) = 0;
 
+  virtual void LookupRowsAsync(CallOptions* opts,
+                               const LookupRowsRequest* request,
+                               LookupRowsResponse* response,
+                               StatusCallback done) = 0;
+
   Status GetStatus(const GetStatusRequest* request,
                    GetStatusResponse* response) {
     Status ret;
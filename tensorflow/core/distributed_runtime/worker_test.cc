@@ -0,0 +1,138 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/worker.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/session_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kDevice[] = "/job:ps/replica:0/task:0/device:CPU:0";
+
+class WorkerLookupRowsTest : public ::testing::Test {
+ protected:
+  WorkerLookupRowsTest() {
+    std::vector<std::unique_ptr<Device>> devices;
+    TF_CHECK_OK(DeviceFactory::AddDevices(SessionOptions(),
+                                          "/job:ps/replica:0/task:0",
+                                          &devices));
+    device_mgr_ = std::make_unique<StaticDeviceMgr>(std::move(devices));
+    TF_CHECK_OK(device_mgr_->LookupDevice("CPU:0", &device_));
+    env_.env = Env::Default();
+    env_.device_mgr = device_mgr_.get();
+    session_mgr_ = std::make_unique<SessionMgr>(
+        &env_, "/job:ps/replica:0/task:0",
+        std::unique_ptr<WorkerCacheInterface>(),
+        [](const ServerDef& server_def, WorkerCacheInterface** worker_cache) {
+          *worker_cache = nullptr;
+          return OkStatus();
+        },
+        /*coordination_handler=*/nullptr);
+    env_.session_mgr = session_mgr_.get();
+    worker_ = std::make_unique<Worker>(&env_);
+  }
+
+  // Creates variable "v" holding `value`, or uninitialized if `value` is
+  // null.
+  void CreateVariable(const Tensor* value) {
+    Var* var = new Var(DT_FLOAT);
+    if (value != nullptr) {
+      *var->tensor() = *value;
+      var->is_initialized = true;
+    }
+    TF_ASSERT_OK(device_->resource_manager()->Create("c", "v", var));
+  }
+
+  Status LookupRows(const std::vector<int64_t>& ids, Tensor* rows) {
+    LookupRowsRequest request;
+    request.set_device(kDevice);
+    request.set_container("c");
+    request.set_var_name("v");
+    for (int64_t id : ids) request.add_ids(id);
+    LookupRowsResponse response;
+    Status status;
+    worker_->LookupRowsAsync(/*opts=*/nullptr, &request, &response,
+                             [&status](const Status& s) { status = s; });
+    TF_RETURN_IF_ERROR(status);
+    if (!rows->FromProto(response.rows())) {
+      return errors::Internal("Cannot parse ", response.rows().DebugString());
+    }
+    return OkStatus();
+  }
+
+  WorkerEnv env_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  Device* device_ = nullptr;
+  std::unique_ptr<SessionMgr> session_mgr_;
+  std::unique_ptr<Worker> worker_;
+};
+
+TEST_F(WorkerLookupRowsTest, ReturnsRequestedRows) {
+  Tensor params(DT_FLOAT, TensorShape({4, 2}));
+  test::FillIota<float>(&params, 0);
+  CreateVariable(&params);
+
+  Tensor rows;
+  TF_ASSERT_OK(LookupRows({3, 0, 3}, &rows));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({6, 7, 0, 1, 6, 7}, TensorShape({3, 2})), rows);
+
+  TF_ASSERT_OK(LookupRows({}, &rows));
+  EXPECT_EQ(TensorShape({0, 2}), rows.shape());
+}
+
+TEST_F(WorkerLookupRowsTest, RejectsIdsOutOfRange) {
+  Tensor params(DT_FLOAT, TensorShape({4, 2}));
+  test::FillIota<float>(&params, 0);
+  CreateVariable(&params);
+  Tensor rows;
+  EXPECT_TRUE(errors::IsInvalidArgument(LookupRows({4}, &rows)));
+  EXPECT_TRUE(errors::IsInvalidArgument(LookupRows({-1}, &rows)));
+}
+
+TEST_F(WorkerLookupRowsTest, RejectsScalarVariable) {
+  Tensor params = test::AsScalar<float>(1);
+  CreateVariable(&params);
+  Tensor rows;
+  EXPECT_TRUE(errors::IsInvalidArgument(LookupRows({0}, &rows)));
+}
+
+TEST_F(WorkerLookupRowsTest, RejectsUninitializedVariable) {
+  CreateVariable(nullptr);
+  Tensor rows;
+  EXPECT_TRUE(errors::IsFailedPrecondition(LookupRows({0}, &rows)));
+}
+
+TEST_F(WorkerLookupRowsTest, MissingVariable) {
+  Tensor rows;
+  EXPECT_TRUE(errors::IsNotFound(LookupRows({0}, &rows)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -120,6 +120,10 @@ string CollInstanceParams::ToString() const {
     }
     strings::StrAppend(&v, "}");
   }  // all subdivs
+  if (impl_details.wire_dtype != DT_INVALID) {
+    strings::StrAppend(&v, " wire_dtype=",
+                       DataTypeString(impl_details.wire_dtype));
+  }
   if (type == PERMUTE_COLLECTIVE) {
     strings::StrAppend(&v, "}, permute_devices {");
     for (const auto& d : devices) {
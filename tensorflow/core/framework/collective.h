@@ -116,6 +116,9 @@ struct CollImplDetails {
                               // e.g. ring or nccl
   float timeout_seconds;      // If non zero, set a completion timeout for the
                               // collective op to detect staleness.
+  // If valid, data is converted to this lower precision type for transfers
+  // between devices, e.g. DT_BFLOAT16 for DT_FLOAT reductions.
+  DataType wire_dtype = DT_INVALID;
 };
 
 // Data common to all members of a collective instance.
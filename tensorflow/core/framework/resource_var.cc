@@ -20,6 +20,21 @@ limitations under the License.
 
 namespace tensorflow {
 
+mutex* Var::row_stripe_mu(int stripe) {
+  mutex* stripes = row_stripe_mu_.load(std::memory_order_acquire);
+  if (stripes == nullptr) {
+    mutex* created = new mutex[kNumRowStripes];
+    if (row_stripe_mu_.compare_exchange_strong(stripes, created,
+                                               std::memory_order_acq_rel)) {
+      stripes = created;
+    } else {
+      // Another thread allocated them first.
+      delete[] created;
+    }
+  }
+  return &stripes[stripe];
+}
+
 Status Var::AsGraphDef(GraphDefBuilder* builder, Node** out) const {
   // Set a shared_name so that the created resource can outlive the graph that
   // created it.
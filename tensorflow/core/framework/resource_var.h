@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <atomic>
 #include <string>
 
 #include "tensorflow/core/framework/resource_base.h"
@@ -57,7 +58,10 @@ namespace tensorflow {
 // sparse reads, providing some extra safety at the expense of performance,
 // while shared mutex allow for "hogwild" behavior. Doing sparse writes under a
 // shared mutex prevents them from overlapping with dense writes, which is
-// necessary as dense writes can change the shape the of the tensor.
+// necessary as dense writes can change the shape the of the tensor. Sparse
+// writes that must not overlap each other but may overlap reads can hold the
+// mutex shared and lock only the row stripes they write, see
+// `row_stripe_mu()`. Readers don't take the stripe locks, so this is opt-in.
 //
 // Transitioning a variable from copy-on-read mode to copy-on-write mode is
 // currently not supported. To upgrade a variable from copy-on-write to
@@ -78,6 +82,13 @@ class Var : public ResourceBase {
   mutex* mu() { return &mu_; }
   Tensor* tensor() { return &tensor_; }
 
+  // The rows of the variable are split into kNumRowStripes ranges of
+  // consecutive rows, each with a mutex that sparse writes which opt in lock
+  // while holding mu() shared. Stripe mutexes must be acquired after mu() and
+  // in order of increasing address. They are allocated on first use.
+  static constexpr int kNumRowStripes = 32;
+  mutex* row_stripe_mu(int stripe);
+
   // Uninitializes the variable, by reverting the state of the tensor to
   // the state when the variable is first created.
   void Uninitialize() {
@@ -112,10 +123,11 @@ class Var : public ResourceBase {
 
  private:
   mutex mu_;
+  std::atomic<mutex*> row_stripe_mu_{nullptr};
   Tensor tensor_;
   std::string debug_name_;
 
-  ~Var() override {}
+  ~Var() override { delete[] row_stripe_mu_.load(); }
   Var(const Var&) = delete;
   void operator=(const Var&) = delete;
 };
@@ -92,6 +92,9 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kSparseSegmentWeightedSum[] = "_SparseSegmentWeightedSum";
+constexpr char kSparseSegmentWeightedSumGrad[] =
+    "_SparseSegmentWeightedSumGrad";
 constexpr char kLeakyRelu[] = "LeakyRelu";
 constexpr char kMklFusedMish[] = "_MklFusedMish";
 constexpr char kRelu[] = "Relu";
@@ -167,6 +170,29 @@ struct TensorToHashBucket {
   int string_to_hash_bucket = kMissingIndex;
 };
 
+// Rows gathered along axis 0, scaled by per-row weights and summed into
+// segments, as built by the weighted combiners of embedding_lookup_sparse():
+//   SegmentSum(Mul([Cast](GatherV2(data, indices, 0)),
+//                  Reshape(weights, [-1, 1, ..., 1])), segment_ids)
+// that can be replaced with a _SparseSegmentWeightedSum.
+struct WeightedSparseSegmentSum {
+  int segment_sum = kMissingIndex;
+  int mul = kMissingIndex;
+  int cast = kMissingIndex;  // Only for bfloat16 and half data.
+  int gather = kMissingIndex;
+  int reshape = kMissingIndex;
+};
+
+// Rows gathered along axis 0 and scaled by per-row weights, as in the gradient
+// of WeightedSparseSegmentSum with respect to the gathered rows:
+//   Mul(GatherV2(grad, segment_ids, 0), Reshape(weights, [-1, 1, ..., 1]))
+// that can be replaced with a _SparseSegmentWeightedSumGrad.
+struct ScaledGather {
+  int mul = kMissingIndex;
+  int gather = kMissingIndex;
+  int reshape = kMissingIndex;
+};
+
 // Pad followed by Conv3D/FusedConv3D
 struct PadWithConv3D {
   PadWithConv3D() = default;
@@ -2675,6 +2701,160 @@ bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+// Returns true if `node_view` gathers rows along axis 0 and only feeds the
+// node it is fused into.
+bool IsFusableRowGather(const RemapperContext& ctx,
+                        const utils::MutableNodeView& node_view) {
+  const auto* node_def = node_view.node();
+  if (!IsGather(*node_def) || node_def->op() == "ResourceGather" ||
+      HasControlFaninOrFanout(node_view) ||
+      !HasAtMostOneFanoutAtPort0(node_view) || IsInPreserveSet(ctx, node_def))
+    return false;
+
+  if (!HasDataType(node_def, DT_INT32, "Tindices") &&
+      !HasDataType(node_def, DT_INT64, "Tindices"))
+    return false;
+
+  if (node_def->op() == "Gather") return true;
+
+  int batch_dims = 0;
+  if (TryGetNodeAttr(*node_def, "batch_dims", &batch_dims) && batch_dims != 0)
+    return false;
+
+  if (node_view.NumRegularFanins() < 3) return false;
+  const auto* axis_node_def = node_view.GetRegularFanin(2).node_view()->node();
+  Tensor axis;
+  if (!IsConstant(*axis_node_def) ||
+      !axis.FromProto(axis_node_def->attr().at("value").tensor()) ||
+      axis.NumElements() != 1)
+    return false;
+  if (axis.dtype() == DT_INT32) return axis.flat<int32>()(0) == 0;
+  if (axis.dtype() == DT_INT64) return axis.flat<int64_t>()(0) == 0;
+  return false;
+}
+
+// Returns true if the Mul `mul_view` scales every row of one input by the
+// matching element of a vector of weights, reshaped to [-1, 1, ..., 1] for
+// broadcasting. Sets the port of the rows and the index of the Reshape.
+bool FindRowWeights(const RemapperContext& ctx,
+                    const utils::MutableNodeView& mul_view, int* rows_port,
+                    int* reshape) {
+  const auto* mul_node_def = mul_view.node();
+  if (!IsMul(*mul_node_def) || mul_view.NumRegularFanins() != 2) return false;
+  if (!HasDataType(mul_node_def, DT_FLOAT) &&
+      !HasDataType(mul_node_def, DT_DOUBLE))
+    return false;
+
+  const auto& props = ctx.graph_properties.GetInputProperties(
+      mul_node_def->name());
+  if (props.size() != 2) return false;
+
+  for (int port = 0; port < 2; ++port) {
+    const auto* weights_view = mul_view.GetRegularFanin(1 - port).node_view();
+    if (!IsReshape(*weights_view->node())) continue;
+
+    // Rows of shape [n, ...] times weights of shape [n, 1, ..., 1].
+    const TensorShapeProto& rows_shape = props[port].shape();
+    const TensorShapeProto& weights_shape = props[1 - port].shape();
+    if (rows_shape.unknown_rank() || weights_shape.unknown_rank() ||
+        rows_shape.dim_size() < 1 ||
+        rows_shape.dim_size() != weights_shape.dim_size())
+      continue;
+    bool broadcasts_over_rows = true;
+    for (int i = 1; i < weights_shape.dim_size(); ++i) {
+      if (weights_shape.dim(i).size() != 1) broadcasts_over_rows = false;
+    }
+    // The fused ops take one weight per row. Leave the Mul alone unless the
+    // row counts are known to match, as sizes or as the same symbolic
+    // dimension, since it may broadcast a single weight or row otherwise.
+    const int64_t num_rows = rows_shape.dim(0).size();
+    const int64_t num_weights = weights_shape.dim(0).size();
+    if (!broadcasts_over_rows || num_rows == -1 || num_rows != num_weights)
+      continue;
+
+    const auto& reshape_props = ctx.graph_properties.GetInputProperties(
+        weights_view->node()->name());
+    if (reshape_props.empty() || reshape_props[0].shape().unknown_rank() ||
+        reshape_props[0].shape().dim_size() != 1)
+      continue;
+
+    *rows_port = port;
+    *reshape = weights_view->node_index();
+    return true;
+  }
+  return false;
+}
+
+bool FindWeightedSparseSegmentSum(const RemapperContext& ctx, int node_index,
+                                  WeightedSparseSegmentSum* matched) {
+  // Root of the pattern must be a SegmentSum on CPU.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (node_def->op() != "SegmentSum" || !NodeIsOnCpu(node_def) ||
+      HasControlFaninOrFanout(*node_view) || node_view->NumRegularFanins() != 2)
+    return false;
+
+  const auto* mul_view = node_view->GetRegularFanin(0).node_view();
+  if (HasControlFaninOrFanout(*mul_view) ||
+      !HasAtMostOneFanoutAtPort0(*mul_view) ||
+      IsInPreserveSet(ctx, mul_view->node()))
+    return false;
+
+  WeightedSparseSegmentSum pattern;
+  int rows_port;
+  if (!FindRowWeights(ctx, *mul_view, &rows_port, &pattern.reshape))
+    return false;
+
+  // bfloat16 and half rows are cast to float before they are scaled.
+  const auto* rows_view = mul_view->GetRegularFanin(rows_port).node_view();
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  if (IsCast(*rows_view->node())) {
+    const auto* cast_node_def = rows_view->node();
+    if (HasControlFaninOrFanout(*rows_view) ||
+        !HasAtMostOneFanoutAtPort0(*rows_view) ||
+        IsInPreserveSet(ctx, cast_node_def) || dtype != DT_FLOAT ||
+        !HasDataType(cast_node_def, DT_FLOAT, "DstT") ||
+        (!HasDataType(cast_node_def, DT_BFLOAT16, "SrcT") &&
+         !HasDataType(cast_node_def, DT_HALF, "SrcT")))
+      return false;
+    pattern.cast = rows_view->node_index();
+    rows_view = rows_view->GetRegularFanin(0).node_view();
+  }
+  if (!IsFusableRowGather(ctx, *rows_view)) return false;
+  if (pattern.cast == kMissingIndex &&
+      !HasDataType(rows_view->node(), dtype, "Tparams"))
+    return false;
+
+  pattern.segment_sum = node_index;
+  pattern.mul = mul_view->node_index();
+  pattern.gather = rows_view->node_index();
+  *matched = pattern;
+  return true;
+}
+
+bool FindScaledGather(const RemapperContext& ctx, int node_index,
+                      ScaledGather* matched) {
+  // Root of the pattern must be a Mul on CPU.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsMul(*node_def) || !NodeIsOnCpu(node_def) ||
+      HasControlFaninOrFanout(*node_view))
+    return false;
+
+  ScaledGather pattern;
+  int rows_port;
+  if (!FindRowWeights(ctx, *node_view, &rows_port, &pattern.reshape))
+    return false;
+
+  const auto* rows_view = node_view->GetRegularFanin(rows_port).node_view();
+  if (!IsFusableRowGather(ctx, *rows_view)) return false;
+
+  pattern.mul = node_index;
+  pattern.gather = rows_view->node_index();
+  *matched = pattern;
+  return true;
+}
+
 // clang-format off
 // HardSwish pattern
 //                        input     Const (value: 3)
@@ -4289,6 +4469,81 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return OkStatus();
 }
 
+Status AddWeightedSparseSegmentSumNode(RemapperContext* ctx,
+                                       const WeightedSparseSegmentSum& matched,
+                                       std::vector<bool>* invalidated_nodes,
+                                       std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& segment_sum = graph->node(matched.segment_sum);
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& reshape = graph->node(matched.reshape);
+  VLOG(2) << "Fuse " << gather.op() << " with Mul and SegmentSum:"
+          << " gather=" << gather.name()
+          << " segment_sum=" << segment_sum.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(segment_sum.name());
+  fused_op.set_device(segment_sum.device());
+  fused_op.set_op(kSparseSegmentWeightedSum);
+  fused_op.add_input(gather.input(0));       // 0: data
+  fused_op.add_input(gather.input(1));       // 1: indices
+  fused_op.add_input(reshape.input(0));      // 2: weights
+  fused_op.add_input(segment_sum.input(1));  // 3: segment_ids
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["Tdata"] = gather.attr().at("Tparams");
+  (*attr)["T"] = segment_sum.attr().at("T");
+  (*attr)["Tidx"] = gather.attr().at("Tindices");
+  (*attr)["Tsegmentids"] = segment_sum.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.segment_sum] = true;
+  (*nodes_to_delete)[matched.mul] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+  if (matched.cast != kMissingIndex) (*nodes_to_delete)[matched.cast] = true;
+
+  return OkStatus();
+}
+
+Status AddScaledGatherNode(RemapperContext* ctx, const ScaledGather& matched,
+                           std::vector<bool>* invalidated_nodes,
+                           std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& mul = graph->node(matched.mul);
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& reshape = graph->node(matched.reshape);
+  VLOG(2) << "Fuse " << gather.op() << " with Mul:"
+          << " gather=" << gather.name() << " mul=" << mul.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(mul.name());
+  fused_op.set_device(mul.device());
+  fused_op.set_op(kSparseSegmentWeightedSumGrad);
+  fused_op.add_input(gather.input(0));   // 0: grad
+  fused_op.add_input(reshape.input(0));  // 1: weights
+  fused_op.add_input(gather.input(1));   // 2: segment_ids
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = mul.attr().at("T");
+  (*attr)["Tsegmentids"] = gather.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.mul] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+
+  return OkStatus();
+}
+
 Status AddFusedBatchMatMul(RemapperContext* ctx,
                            const std::map<string, int>& matched_nodes_map,
                            const std::set<int>& remove_node_indices,
@@ -4762,17 +5017,33 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
     return true;
   };
 
+  // Candidate for a WeightedSparseSegmentSum or ScaledGather fusion.
+  const auto is_scaled_gather_candidate = [&]() -> bool {
+    if (!NodeIsOnCpu(node_def)) return false;
+    const auto* mul_view = node_view;
+    if (node_def->op() == "SegmentSum") {
+      if (node_view->NumRegularFanins() < 1) return false;
+      mul_view = node_view->GetRegularFanin(0).node_view();
+    }
+    if (!IsMul(*mul_view->node())) return false;
+    for (int i = 0; i < mul_view->NumRegularFanins(); ++i) {
+      if (IsReshape(*mul_view->GetRegularFanin(i).node_view()->node()))
+        return true;
+    }
+    return false;
+  };
+
   if (IsMKLEnabled())
     return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
            IsContractionWithAdd(ctx, node_index) ||
            is_act_biasadd_conv_candidate() || IsBiasAdd(*node_def) ||
-           IsTranspose(*node_def);
+           IsTranspose(*node_def) || is_scaled_gather_candidate();
 
   return is_act_biasadd_conv_candidate() || is_batch_norm_candidate() ||
          is_batch_norm_fusion_candidate() ||
          is_batch_norm_grad_fusion_candidate() ||
          is_matmul_gelu_exact_fusion_candidate() ||
-         is_act_biasadd_matmul_candidate();
+         is_act_biasadd_matmul_candidate() || is_scaled_gather_candidate();
 }
 }  // namespace
 
@@ -5117,6 +5388,28 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap Gather+Mul+SegmentSum, the weighted combiners of
+    // embedding_lookup_sparse(), into the _SparseSegmentWeightedSum.
+    WeightedSparseSegmentSum weighted_sparse_segment_sum;
+    if (allow_non_differentiable_rewrites &&
+        FindWeightedSparseSegmentSum(ctx, i, &weighted_sparse_segment_sum)) {
+      TF_RETURN_IF_ERROR(AddWeightedSparseSegmentSumNode(
+          &ctx, weighted_sparse_segment_sum, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
+    // Remap Gather+Mul, e.g. in the gradient of the above, into the
+    // _SparseSegmentWeightedSumGrad.
+    ScaledGather scaled_gather;
+    if (allow_non_differentiable_rewrites &&
+        FindScaledGather(ctx, i, &scaled_gather)) {
+      TF_RETURN_IF_ERROR(AddScaledGatherNode(&ctx, scaled_gather,
+                                             &invalidated_nodes,
+                                             &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
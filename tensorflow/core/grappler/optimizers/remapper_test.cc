@@ -1766,6 +1766,136 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+class RemapperWeightedSparseSegmentSumTest : public RemapperTest {
+ protected:
+  // Builds the graph of a weighted embedding_lookup_sparse() of a table of
+  // type `DTYPE`, optionally followed by the gradient of the scaled rows.
+  template <DataType DTYPE>
+  void RunTest(bool gradient) {
+    using ::tensorflow::ops::Placeholder;
+
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto params = Placeholder(s.WithOpName("params"), DTYPE,
+                              ops::Placeholder::Shape({10, 4}));
+    auto ids = Placeholder(s.WithOpName("ids"), DT_INT32,
+                           ops::Placeholder::Shape({6}));
+    auto weights = Placeholder(s.WithOpName("weights"), DT_FLOAT,
+                               ops::Placeholder::Shape({6}));
+    auto segment_ids = ops::Const(s.WithOpName("segment_ids"),
+                                  {0, 0, 1, 3, 3, 3}, {6});
+    auto axis = ops::Const(s.WithOpName("axis"), 0);
+    Output rows = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+    if (DTYPE != DT_FLOAT) {
+      rows = ops::Cast(s.WithOpName("cast"), rows, DT_FLOAT);
+    }
+    auto bcast_weights = ops::Reshape(s.WithOpName("bcast_weights"), weights,
+                                      ops::Const(s, {-1, 1}, {2}));
+    auto scaled = ops::Mul(s.WithOpName("scaled"), rows, bcast_weights);
+    auto sum = ops::SegmentSum(s.WithOpName("sum"), scaled, segment_ids);
+    string fused_name = "sum";
+    string fused_op = "_SparseSegmentWeightedSum";
+    Output fetch = sum;
+    if (gradient) {
+      // The gradient of the scaled rows with respect to the gathered rows.
+      auto grad_rows = ops::GatherV2(s.WithOpName("grad_gather"), sum,
+                                     segment_ids, axis);
+      fetch = ops::Mul(s.WithOpName("grad_scaled"), grad_rows, bcast_weights);
+      fused_name = "grad_scaled";
+      fused_op = "_SparseSegmentWeightedSumGrad";
+    }
+    ops::Identity(s.WithOpName("fetch"), fetch);
+
+    Tensor ids_t(DT_INT32, TensorShape({6}));
+    for (int i = 0; i < 6; ++i) ids_t.flat<int32>()(i) = (i * 7) % 10;
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"params", GenerateTensorWithSetRandom<DTYPE>({10, 4})},
+                 {"ids", ids_t},
+                 {"weights", GenerateTensorWithSetRandom<DT_FLOAT>({6})}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == fused_name) {
+        EXPECT_EQ(node.op(), fused_op);
+        found++;
+      }
+      EXPECT_NE(node.name(), "scaled");
+      EXPECT_NE(node.name(), "cast");
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectClose(tensors[0], tensors_expected[0], 1e-6);
+  }
+};
+
+// Scaling by weights whose count may differ from the number of rows
+// broadcasts, which the fused ops don't support.
+TEST_F(RemapperWeightedSparseSegmentSumTest, DoesNotFuseBroadcast) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (const auto& [ids_shape, weights_shape] :
+       std::vector<std::pair<PartialTensorShape, PartialTensorShape>>{
+           {PartialTensorShape({6}), PartialTensorShape({1})},
+           {PartialTensorShape({1}), PartialTensorShape({6})},
+           {PartialTensorShape({-1}), PartialTensorShape({-1})}}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto params = Placeholder(s.WithOpName("params"), DT_FLOAT,
+                              ops::Placeholder::Shape({10, 4}));
+    auto ids = Placeholder(s.WithOpName("ids"), DT_INT32,
+                           ops::Placeholder::Shape(ids_shape));
+    auto weights = Placeholder(s.WithOpName("weights"), DT_FLOAT,
+                               ops::Placeholder::Shape(weights_shape));
+    auto segment_ids = Placeholder(s.WithOpName("segment_ids"), DT_INT32);
+    auto axis = ops::Const(s.WithOpName("axis"), 0);
+    auto rows = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+    auto bcast_weights = ops::Reshape(s.WithOpName("bcast_weights"), weights,
+                                      ops::Const(s, {-1, 1}, {2}));
+    auto scaled = ops::Mul(s.WithOpName("scaled"), rows, bcast_weights);
+    auto sum = ops::SegmentSum(s.WithOpName("sum"), scaled, segment_ids);
+    ops::Identity(s.WithOpName("fetch"), sum);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "sum") EXPECT_EQ(node.op(), "SegmentSum");
+      if (node.name() == "scaled") EXPECT_EQ(node.op(), "Mul");
+    }
+  }
+}
+
+TEST_F(RemapperWeightedSparseSegmentSumTest, F32) {
+  RunTest<DT_FLOAT>(/*gradient=*/false);
+}
+
+TEST_F(RemapperWeightedSparseSegmentSumTest, BF16) {
+  RunTest<DT_BFLOAT16>(/*gradient=*/false);
+}
+
+TEST_F(RemapperWeightedSparseSegmentSumTest, Gradient) {
+  RunTest<DT_FLOAT>(/*gradient=*/true);
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
@@ -0,0 +1,406 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/lib/png/png_io.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+static const char kPngMagicBytes[] = "\x89\x50\x4E\x47\x0D\x0A\x1A\x0A";
+// The 4th byte of JPEG is '\xe0' or '\xe1', so check just the first three.
+static const char kJpegMagicBytes[] = "\xff\xd8\xff";
+
+// Rough cost of decoding and resizing one image, in cycles. Decoding takes
+// milliseconds, so every image is worth a shard of its own.
+constexpr int64_t kCostPerImage = 1 << 24;
+
+// A crop window [y, x, height, width], in pixels of the encoded image.
+struct CropWindow {
+  int64_t y;
+  int64_t x;
+  int64_t height;
+  int64_t width;
+};
+
+// A decoded image, and the window of it to resample. The window is fractional
+// when the image was scaled down during decoding.
+struct DecodedImage {
+  const uint8* pixels;
+  int64_t height;
+  int64_t width;
+  // Distance between rows of `pixels`, in bytes.
+  int64_t row_stride;
+  float window_y;
+  float window_x;
+  float window_height;
+  float window_width;
+};
+
+// Returns the largest libjpeg scaling denominator that keeps the crop window
+// at least as large as the output, so that the image is only ever downscaled.
+int JpegRatioForSize(const CropWindow& window, int64_t out_height,
+                     int64_t out_width) {
+  for (int ratio : {8, 4, 2}) {
+    if (window.height >= out_height * ratio &&
+        window.width >= out_width * ratio) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
+Status CheckCropWindow(const CropWindow& window, int64_t height,
+                       int64_t width) {
+  if (window.y < 0 || window.x < 0 || window.height <= 0 ||
+      window.width <= 0 || window.y + window.height > height ||
+      window.x + window.width > width) {
+    return errors::InvalidArgument(
+        "Crop window [", window.y, ", ", window.x, ", ", window.height, ", ",
+        window.width, "] is not inside an image of size ", height, "x", width);
+  }
+  return OkStatus();
+}
+
+// Decodes `window` of a JPEG image, scaled down in the DCT domain by as much
+// as `out_height` and `out_width` allow. Only the MCU rows and columns that
+// overlap the window are decoded.
+Status DecodeJpegWindow(StringPiece contents, const CropWindow* crop,
+                        int channels, J_DCT_METHOD dct_method,
+                        int64_t out_height, int64_t out_width,
+                        std::vector<uint8>* buffer, DecodedImage* image) {
+  int height, width, components;
+  if (!jpeg::GetImageInfo(contents.data(), contents.size(), &width, &height,
+                          &components)) {
+    return errors::InvalidArgument("Invalid JPEG data, size ",
+                                   contents.size());
+  }
+  const CropWindow window =
+      crop != nullptr ? *crop : CropWindow{0, 0, height, width};
+  TF_RETURN_IF_ERROR(CheckCropWindow(window, height, width));
+
+  // libjpeg rounds scaled sizes up.
+  const int ratio = JpegRatioForSize(window, out_height, out_width);
+  const int64_t scaled_height = (height + ratio - 1) / ratio;
+  const int64_t scaled_width = (width + ratio - 1) / ratio;
+  const int64_t y0 = window.y / ratio;
+  const int64_t x0 = window.x / ratio;
+  const int64_t y1 = std::min<int64_t>(
+      (window.y + window.height + ratio - 1) / ratio, scaled_height);
+  const int64_t x1 = std::min<int64_t>(
+      (window.x + window.width + ratio - 1) / ratio, scaled_width);
+
+  jpeg::UncompressFlags flags;
+  flags.ratio = ratio;
+  flags.components = channels;
+  flags.dct_method = dct_method;
+  flags.crop = y0 != 0 || x0 != 0 || y1 != scaled_height || x1 != scaled_width;
+  flags.crop_y = y0;
+  flags.crop_x = x0;
+  flags.crop_height = y1 - y0;
+  flags.crop_width = x1 - x0;
+  int decoded_height = 0;
+  int decoded_width = 0;
+  int decoded_channels = 0;
+  const uint8* pixels = jpeg::Uncompress(
+      contents.data(), contents.size(), flags, /*nwarn=*/nullptr,
+      [&](int w, int h, int c) -> uint8* {
+        decoded_height = h;
+        decoded_width = w;
+        decoded_channels = c;
+        buffer->resize(static_cast<size_t>(h) * w * c);
+        return buffer->data();
+      });
+  if (pixels == nullptr) {
+    return errors::InvalidArgument("Invalid JPEG data, size ",
+                                   contents.size());
+  }
+  if (decoded_height != flags.crop_height ||
+      decoded_width != flags.crop_width || decoded_channels != channels) {
+    return errors::Internal("Decoded a ", decoded_height, "x", decoded_width,
+                            "x", decoded_channels, " JPEG image instead of ",
+                            flags.crop_height, "x", flags.crop_width, "x",
+                            channels);
+  }
+  image->pixels = pixels;
+  image->height = decoded_height;
+  image->width = decoded_width;
+  image->row_stride = static_cast<int64_t>(decoded_width) * channels;
+  image->window_y = static_cast<float>(window.y) / ratio - y0;
+  image->window_x = static_cast<float>(window.x) / ratio - x0;
+  image->window_height = static_cast<float>(window.height) / ratio;
+  image->window_width = static_cast<float>(window.width) / ratio;
+  return OkStatus();
+}
+
+// Decodes a PNG image and points `image` at `crop`, or at the whole image.
+Status DecodePngWindow(StringPiece contents, const CropWindow* crop,
+                       int channels, std::vector<uint8>* buffer,
+                       DecodedImage* image) {
+  png::DecodeContext decode;
+  if (!png::CommonInitDecode(contents, channels, /*desired_channel_bits=*/8,
+                             &decode)) {
+    return errors::InvalidArgument(
+        "Invalid PNG. Failed to initialize decoder.");
+  }
+  auto cleanup =
+      gtl::MakeCleanup([&decode]() { png::CommonFreeDecode(&decode); });
+  const int64_t height = decode.height;
+  const int64_t width = decode.width;
+  if (height <= 0 || height >= (1LL << 27) || width <= 0 ||
+      width >= (1LL << 27) || height * width >= (1LL << 29)) {
+    return errors::InvalidArgument("PNG size too large for int: ", width,
+                                   " by ", height);
+  }
+  const CropWindow window =
+      crop != nullptr ? *crop : CropWindow{0, 0, height, width};
+  TF_RETURN_IF_ERROR(CheckCropWindow(window, height, width));
+
+  buffer->resize(height * width * channels);
+  if (!png::CommonFinishDecode(reinterpret_cast<png_bytep>(buffer->data()),
+                               width * channels, &decode)) {
+    return errors::InvalidArgument("Invalid PNG data, size ",
+                                   contents.size());
+  }
+  image->pixels = buffer->data() + (window.y * width + window.x) * channels;
+  image->height = window.height;
+  image->width = window.width;
+  image->row_stride = width * channels;
+  image->window_y = 0;
+  image->window_x = 0;
+  image->window_height = window.height;
+  image->window_width = window.width;
+  return OkStatus();
+}
+
+// Where an output row or column samples the input, as in resize_bilinear with
+// half-pixel centers.
+struct InterpolationWeight {
+  int64_t lower;
+  int64_t upper;
+  float lerp;
+};
+
+void ComputeInterpolationWeights(int64_t out_size, int64_t in_size,
+                                 float window_start, float window_size,
+                                 InterpolationWeight* weights) {
+  const float scale = window_size / out_size;
+  for (int64_t i = 0; i < out_size; ++i) {
+    const float in = window_start + (i + 0.5f) * scale - 0.5f;
+    const float in_f = std::floor(in);
+    weights[i].lower =
+        std::min<int64_t>(std::max<int64_t>(in_f, 0), in_size - 1);
+    weights[i].upper =
+        std::min<int64_t>(std::max<int64_t>(std::ceil(in), 0), in_size - 1);
+    weights[i].lerp = in - in_f;
+  }
+}
+
+template <typename T>
+T FromFloat(float value) {
+  return static_cast<T>(value);
+}
+
+template <>
+uint8 FromFloat<uint8>(float value) {
+  // `value` is a convex combination of uint8 values.
+  return static_cast<uint8>(value + 0.5f);
+}
+
+// Bilinearly resamples the window of `image` into the [out_height, out_width,
+// channels] image at `output`.
+template <typename T>
+void ResizeWindow(const DecodedImage& image, int channels, int64_t out_height,
+                  int64_t out_width, std::vector<InterpolationWeight>* ys,
+                  std::vector<InterpolationWeight>* xs, T* output) {
+  ys->resize(out_height);
+  xs->resize(out_width);
+  ComputeInterpolationWeights(out_height, image.height, image.window_y,
+                              image.window_height, ys->data());
+  ComputeInterpolationWeights(out_width, image.width, image.window_x,
+                              image.window_width, xs->data());
+  for (int64_t y = 0; y < out_height; ++y) {
+    const InterpolationWeight& wy = (*ys)[y];
+    const uint8* top = image.pixels + wy.lower * image.row_stride;
+    const uint8* bottom = image.pixels + wy.upper * image.row_stride;
+    for (int64_t x = 0; x < out_width; ++x) {
+      const InterpolationWeight& wx = (*xs)[x];
+      const int64_t left = wx.lower * channels;
+      const int64_t right = wx.upper * channels;
+      for (int c = 0; c < channels; ++c) {
+        const float top_left = top[left + c];
+        const float top_right = top[right + c];
+        const float bottom_left = bottom[left + c];
+        const float bottom_right = bottom[right + c];
+        const float top_value = top_left + (top_right - top_left) * wx.lerp;
+        const float bottom_value =
+            bottom_left + (bottom_right - bottom_left) * wx.lerp;
+        *output++ =
+            FromFloat<T>(top_value + (bottom_value - top_value) * wy.lerp);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// Decodes a batch of JPEG and PNG images in parallel, crops them and resizes
+// them bilinearly straight into the output batch. JPEG images are scaled down
+// by libjpeg while decoding, by the largest factor that keeps them at least as
+// large as the output, and only the part of them that covers the crop window
+// is decoded.
+template <typename T>
+class DecodeAndResizeImagesOp : public OpKernel {
+ public:
+  explicit DecodeAndResizeImagesOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        channels_));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        dct_method.empty() || dct_method == "INTEGER_FAST" ||
+            dct_method == "INTEGER_ACCURATE",
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    dct_method_ = dct_method == "INTEGER_FAST" ? JDCT_IFAST : JDCT_ISLOW;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    const Tensor& crop_windows = context->input(1);
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be 1-D, got shape ",
+                                        contents.shape().DebugString()));
+    const int64_t batch_size = contents.NumElements();
+    OP_REQUIRES(context,
+                crop_windows.dims() == 2 && crop_windows.dim_size(1) == 4 &&
+                    (crop_windows.dim_size(0) == 0 ||
+                     crop_windows.dim_size(0) == batch_size),
+                errors::InvalidArgument(
+                    "crop_windows must have shape [0, 4] or [", batch_size,
+                    ", 4], got ", crop_windows.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(size.shape()) &&
+                    size.NumElements() == 2,
+                errors::InvalidArgument("size must have shape [2], got ",
+                                        size.shape().DebugString()));
+    const int64_t out_height = size.vec<int32>()(0);
+    const int64_t out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got [",
+                                        out_height, ", ", out_width, "]"));
+
+    // The output may be too large for a TensorShape.
+    TensorShape output_shape;
+    OP_REQUIRES_OK(context, TensorShape::BuildTensorShape(
+                                {batch_size, out_height, out_width, channels_},
+                                &output_shape));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    if (batch_size == 0) return;
+
+    const auto contents_vec = contents.vec<tstring>();
+    const bool has_crop_windows = crop_windows.dim_size(0) > 0;
+    const auto crop_matrix = crop_windows.matrix<int32>();
+    T* output_data = output->flat<T>().data();
+    const int64_t image_size = out_height * out_width * channels_;
+    std::vector<Status> statuses(batch_size);
+    auto decode_and_resize = [&](int64_t begin, int64_t end) {
+      std::vector<uint8> buffer;
+      std::vector<InterpolationWeight> ys;
+      std::vector<InterpolationWeight> xs;
+      for (int64_t i = begin; i < end; ++i) {
+        CropWindow crop{};
+        if (has_crop_windows) {
+          crop = {crop_matrix(i, 0), crop_matrix(i, 1), crop_matrix(i, 2),
+                  crop_matrix(i, 3)};
+        }
+        const CropWindow* crop_ptr = has_crop_windows ? &crop : nullptr;
+        const StringPiece input = contents_vec(i);
+        DecodedImage image;
+        if (absl::StartsWith(input, kJpegMagicBytes)) {
+          statuses[i] =
+              DecodeJpegWindow(input, crop_ptr, channels_, dct_method_,
+                               out_height, out_width, &buffer, &image);
+        } else if (absl::StartsWith(input, kPngMagicBytes)) {
+          statuses[i] =
+              DecodePngWindow(input, crop_ptr, channels_, &buffer, &image);
+        } else {
+          statuses[i] = errors::InvalidArgument(
+              "Unknown image file format. One of JPEG or PNG is required.");
+        }
+        if (!statuses[i].ok()) {
+          statuses[i] = errors::CreateWithUpdatedMessage(
+              statuses[i],
+              strings::StrCat("contents[", i, "]: ", statuses[i].message()));
+          continue;
+        }
+        ResizeWindow(image, channels_, out_height, out_width, &ys, &xs,
+                     output_data + i * image_size);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+          kCostPerImage, decode_and_resize);
+    for (const Status& status : statuses) {
+      OP_REQUIRES_OK(context, status);
+    }
+  }
+
+ private:
+  int channels_;
+  J_DCT_METHOD dct_method_;
+};
+
+#define REGISTER_KERNEL(T)                                       \
+  REGISTER_KERNEL_BUILDER(Name("DecodeAndResizeImages")          \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<T>("dtype")        \
+                              .HostMemory("size"),               \
+                          DecodeAndResizeImagesOp<T>)
+
+REGISTER_KERNEL(uint8);
+REGISTER_KERNEL(float);
+
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
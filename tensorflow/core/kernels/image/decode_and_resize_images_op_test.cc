@@ -0,0 +1,198 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/lib/png/png_io.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns an RGB image whose red channel is x and whose green channel is y,
+// so that bilinear resampling reproduces the sampled coordinates.
+std::vector<uint8> Gradient(int height, int width) {
+  std::vector<uint8> image(height * width * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8* pixel = &image[(y * width + x) * 3];
+      pixel[0] = x;
+      pixel[1] = y;
+      pixel[2] = 128;
+    }
+  }
+  return image;
+}
+
+tstring EncodePng(int height, int width) {
+  const std::vector<uint8> image = Gradient(height, width);
+  tstring png;
+  CHECK(png::WriteImageToBuffer(image.data(), width, height, width * 3,
+                                /*num_channels=*/3, /*channel_bits=*/8,
+                                /*compression=*/-1, &png, nullptr));
+  return png;
+}
+
+tstring EncodeJpeg(int height, int width) {
+  const std::vector<uint8> image = Gradient(height, width);
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  flags.quality = 100;
+  flags.chroma_downsampling = false;
+  return jpeg::Compress(image.data(), width, height, flags);
+}
+
+class DecodeAndResizeImagesOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType dtype) {
+    TF_ASSERT_OK(NodeDefBuilder("decode_and_resize", "DecodeAndResizeImages")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("dtype", dtype)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddInputs(const std::vector<tstring>& contents,
+                 const std::vector<int32>& crop_windows, int32 height,
+                 int32 width) {
+    const int64_t batch_size = contents.size();
+    const int64_t num_crop_windows = crop_windows.size() / 4;
+    AddInputFromArray<tstring>(TensorShape({batch_size}), contents);
+    AddInputFromArray<int32>(TensorShape({num_crop_windows, 4}), crop_windows);
+    AddInputFromArray<int32>(TensorShape({2}), {height, width});
+  }
+
+  // Checks that output image `b` samples the gradient at x = x0 + sx * j and
+  // y = y0 + sy * i.
+  template <typename T>
+  void ExpectGradient(int b, float y0, float sy, float x0, float sx,
+                      float tolerance) {
+    const auto images = GetOutput(0)->tensor<T, 4>();
+    for (int i = 0; i < images.dimension(1); ++i) {
+      for (int j = 0; j < images.dimension(2); ++j) {
+        EXPECT_NEAR(x0 + sx * j, images(b, i, j, 0), tolerance)
+            << "at " << b << ", " << i << ", " << j;
+        EXPECT_NEAR(y0 + sy * i, images(b, i, j, 1), tolerance)
+            << "at " << b << ", " << i << ", " << j;
+        EXPECT_NEAR(128, images(b, i, j, 2), tolerance);
+      }
+    }
+  }
+};
+
+TEST_F(DecodeAndResizeImagesOpTest, Png) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodePng(32, 64), EncodePng(64, 32)}, {}, 8, 16);
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({2, 8, 16, 3}), GetOutput(0)->shape());
+  // Pixel centers land halfway between input pixels, which rounds up.
+  ExpectGradient<uint8>(0, 2, 4, 2, 4, 0);
+  ExpectGradient<uint8>(1, 4, 8, 1, 2, 0);
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, PngCropFloat) {
+  MakeOp(DT_FLOAT);
+  AddInputs({EncodePng(32, 64)}, {4, 8, 16, 32}, 4, 8);
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({1, 4, 8, 3}), GetOutput(0)->shape());
+  ExpectGradient<float>(0, 5.5, 4, 9.5, 4, 0);
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, JpegScaledDuringDecode) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodeJpeg(256, 256)}, {}, 32, 32);
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({1, 32, 32, 3}), GetOutput(0)->shape());
+  ExpectGradient<uint8>(0, 3.5, 8, 3.5, 8, 3);
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, JpegUnalignedCrop) {
+  MakeOp(DT_FLOAT);
+  AddInputs({EncodeJpeg(256, 256)}, {20, 36, 128, 160}, 16, 20);
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({1, 16, 20, 3}), GetOutput(0)->shape());
+  ExpectGradient<float>(0, 23.5, 8, 39.5, 8, 3);
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, JpegUpscaled) {
+  MakeOp(DT_FLOAT);
+  AddInputs({EncodeJpeg(16, 16)}, {}, 32, 32);
+  TF_ASSERT_OK(RunOpKernel());
+  const auto images = GetOutput(0)->tensor<float, 4>();
+  // Away from the clamped border, sampling is linear in the output index.
+  for (int i = 1; i < 31; ++i) {
+    EXPECT_NEAR(0.5f * i - 0.25f, images(0, i, i, 0), 2);
+    EXPECT_NEAR(0.5f * i - 0.25f, images(0, i, i, 1), 2);
+  }
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, InvalidImage) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodePng(8, 8), "not an image"}, {}, 4, 4);
+  const Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  EXPECT_TRUE(absl::StrContains(status.message(), "contents[1]")) << status;
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, TruncatedJpeg) {
+  MakeOp(DT_UINT8);
+  tstring jpeg = EncodeJpeg(64, 64);
+  jpeg.resize(jpeg.size() / 2);
+  AddInputs({jpeg}, {}, 4, 4);
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, CropOutOfRange) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodePng(8, 8), EncodeJpeg(8, 8)}, {0, 0, 8, 8, 4, 4, 8, 2}, 4,
+            4);
+  const Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  EXPECT_TRUE(absl::StrContains(status.message(), "contents[1]")) << status;
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, CropWindowsMustMatchBatch) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodePng(8, 8), EncodePng(8, 8)}, {0, 0, 8, 8}, 4, 4);
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, SizeMustBePositive) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodePng(8, 8)}, {}, 0, 4);
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(DecodeAndResizeImagesOpTest, OutputTooLarge) {
+  MakeOp(DT_UINT8);
+  AddInputs({EncodePng(8, 8)}, {}, std::numeric_limits<int32>::max(),
+            std::numeric_limits<int32>::max());
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <memory>
 #include <string>
 
 #include "re2/re2.h"
@@ -22,8 +23,61 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
+namespace {
+
+// Rough cost of matching one string, in cycles.
+constexpr int64_t kCostPerString = 1000;
+
+// Fully matches strings against a pattern. Strings outside the range of
+// strings the pattern can match, e.g. all strings that do not start with the
+// literal prefix of the pattern, are rejected with a string comparison
+// instead of running RE2.
+class FullMatcher {
+ public:
+  explicit FullMatcher(const string& pattern) : re_(pattern) {
+    // An empty `max_` would mean that there is no upper bound.
+    has_range_ = re_.ok() &&
+                 re_.PossibleMatchRange(&min_, &max_, kMaxRangeLength) &&
+                 !max_.empty();
+  }
+
+  const RE2& re() const { return re_; }
+
+  bool Match(StringPiece s) const {
+    if (has_range_ && (s < StringPiece(min_) || s > StringPiece(max_))) {
+      return false;
+    }
+    return RE2::FullMatch(s, re_);
+  }
+
+  // Sets output(i) to whether input(i) matches, in parallel.
+  void MatchAll(OpKernelContext* ctx, TTypes<tstring>::ConstFlat input,
+                TTypes<bool>::Flat output) const {
+    auto match = [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        output(i) = Match(input(i));
+      }
+    };
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, input.size(),
+          kCostPerString, match);
+  }
+
+ private:
+  // Longest bounds of the match range. Longer bounds reject more strings, but
+  // take longer to compute and compare.
+  static constexpr int kMaxRangeLength = 16;
+
+  RE2 re_;
+  bool has_range_;
+  string min_;
+  string max_;
+};
+
+}  // namespace
 
 class RegexFullMatchOp : public OpKernel {
  public:
@@ -42,41 +96,38 @@ class RegexFullMatchOp : public OpKernel {
                 errors::InvalidArgument("Pattern must be scalar, but received ",
                                         pattern_tensor->shape().DebugString()));
     const string pattern = pattern_tensor->flat<tstring>()(0);
-    std::shared_ptr<RE2> regex = CachedRE2(pattern);
-    OP_REQUIRES(ctx, regex->ok(),
+    std::shared_ptr<FullMatcher> matcher = CachedMatcher(pattern);
+    OP_REQUIRES(ctx, matcher->re().ok(),
                 errors::InvalidArgument("Invalid pattern: ", pattern,
-                                        ", error: ", regex->error()));
+                                        ", error: ", matcher->re().error()));
 
     Tensor* output_tensor = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("output", input_tensor->shape(),
                                              &output_tensor));
-    auto output_flat = output_tensor->flat<bool>();
-    for (size_t i = 0; i < input_flat.size(); ++i) {
-      output_flat(i) = RE2::FullMatch(input_flat(i), *regex);
-    }
+    matcher->MatchAll(ctx, input_flat, output_tensor->flat<bool>());
   }
 
  private:
-  std::shared_ptr<RE2> CachedRE2(const string& pattern) {
+  std::shared_ptr<FullMatcher> CachedMatcher(const string& pattern) {
     {
       tf_shared_lock l(mu_);
-      if (regex_ != nullptr && regex_->pattern() == pattern) {
-        return regex_;
+      if (matcher_ != nullptr && matcher_->re().pattern() == pattern) {
+        return matcher_;
       }
     }
-    // Construct the new RE2 object before acquiring the lock.
-    auto regex = std::make_shared<RE2>(pattern);
+    // Construct the new matcher before acquiring the lock.
+    auto matcher = std::make_shared<FullMatcher>(pattern);
     {
       mutex_lock l(mu_);
       // Swap instead of assigning so that we destruct the old
-      // RE2 object (when necessary) after releasing the lock.
-      regex_.swap(regex);
-      return regex_;
+      // matcher (when necessary) after releasing the lock.
+      matcher_.swap(matcher);
+      return matcher_;
     }
   }
 
   mutex mu_;
-  std::shared_ptr<RE2> regex_ TF_GUARDED_BY(mu_);
+  std::shared_ptr<FullMatcher> matcher_ TF_GUARDED_BY(mu_);
 
   RegexFullMatchOp(const RegexFullMatchOp&) = delete;
   void operator=(const RegexFullMatchOp&) = delete;
@@ -90,10 +141,10 @@ class StaticRegexFullMatchOp : public OpKernel {
   explicit StaticRegexFullMatchOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     string pattern;
     OP_REQUIRES_OK(ctx, ctx->GetAttr("pattern", &pattern));
-    re_ = std::make_unique<RE2>(pattern);
-    OP_REQUIRES(ctx, re_->ok(),
+    matcher_ = std::make_unique<FullMatcher>(pattern);
+    OP_REQUIRES(ctx, matcher_->re().ok(),
                 errors::InvalidArgument("Invalid pattern: ", pattern,
-                                        ", error: ", re_->error()));
+                                        ", error: ", matcher_->re().error()));
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -104,14 +155,11 @@ class StaticRegexFullMatchOp : public OpKernel {
     Tensor* output_tensor = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("output", input_tensor->shape(),
                                              &output_tensor));
-    auto output_flat = output_tensor->flat<bool>();
-    for (size_t i = 0; i < input_flat.size(); ++i) {
-      output_flat(i) = RE2::FullMatch(input_flat(i), *re_);
-    }
+    matcher_->MatchAll(ctx, input_flat, output_tensor->flat<bool>());
   }
 
  private:
-  std::unique_ptr<RE2> re_;
+  std::unique_ptr<FullMatcher> matcher_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("StaticRegexFullMatch").Device(DEVICE_CPU),
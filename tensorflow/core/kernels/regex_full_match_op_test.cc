@@ -0,0 +1,107 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "re2/re2.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Strings around the bounds of the match ranges of the patterns below.
+const std::vector<tstring>& Inputs() {
+  static const auto* inputs = new std::vector<tstring>{
+      "", "a", "ab", "abc", "abcd", "abd", "ABC", "aBc", "abb", "abc\xff",
+      "b", "foobaz", "barbaz", "foobar", "bazbaz", "123", "12a", "\xff\xff",
+      "\xc3\xbf", "zzz", "abcabc", "ab\ncd", "x", "aaaaaaaaaaaaaaaaaaaa"};
+  return *inputs;
+}
+
+class RegexFullMatchOpTest
+    : public OpsTestBase,
+      public ::testing::WithParamInterface<std::tuple<const char*, bool>> {
+ protected:
+  string pattern() const { return std::get<0>(GetParam()); }
+  bool is_static() const { return std::get<1>(GetParam()); }
+};
+
+TEST_P(RegexFullMatchOpTest, MatchesLikeRE2) {
+  if (is_static()) {
+    TF_ASSERT_OK(NodeDefBuilder("regex_full_match", "StaticRegexFullMatch")
+                     .Input(FakeInput(DT_STRING))
+                     .Attr("pattern", pattern())
+                     .Finalize(node_def()));
+  } else {
+    TF_ASSERT_OK(NodeDefBuilder("regex_full_match", "RegexFullMatch")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_STRING))
+                     .Finalize(node_def()));
+  }
+  TF_ASSERT_OK(InitOp());
+  const std::vector<tstring>& inputs = Inputs();
+  AddInputFromArray<tstring>(TensorShape({static_cast<int64_t>(inputs.size())}),
+                             inputs);
+  if (!is_static()) {
+    AddInputFromArray<tstring>(TensorShape({}), {tstring(pattern())});
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Strings outside the match range of the pattern are rejected without
+  // running RE2, which must not change any result.
+  const RE2 re(pattern());
+  ASSERT_TRUE(re.ok());
+  const auto output = GetOutput(0)->flat<bool>();
+  for (int i = 0; i < static_cast<int>(inputs.size()); ++i) {
+    EXPECT_EQ(RE2::FullMatch(inputs[i], re), output(i))
+        << "input: " << inputs[i];
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Patterns, RegexFullMatchOpTest,
+    ::testing::Combine(::testing::Values("abc", "abc.*", "ab.", "(?i)abc",
+                                         "(?i)ab.*", "(foo|bar)baz", "a+",
+                                         "\\d+", "[^x]*", "", "\\xff+",
+                                         "(?s)ab.cd", ".*bc", "a{20}",
+                                         "^abc$"),
+                       ::testing::Bool()));
+
+class RegexFullMatchOpErrorTest : public OpsTestBase {};
+
+TEST_F(RegexFullMatchOpErrorTest, InvalidPattern) {
+  TF_ASSERT_OK(NodeDefBuilder("regex_full_match", "RegexFullMatch")
+                   .Input(FakeInput(DT_STRING))
+                   .Input(FakeInput(DT_STRING))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<tstring>(TensorShape({1}), {"a"});
+  AddInputFromArray<tstring>(TensorShape({}), {"(a"});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
@@ -34,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -50,12 +52,13 @@ Tensor MakeInput(const TensorShape& shape,
 class RestoreV2OpTest : public OpsTestBase {
  protected:
   // Makes an operation to restore two tensors
-  void MakeRestoreOp(DataType dt) {
+  void MakeRestoreOp(DataType dt, bool use_mmap = false) {
     TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
                      .Input(FakeInput())    // prefix
                      .Input(FakeInput())    // tensor_names
                      .Input(FakeInput())    // shape_and_slices
                      .Attr("dtypes", {dt})  // dtypes
+                     .Attr("use_mmap", use_mmap)
                      .Finalize(node_def()));
     TF_ASSERT_OK(InitOp());
   }
@@ -356,5 +359,49 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+TEST_F(RestoreV2OpTest, RestoreMapped) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_mapped");
+  {
+    BundleWriter::Options options;
+    options.data_alignment = 64;
+    BundleWriter writer(Env::Default(), prefix, options);
+    TF_ASSERT_OK(writer.Add("tensor_float",
+                            test::AsTensor<float>({1, 2, 3, 4, 5, 6})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  MakeRestoreOp(DT_FLOAT, /*use_mmap=*/true);
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({1}),
+                    [](int x) -> tstring { return "tensor_float"; });
+  AddInput<tstring>(TensorShape({1}), [](int x) -> tstring { return ""; });
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3, 4, 5, 6}),
+                                 *GetOutput(0));
+  // Mapped buffers don't own their memory, so they are never forwarded.
+  EXPECT_FALSE(GetOutput(0)->RefCountIsOne());
+}
+
+TEST_F(RestoreV2OpTest, RestoreMappedRejectsWrongDtype) {
+  const string prefix =
+      io::JoinPath(testing::TmpDir(), "tensor_mapped_wrong_dtype");
+  {
+    BundleWriter::Options options;
+    options.data_alignment = 64;
+    BundleWriter writer(Env::Default(), prefix, options);
+    TF_ASSERT_OK(writer.Add("tensor_int", test::AsTensor<int32>({1, 2})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  MakeRestoreOp(DT_FLOAT, /*use_mmap=*/true);
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({1}),
+                    [](int x) -> tstring { return "tensor_int"; });
+  AddInput<tstring>(TensorShape({1}), [](int x) -> tstring { return ""; });
+  EXPECT_EQ(error::INVALID_ARGUMENT, RunOpKernel().code());
+}
+
 }  // namespace
 }  // namespace tensorflow
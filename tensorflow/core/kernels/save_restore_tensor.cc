@@ -257,13 +257,14 @@ const int64_t kLargeShapeThreshold = 16 << 20;  // 16M
 struct RestoreOp {
   RestoreOp(OpKernelContext* context, int idx, const string& tensor_name,
             const string& shape_and_slice, const string& reader_prefix,
-            DataType dtype)
+            DataType dtype, bool use_mmap)
       : context(context),
         idx(idx),
         tensor_name(tensor_name),
         shape_and_slice(shape_and_slice),
         reader_prefix(reader_prefix),
-        dtype(dtype) {}
+        dtype(dtype),
+        use_mmap(use_mmap) {}
 
   // Move-only. It does not make sense to "run()" a copied RestoreOp.
   RestoreOp(const RestoreOp&) = delete;
@@ -301,7 +302,19 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    if (shape_and_slice.empty() && use_mmap) {
+      // Lookup the full tensor, sharing the memory of the data file.
+      Tensor mapped_tensor;
+      TF_RETURN_IF_ERROR(reader->LookupZeroCopy(tensor_name, &mapped_tensor));
+      if (mapped_tensor.dtype() != dtype) {
+        return errors::InvalidArgument(
+            "tensor_name = ", tensor_name, "; expected dtype ",
+            DataTypeString(dtype), " does not equal restored dtype ",
+            DataTypeString(mapped_tensor.dtype()));
+      }
+      context->set_output(idx, mapped_tensor);
+      restored_tensor = context->mutable_output(idx);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -355,6 +368,7 @@ struct RestoreOp {
   string shape_and_slice;
   string reader_prefix;
   DataType dtype;
+  bool use_mmap;
 
   ::tensorflow::Status status;
 };
@@ -364,7 +378,7 @@ struct RestoreOp {
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes) {
+                        gtl::ArraySlice<DataType> dtypes, bool use_mmap) {
   const string& prefix_string = prefix.scalar<tstring>()();
 
   const auto& tensor_names_flat = tensor_names.flat<tstring>();
@@ -374,7 +388,8 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   restore_ops.reserve(tensor_names_flat.size());
   for (int i = 0; i < tensor_names_flat.size(); ++i) {
     restore_ops.push_back({context, i, tensor_names_flat(i),
-                           shape_and_slices_flat(i), prefix_string, dtypes[i]});
+                           shape_and_slices_flat(i), prefix_string, dtypes[i],
+                           use_mmap});
   }
 
   BundleReader default_reader(Env::Default(), prefix_string);
@@ -63,10 +63,13 @@ void RestoreTensor(OpKernelContext* context,
 //   * "prefix" has 1 element, DT_STRING.
 //   * "tensor_names" and "shape_and_slices" shaped {N}, both DT_STRING.
 //   * "dtypes" has N elements, the datatypes of the to-restore tensors.
+// If "use_mmap" is true, suitably aligned non-partitioned tensors are backed by
+// a read-only mapping of the checkpoint instead of a copy.
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes);
+                        gtl::ArraySlice<DataType> dtypes,
+                        bool use_mmap);
 
 }  // namespace tensorflow
 
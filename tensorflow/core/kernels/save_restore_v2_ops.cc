@@ -95,7 +95,12 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_data_shards",
+                                             &writer_options_.num_data_shards));
+    OP_REQUIRES_OK(context, context->GetAttr("data_alignment",
+                                             &writer_options_.data_alignment));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -111,7 +116,7 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
+    BundleWriter writer(Env::Default(), prefix_string, writer_options_);
     OP_REQUIRES_OK(context, writer.status());
     VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
 
@@ -182,6 +187,9 @@ class SaveV2 : public OpKernel {
       checkpoint_callback_manager->Unref();
     }
   }
+
+ private:
+  BundleWriter::Options writer_options_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -190,6 +198,7 @@ class RestoreV2 : public OpKernel {
  public:
   explicit RestoreV2(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_mmap", &use_mmap_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -229,8 +238,9 @@ class RestoreV2 : public OpKernel {
       return;
     }
     // If found, invokes the V2 reader.
-    OP_REQUIRES_OK(context, RestoreTensorsV2(context, prefix, tensor_names,
-                                             shape_and_slices, dtypes_));
+    OP_REQUIRES_OK(context,
+                   RestoreTensorsV2(context, prefix, tensor_names,
+                                    shape_and_slices, dtypes_, use_mmap_));
 
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
@@ -256,6 +266,8 @@ class RestoreV2 : public OpKernel {
  private:
   // Expected dtypes of the to-restore tensors.
   std::vector<DataType> dtypes_;
+  // Whether to map suitably aligned tensors instead of copying them.
+  bool use_mmap_;
 };
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
@@ -29,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -48,8 +51,62 @@ class SaveV2OpTest : public OpsTestBase {
                      .Finalize(node_def()));
     TF_ASSERT_OK(InitOp());
   }
+
+  void MakeShardedOp(int num_data_shards, int data_alignment) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_FLOAT}))  // tensors
+                     .Attr("num_data_shards", num_data_shards)
+                     .Attr("data_alignment", data_alignment)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
 };
 
+TEST_F(SaveV2OpTest, ShardedAndAligned) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_sharded");
+  MakeShardedOp(/*num_data_shards=*/2, /*data_alignment=*/64);
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({2}), [](int x) -> tstring {
+    return x == 0 ? "tensor_a" : "tensor_b";
+  });
+  AddInput<tstring>(TensorShape({2}), [](int x) -> tstring { return ""; });
+  AddInput<float>(TensorShape({3}), [](int x) -> float { return x; });
+  AddInput<float>(TensorShape({5}), [](int x) -> float { return -x; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int shard = 0; shard < 2; ++shard) {
+    TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, shard, 2)));
+  }
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  for (const char* key : {"tensor_a", "tensor_b"}) {
+    BundleEntryProto entry;
+    TF_ASSERT_OK(reader.GetBundleEntryProto(key, &entry));
+    EXPECT_EQ(0, entry.offset() % 64) << key;
+  }
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("tensor_a", &val));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({0, 1, 2}), val);
+  TF_ASSERT_OK(reader.Lookup("tensor_b", &val));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({0, -1, -2, -3, -4}),
+                                 val);
+}
+
+TEST_F(SaveV2OpTest, RejectsZeroShards) {
+  TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Input(FakeInput({DT_FLOAT}))
+                   .Attr("num_data_shards", 0)
+                   .Finalize(node_def()));
+  EXPECT_FALSE(InitOp().ok());
+}
+
 TEST_F(SaveV2OpTest, Simple) {
   const string prefix = io::JoinPath(testing::TmpDir(), "tensor_simple");
   const string tensornames[] = {
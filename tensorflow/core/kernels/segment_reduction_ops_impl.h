@@ -18,7 +18,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
 #define TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 #include "tensorflow/core/framework/op_requires.h"
 #include "tensorflow/core/platform/types.h"
@@ -77,6 +79,84 @@ Status ValidateSparseSegmentReduction(OpKernelContext* context,
                                       const Tensor& indices,
                                       const Tensor& segment_ids,
                                       bool has_num_segments);
+
+// Segment reductions on CPU split their work by rows rather than by segments,
+// into blocks of about this many values, so that a few huge segments are
+// spread over as many threads as many tiny ones.
+constexpr int64_t kSegmentReductionBlockSize = 1 << 15;
+
+// Unsorted segment reductions split their rows into at most this many shards
+// of at least one block each. The shards depend only on the size of the input,
+// not on the number of threads, so that floating point results don't either.
+constexpr int64_t kMaxUnsortedSegmentReductionShards = 64;
+
+// Returns the number of rows of `num_cols` values in a block. Blocks have at
+// least 8 rows, which bounds the partial reductions kept for segments split
+// between blocks to a quarter of the input.
+inline int64_t SegmentReductionBlockRows(int64_t num_cols) {
+  return std::max<int64_t>(
+      8, kSegmentReductionBlockSize / std::max<int64_t>(num_cols, 1));
+}
+
+// Numbers the pieces of the segments that the blocks of `block_rows` of
+// `num_rows` rows, sorted by segment, split. Every block holds at most two
+// such pieces, its first and its last, and the pieces of a segment get
+// consecutive numbers. Returns the first number of every block followed by
+// the number of pieces. `segment_of(row)` returns the segment of a row.
+template <typename SegmentOf>
+std::vector<int64_t> SplitSegmentPieces(int64_t num_rows, int64_t block_rows,
+                                        SegmentOf segment_of) {
+  const int64_t num_blocks = (num_rows + block_rows - 1) / block_rows;
+  std::vector<int64_t> first_piece(num_blocks + 1, 0);
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    const int64_t begin = b * block_rows;
+    const int64_t end = std::min(num_rows, begin + block_rows);
+    const bool head = begin > 0 && segment_of(begin - 1) == segment_of(begin);
+    const bool tail =
+        end < num_rows && segment_of(end - 1) == segment_of(end);
+    const bool one_piece = segment_of(begin) == segment_of(end - 1);
+    first_piece[b + 1] = first_piece[b] + head + tail -
+                         (head && tail && one_piece ? 1 : 0);
+  }
+  return first_piece;
+}
+
+// Reduces `num_rows` consecutive rows of `num_cols` values starting at `in`
+// into the row `out`. We don't use out_row.device(...) because these pieces
+// of work are likely to be very small and the context switching overhead
+// dwarfs any benefit we get from using another thread to do this work.
+template <typename T, typename Reducer>
+void ReduceSegmentRows(const T* in, int64_t num_rows, int64_t num_cols,
+                       T* out) {
+  typename TTypes<T>::UnalignedVec out_row(out, num_cols);
+  if (num_rows == 1) {
+    out_row = typename TTypes<T>::UnalignedConstVec(in, num_cols);
+    return;
+  }
+  Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
+  typename TTypes<T>::UnalignedConstMatrix in_rows(in, num_rows, num_cols);
+  out_row = in_rows.reduce(dims_to_reduce, Reducer());
+}
+
+// A segment split between blocks is reduced from the reductions of its
+// pieces. These use `Partial`, and `Finalize` turns their reduction into the
+// reduction of the segment's `num_rows` rows.
+template <typename Reducer>
+struct SplitSegmentReducer {
+  typedef Reducer Partial;
+  template <typename T>
+  static void Finalize(int64_t num_rows, typename TTypes<T>::UnalignedVec out) {
+  }
+};
+
+template <typename T>
+struct SplitSegmentReducer<Eigen::internal::MeanReducer<T> > {
+  typedef Eigen::internal::SumReducer<T> Partial;
+  template <typename U>
+  static void Finalize(int64_t num_rows, typename TTypes<U>::UnalignedVec out) {
+    out = out / static_cast<U>(num_rows);
+  }
+};
 }  // namespace internal
 
 // This operator handles reducing segments along the first dimension.
@@ -126,80 +206,111 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
-    Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
-    Index start = 0, end = 1;
-
-    Index uninitialized_index = 0;  // Index from which the output is not set.
-    Index out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
-    Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      Index next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
-        }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
-      }
-
-      // Process segment [start, end)
-      const T* in_slice_ptr = &input_flat(start, 0);
-      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                               Eigen::Unaligned>
-          OutT;
-
+    // Copy and validate the segment ids before reducing any of them, so that
+    // the blocks reduced in parallel below all see the validated ids.
+    std::vector<Index> ids(num_indices);
+    for (int64_t i = 0; i < num_indices; ++i) {
+      ids[i] = internal::SubtleMustCopy(segment_vec(i));
+    }
+    for (int64_t i = 0; i < num_indices; ++i) {
+      // Verify that the segment ids are growing.
+      OP_REQUIRES(context, i + 1 == num_indices || ids[i] <= ids[i + 1],
+                  errors::InvalidArgument("segment ids are not increasing"));
       OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
+          context, FastBoundsCheck(ids[i], output_rows),
           errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
+              "Segment id ", ids[i], " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
+    }
 
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(T(default_value));
+    // Split the rows into blocks of about the same number of values, so that
+    // huge segments don't leave all but one thread idle. The pieces of the
+    // segments split between blocks are reduced into `partials` and merged
+    // once all blocks are done.
+    typedef typename internal::SplitSegmentReducer<Reducer>::Partial
+        PartialReducer;
+    const int64_t block_rows = internal::SegmentReductionBlockRows(num_col);
+    const int64_t num_blocks = (num_indices + block_rows - 1) / block_rows;
+    const std::vector<int64_t> first_piece = internal::SplitSegmentPieces(
+        num_indices, block_rows, [&ids](int64_t i) { return ids[i]; });
+    const int64_t num_pieces = first_piece[num_blocks];
+    Tensor partials;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({num_pieces, num_col}), &partials));
+    auto partials_flat = partials.matrix<T>();
+    std::vector<Index> piece_segment(num_pieces);
+    std::vector<int64_t> piece_rows(num_pieces);
+
+    auto reduce_blocks = [&](int64_t first_block, int64_t last_block) {
+      for (int64_t b = first_block; b < last_block; ++b) {
+        const int64_t begin = b * block_rows;
+        const int64_t end = std::min(num_indices, begin + block_rows);
+        int64_t piece = first_piece[b];
+        // Index from which the output is not set.
+        Index uninitialized_index = begin == 0 ? 0 : ids[begin - 1] + 1;
+        for (int64_t start = begin; start < end;) {
+          const Index out_index = ids[start];
+          int64_t stop = start + 1;
+          while (stop < end && ids[stop] == out_index) ++stop;
+
+          // If there is a gap between two indices, we need to set that gap to
+          // the default value.
+          if (out_index > uninitialized_index) {
+            Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+                out_index - uninitialized_index, num_col);
+            Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                             Eigen::Unaligned>
+                gap_slice(&output_flat(uninitialized_index, 0),
+                          gap_slice_shape);
+            gap_slice.setConstant(T(default_value));
+          }
+
+          // Process segment [start, stop), unless it continues in the
+          // previous or the next block.
+          if ((start == begin && begin > 0 && ids[begin - 1] == out_index) ||
+              (stop == end && end < num_indices && ids[end] == out_index)) {
+            internal::ReduceSegmentRows<T, PartialReducer>(
+                &input_flat(start, 0), stop - start, num_col,
+                &partials_flat(piece, 0));
+            piece_segment[piece] = out_index;
+            piece_rows[piece] = stop - start;
+            ++piece;
+          } else {
+            internal::ReduceSegmentRows<T, Reducer>(
+                &input_flat(start, 0), stop - start, num_col,
+                &output_flat(out_index, 0));
+          }
+          uninitialized_index = out_index + 1;
+          start = stop;
+        }
       }
+    };
+    if (num_blocks == 1) {
+      reduce_blocks(0, 1);
+    } else {
+      const double block_values = block_rows * num_col;
+      const Eigen::TensorOpCost cost(block_values * sizeof(T), 0,
+                                     block_values);
+      context->eigen_cpu_device().parallelFor(num_blocks, cost,
+                                              reduce_blocks);
+    }
 
-      T* out_slice_ptr = &output_flat(out_index, 0);
-      OutT out_slice(out_slice_ptr, out_slice_shape);
-      // We don't use out_slice.device(context->eigen_device<Device>)
-      // because these pieces of work are likely to be very small and
-      // the context switching overhead dwarfs any benefit we get from
-      // using another thread to do this work.
-      if (start == end - 1) {
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, out_slice_shape);
-        out_slice = in_slice;
-      } else {
-        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
-                                                           num_col);
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, in_slice_shape);
-
-        out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+    // The pieces of a segment have consecutive numbers.
+    for (int64_t piece = 0; piece < num_pieces;) {
+      const Index out_index = piece_segment[piece];
+      int64_t end_piece = piece + 1;
+      int64_t num_rows = piece_rows[piece];
+      while (end_piece < num_pieces &&
+             piece_segment[end_piece] == out_index) {
+        num_rows += piece_rows[end_piece++];
       }
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
+      T* out_row = &output_flat(out_index, 0);
+      internal::ReduceSegmentRows<T, PartialReducer>(
+          &partials_flat(piece, 0), end_piece - piece, num_col, out_row);
+      internal::SplitSegmentReducer<Reducer>::template Finalize<T>(
+          num_rows, typename TTypes<T>::UnalignedVec(out_row, num_col));
+      piece = end_piece;
     }
   }
 };
@@ -390,36 +501,196 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     // Nothing to reduce. All output values equal to `InitialValueF()`.
     if (num_reductions == 0) return;
 
-    // Parallelize by `num_segments`. It's simple, efficient and safe
-    // (no data dependency):
-    //
-    //   input   segment_ids                 num_segments  operation
-    //   | a0 |  | 0 |            worker 1:  |0|           f(a0, a1)
-    //   | b0 |  | 1 |            worker 2:  |1|           f(b0, b1)
-    // N | c0 |  | 2 |       -->  worker 3:  |2|           f(c0)
-    //   | b1 |  | 1 |
-    //   | a1 |  | 0 |
-    //
-    // TODO(intel-tf): Balance workload in `row_counter` to make parallelism
-    //                 more efficient.
-    auto reductionWorker = [&](int64_t begin, int64_t end) -> void {
-      for (int64_t i = 0; i < N; i++) {
-        Index j = internal::SubtleMustCopy(segment_ids(i));
-        // If `j` is in work scope of this worker, do the reduction.
-        if (j >= begin && j < end) {
-          reduction(data.template chip<0>(i), output.template chip<0>(j));
+    // Segment sizes of graph data tend to follow a power law, so the work is
+    // split by rows rather than by segments. While there are few segments,
+    // every shard of the rows reduces them into its own copy of the output.
+    // Otherwise the rows are sorted into ranges of segments holding about the
+    // same number of rows, and only the largest segments are split.
+    const int64_t num_shards = std::max<int64_t>(
+        1, std::min<int64_t>(
+               internal::kMaxUnsortedSegmentReductionShards,
+               N * inner_dim / internal::kSegmentReductionBlockSize));
+    if (num_shards == 1 || 4 * (num_shards - 1) * num_segments <= N) {
+      ReduceShards(ctx, num_shards, segment_ids, data, row_counter, output);
+    } else {
+      ReduceSegmentRanges(ctx, num_shards, segment_ids, data, row_counter,
+                          num_real_segment, output);
+    }
+  }
+
+ private:
+  // Reduces `num_shards` consecutive shards of the rows into the output and
+  // `num_shards - 1` private copies of it, and then merges the copies.
+  void ReduceShards(OpKernelContext* ctx, int64_t num_shards,
+                    typename TTypes<Index>::ConstFlat segment_ids,
+                    typename TTypes<T, 2>::ConstTensor data,
+                    const std::vector<Index>& row_counter,
+                    typename TTypes<T, 2>::Tensor output) {
+    auto cpu_device = ctx->eigen_cpu_device();
+    const int64_t N = segment_ids.dimension(0);
+    const int64_t num_segments = output.dimension(0);
+    const int64_t inner_dim = data.dimension(1);
+    ReductionF reduction;
+
+    std::vector<Tensor> copies(num_shards - 1);
+    for (Tensor& copy : copies) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                              DataTypeToEnum<T>::value,
+                              TensorShape({num_segments, inner_dim}), &copy));
+      auto copy_flat = copy.matrix<T>();
+      copy_flat.device(cpu_device) = copy_flat.constant(InitialValueF()());
+    }
+
+    auto reduce_shards = [&](int64_t first_shard, int64_t last_shard) {
+      for (int64_t s = first_shard; s < last_shard; ++s) {
+        auto shard_output = s == 0 ? output : copies[s - 1].matrix<T>();
+        for (int64_t i = N * s / num_shards; i < N * (s + 1) / num_shards;
+             ++i) {
+          Index j = internal::SubtleMustCopy(segment_ids(i));
+          if (!FastBoundsCheck(j, num_segments)) continue;
+          reduction(data.template chip<0>(i), shard_output.template chip<0>(j));
         }
       }
     };
-
     // Reduction functors includes Sum, Max, Min, etc. Simply consider it
     // will cost 5 cycles per operation.
-    const int64_t kAverTaskSize = num_real_segment / num_segments;
-    const int64_t compute_cycles = 5 * inner_dim * kAverTaskSize;
-    const int64_t input_bytes = sizeof(T) * inner_dim * kAverTaskSize;
-    const int64_t output_bytes = sizeof(T) * inner_dim * kAverTaskSize;
-    const Eigen::TensorOpCost cost(input_bytes, output_bytes, compute_cycles);
-    cpu_device.parallelFor(num_segments, cost, reductionWorker);
+    const double shard_values = static_cast<double>(N) * inner_dim / num_shards;
+    cpu_device.parallelFor(
+        num_shards,
+        Eigen::TensorOpCost(sizeof(T) * shard_values, 0, 5 * shard_values),
+        reduce_shards);
+    if (num_shards == 1) return;
+
+    auto merge_copies = [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j < end; ++j) {
+        if (row_counter[j] == 0) continue;
+        for (const Tensor& copy : copies) {
+          reduction(copy.matrix<T>().template chip<0>(j),
+                    output.template chip<0>(j));
+        }
+      }
+    };
+    const double merge_values = static_cast<double>(num_shards) * inner_dim;
+    cpu_device.parallelFor(
+        num_segments,
+        Eigen::TensorOpCost(sizeof(T) * merge_values, sizeof(T) * inner_dim,
+                            5 * merge_values),
+        merge_copies);
+  }
+
+  // Splits the segments into `num_shards` ranges that hold about the same
+  // number of rows, and reduces the rows of every range in parallel, in the
+  // order of the input. Segments holding more than half as many rows as a
+  // range are instead split between the shards like in ReduceShards.
+  void ReduceSegmentRanges(OpKernelContext* ctx, int64_t num_shards,
+                           typename TTypes<Index>::ConstFlat segment_ids,
+                           typename TTypes<T, 2>::ConstTensor data,
+                           const std::vector<Index>& row_counter,
+                           int64_t num_rows,
+                           typename TTypes<T, 2>::Tensor output) {
+    const int64_t N = segment_ids.dimension(0);
+    const int64_t num_segments = output.dimension(0);
+    const int64_t inner_dim = data.dimension(1);
+    ReductionF reduction;
+
+    // `owner[j]` is the range of segment `j`, or `num_shards` plus the index
+    // of `j` in `large_segments`.
+    const int64_t range_rows = (num_rows + num_shards - 1) / num_shards;
+    std::vector<int64_t> owner(num_segments);
+    std::vector<int64_t> large_segments;
+    int64_t small_rows = 0;
+    for (int64_t j = 0; j < num_segments; ++j) {
+      if (2 * static_cast<int64_t>(row_counter[j]) > range_rows) {
+        owner[j] = num_shards + large_segments.size();
+        large_segments.push_back(j);
+      } else {
+        small_rows += row_counter[j];
+      }
+    }
+    for (int64_t j = 0, rows = 0; j < num_segments; ++j) {
+      if (owner[j] >= num_shards) continue;
+      owner[j] = std::min(num_shards - 1,
+                          rows * num_shards / std::max<int64_t>(small_rows, 1));
+      rows += row_counter[j];
+    }
+
+    // Bucket the rows by range, keeping them in order. The rows of large
+    // segments go into one more bucket. Rows whose segment id changed since
+    // it was counted are left out.
+    std::vector<int64_t> bucket_begin(num_shards + 2, 0);
+    for (int64_t j = 0; j < num_segments; ++j) {
+      bucket_begin[std::min(owner[j], num_shards) + 1] += row_counter[j];
+    }
+    for (int64_t o = 0; o <= num_shards; ++o) {
+      bucket_begin[o + 1] += bucket_begin[o];
+    }
+    std::vector<int64_t> rows(num_rows, 0);
+    std::vector<int64_t> next_row(bucket_begin.begin(), bucket_begin.end() - 1);
+    for (int64_t i = 0; i < N; ++i) {
+      Index j = internal::SubtleMustCopy(segment_ids(i));
+      if (!FastBoundsCheck(j, num_segments)) continue;
+      const int64_t o = std::min(owner[j], num_shards);
+      if (next_row[o] == bucket_begin[o + 1]) continue;
+      rows[next_row[o]++] = i;
+    }
+
+    // Every shard reduces its part of the rows of large segments into the
+    // output or a private copy of the large segments' rows.
+    const int64_t num_large = large_segments.size();
+    std::vector<Tensor> copies(num_large > 0 ? num_shards - 1 : 0);
+    for (Tensor& copy : copies) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                              DataTypeToEnum<T>::value,
+                              TensorShape({num_large, inner_dim}), &copy));
+      copy.matrix<T>().setConstant(InitialValueF()());
+    }
+    const int64_t large_begin = bucket_begin[num_shards];
+    const int64_t large_rows = bucket_begin[num_shards + 1] - large_begin;
+
+    auto reduce_shards = [&](int64_t first_task, int64_t last_task) {
+      for (int64_t task = first_task; task < last_task; ++task) {
+        if (task < num_shards) {
+          for (int64_t k = bucket_begin[task]; k < bucket_begin[task + 1];
+               ++k) {
+            Index j = internal::SubtleMustCopy(segment_ids(rows[k]));
+            if (!FastBoundsCheck(j, num_segments) || owner[j] != task) {
+              continue;
+            }
+            reduction(data.template chip<0>(rows[k]),
+                      output.template chip<0>(j));
+          }
+          continue;
+        }
+        const int64_t s = task - num_shards;
+        for (int64_t k = large_begin + large_rows * s / num_shards;
+             k < large_begin + large_rows * (s + 1) / num_shards; ++k) {
+          Index j = internal::SubtleMustCopy(segment_ids(rows[k]));
+          if (!FastBoundsCheck(j, num_segments) || owner[j] < num_shards) {
+            continue;
+          }
+          if (s == 0) {
+            reduction(data.template chip<0>(rows[k]),
+                      output.template chip<0>(j));
+          } else {
+            reduction(data.template chip<0>(rows[k]),
+                      copies[s - 1].matrix<T>().template chip<0>(
+                          owner[j] - num_shards));
+          }
+        }
+      }
+    };
+    const double shard_values = static_cast<double>(range_rows) * inner_dim;
+    ctx->eigen_cpu_device().parallelFor(
+        num_large > 0 ? 2 * num_shards : num_shards,
+        Eigen::TensorOpCost(sizeof(T) * shard_values, 0, 5 * shard_values),
+        reduce_shards);
+
+    for (int64_t l = 0; l < num_large; ++l) {
+      for (const Tensor& copy : copies) {
+        reduction(copy.matrix<T>().template chip<0>(l),
+                  output.template chip<0>(large_segments[l]));
+      }
+    }
   }
 };
 
@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -31,16 +34,183 @@ limitations under the License.
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+class SegmentReductionOpTest : public OpsTestBase {
+ protected:
+  // Runs `op` on `data`, whose rows hold `num_cols` values, and checks its
+  // output against `reduce` applied to the values of every output element.
+  // The unsorted ops also take `num_segments`.
+  void RunAndCheck(
+      const string& op, const std::vector<float>& data, int64_t num_cols,
+      const std::vector<int32>& segment_ids, int32 num_segments,
+      float empty_value,
+      const std::function<float(const std::vector<float>&)>& reduce) {
+    const bool unsorted = absl::StartsWith(op, "Unsorted");
+    NodeDefBuilder builder("segment_reduction", op);
+    builder.Input(FakeInput(DT_FLOAT)).Input(FakeInput(DT_INT32));
+    if (unsorted) builder.Input(FakeInput(DT_INT32));
+    TF_ASSERT_OK(builder.Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const int64_t num_rows = segment_ids.size();
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}), data);
+    AddInputFromArray<int32>(TensorShape({num_rows}), segment_ids);
+    if (unsorted) AddInputFromArray<int32>(TensorShape({}), {num_segments});
+    TF_ASSERT_OK(RunOpKernel());
+
+    std::vector<std::vector<int64_t>> segment_rows(num_segments);
+    for (int64_t i = 0; i < num_rows; ++i) {
+      if (segment_ids[i] >= 0) segment_rows[segment_ids[i]].push_back(i);
+    }
+    Tensor expected(DT_FLOAT, TensorShape({num_segments, num_cols}));
+    for (int32 j = 0; j < num_segments; ++j) {
+      for (int64_t c = 0; c < num_cols; ++c) {
+        std::vector<float> values;
+        for (int64_t i : segment_rows[j]) {
+          values.push_back(data[i * num_cols + c]);
+        }
+        expected.matrix<float>()(j, c) =
+            values.empty() ? empty_value : reduce(values);
+      }
+    }
+    test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-3, /*rtol=*/1e-5);
+  }
+
+  // Runs UnsortedSegmentSum on one thread and on all threads, and checks that
+  // the results are identical.
+  void ExpectSameSumOnAnyThreads(const std::vector<float>& data,
+                                 int64_t num_cols,
+                                 const std::vector<int32>& segment_ids,
+                                 int32 num_segments) {
+    TF_ASSERT_OK(NodeDefBuilder("segment_reduction", "UnsortedSegmentSum")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const int64_t num_rows = segment_ids.size();
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}), data);
+    AddInputFromArray<int32>(TensorShape({num_rows}), segment_ids);
+    AddInputFromArray<int32>(TensorShape({}), {num_segments});
+    Tensor single_threaded;
+    {
+      ScopedPerThreadMaxParallelism scope(1);
+      TF_ASSERT_OK(RunOpKernel());
+      single_threaded = *GetOutput(0);
+    }
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorEqual<float>(single_threaded, *GetOutput(0));
+  }
+};
+
+static float SumOf(const std::vector<float>& values) {
+  double sum = 0;
+  for (float value : values) sum += value;
+  return sum;
+}
+
+static float MeanOf(const std::vector<float>& values) {
+  return SumOf(values) / values.size();
+}
+
+static float MaxOf(const std::vector<float>& values) {
+  return *std::max_element(values.begin(), values.end());
+}
+
+static std::vector<float> RandomData(int64_t size) {
+  random::PhiloxRandom philox(7, 11);
+  random::SimplePhilox rnd(&philox);
+  std::vector<float> data(size);
+  for (float& value : data) value = rnd.RandFloat() - 0.5f;
+  return data;
+}
+
+// Returns sorted segment ids with gaps, whose segments range from a single
+// row to several times the rows that are reduced in one piece.
+static std::vector<int32> SortedPowerLawSegmentIds(int64_t num_rows) {
+  std::vector<int32> segment_ids;
+  const int64_t sizes[] = {9000, 1, 2, 3, 50, 1, 700, 1, 5000, 4};
+  for (int32 j = 0; segment_ids.size() < static_cast<size_t>(num_rows);
+       j += 1 + j % 3) {
+    const int64_t size = segment_ids.size() + sizes[j % 10];
+    segment_ids.resize(std::min(num_rows, size), j);
+  }
+  return segment_ids;
+}
+
+// Returns segment ids in [0, num_segments), whose segment sizes follow a
+// power law, and a few -1 ids that drop their rows.
+static std::vector<int32> UnsortedPowerLawSegmentIds(int64_t num_rows,
+                                                     int32 num_segments) {
+  random::PhiloxRandom philox(3, 5);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> segment_ids(num_rows);
+  for (int32& j : segment_ids) {
+    const float u = rnd.RandFloat();
+    j = std::min(num_segments - 1,
+                 static_cast<int32>(num_segments * u * u * u * u));
+    if (rnd.Uniform(100) == 0) j = -1;
+  }
+  return segment_ids;
+}
+
+TEST_F(SegmentReductionOpTest, SegmentSumSplitsLargeSegments) {
+  const std::vector<int32> segment_ids = SortedPowerLawSegmentIds(40000);
+  RunAndCheck("SegmentSum", RandomData(40000 * 8), 8, segment_ids,
+              segment_ids.back() + 1, 0, SumOf);
+}
+
+TEST_F(SegmentReductionOpTest, SegmentMeanSplitsLargeSegments) {
+  const std::vector<int32> segment_ids = SortedPowerLawSegmentIds(40000);
+  RunAndCheck("SegmentMean", RandomData(40000 * 8), 8, segment_ids,
+              segment_ids.back() + 1, 0, MeanOf);
+}
+
+TEST_F(SegmentReductionOpTest, SegmentMaxSplitsLargeSegments) {
+  const std::vector<int32> segment_ids = SortedPowerLawSegmentIds(20000);
+  RunAndCheck("SegmentMax", RandomData(20000 * 3), 3, segment_ids,
+              segment_ids.back() + 1, 0, MaxOf);
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumFewSegments) {
+  RunAndCheck("UnsortedSegmentSum", RandomData(50000 * 16), 16,
+              UnsortedPowerLawSegmentIds(50000, 20), 20, 0, SumOf);
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumManySegments) {
+  RunAndCheck("UnsortedSegmentSum", RandomData(50000 * 16), 16,
+              UnsortedPowerLawSegmentIds(50000, 40000), 40000, 0, SumOf);
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentMaxManySegments) {
+  RunAndCheck("UnsortedSegmentMax", RandomData(50000 * 16), 16,
+              UnsortedPowerLawSegmentIds(50000, 40000), 40000,
+              std::numeric_limits<float>::lowest(), MaxOf);
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumFewSegmentsOnAnyThreads) {
+  ExpectSameSumOnAnyThreads(RandomData(50000 * 16), 16,
+                            UnsortedPowerLawSegmentIds(50000, 20), 20);
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumManySegmentsOnAnyThreads) {
+  ExpectSameSumOnAnyThreads(RandomData(50000 * 16), 16,
+                            UnsortedPowerLawSegmentIds(50000, 40000), 40000);
+}
+
 static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
                                         const string& reduction, int num_rows,
-                                        int num_cols, int segment_size) {
+                                        int num_cols, int segment_size,
+                                        bool power_law) {
   std::unique_ptr<Device> device(
       DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0"));
 
@@ -53,8 +223,19 @@ static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
 
   TensorShape shape2({num_rows});
   Tensor indices(DT_INT32, shape2);
-  test::FillFn<int>(&indices,
-                    [&segment_size](int i) -> int { return i % segment_size; });
+  if (power_law) {
+    // Segment sizes follow a power law, like the degrees of graph nodes.
+    random::PhiloxRandom philox(3, 5);
+    random::SimplePhilox rnd(&philox);
+    test::FillFn<int>(&indices, [&](int i) -> int {
+      const float u = rnd.RandFloat();
+      return std::min(segment_size - 1,
+                      static_cast<int>(segment_size * u * u * u * u));
+    });
+  } else {
+    test::FillFn<int>(
+        &indices, [&segment_size](int i) -> int { return i % segment_size; });
+  }
   reduction_inputs.push_back({nullptr, &indices});
 
   Tensor num_segments(DT_INT32, TensorShape({}));
@@ -96,7 +277,7 @@ static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
 
 #define BM_UnsortedReduce(O, R, C, S)                                        \
   static void BM_##O##_##R##_##C##_##S(::testing::benchmark::State& state) { \
-    BM_UnsortedSegmentReduction(state, #O, R, C, S);                         \
+    BM_UnsortedSegmentReduction(state, #O, R, C, S, false);                  \
   }                                                                          \
   BENCHMARK(BM_##O##_##R##_##C##_##S);
 
@@ -106,6 +287,16 @@ static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
 BM_UnsortedReduce_Arg(4096, 1024, 1);
 BM_UnsortedReduce_Arg(4096, 1024, 128);
 
+#define BM_UnsortedReducePowerLaw(O, R, C, S)                            \
+  static void BM_##O##_PowerLaw_##R##_##C##_##S(                         \
+      ::testing::benchmark::State& state) {                              \
+    BM_UnsortedSegmentReduction(state, #O, R, C, S, true);               \
+  }                                                                      \
+  BENCHMARK(BM_##O##_PowerLaw_##R##_##C##_##S);
+
+BM_UnsortedReducePowerLaw(UnsortedSegmentSum, 1048576, 64, 16);
+BM_UnsortedReducePowerLaw(UnsortedSegmentSum, 1048576, 64, 131072);
+
 template <typename Index>
 static void BM_SegmentReduction(::testing::benchmark::State& state,
                                 const string& reduction, Index num_rows,
@@ -0,0 +1,247 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+//
+// These kernels are created by the remapper for the weighted combiners of
+// embedding_lookup_sparse(), which otherwise gather a [nnz, dim] tensor of
+// rows, scale it and only then reduce it to [num_segments, dim].
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Reduces the rows of `data` picked by `indices`, scaled by `weights`, into
+// the output row given by `segment_ids`. Rows are accumulated in T, which is
+// float for bfloat16 and half tables. Segments are reduced in parallel, each
+// straight into its output row.
+template <typename Tdata, typename T, typename Index, typename SegmentId>
+class SparseSegmentWeightedSumOp : public OpKernel {
+ public:
+  explicit SparseSegmentWeightedSumOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& data = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& weights = context->input(2);
+    const Tensor& segment_ids = context->input(3);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(data.shape()),
+                errors::InvalidArgument("data must be at least 1-D, got ",
+                                        data.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector, got ",
+                                        indices.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(weights.shape()),
+                errors::InvalidArgument("weights should be a vector, got ",
+                                        weights.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector, got ",
+                                        segment_ids.shape().DebugString()));
+    const int64_t num_indices = indices.NumElements();
+    OP_REQUIRES(context,
+                weights.NumElements() == num_indices &&
+                    segment_ids.NumElements() == num_indices,
+                errors::InvalidArgument(
+                    "indices, weights and segment_ids should have the same "
+                    "size, got ",
+                    num_indices, ", ", weights.NumElements(), " and ",
+                    segment_ids.NumElements()));
+
+    const auto data_flat = data.flat_outer_dims<Tdata>();
+    const auto indices_vec = indices.vec<Index>();
+    const auto weights_vec = weights.vec<T>();
+    const auto segment_vec = segment_ids.vec<SegmentId>();
+    const int64_t num_rows = data_flat.dimension(0);
+    const int64_t num_col = data_flat.dimension(1);
+
+    // Validates the inputs and finds where every segment starts, so that the
+    // parallel reduction below cannot fail.
+    std::vector<int64_t> segment_starts;
+    SegmentId last_segment_id = -1;
+    for (int64_t i = 0; i < num_indices; ++i) {
+      const Index index = internal::SubtleMustCopy(indices_vec(i));
+      OP_REQUIRES(context, FastBoundsCheck(index, num_rows),
+                  errors::InvalidArgument("indices[", i, "] == ", index,
+                                          " out of range [0, ", num_rows,
+                                          ")"));
+      const SegmentId segment_id = internal::SubtleMustCopy(segment_vec(i));
+      if (i == 0 || segment_id != last_segment_id) {
+        OP_REQUIRES(context, segment_id > last_segment_id,
+                    errors::InvalidArgument(
+                        i == 0 ? "segment ids must be >= 0"
+                               : "segment ids are not increasing"));
+        segment_starts.push_back(i);
+      }
+      last_segment_id = segment_id;
+    }
+    const int64_t num_segments = segment_starts.size();
+    segment_starts.push_back(num_indices);
+
+    TensorShape output_shape = data.shape();
+    OP_REQUIRES_OK(context,
+                   output_shape.SetDimWithStatus(0, last_segment_id + 1));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+    auto output_flat = output->flat_outer_dims<T>();
+
+    auto reduce = [&](int64_t begin, int64_t end) {
+      for (int64_t s = begin; s < end; ++s) {
+        const int64_t start = segment_starts[s];
+        const int64_t limit = segment_starts[s + 1];
+        const SegmentId out_index = segment_vec(start);
+        // Segment ids without rows are zero. Every segment clears the gap
+        // between the previous segment and itself.
+        const SegmentId gap_start =
+            s == 0 ? 0 : segment_vec(segment_starts[s - 1]) + 1;
+        if (out_index > gap_start) {
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap(&output_flat(gap_start, 0), out_index - gap_start, num_col);
+          gap.setZero();
+        }
+        auto row = [&](int64_t i) {
+          return data_flat.template chip<0>(indices_vec(i)).template cast<T>() *
+                 weights_vec(i);
+        };
+        auto out = output_flat.template chip<0>(out_index);
+        out = row(start);
+        for (int64_t i = start + 1; i < limit; ++i) out += row(i);
+      }
+    };
+    const int64_t cost_per_segment =
+        std::max<int64_t>(num_indices / num_segments, 1) * num_col *
+        (2 * Eigen::TensorOpCost::AddCost<T>() +
+         Eigen::TensorOpCost::MulCost<T>());
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_segments,
+          cost_per_segment, reduce);
+  }
+};
+
+// Computes the rows of the gradient of _SparseSegmentWeightedSum with respect
+// to the gathered rows of `data`: row i is grad[segment_ids[i]] * weights[i].
+template <typename T, typename SegmentId>
+class SparseSegmentWeightedSumGradOp : public OpKernel {
+ public:
+  explicit SparseSegmentWeightedSumGradOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad = context->input(0);
+    const Tensor& weights = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad must be at least 1-D, got ",
+                                        grad.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(weights.shape()),
+                errors::InvalidArgument("weights should be a vector, got ",
+                                        weights.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector, got ",
+                                        segment_ids.shape().DebugString()));
+    const int64_t num_indices = segment_ids.NumElements();
+    OP_REQUIRES(context, weights.NumElements() == num_indices,
+                errors::InvalidArgument(
+                    "weights and segment_ids should have the same size, got ",
+                    weights.NumElements(), " and ", num_indices));
+
+    const auto grad_flat = grad.flat_outer_dims<T>();
+    const auto weights_vec = weights.vec<T>();
+    const auto segment_vec = segment_ids.vec<SegmentId>();
+    const int64_t num_segments = grad_flat.dimension(0);
+    const int64_t num_col = grad_flat.dimension(1);
+    for (int64_t i = 0; i < num_indices; ++i) {
+      const SegmentId segment_id = internal::SubtleMustCopy(segment_vec(i));
+      OP_REQUIRES(context, FastBoundsCheck(segment_id, num_segments),
+                  errors::InvalidArgument("segment_ids[", i, "] == ",
+                                          segment_id, " out of range [0, ",
+                                          num_segments, ")"));
+    }
+
+    TensorShape output_shape = grad.shape();
+    OP_REQUIRES_OK(context, output_shape.SetDimWithStatus(0, num_indices));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+    auto output_flat = output->flat_outer_dims<T>();
+
+    auto scale = [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        output_flat.template chip<0>(i) =
+            grad_flat.template chip<0>(segment_vec(i)) * weights_vec(i);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_indices,
+          num_col * Eigen::TensorOpCost::MulCost<T>(), scale);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(Tdata, T, Index, SegmentId)                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_SparseSegmentWeightedSum")                                  \
+          .Device(DEVICE_CPU)                                            \
+          .TypeConstraint<Tdata>("Tdata")                                \
+          .TypeConstraint<T>("T")                                        \
+          .TypeConstraint<Index>("Tidx")                                 \
+          .TypeConstraint<SegmentId>("Tsegmentids"),                     \
+      SparseSegmentWeightedSumOp<Tdata, T, Index, SegmentId>)
+
+#define REGISTER_CPU_KERNELS(Tdata, T)           \
+  REGISTER_CPU_KERNEL(Tdata, T, int32, int32);   \
+  REGISTER_CPU_KERNEL(Tdata, T, int32, int64_t); \
+  REGISTER_CPU_KERNEL(Tdata, T, int64_t, int32); \
+  REGISTER_CPU_KERNEL(Tdata, T, int64_t, int64_t)
+
+REGISTER_CPU_KERNELS(bfloat16, float);
+REGISTER_CPU_KERNELS(Eigen::half, float);
+REGISTER_CPU_KERNELS(float, float);
+REGISTER_CPU_KERNELS(double, double);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+#define REGISTER_CPU_GRAD_KERNEL(T, SegmentId)                           \
+  REGISTER_KERNEL_BUILDER(Name("_SparseSegmentWeightedSumGrad")          \
+                              .Device(DEVICE_CPU)                        \
+                              .TypeConstraint<T>("T")                    \
+                              .TypeConstraint<SegmentId>("Tsegmentids"), \
+                          SparseSegmentWeightedSumGradOp<T, SegmentId>)
+
+REGISTER_CPU_GRAD_KERNEL(float, int32);
+REGISTER_CPU_GRAD_KERNEL(float, int64_t);
+REGISTER_CPU_GRAD_KERNEL(double, int32);
+REGISTER_CPU_GRAD_KERNEL(double, int64_t);
+
+#undef REGISTER_CPU_GRAD_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,122 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class SparseSegmentWeightedSumOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType data_type, DataType type) {
+    TF_ASSERT_OK(
+        NodeDefBuilder("weighted_sum", "_SparseSegmentWeightedSum")
+            .Input(FakeInput(data_type))
+            .Input(FakeInput(DT_INT32))
+            .Input(FakeInput(type))
+            .Input(FakeInput(DT_INT64))
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(SparseSegmentWeightedSumOpTest, Float) {
+  MakeOp(DT_FLOAT, DT_FLOAT);
+  AddInputFromArray<float>(TensorShape({3, 2}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<int32>(TensorShape({4}), {2, 0, 2, 1});
+  AddInputFromArray<float>(TensorShape({4}), {1, 2, 0.5, -1});
+  AddInputFromArray<int64_t>(TensorShape({4}), {0, 0, 2, 3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({4, 2}));
+  test::FillValues<float>(&expected, {7, 10, 0, 0, 2.5, 3, -3, -4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, AccumulatesBfloat16InFloat) {
+  MakeOp(DT_BFLOAT16, DT_FLOAT);
+  AddInputFromArray<bfloat16>(
+      TensorShape({2, 2}),
+      {bfloat16(256), bfloat16(1), bfloat16(1), bfloat16(-2)});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 1});
+  AddInputFromArray<float>(TensorShape({3}), {1, 0.5, 0.5});
+  AddInputFromArray<int64_t>(TensorShape({3}), {0, 0, 0});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // 257 is not representable in bfloat16.
+  Tensor expected(DT_FLOAT, TensorShape({1, 2}));
+  test::FillValues<float>(&expected, {257, -1});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, Empty) {
+  MakeOp(DT_FLOAT, DT_FLOAT);
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({0}), {});
+  AddInputFromArray<int64_t>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({0, 3}), GetOutput(0)->shape());
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, IndexOutOfRange) {
+  MakeOp(DT_FLOAT, DT_FLOAT);
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 2});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 2});
+  AddInputFromArray<float>(TensorShape({2}), {1, 1});
+  AddInputFromArray<int64_t>(TensorShape({2}), {0, 1});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, UnsortedSegmentIds) {
+  MakeOp(DT_FLOAT, DT_FLOAT);
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 2});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 0});
+  AddInputFromArray<float>(TensorShape({3}), {1, 1, 1});
+  AddInputFromArray<int64_t>(TensorShape({3}), {1, 0, 1});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, Grad) {
+  TF_ASSERT_OK(
+      NodeDefBuilder("weighted_sum_grad", "_SparseSegmentWeightedSumGrad")
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_INT32))
+          .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({3, 2}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({4}), {1, 2, 0.5, -1});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 0, 2, 1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({4, 2}));
+  test::FillValues<float>(&expected, {1, 2, 2, 4, 2.5, 3, -3, -4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -19,17 +19,169 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace functor {
+
+namespace {
+// Vectorize certain operations above this size.
+constexpr std::size_t kNumVectorize = 32;
+
+// Minimum nnz * output columns for which the CPU kernel converts the sparse
+// operand to CSR and computes the rows of the output in parallel. Below it,
+// the single threaded COO loop is faster.
+constexpr int64_t kCsrMinWork = 1 << 16;
+
+Status KOutOfBoundsError(int64_t k, std::size_t i, int rhs_index_a,
+                         std::size_t lhs_right) {
+  return errors::InvalidArgument("k (", k, ") from index[", i, ",", rhs_index_a,
+                                 "] out of bounds (>=", lhs_right, ")");
+}
+
+Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
+                         int64_t out_dim0) {
+  return errors::InvalidArgument("m (", m, ") from index[", i, ",", lhs_index_a,
+                                 "] out of bounds (>=", out_dim0, ")");
+}
+}  // namespace
+
+// The structure of op(A) in compressed sparse row (CSR) form, restricted to
+// its non-empty rows. Entry j of the CSR matrix is entry perm[j] of the COO
+// input, or entry j if perm is empty, so the values of A are read in place.
+struct SparseRowStructure {
+  std::vector<int64_t> rows;        // The non-empty rows, increasing.
+  std::vector<int64_t> row_starts;  // Offsets into cols, rows.size() + 1.
+  std::vector<int64_t> cols;
+  std::vector<int64_t> perm;
+};
+
+template <typename Tindices, bool ADJ_A>
+Status BuildSparseRowStructure(typename TTypes<Tindices>::ConstMatrix a_indices,
+                               int64_t num_rows, int64_t num_cols,
+                               SparseRowStructure* csr) {
+  const int lhs_index_a = ADJ_A ? 1 : 0;
+  const int rhs_index_a = ADJ_A ? 0 : 1;
+  const int64_t nnz = a_indices.dimension(0);
+
+  std::vector<int64_t> entry_rows(nnz);
+  csr->cols.resize(nnz);
+  bool sorted = true;
+  for (int64_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, num_cols)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, num_cols);
+    }
+    if (!FastBoundsCheck(m, num_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, num_rows);
+    }
+    entry_rows[i] = m;
+    csr->cols[i] = k;
+    if (i > 0 && entry_rows[i] < entry_rows[i - 1]) sorted = false;
+  }
+
+  // Canonically ordered SparseTensors are already sorted by row unless A is
+  // adjoint. The sort is stable, so every row keeps the order of its entries.
+  if (!sorted) {
+    csr->perm.resize(nnz);
+    std::iota(csr->perm.begin(), csr->perm.end(), 0);
+    std::stable_sort(csr->perm.begin(), csr->perm.end(),
+                     [&entry_rows](int64_t x, int64_t y) {
+                       return entry_rows[x] < entry_rows[y];
+                     });
+    std::vector<int64_t> cols(nnz);
+    for (int64_t j = 0; j < nnz; ++j) cols[j] = csr->cols[csr->perm[j]];
+    csr->cols = std::move(cols);
+  }
+  for (int64_t j = 0; j < nnz; ++j) {
+    const int64_t row = entry_rows[sorted ? j : csr->perm[j]];
+    if (csr->rows.empty() || row != csr->rows.back()) {
+      csr->rows.push_back(row);
+      csr->row_starts.push_back(j);
+    }
+  }
+  csr->row_starts.push_back(nnz);
+  return OkStatus();
+}
+
+// Computes out = op(A) * op(B) from the CSR structure of op(A), in parallel
+// over the rows of the output. The entries of a row are accumulated in the
+// same order as in the COO implementation, so the results are identical.
+template <typename T, bool ADJ_A, bool ADJ_B>
+Status SparseTensorDenseMatMulCsr(OpKernelContext* ctx,
+                                  const SparseRowStructure& csr,
+                                  typename TTypes<T>::ConstVec a_values,
+                                  typename TTypes<T>::ConstMatrix b,
+                                  typename TTypes<T>::Matrix out) {
+  using Tsum = typename SumType<T>::type;
+  const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+  const int64_t rhs_right = out.dimension(1);
+  const int64_t lhs_right = ADJ_B ? b.dimension(1) : b.dimension(0);
+
+  // Every entry reads a row of op(B), so transpose and conjugate B once.
+  const T* b_data = b.data();
+  Tensor adjoint_b;
+  if (ADJ_B) {
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value,
+                           TensorShape({lhs_right, rhs_right}), &adjoint_b));
+    Eigen::array<int, 2> shuffle(1, 0);
+    adjoint_b.matrix<T>().device(d) = b.shuffle(shuffle).conjugate();
+    b_data = adjoint_b.flat<T>().data();
+  }
+  typename TTypes<T>::ConstMatrix b_rows(b_data, lhs_right, rhs_right);
+
+  // Rows of the output without entries stay zero.
+  out.device(d) = out.constant(T(0));
+
+  auto compute_rows = [&](int64_t begin, int64_t end) {
+    Eigen::Tensor<Tsum, 1, Eigen::RowMajor> sum(rhs_right);
+    for (int64_t r = begin; r < end; ++r) {
+      sum.setZero();
+      for (int64_t j = csr.row_starts[r]; j < csr.row_starts[r + 1]; ++j) {
+        const int64_t entry = csr.perm.empty() ? j : csr.perm[j];
+        const Tsum a_value = static_cast<Tsum>(
+            ADJ_A ? MaybeConj(a_values(entry)) : a_values(entry));
+        if (rhs_right < kNumVectorize) {
+          const T* b_row = &b_rows(csr.cols[j], 0);
+          for (int64_t n = 0; n < rhs_right; ++n) {
+            sum(n) += a_value * static_cast<Tsum>(b_row[n]);
+          }
+        } else {
+          sum += b_rows.template chip<0>(csr.cols[j]).template cast<Tsum>() *
+                 a_value;
+        }
+      }
+      out.template chip<0>(csr.rows[r]) = sum.template cast<T>();
+    }
+  };
+  const int64_t num_rows = csr.rows.size();
+  const int64_t cost_per_row =
+      (csr.cols.size() / num_rows + 1) * rhs_right *
+      (Eigen::TensorOpCost::AddCost<Tsum>() +
+       Eigen::TensorOpCost::MulCost<Tsum>());
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, num_rows,
+        cost_per_row, compute_rows);
+  return OkStatus();
+}
+
+}  // namespace functor
+
 template <typename Device, typename T, typename Tindices>
 class SparseTensorDenseMatMulOp : public OpKernel {
  public:
@@ -133,6 +285,26 @@ class SparseTensorDenseMatMulOp : public OpKernel {
       return;
     }
 
+    if constexpr (std::is_same<Device, CPUDevice>::value) {
+      if (ctx->device()->tensorflow_cpu_worker_threads()->num_threads > 1 &&
+          nnz * outer_right >= functor::kCsrMinWork) {
+#define MAYBE_ADJOINT_CSR(ADJ_A, ADJ_B)                                     \
+  if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                         \
+    OP_REQUIRES_OK(ctx, ComputeWithCsr<ADJ_A, ADJ_B>(                       \
+                            ctx, *a_indices, a_values->vec<T>(),            \
+                            b->matrix<T>(), outer_left, inner_left, out)); \
+  }
+
+        MAYBE_ADJOINT_CSR(false, false);
+        MAYBE_ADJOINT_CSR(false, true);
+        MAYBE_ADJOINT_CSR(true, false);
+        MAYBE_ADJOINT_CSR(true, true);
+
+#undef MAYBE_ADJOINT_CSR
+        return;
+      }
+    }
+
 #define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                           \
   if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                           \
     Status functor_status = functor::SparseTensorDenseMatMulFunctor<          \
@@ -151,6 +323,20 @@ class SparseTensorDenseMatMulOp : public OpKernel {
   }
 
  private:
+  // Multiplies with the CSR structure of op(A), which is built on every call.
+  // Building it is linear in nnz when the entries are already in row order.
+  template <bool ADJ_A, bool ADJ_B>
+  Status ComputeWithCsr(OpKernelContext* ctx, const Tensor& a_indices,
+                        typename TTypes<T>::ConstVec a_values,
+                        typename TTypes<T>::ConstMatrix b, int64_t num_rows,
+                        int64_t num_cols, Tensor* out) {
+    functor::SparseRowStructure csr;
+    TF_RETURN_IF_ERROR((functor::BuildSparseRowStructure<Tindices, ADJ_A>(
+        a_indices.matrix<Tindices>(), num_rows, num_cols, &csr)));
+    return functor::SparseTensorDenseMatMulCsr<T, ADJ_A, ADJ_B>(
+        ctx, csr, a_values, b, out->matrix<T>());
+  }
+
   bool adjoint_a_;
   bool adjoint_b_;
 };
@@ -238,35 +424,20 @@ REGISTER_KERNELS_GPU(complex128);
 namespace functor {
 
 namespace {
-Status KOutOfBoundsError(int64_t k, std::size_t i, int rhs_index_a,
-                         std::size_t lhs_right) {
-  return errors::InvalidArgument("k (", k, ") from index[", i, ",", rhs_index_a,
-                                 "] out of bounds (>=", lhs_right, ")");
-}
-
-Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
-                         int64_t out_dim0) {
-  return errors::InvalidArgument("m (", m, ") from index[", i, ",", lhs_index_a,
-                                 "] out of bounds (>=", out_dim0, ")");
-}
-
 template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
 Status SparseTensorDenseMatMulImpl(
     typename TTypes<Tsum>::Matrix out,
     typename TTypes<Tindices>::ConstMatrix a_indices,
     typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b) {
-  // Vectorize certain operations above this size.
-  static constexpr std::size_t kNumVectorize = 32;
-
   const std::size_t nnz = a_values.size();
   const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
   const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
   const int lhs_index_a = ADJ_A ? 1 : 0;
   const int rhs_index_a = ADJ_A ? 0 : 1;
 
-  // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-  // approach that achieves the performance of the single threaded
-  // one.  Perhaps Eigen threadpool implementation is just too slow?
+  // With more than one thread, large products go through
+  // SparseTensorDenseMatMulCsr instead, which sorts the entries by row to
+  // compute the rows of the output in parallel.
 
   if (rhs_right < kNumVectorize) {
     // Disable vectorization if the RHS of output is too small
@@ -14,15 +14,165 @@ limitations under the License.
 ==============================================================================*/
 
 #include <random>
+#include <tuple>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
+class SparseTensorDenseMatMulOpTest
+    : public OpsTestBase,
+      public ::testing::WithParamInterface<std::tuple<bool, bool>> {
+ protected:
+  // Multiplies a random [m, k] sparse matrix with `nnz` entries, in random
+  // order, by a random [k, n] matrix and checks the result against a dense
+  // product.
+  void RunTest(int nnz, int m, int k, int n) {
+    const bool adjoint_a = std::get<0>(GetParam());
+    const bool adjoint_b = std::get<1>(GetParam());
+    TF_ASSERT_OK(NodeDefBuilder("matmul", "SparseTensorDenseMatMul")
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("adjoint_a", adjoint_a)
+                     .Attr("adjoint_b", adjoint_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> row_dist(0, m - 1);
+    std::uniform_int_distribution<> col_dist(0, k - 1);
+    std::uniform_real_distribution<float> value_dist(-1, 1);
+    std::vector<int64_t> indices;
+    std::vector<float> values;
+    std::vector<float> dense_a(m * k, 0);
+    for (int i = 0; i < nnz; ++i) {
+      const int row = row_dist(gen);
+      const int col = col_dist(gen);
+      const float value = value_dist(gen);
+      indices.push_back(adjoint_a ? col : row);
+      indices.push_back(adjoint_a ? row : col);
+      values.push_back(value);
+      dense_a[row * k + col] += value;
+    }
+    std::vector<float> b(k * n);
+    for (float& value : b) value = value_dist(gen);
+
+    AddInputFromArray<int64_t>(TensorShape({nnz, 2}), indices);
+    AddInputFromArray<float>(TensorShape({nnz}), values);
+    AddInputFromArray<int64_t>(TensorShape({2}), {adjoint_a ? k : m,
+                                                  adjoint_a ? m : k});
+    Tensor b_t(DT_FLOAT, adjoint_b ? TensorShape({n, k}) : TensorShape({k, n}));
+    for (int i = 0; i < k; ++i) {
+      for (int j = 0; j < n; ++j) {
+        b_t.flat<float>()(adjoint_b ? j * k + i : i * n + j) = b[i * n + j];
+      }
+    }
+    AddInputFromArray<float>(b_t.shape(), b_t.flat<float>());
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(DT_FLOAT, TensorShape({m, n}));
+    auto expected_t = expected.matrix<float>();
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < n; ++j) {
+        float sum = 0;
+        for (int l = 0; l < k; ++l) sum += dense_a[i * k + l] * b[l * n + j];
+        expected_t(i, j) = sum;
+      }
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+
+    // Again with the same indices and new values.
+    inputs_[1].tensor->flat<float>() = inputs_[1].tensor->flat<float>() * 2.0f;
+    expected_t = expected_t * 2.0f;
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_P(SparseTensorDenseMatMulOpTest, Small) { RunTest(20, 8, 6, 3); }
+
+TEST_P(SparseTensorDenseMatMulOpTest, Large) { RunTest(20000, 300, 200, 40); }
+
+INSTANTIATE_TEST_SUITE_P(Adjoint, SparseTensorDenseMatMulOpTest,
+                         ::testing::Combine(::testing::Bool(),
+                                            ::testing::Bool()));
+
+class SparseTensorDenseMatMulRowOrderTest : public OpsTestBase {
+ protected:
+  static constexpr int kNnz = 4096;
+  static constexpr int kM = 256;
+  static constexpr int kK = 64;
+  static constexpr int kN = 32;
+
+  // Adds the inputs of a [kM, kK] sparse matrix with entries in row order
+  // times a [kK, kN] matrix, large enough for the CSR path.
+  void SetUpOp() {
+    TF_ASSERT_OK(NodeDefBuilder("matmul", "SparseTensorDenseMatMul")
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    std::vector<int64_t> indices;
+    std::vector<float> values;
+    for (int i = 0; i < kNnz; ++i) {
+      indices.push_back(i * kM / kNnz);
+      indices.push_back((i * 7) % kK);
+      values.push_back(i % 5 - 2);
+    }
+    std::vector<float> b(kK * kN);
+    for (int i = 0; i < kK * kN; ++i) b[i] = i % 3 - 1;
+    AddInputFromArray<int64_t>(TensorShape({kNnz, 2}), indices);
+    AddInputFromArray<float>(TensorShape({kNnz}), values);
+    AddInputFromArray<int64_t>(TensorShape({2}), {kM, kK});
+    AddInputFromArray<float>(TensorShape({kK, kN}), b);
+  }
+
+  // Returns the product of the current inputs, computed densely.
+  Tensor Expected() {
+    const auto indices = inputs_[0].tensor->matrix<int64_t>();
+    const auto values = inputs_[1].tensor->vec<float>();
+    const auto b = inputs_[3].tensor->matrix<float>();
+    Tensor expected(DT_FLOAT, TensorShape({kM, kN}));
+    auto expected_t = expected.matrix<float>();
+    expected_t.setZero();
+    for (int i = 0; i < kNnz; ++i) {
+      for (int j = 0; j < kN; ++j) {
+        expected_t(indices(i, 0), j) += values(i) * b(indices(i, 1), j);
+      }
+    }
+    return expected;
+  }
+};
+
+TEST_F(SparseTensorDenseMatMulRowOrderTest, InputsUpdatedInPlace) {
+  SetUpOp();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(), *GetOutput(0), 1e-4);
+
+  // New values, then new indices, in the same buffers.
+  inputs_[1].tensor->flat<float>() = inputs_[1].tensor->flat<float>() * 2.0f;
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(), *GetOutput(0), 1e-4);
+  auto indices = inputs_[0].tensor->matrix<int64_t>();
+  indices(kNnz - 1, 1) = (indices(kNnz - 1, 1) + 1) % kK;
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(), *GetOutput(0), 1e-4);
+}
+
 Node* SparseTensorDenseMatMulNode(Graph* g, Node* a_indices, Node* a_values,
                                   Node* a_shape, Node* b, bool adjoint_a,
                                   bool adjoint_b) {
@@ -15,7 +15,9 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -28,79 +30,93 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 // Split input string `str` based on a character delimiter.
-// Returns a vector of StringPieces which are valid as long as input `str`
-// is valid.
+// Appends StringPieces which are valid as long as input `str` is valid to
+// `result`.
 // Note: The single character delimiter is a common case and is implemented as
-// a series of finds in the input string, making it much more efficient than
-// SplitOnCharSet.
+// a series of finds (memchr) in the input string, making it much more
+// efficient than SplitOnCharSet.
 template <typename Predicate>
-std::vector<StringPiece> SplitOnChar(const tstring& str, const char delim,
-                                     Predicate p) {
-  std::vector<StringPiece> result;
+void SplitOnChar(const tstring& str, const char delim, Predicate p,
+                 std::vector<StringPiece>* result) {
   StringPiece text(str);
   auto f = text.find(delim);
   while (f != StringPiece::npos) {
     StringPiece token = text.substr(0, f);
     if (p(token)) {
-      result.emplace_back(token);
+      result->emplace_back(token);
     }
     text.remove_prefix(f + 1);
     f = text.find(delim);
   }
   if (p(text)) {
-    result.push_back(text);
+    result->push_back(text);
   }
-  return result;
 }
 
+// A set of single-byte delimiters. Membership is one table lookup, so
+// scanning a string costs the same for any number of delimiters.
+class DelimiterSet {
+ public:
+  explicit DelimiterSet(StringPiece delims) {
+    for (char c : delims) {
+      is_delim_[static_cast<unsigned char>(c)] = true;
+    }
+  }
+
+  bool Contains(char c) const {
+    return is_delim_[static_cast<unsigned char>(c)];
+  }
+
+ private:
+  bool is_delim_[256] = {};
+};
+
 // Split input string `str` based on a set of character delimiters.
-// Returns a vector of StringPieces which are valid as long as input `str`
-// is valid.
+// Appends StringPieces which are valid as long as input `str` is valid to
+// `result`.
 // Based on str_util::Split.
 template <typename Predicate>
-std::vector<StringPiece> SplitOnCharSet(const tstring& str,
-                                        const tstring& delim_set, Predicate p) {
-  std::vector<StringPiece> result;
+void SplitOnCharSet(const tstring& str, const DelimiterSet& delims,
+                    Predicate p, std::vector<StringPiece>* result) {
   StringPiece text(str);
-  StringPiece delims(delim_set);
   size_t token_start = 0;
   for (size_t i = 0; i < text.size() + 1; i++) {
-    if ((i == text.size()) || (delims.find(text[i]) != StringPiece::npos)) {
+    if ((i == text.size()) || delims.Contains(text[i])) {
       StringPiece token(text.data() + token_start, i - token_start);
       if (p(token)) {
-        result.emplace_back(token);
+        result->emplace_back(token);
       }
       token_start = i + 1;
     }
   }
-  return result;
 }
 
-// Split input string `str` based on given delimiter.
-// Returns a vector of StringPieces which are valid as long as input `str`
-// is valid.
+// Split input string `str` based on given delimiter, whose bytes are
+// `delim_set`.
+// Appends StringPieces which are valid as long as input `str` is valid to
+// `result`.
 template <typename Predicate>
-std::vector<StringPiece> Split(const tstring& str, const tstring& delimiter,
-                               Predicate predicate) {
+void Split(const tstring& str, const tstring& delimiter,
+           const DelimiterSet& delim_set, Predicate predicate,
+           std::vector<StringPiece>* result) {
   if (str.empty()) {
-    return std::vector<StringPiece>();
+    return;
   }
   if (delimiter.empty()) {
-    std::vector<StringPiece> result;
-    result.resize(str.size());
     for (size_t i = 0; i < str.size(); ++i) {
-      result[i] = StringPiece(str.data() + i, 1);
+      result->emplace_back(str.data() + i, 1);
     }
-    return result;
+    return;
   }
   if (delimiter.size() == 1) {
-    return SplitOnChar(str, delimiter[0], predicate);
+    SplitOnChar(str, delimiter[0], predicate, result);
+    return;
   }
-  return SplitOnCharSet(str, delimiter, predicate);
+  SplitOnCharSet(str, delim_set, predicate, result);
 }
 
-std::vector<StringPiece> SplitV2(const tstring& str, StringPiece sep,
-                                 int maxsplit) {
+void SplitV2(const tstring& str, StringPiece sep, int maxsplit,
+             std::vector<StringPiece>* result) {
   // This SplitV2 method matches the behavior of python's str.split:
   //   If sep is given, consecutive delimiters are not grouped together
   //   and are deemed to delimit empty strings (for example, '1,,2'.split(',')
@@ -115,12 +131,10 @@ std::vector<StringPiece> SplitV2(const tstring& str, StringPiece sep,
   //   splitting an empty string or a string consisting of just whitespace
   //   with a None separator returns [].
 
-  std::vector<StringPiece> result;
-
   StringPiece text(str);
   if (maxsplit == 0) {
-    result.emplace_back(text);
-    return result;
+    result->emplace_back(text);
+    return;
   }
 
   if (sep.empty()) {
@@ -129,32 +143,33 @@ std::vector<StringPiece> SplitV2(const tstring& str, StringPiece sep,
     str_util::RemoveLeadingWhitespace(&text);
     int split = 0;
     while (str_util::ConsumeNonWhitespace(&text, &token)) {
-      result.push_back(token);
+      result->push_back(token);
       str_util::RemoveLeadingWhitespace(&text);
       ++split;
       if (maxsplit > 0 && split == maxsplit) {
-        result.push_back(text);
-        return result;
+        result->push_back(text);
+        return;
       }
     }
-    return result;
+    return;
   }
-  auto p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
+  // find() looks for the first byte of `sep` with memchr before comparing
+  // the rest, which is much faster than a byte-by-byte std::search.
+  auto f = text.find(sep);
   int split = 0;
-  while (p != text.end()) {
-    StringPiece token = text.substr(0, p - text.begin());
-    result.push_back(token);
+  while (f != StringPiece::npos) {
+    StringPiece token = text.substr(0, f);
+    result->push_back(token);
     text.remove_prefix(token.size());
     text.remove_prefix(sep.size());
     ++split;
     if (maxsplit > 0 && split == maxsplit) {
-      result.push_back(StringPiece(text));
-      return result;
+      result->push_back(StringPiece(text));
+      return;
     }
-    p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
+    f = text.find(sep);
   }
-  result.push_back(text);
-  return result;
+  result->push_back(text);
 }
 
 }  // namespace
@@ -189,6 +204,7 @@ class StringSplitOp : public OpKernel {
                                 delimiter_tensor->shape().DebugString()));
     const auto delimiter_vec = delimiter_tensor->flat<tstring>();
     const tstring& delimiter = delimiter_vec(0);
+    const DelimiterSet delim_set(delimiter);
     // Empty delimiter means split the input character by character.
     std::vector<StringPiece> tokens;
     // Guess that we'll be unpacking a handful of tokens per example.
@@ -199,15 +215,18 @@ class StringSplitOp : public OpKernel {
     int64_t max_num_entries = 0;
     std::vector<int64_t> num_indices(batch_size);
     for (int64_t i = 0; i < batch_size; ++i) {
-      std::vector<StringPiece> parts =
-          skip_empty_ ? Split(input_vec(i), delimiter, str_util::SkipEmpty())
-                      : Split(input_vec(i), delimiter, str_util::AllowEmpty());
-      int64_t n_entries = parts.size();
+      // Tokens are appended straight to `tokens`, without a vector per input.
+      if (skip_empty_) {
+        Split(input_vec(i), delimiter, delim_set, str_util::SkipEmpty(),
+              &tokens);
+      } else {
+        Split(input_vec(i), delimiter, delim_set, str_util::AllowEmpty(),
+              &tokens);
+      }
+      int64_t n_entries = tokens.size() - output_size;
       num_indices[i] = n_entries;
       output_size += n_entries;
       max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), std::make_move_iterator(parts.begin()),
-                    std::make_move_iterator(parts.end()));
     }
 
     Tensor* sp_indices_t;
@@ -272,12 +291,11 @@ class StringSplitV2Op : public OpKernel {
     int64_t max_num_entries = 0;
     std::vector<int64_t> num_indices(batch_size);
     for (int64_t i = 0; i < batch_size; ++i) {
-      std::vector<StringPiece> parts = SplitV2(input_vec(i), sep, maxsplit_);
-      int64_t n_entries = parts.size();
+      SplitV2(input_vec(i), sep, maxsplit_, &tokens);
+      int64_t n_entries = tokens.size() - output_size;
       num_indices[i] = n_entries;
       output_size += n_entries;
       max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
     }
 
     Tensor* sp_indices_t;
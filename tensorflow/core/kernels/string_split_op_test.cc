@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -64,6 +66,70 @@ Tensor GetTestTensor(int batch) {
   return t;
 }
 
+class StringSplitOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(bool skip_empty) {
+    TF_ASSERT_OK(NodeDefBuilder("string_split_op", "StringSplit")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_STRING))
+                     .Attr("skip_empty", skip_empty)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void ExpectTokens(const std::vector<int64_t>& indices,
+                    const std::vector<tstring>& tokens,
+                    const std::vector<int64_t>& shape) {
+    const int64_t num_tokens = tokens.size();
+    Tensor expected_indices(DT_INT64, TensorShape({num_tokens, 2}));
+    test::FillValues<int64_t>(&expected_indices, indices);
+    test::ExpectTensorEqual<int64_t>(expected_indices, *GetOutput(0));
+    test::ExpectTensorEqual<tstring>(test::AsTensor<tstring>(tokens),
+                                     *GetOutput(1));
+    test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>(shape),
+                                     *GetOutput(2));
+  }
+};
+
+TEST_F(StringSplitOpTest, SingleCharDelimiter) {
+  MakeOp(/*skip_empty=*/true);
+  AddInputFromArray<tstring>(TensorShape({3}), {"a b", " c  d ", ""});
+  AddInputFromArray<tstring>(TensorShape({}), {" "});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectTokens({0, 0, 0, 1, 1, 0, 1, 1}, {"a", "b", "c", "d"}, {3, 2});
+}
+
+TEST_F(StringSplitOpTest, DelimiterSet) {
+  MakeOp(/*skip_empty=*/false);
+  AddInputFromArray<tstring>(TensorShape({2}), {"a,b;c", ";x"});
+  AddInputFromArray<tstring>(TensorShape({}), {",;"});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectTokens({0, 0, 0, 1, 0, 2, 1, 0, 1, 1}, {"a", "b", "c", "", "x"},
+               {2, 3});
+}
+
+TEST_F(StringSplitOpTest, EmptyDelimiter) {
+  MakeOp(/*skip_empty=*/true);
+  AddInputFromArray<tstring>(TensorShape({2}), {"ab", "c"});
+  AddInputFromArray<tstring>(TensorShape({}), {""});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectTokens({0, 0, 0, 1, 1, 0}, {"a", "b", "c"}, {2, 2});
+}
+
+TEST_F(StringSplitOpTest, SplitV2MultiCharSeparator) {
+  TF_ASSERT_OK(NodeDefBuilder("string_split_op", "StringSplitV2")
+                   .Input(FakeInput(DT_STRING))
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("maxsplit", -1)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<tstring>(TensorShape({2}), {"1<>2<><>3", "<<>"});
+  AddInputFromArray<tstring>(TensorShape({}), {"<>"});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectTokens({0, 0, 0, 1, 0, 2, 0, 3, 1, 0, 1, 1},
+               {"1", "2", "", "3", "<", ""}, {2, 4});
+}
+
 Graph* SetupStringSplitGraph(const Tensor& input) {
   Graph* g = new Graph(OpRegistry::Global());
   Tensor delim(DT_STRING, TensorShape({}));
@@ -20,7 +20,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/topk_op.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <numeric>
+#include <type_traits>
 #include <vector>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -30,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -127,6 +133,207 @@ class TopK : public OpKernel {
   bool sorted_;
 };
 
+namespace {
+
+// Rows at least this wide are split across columns when there are too few of
+// them to keep the threads busy.
+constexpr int64_t kMinColumnsForColumnParallelTopK = 1 << 16;
+// Columns of a row handled by one shard of the column-parallel top-k.
+constexpr int64_t kTopKColumnBlockSize = 1 << 14;
+// Values sampled from a row to estimate the threshold of its top k.
+constexpr int64_t kTopKSampleSize = 1 << 14;
+// Bits of the radix select digits, which index histograms of 2^11 counts.
+constexpr int kTopKRadixBits = 11;
+
+template <typename T>
+using TopKRadixKey = std::conditional_t<sizeof(T) == 8, uint64, uint32>;
+
+// Maps `value` to an unsigned key with the same order, whose top bits the
+// radix select histograms. Both zeros map to the same key since they compare
+// equal. NaNs have no place in the order and must be checked for separately.
+template <typename T>
+TopKRadixKey<T> ToTopKRadixKey(T value) {
+  using Key = TopKRadixKey<T>;
+  constexpr Key kSignBit = Key{1} << (8 * sizeof(Key) - 1);
+  if constexpr (Eigen::NumTraits<T>::IsInteger) {
+    if constexpr (std::numeric_limits<T>::is_signed) {
+      using SignedKey = std::make_signed_t<Key>;
+      return static_cast<Key>(static_cast<SignedKey>(value)) ^ kSignBit;
+    } else {
+      return static_cast<Key>(value);
+    }
+  } else {
+    using Float = std::conditional_t<sizeof(T) == 8, double, float>;
+    // Adding zero turns -0 into +0.
+    const Float f = static_cast<Float>(value) + Float{0};
+    Key bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    // Flips all bits of negative values and only the sign bit of the others,
+    // without branching on the sign.
+    const Key negative = static_cast<Key>(
+        static_cast<std::make_signed_t<Key>>(bits) >> (8 * sizeof(Key) - 1));
+    return bits ^ (negative | kSignBit);
+  }
+}
+
+// Appends the indices of the values of `row` that pass `filter` to
+// `candidates`, in increasing order. The row is filtered in parallel, block
+// by block. Returns false if the row holds NaNs.
+template <typename T, typename Tidx, typename Filter>
+bool FilterTopKCandidates(const DeviceBase::CpuWorkerThreads& worker_threads,
+                          const T* row, int64_t num_cols, Filter filter,
+                          std::vector<Tidx>* candidates) {
+  const int64_t num_blocks =
+      (num_cols + kTopKColumnBlockSize - 1) / kTopKColumnBlockSize;
+  std::vector<std::vector<Tidx>> block_candidates(num_blocks);
+  std::atomic<bool> has_nan(false);
+  auto filter_blocks = [&](int64_t begin, int64_t end) {
+    for (int64_t block = begin; block < end; ++block) {
+      std::vector<Tidx>& passed = block_candidates[block];
+      const int64_t start = block * kTopKColumnBlockSize;
+      const int64_t limit = std::min(num_cols, start + kTopKColumnBlockSize);
+      bool block_has_nan = false;
+      for (int64_t c = start; c < limit; ++c) {
+        if (filter(row[c])) passed.push_back(static_cast<Tidx>(c));
+        if constexpr (!Eigen::NumTraits<T>::IsInteger) {
+          block_has_nan |= Eigen::numext::isnan(row[c]);
+        }
+      }
+      if (block_has_nan) has_nan = true;
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+        kTopKColumnBlockSize * 4 * Eigen::TensorOpCost::AddCost<T>(),
+        filter_blocks);
+  if (has_nan) return false;
+  for (const std::vector<Tidx>& passed : block_candidates) {
+    candidates->insert(candidates->end(), passed.begin(), passed.end());
+  }
+  return true;
+}
+
+// Returns the smallest key that at least k keys of a NaN-free row reach,
+// rounded down to the radix digits examined. Each pass histograms the next
+// digit of the keys that share the digits picked so far, until few enough
+// keys reach the threshold.
+template <typename T>
+TopKRadixKey<T> RadixSelectTopKThreshold(
+    const DeviceBase::CpuWorkerThreads& worker_threads, const T* row,
+    int64_t num_cols, int k) {
+  using Key = TopKRadixKey<T>;
+  constexpr int kKeyBits = 8 * sizeof(Key);
+  const int64_t max_candidates = std::max<int64_t>(2 * k, kTopKColumnBlockSize);
+  const int64_t num_blocks =
+      (num_cols + kTopKColumnBlockSize - 1) / kTopKColumnBlockSize;
+  // `num_above` keys are above `prefix` in the bits under `prefix_mask`;
+  // `num_candidates` keys also count those equal to it.
+  Key prefix = 0;
+  Key prefix_mask = 0;
+  int prefix_bits = 0;
+  int64_t num_above = 0;
+  int64_t num_candidates = num_cols;
+  std::vector<int64_t> histogram;
+  mutex mu;
+  while (prefix_bits < kKeyBits && num_candidates > max_candidates) {
+    const int digit_bits = std::min(kTopKRadixBits, kKeyBits - prefix_bits);
+    const int shift = kKeyBits - prefix_bits - digit_bits;
+    const int64_t num_digits = int64_t{1} << digit_bits;
+    histogram.assign(num_digits, 0);
+    auto histogram_blocks = [&](int64_t begin, int64_t end) {
+      std::vector<int64_t> local_histogram(num_digits);
+      const int64_t limit = std::min(num_cols, end * kTopKColumnBlockSize);
+      for (int64_t c = begin * kTopKColumnBlockSize; c < limit; ++c) {
+        const Key key = ToTopKRadixKey(row[c]);
+        if ((key & prefix_mask) == prefix) {
+          ++local_histogram[(key >> shift) & (num_digits - 1)];
+        }
+      }
+      mutex_lock l(mu);
+      for (int64_t i = 0; i < num_digits; ++i) {
+        histogram[i] += local_histogram[i];
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          kTopKColumnBlockSize * 4 * Eigen::TensorOpCost::AddCost<Key>(),
+          histogram_blocks);
+
+    // Picks the largest digit with at least k keys at or above it.
+    int64_t digit = num_digits - 1;
+    while (digit > 0 && num_above + histogram[digit] < k) {
+      num_above += histogram[digit--];
+    }
+    num_candidates = num_above + histogram[digit];
+    prefix |= static_cast<Key>(digit) << shift;
+    prefix_mask |= static_cast<Key>(num_digits - 1) << shift;
+    prefix_bits += digit_bits;
+  }
+  return prefix;
+}
+
+// Writes the indices of the top k values of a row too wide for one thread to
+// `indices`, in the order of the heap-based top-k: by decreasing value, then
+// by increasing index. The row is filtered in parallel down to the values
+// reaching a threshold, and only those candidates are sorted. The threshold is
+// first estimated from a sample, so that a little over 2k values reach it, and
+// found by radix select in the rare case that fewer than k do. Returns false
+// without writing anything if the row holds NaNs, which only the heap-based
+// top-k orders as before.
+template <typename T, typename Tidx>
+bool ColumnParallelTopK(const DeviceBase::CpuWorkerThreads& worker_threads,
+                        const T* row, int64_t num_cols, int k, Tidx* indices) {
+  std::vector<T> sample;
+  sample.reserve(kTopKSampleSize);
+  const int64_t stride = std::max<int64_t>(num_cols / kTopKSampleSize, 1);
+  for (int64_t c = 0; c < num_cols && sample.size() < sample.capacity();
+       c += stride) {
+    if constexpr (!Eigen::NumTraits<T>::IsInteger) {
+      if (Eigen::numext::isnan(row[c])) return false;
+    }
+    sample.push_back(row[c]);
+  }
+  // Aims for 2k candidates, plus the values above the 16 largest samples so
+  // that the estimate is rarely too high when k is small.
+  const int64_t sample_size = sample.size();
+  const int64_t sample_rank =
+      std::min(2 * k * sample_size / num_cols + 16, sample_size - 1);
+  std::nth_element(sample.begin(), sample.begin() + sample_rank, sample.end(),
+                   std::greater<T>());
+  const T estimate = sample[sample_rank];
+
+  std::vector<Tidx> candidates;
+  if (!FilterTopKCandidates(worker_threads, row, num_cols,
+                            [estimate](T value) { return value >= estimate; },
+                            &candidates)) {
+    return false;
+  }
+  if (static_cast<int64_t>(candidates.size()) < k) {
+    const TopKRadixKey<T> threshold =
+        RadixSelectTopKThreshold(worker_threads, row, num_cols, k);
+    candidates.clear();
+    FilterTopKCandidates(
+        worker_threads, row, num_cols,
+        [threshold](T value) { return ToTopKRadixKey(value) >= threshold; },
+        &candidates);
+  }
+  DCHECK_GE(static_cast<int64_t>(candidates.size()), k);
+
+  const auto stable_comp = [row](const Tidx a, const Tidx b) {
+    if (row[b] < row[a]) {
+      return true;
+    } else if (row[b] > row[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  };
+  std::partial_sort(candidates.begin(), candidates.begin() + k,
+                    candidates.end(), stable_comp);
+  std::copy_n(candidates.begin(), k, indices);
+  return true;
+}
+
+}  // namespace
+
 namespace functor {
 
 template <typename T, typename Tidx>
@@ -233,6 +440,25 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
       }  // for (Tidx b = ...
     };
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    // Too few rows to shard over: split each row across the threads instead.
+    // A single row is always split, since filtering it against a threshold
+    // also beats the heap on one thread.
+    if (k < num_cols && num_cols >= kMinColumnsForColumnParallelTopK &&
+        (num_rows == 1 || num_rows < worker_threads.num_threads)) {
+      for (int64_t b = 0; b < num_rows; ++b) {
+        if (ColumnParallelTopK(worker_threads, &input(b, 0), num_cols, k,
+                               &indices(b, 0))) {
+          std::transform(
+              &indices(b, 0), &indices(b, k), &values(b, 0),
+              [b, &input](const Tidx loc) { return input(b, loc); });
+        } else {
+          SortIndices(b, b + 1);
+        }
+      }
+      return OkStatus();
+    }
+
     // Guesstimate of cost; 4*N*log(K) where N == num_cols.
     // If K == N, assume the cost is N*log(K + 1).
     const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<Tidx>() +
@@ -247,7 +473,6 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
     const int64_t final_cost = (total_cost >= static_cast<double>(kint64max))
                                    ? kint64max
                                    : static_cast<int64_t>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Rows this wide are split across columns.
+constexpr int kWideRow = 100000;
+
+class TopKOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  void RunTopK(const std::vector<T>& input, int64_t num_rows, int k,
+               bool sorted = true) {
+    TF_ASSERT_OK(NodeDefBuilder("top_k", "TopKV2")
+                     .Input(FakeInput(DataTypeToEnum<T>::value))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("sorted", sorted)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const int64_t num_cols = input.size() / num_rows;
+    AddInputFromArray<T>(TensorShape({num_rows, num_cols}), input);
+    AddInputFromArray<int32>(TensorShape({}), {k});
+    TF_ASSERT_OK(RunOpKernel());
+  }
+
+  // Checks the outputs against a stable sort of every row by decreasing
+  // value, which breaks ties by increasing index.
+  template <typename T>
+  void ExpectTopK(const std::vector<T>& input, int64_t num_rows, int k) {
+    const int64_t num_cols = input.size() / num_rows;
+    Tensor expected_values(DataTypeToEnum<T>::value,
+                           TensorShape({num_rows, k}));
+    Tensor expected_indices(DT_INT32, TensorShape({num_rows, k}));
+    for (int64_t b = 0; b < num_rows; ++b) {
+      const T* row = &input[b * num_cols];
+      std::vector<int32> order(num_cols);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(),
+                       [row](int32 x, int32 y) { return row[y] < row[x]; });
+      for (int i = 0; i < k; ++i) {
+        expected_values.matrix<T>()(b, i) = row[order[i]];
+        expected_indices.matrix<int32>()(b, i) = order[i];
+      }
+    }
+    test::ExpectTensorEqual<T>(expected_values, *GetOutput(0));
+    test::ExpectTensorEqual<int32>(expected_indices, *GetOutput(1));
+  }
+};
+
+std::vector<float> RandomFloats(int64_t size, int num_distinct) {
+  random::PhiloxRandom philox(17, 29);
+  random::SimplePhilox rnd(&philox);
+  std::vector<float> values(size);
+  for (float& value : values) {
+    value = num_distinct > 0 ? rnd.Uniform(num_distinct) - num_distinct / 2
+                             : rnd.RandFloat() - 0.5f;
+  }
+  return values;
+}
+
+TEST_F(TopKOpTest, WideRow) {
+  const std::vector<float> input = RandomFloats(kWideRow, 0);
+  RunTopK(input, 1, 100);
+  ExpectTopK(input, 1, 100);
+}
+
+TEST_F(TopKOpTest, WideRowLargeK) {
+  const std::vector<float> input = RandomFloats(kWideRow, 0);
+  RunTopK(input, 1, 60000);
+  ExpectTopK(input, 1, 60000);
+}
+
+TEST_F(TopKOpTest, WideRowTiesKeepLowestIndices) {
+  const std::vector<float> input = RandomFloats(2 * kWideRow, 5);
+  RunTopK(input, 2, 1000);
+  ExpectTopK(input, 2, 1000);
+}
+
+TEST_F(TopKOpTest, WideRowZerosOfBothSigns) {
+  std::vector<float> input(kWideRow, 0.0f);
+  for (int i = 0; i < kWideRow; i += 3) input[i] = -0.0f;
+  input[kWideRow / 2] = -1.0f;
+  RunTopK(input, 1, 10);
+  ExpectTopK(input, 1, 10);
+}
+
+TEST_F(TopKOpTest, WideRowThresholdEstimateTooHigh) {
+  // Only the columns that the threshold is estimated from are nonzero, so
+  // that too few values reach the estimate and the threshold has to be found
+  // by radix select. The row is sampled every 6 columns, 16384 times.
+  std::vector<float> input(kWideRow, 0.0f);
+  for (int i = 0; i < 6 * 16384; i += 6) input[i] = i;
+  RunTopK(input, 1, 150);
+  ExpectTopK(input, 1, 150);
+}
+
+TEST_F(TopKOpTest, WideRowInt64) {
+  random::PhiloxRandom philox(3, 5);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64_t> input(kWideRow);
+  for (int64_t& value : input) {
+    value = static_cast<int64_t>(rnd.Rand64());
+  }
+  input[7] = std::numeric_limits<int64_t>::max();
+  input[8] = std::numeric_limits<int64_t>::min();
+  RunTopK(input, 1, 500);
+  ExpectTopK(input, 1, 500);
+}
+
+TEST_F(TopKOpTest, WideRowUnsorted) {
+  const std::vector<float> input = RandomFloats(kWideRow, 100);
+  RunTopK(input, 1, 300, /*sorted=*/false);
+  // Unsorted results make no promise about their order, only their set.
+  std::vector<int32> indices(300);
+  std::copy_n(GetOutput(1)->flat<int32>().data(), 300, indices.begin());
+  std::sort(indices.begin(), indices.end());
+  std::vector<int32> order(kWideRow);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&input](int32 x, int32 y) {
+    return input[y] < input[x];
+  });
+  order.resize(300);
+  std::sort(order.begin(), order.end());
+  EXPECT_EQ(order, indices);
+}
+
+TEST_F(TopKOpTest, WideRowWithNaN) {
+  std::vector<float> input = RandomFloats(kWideRow, 0);
+  input[1234] = std::numeric_limits<float>::quiet_NaN();
+  RunTopK(input, 1, 10);
+  EXPECT_EQ(TensorShape({1, 10}), GetOutput(1)->shape());
+}
+
+TEST_F(TopKOpTest, NarrowRows) {
+  const std::vector<float> input = RandomFloats(64 * 100, 7);
+  RunTopK(input, 64, 9);
+  ExpectTopK(input, 64, 9);
+}
+
+}  // namespace
+}  // namespace tensorflow
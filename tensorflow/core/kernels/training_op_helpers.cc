@@ -15,10 +15,44 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_op_helpers.h"
 
+#include <algorithm>
+
 
 namespace tensorflow {
 
 
+VariableRowStripeLocks::VariableRowStripeLocks(
+    OpKernelContext* ctx, const std::vector<int>& input_ids,
+    const std::vector<int>& stripes) TF_NO_THREAD_SAFETY_ANALYSIS {
+  for (auto input : input_ids) {
+    Var* var;
+    // Invalid references are reported when the variables are read.
+    if (!LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) continue;
+    if (std::find(vars_.begin(), vars_.end(), var) != vars_.end()) {
+      var->Unref();
+      continue;
+    }
+    vars_.push_back(var);
+    for (auto stripe : stripes) {
+      mutexes_.push_back(var->row_stripe_mu(stripe));
+    }
+  }
+  std::sort(mutexes_.begin(), mutexes_.end());
+  for (mutex* mu : mutexes_) {
+    mu->lock();
+  }
+}
+
+VariableRowStripeLocks::~VariableRowStripeLocks()
+    TF_NO_THREAD_SAFETY_ANALYSIS {
+  for (mutex* mu : mutexes_) {
+    mu->unlock();
+  }
+  for (Var* var : vars_) {
+    var->Unref();
+  }
+}
+
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output) {
   if (ctx->input_dtype(input) != DT_RESOURCE) {
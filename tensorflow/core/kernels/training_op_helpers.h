@@ -17,7 +17,10 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_TRAINING_OP_HELPERS_H_
 
 #include <optional>
+#include <type_traits>
+#include <vector>
 
+#include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
@@ -213,6 +216,68 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
   return variableInputLock;
 }
 
+// Returns whether a sparse update that asks for exclusive locks with `do_lock`
+// can hold the mutexes of the variables at `input_ids` shared and lock only
+// the row stripes it writes with `VariableRowStripeLocks`, so that concurrent
+// updates of different rows of the same variables don't serialize. Readers of
+// the variables hold their mutexes shared and are not excluded by the stripe
+// locks, so updates must opt in with `use_row_locking`. All of the variables
+// must also be resource variables updated on CPU.
+template <typename Device>
+bool CanLockVariableRowStripes(OpKernelContext* ctx, bool do_lock,
+                               bool use_row_locking,
+                               const std::vector<int>& input_ids) {
+  if (!do_lock || !use_row_locking ||
+      !std::is_same<Device, Eigen::ThreadPoolDevice>::value) {
+    return false;
+  }
+  for (auto i : input_ids) {
+    if (ctx->input_dtype(i) != DT_RESOURCE) return false;
+  }
+  return true;
+}
+
+// Returns the sorted row stripes of a variable with `num_rows` rows that
+// `indices` fall in, see `Var::row_stripe_mu()`. Out of range indices are
+// skipped; the update reports them.
+template <typename Tindex>
+std::vector<int> VariableRowStripes(typename TTypes<Tindex>::ConstVec indices,
+                                    int64_t num_rows) {
+  std::vector<int> stripes;
+  if (num_rows == 0) return stripes;
+  const int64_t rows_per_stripe =
+      (num_rows + Var::kNumRowStripes - 1) / Var::kNumRowStripes;
+  std::vector<bool> touched(Var::kNumRowStripes, false);
+  for (int64_t i = 0; i < indices.dimension(0); ++i) {
+    const Tindex index = internal::SubtleMustCopy(indices(i));
+    if (FastBoundsCheck(index, num_rows)) {
+      touched[index / rows_per_stripe] = true;
+    }
+  }
+  for (int stripe = 0; stripe < Var::kNumRowStripes; ++stripe) {
+    if (touched[stripe]) stripes.push_back(stripe);
+  }
+  return stripes;
+}
+
+// Exclusive locks on the row stripes `stripes` of the resource variables at
+// `input_ids`, acquired in address order and released when deleted. The
+// mutexes of the variables must already be held shared.
+class VariableRowStripeLocks {
+ public:
+  VariableRowStripeLocks(OpKernelContext* ctx,
+                         const std::vector<int>& input_ids,
+                         const std::vector<int>& stripes);
+  ~VariableRowStripeLocks();
+
+ private:
+  std::vector<Var*> vars_;
+  std::vector<mutex*> mutexes_;
+
+  VariableRowStripeLocks(const VariableRowStripeLocks&) = delete;
+  void operator=(const VariableRowStripeLocks&) = delete;
+};
+
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output);
 
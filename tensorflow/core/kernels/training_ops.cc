@@ -17,6 +17,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_ops.h"
 
 #include <algorithm>  // NOLINT
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -40,6 +44,102 @@ inline T sgn(const T x) {
   T one(1);
   return (x == zero ? zero : (x < zero ? -one : one));
 }
+
+// Calls `update_row(index, i)` for every offset i in `indices`, where index is
+// indices(i), after checking that all of them are in [0, first_dim_size). The
+// updates are grouped by row, so that every row is updated by one thread in
+// the order of its offsets, and the threads take ranges of consecutive rows.
+// Unlike sharding the offsets, this keeps duplicate indices from racing.
+template <typename Tindex, typename UpdateRow>
+Status ParallelUpdateSparseRows(const CPUDevice& d,
+                                typename TTypes<Tindex>::ConstVec indices,
+                                Tindex first_dim_size,
+                                const Eigen::TensorOpCost& cost_per_update,
+                                UpdateRow update_row) {
+  const Tindex N = static_cast<Tindex>(indices.dimension(0));
+  // Pairs of (index, offset), sorted by index and then by offset.
+  std::vector<std::pair<Tindex, Tindex>> updates(N);
+  bool sorted = true;
+  for (Tindex i = 0; i < N; ++i) {
+    const Tindex index = internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(index, first_dim_size)) {
+      return errors::InvalidArgument(strings::StrCat(
+          "Index ", index, " at offset ", i, " in indices is out of range"));
+    }
+    updates[i] = {index, i};
+    if (i > 0 && index < updates[i - 1].first) sorted = false;
+  }
+  if (!sorted) std::sort(updates.begin(), updates.end());
+
+  std::vector<Tindex> row_starts;
+  for (Tindex i = 0; i < N; ++i) {
+    if (i == 0 || updates[i].first != updates[i - 1].first) {
+      row_starts.push_back(i);
+    }
+  }
+  const Tindex num_rows = row_starts.size();
+  row_starts.push_back(N);
+
+  const auto shard = [&](Tindex start_row, Tindex end_row) {
+    for (Tindex r = start_row; r < end_row; ++r) {
+      for (Tindex k = row_starts[r]; k < row_starts[r + 1]; ++k) {
+        update_row(updates[k].first, updates[k].second);
+      }
+    }
+  };
+  d.parallelFor(num_rows,
+                cost_per_update * (static_cast<double>(N) / num_rows), shard);
+  return OkStatus();
+}
+
+// Rows of float and double variables are updated a packet at a time.
+template <typename T>
+constexpr bool kVectorizeSparseRows =
+    std::is_same<T, float>::value || std::is_same<T, double>::value;
+
+// Applies the Adagrad update for gradient row `grad` to the `n` elements of a
+// row of var and accum, in a single pass over the row.
+template <typename T, bool has_epsilon>
+void SparseAdagradRow(T* var, T* accum, const T* grad, int64_t n, T lr,
+                      T epsilon, bool update_slots) {
+  int64_t j = 0;
+  if constexpr (kVectorizeSparseRows<T>) {
+    using Eigen::internal::padd;
+    using Eigen::internal::pmul;
+    typedef typename Eigen::internal::packet_traits<T>::type Packet;
+    static const int64_t kPacketSize = (sizeof(Packet) / sizeof(T));
+    const Packet lr_packet = Eigen::internal::pset1<Packet>(lr);
+    const Packet epsilon_packet = Eigen::internal::pset1<Packet>(epsilon);
+    for (; j + kPacketSize <= n; j += kPacketSize) {
+      const Packet g = Eigen::internal::ploadu<Packet>(grad + j);
+      Packet a = Eigen::internal::ploadu<Packet>(accum + j);
+      if (update_slots) {
+        a = padd(a, pmul(g, g));
+        Eigen::internal::pstoreu<T>(accum + j, a);
+      }
+      Packet step;
+      if (has_epsilon) {
+        const Packet denominator =
+            padd(Eigen::internal::psqrt(a), epsilon_packet);
+        step = Eigen::internal::pdiv(pmul(lr_packet, g), denominator);
+      } else {
+        step = pmul(pmul(lr_packet, g), Eigen::internal::prsqrt(a));
+      }
+      const Packet v = Eigen::internal::ploadu<Packet>(var + j);
+      Eigen::internal::pstoreu<T>(var + j, Eigen::internal::psub(v, step));
+    }
+  }
+  for (; j < n; ++j) {
+    if (update_slots) {
+      accum[j] += grad[j] * grad[j];
+    }
+    if (has_epsilon) {
+      var[j] -= lr * grad[j] / (Eigen::numext::sqrt(accum[j]) + epsilon);
+    } else {
+      var[j] -= lr * grad[j] / Eigen::numext::sqrt(accum[j]);
+    }
+  }
+}
 }  // namespace
 
 namespace functor {
@@ -175,70 +275,19 @@ struct SparseApplyAdagrad<CPUDevice, T, Tindex, has_epsilon> {
     if (N == 0) return OkStatus();
     const Tindex first_dim_size = static_cast<Tindex>(var.dimension(0));
     const T lr_scalar = lr();
+    const T epsilon_scalar = epsilon();
     const int in_bytes = inner_dim * sizeof(T) * 3;
     const int out_bytes = inner_dim * sizeof(T) * 2;
     const int cycles = inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 2 +
                                     Eigen::TensorOpCost::MulCost<T>() * 2);
     const Eigen::TensorOpCost cost(in_bytes, out_bytes, cycles);
 
-    if (inner_dim > 1) {
-      for (Tindex i = 0; i < N; ++i) {
-        const Tindex index = internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, first_dim_size)) {
-          return errors::InvalidArgument(
-              strings::StrCat("Index ", index, " at offset ", i,
-                              " in indices is out of range"));
-        }
-      }
-
-      const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
-        for (Tindex i = start_idx; i < end_idx; ++i) {
-          const Tindex index = internal::SubtleMustCopy(indices(i));
-          auto a = accum.template chip<0>(index);
-          auto g = grad.template chip<0>(i);
-          auto v = var.template chip<0>(index);
-          if (update_slots) {
-            a += g.square();
-          }
-          if (has_epsilon) {
-            v -= g.constant(lr_scalar) * g / (a.sqrt() + a.constant(epsilon()));
-          } else {
-            v -= g.constant(lr_scalar) * g * a.rsqrt();
-          }
-        }
-      };
-
-      d.parallelFor(N, cost, shard);
-    } else {
-      for (Tindex i = 0; i < N; ++i) {
-        const Tindex index = internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, first_dim_size)) {
-          return errors::InvalidArgument(
-              strings::StrCat("Index ", index, " at offset ", i,
-                              " in indices is out of range"));
-        }
-      }
-
-      const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
-        for (Tindex i = start_idx; i < end_idx; ++i) {
-          const Tindex index = internal::SubtleMustCopy(indices(i));
-          T& a = accum(index);
-          const T& g = grad(i);
-          if (update_slots) {
-            a += g * g;
-          }
-          if (has_epsilon) {
-            var(index) -= lr_scalar * g / (Eigen::numext::sqrt(a) + epsilon());
-          } else {
-            var(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
-          }
-        }
-      };
-
-      d.parallelFor(N, cost, shard);
-    }
-
-    return OkStatus();
+    return ParallelUpdateSparseRows<Tindex>(
+        d, indices, first_dim_size, cost, [&](Tindex index, Tindex i) {
+          SparseAdagradRow<T, has_epsilon>(
+              &var(index, 0), &accum(index, 0), &grad(i, 0), inner_dim,
+              lr_scalar, epsilon_scalar, update_slots);
+        });
   }
 };
 
@@ -528,60 +577,79 @@ inline T FtrlCompute(const T& accum, const T& linear, const T& lr, const T& l1,
   }
 }
 
-template <typename T, typename GradTy, typename GradeMaybeWithShrinkageTy,
-          typename AccumTy, typename LinearTy, typename VarTy>
-void ComputeFtrl(GradTy grad,
-                 GradeMaybeWithShrinkageTy grad_maybe_with_shrinkage,
-                 AccumTy accum, LinearTy linear, VarTy var, T l1_scalar,
-                 T l2_scalar, bool multiply_linear_by_lr, T lr_power_scalar,
-                 T lr_scalar) {
-  auto new_accum = accum + grad.square();
-  if (multiply_linear_by_lr) {
-    if (lr_power_scalar == static_cast<T>(-0.5)) {
-      linear += grad_maybe_with_shrinkage * lr_scalar -
-                (new_accum.sqrt() - accum.sqrt()) * var;
-    } else {
-      linear +=
-          grad_maybe_with_shrinkage * lr_scalar -
-          (new_accum.pow(-lr_power_scalar) - accum.pow(-lr_power_scalar)) * var;
-    }
-  } else {
-    if (lr_power_scalar == static_cast<T>(-0.5)) {
-      linear += grad_maybe_with_shrinkage -
-                (new_accum.sqrt() - accum.sqrt()) / lr_scalar * var;
-    } else {
-      linear += grad_maybe_with_shrinkage - (new_accum.pow(-lr_power_scalar) -
-                                             accum.pow(-lr_power_scalar)) /
-                                                lr_scalar * var;
+// Applies the FTRL update for gradient row `grad` to the `n` elements of a
+// row of var, accum and linear, in a single pass over the row.
+template <typename T, bool has_l2_shrinkage>
+void SparseFtrlRow(T* var, T* accum, T* linear, const T* grad, int64_t n,
+                   T lr, T l1, T l2, T l2_shrinkage, T lr_power,
+                   bool multiply_linear_by_lr) {
+  int64_t j = 0;
+  if constexpr (kVectorizeSparseRows<T>) {
+    if (lr_power == static_cast<T>(-0.5)) {
+      using Eigen::internal::padd;
+      using Eigen::internal::pdiv;
+      using Eigen::internal::pmul;
+      using Eigen::internal::psqrt;
+      using Eigen::internal::psub;
+      typedef typename Eigen::internal::packet_traits<T>::type Packet;
+      static const int64_t kPacketSize = (sizeof(Packet) / sizeof(T));
+      const T l1_scaled = multiply_linear_by_lr ? l1 * lr : l1;
+      const T l2_scaled = multiply_linear_by_lr ? static_cast<T>(2) * l2 * lr
+                                                : static_cast<T>(2) * l2;
+      const Packet lr_packet = Eigen::internal::pset1<Packet>(lr);
+      const Packet shrinkage_packet =
+          Eigen::internal::pset1<Packet>(static_cast<T>(2) * l2_shrinkage);
+      const Packet l1_packet = Eigen::internal::pset1<Packet>(l1_scaled);
+      const Packet neg_l1_packet = Eigen::internal::pset1<Packet>(-l1_scaled);
+      const Packet l2_packet = Eigen::internal::pset1<Packet>(l2_scaled);
+      for (; j + kPacketSize <= n; j += kPacketSize) {
+        const Packet g = Eigen::internal::ploadu<Packet>(grad + j);
+        const Packet v = Eigen::internal::ploadu<Packet>(var + j);
+        const Packet a = Eigen::internal::ploadu<Packet>(accum + j);
+        Packet l = Eigen::internal::ploadu<Packet>(linear + j);
+        const Packet g_maybe_with_shrinkage =
+            has_l2_shrinkage ? padd(g, pmul(shrinkage_packet, v)) : g;
+        const Packet new_a = padd(a, pmul(g, g));
+        const Packet sqrt_new_a = psqrt(new_a);
+        const Packet sigma = psub(sqrt_new_a, psqrt(a));
+        Packet quadratic;
+        if (multiply_linear_by_lr) {
+          l = padd(l, psub(pmul(g_maybe_with_shrinkage, lr_packet),
+                           pmul(sigma, v)));
+          quadratic = padd(sqrt_new_a, l2_packet);
+        } else {
+          l = padd(l, psub(g_maybe_with_shrinkage,
+                           pmul(pdiv(sigma, lr_packet), v)));
+          quadratic = padd(pdiv(sqrt_new_a, lr_packet), l2_packet);
+        }
+        const Packet l1_reg_adjust = Eigen::internal::pmax(
+            Eigen::internal::pmin(l, l1_packet), neg_l1_packet);
+        Eigen::internal::pstoreu<T>(var + j,
+                                    pdiv(psub(l1_reg_adjust, l), quadratic));
+        Eigen::internal::pstoreu<T>(accum + j, new_a);
+        Eigen::internal::pstoreu<T>(linear + j, l);
+      }
     }
   }
-  auto l1_reg_adjust =
-      (multiply_linear_by_lr ? linear.cwiseMin(l1_scalar * lr_scalar)
-                                   .cwiseMax(-l1_scalar * lr_scalar)
-                             : linear.cwiseMin(l1_scalar).cwiseMax(-l1_scalar));
-  auto x = l1_reg_adjust - linear;
-  if (multiply_linear_by_lr) {
-    if (lr_power_scalar == static_cast<T>(-0.5)) {
-      auto y = new_accum.sqrt() +
-               linear.constant(static_cast<T>(2) * l2_scalar * lr_scalar);
-      var = x / y;
-    } else {
-      auto y = new_accum.pow(-lr_power_scalar) +
-               linear.constant(static_cast<T>(2) * l2_scalar * lr_scalar);
-      var = x / y;
+  using Eigen::numext::pow;
+  for (; j < n; ++j) {
+    T g = grad[j];
+    if (has_l2_shrinkage) {
+      g += static_cast<T>(2) * l2_shrinkage * var[j];
     }
-  } else {
-    if (lr_power_scalar == static_cast<T>(-0.5)) {
-      auto y = new_accum.sqrt() / new_accum.constant(lr_scalar) +
-               linear.constant(static_cast<T>(2) * l2_scalar);
-      var = x / y;
-    } else {
-      auto y = new_accum.pow(-lr_power_scalar) / new_accum.constant(lr_scalar) +
-               linear.constant(static_cast<T>(2) * l2_scalar);
-      var = x / y;
+    const T updated_a = accum[j] + grad[j] * grad[j];
+    T sigma = pow(updated_a, -lr_power) - pow(accum[j], -lr_power);
+    if (!multiply_linear_by_lr) {
+      sigma /= lr;
     }
+    const T updated_l =
+        (multiply_linear_by_lr ? linear[j] + g * lr - sigma * var[j]
+                               : linear[j] + g - sigma * var[j]);
+    var[j] = FtrlCompute(updated_a, updated_l, lr, l1, l2, lr_power,
+                         multiply_linear_by_lr);
+    accum[j] = updated_a;
+    linear[j] = updated_l;
   }
-  accum += grad.square();
 }
 }  // namespace
 
@@ -599,87 +667,28 @@ struct SparseApplyFtrl<CPUDevice, T, Tindex, has_l2_shrinkage> {
                     typename TTypes<Tindex>::ConstVec indices_vec,
                     int64_t inner_dim, bool multiply_linear_by_lr) {
     const Tindex N = static_cast<Tindex>(indices_vec.dimension(0));
-    if (N > 0) {
-      T lr_scalar = lr();
-      T l1_scalar = l1();
-      T l2_scalar = l2();
-      T l2_shrinkage_scalar;
-      if (has_l2_shrinkage) {
-        l2_shrinkage_scalar = l2_shrinkage();
-      }
-      T lr_power_scalar = lr_power();
-      if (inner_dim > 1) {
-        const Tindex first_dim_size =
-            static_cast<Tindex>(var_flat.dimension(0));
-
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          if (!FastBoundsCheck(index, first_dim_size)) {
-            return errors::InvalidArgument(
-                strings::StrCat("Index ", index, " at offset ", i,
-                                " in indices is out of range"));
-          }
-          auto accum = accum_flat.template chip<0>(index);
-          auto linear = linear_flat.template chip<0>(index);
-          auto grad = grad_flat.template chip<0>(i);
-          auto var = var_flat.template chip<0>(index);
-
-          if (has_l2_shrinkage) {
-            auto grad_with_shrinkage =
-                grad + static_cast<T>(2) * l2_shrinkage_scalar * var;
-            ComputeFtrl(/*grad=*/grad,
-                        /*grad_maybe_with_shrinkage=*/grad_with_shrinkage,
-                        /*accum=*/accum, /*linear=*/linear, /*var=*/var,
-                        /*l1_scalar=*/l1_scalar, /*l2_scalar=*/l2_scalar,
-                        /*multiply_linear_by_lr=*/multiply_linear_by_lr,
-                        /*lr_power_scalar=*/lr_power_scalar,
-                        /*lr_scalar=*/lr_scalar);
-          } else {
-            ComputeFtrl(/*grad=*/grad, /*grad_maybe_with_shrinkage=*/grad,
-                        /*accum=*/accum, /*linear=*/linear, /*var=*/var,
-                        /*l1_scalar=*/l1_scalar, /*l2_scalar=*/l2_scalar,
-                        /*multiply_linear_by_lr=*/multiply_linear_by_lr,
-                        /*lr_power_scalar=*/lr_power_scalar,
-                        /*lr_scalar=*/lr_scalar);
-          }
-        }
-      } else {
-        const Tindex first_dim_size = accum_flat.size();
-
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          if (!FastBoundsCheck(index, first_dim_size)) {
-            return errors::InvalidArgument(
-                strings::StrCat("Index ", index, " at offset ", i,
-                                " in indices is out of range"));
-          }
-          T& a = accum_flat(index);
-          T& l = linear_flat(index);
-          T& v = var_flat(index);
-          T g;
-          if (has_l2_shrinkage) {
-            g = grad_flat(i) +
-                (static_cast<T>(2) * l2_shrinkage_scalar * var_flat(index));
-          } else {
-            g = grad_flat(i);
-          }
+    if (N == 0) return OkStatus();
+    const Tindex first_dim_size = static_cast<Tindex>(var_flat.dimension(0));
+    const T lr_scalar = lr();
+    const T l1_scalar = l1();
+    const T l2_scalar = l2();
+    const T l2_shrinkage_scalar = has_l2_shrinkage ? l2_shrinkage() : T(0);
+    const T lr_power_scalar = lr_power();
+    const int in_bytes = inner_dim * sizeof(T) * 4;
+    const int out_bytes = inner_dim * sizeof(T) * 3;
+    const int cycles = inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 6 +
+                                    Eigen::TensorOpCost::MulCost<T>() * 4 +
+                                    Eigen::TensorOpCost::DivCost<T>() * 2);
+    const Eigen::TensorOpCost cost(in_bytes, out_bytes, cycles);
 
-          T updated_a = a + grad_flat(i) * grad_flat(i);
-          using Eigen::numext::pow;
-          T sigma = pow(updated_a, -lr_power_scalar) - pow(a, -lr_power_scalar);
-          if (!multiply_linear_by_lr) {
-            sigma /= lr_scalar;
-          }
-          T updated_l = (multiply_linear_by_lr ? l + g * lr_scalar - sigma * v
-                                               : l + g - sigma * v);
-          v = FtrlCompute(updated_a, updated_l, lr_scalar, l1_scalar, l2_scalar,
-                          lr_power_scalar, multiply_linear_by_lr);
-          a = updated_a;
-          l = updated_l;
-        }
-      }
-    }
-    return OkStatus();
+    return ParallelUpdateSparseRows<Tindex>(
+        d, indices_vec, first_dim_size, cost, [&](Tindex index, Tindex i) {
+          SparseFtrlRow<T, has_l2_shrinkage>(
+              &var_flat(index, 0), &accum_flat(index, 0),
+              &linear_flat(index, 0), &grad_flat(i, 0), inner_dim, lr_scalar,
+              l1_scalar, l2_scalar, l2_shrinkage_scalar, lr_power_scalar,
+              multiply_linear_by_lr);
+        });
   }
 };
 
@@ -1884,12 +1893,20 @@ class SparseApplyAdagradOp : public OpKernel {
   explicit SparseApplyAdagradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+    // Only the resource variable ops have the attr.
+    if (ctx->HasAttr("use_row_locking")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    }
   }
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
+    // Updates that opt in lock the row stripes they update instead of holding
+    // the variables' mutexes exclusively.
+    const bool lock_row_stripes = CanLockVariableRowStripes<Device>(
+        ctx, use_exclusive_lock_, use_row_locking_, {0, 1});
     auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+        ctx, use_exclusive_lock_ && !lock_row_stripes, sparse, {0, 1});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -1938,6 +1955,12 @@ class SparseApplyAdagradOp : public OpKernel {
                 errors::InvalidArgument(
                     "Inner dimension should be greater than zero."));
 
+    std::optional<VariableRowStripeLocks> row_stripe_locks;
+    if (lock_row_stripes) {
+      row_stripe_locks.emplace(ctx, std::vector<int>{0, 1},
+                               VariableRowStripes<Tindex>(
+                                   indices.vec<Tindex>(), var.dim_size(0)));
+    }
     const Device& device = ctx->template eigen_device<Device>();
     OP_REQUIRES_OK(
         ctx, functor::SparseApplyAdagrad<Device, T, Tindex,
@@ -1953,6 +1976,7 @@ class SparseApplyAdagradOp : public OpKernel {
  private:
   bool use_exclusive_lock_;
   bool update_slots_;
+  bool use_row_locking_ = false;
 };
 
 #define REGISTER_KERNELS(D, T, Tindices)                                 \
@@ -2014,12 +2038,20 @@ class SparseApplyAdagradV2Op : public OpKernel {
   explicit SparseApplyAdagradV2Op(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+    // Only the resource variable ops have the attr.
+    if (ctx->HasAttr("use_row_locking")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    }
   }
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
+    // Updates that opt in lock the row stripes they update instead of holding
+    // the variables' mutexes exclusively.
+    const bool lock_row_stripes = CanLockVariableRowStripes<Device>(
+        ctx, use_exclusive_lock_, use_row_locking_, {0, 1});
     auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+        ctx, use_exclusive_lock_ && !lock_row_stripes, sparse, {0, 1});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -2072,6 +2104,12 @@ class SparseApplyAdagradV2Op : public OpKernel {
                 errors::InvalidArgument(
                     "Inner dimension should be greater than zero."));
 
+    std::optional<VariableRowStripeLocks> row_stripe_locks;
+    if (lock_row_stripes) {
+      row_stripe_locks.emplace(ctx, std::vector<int>{0, 1},
+                               VariableRowStripes<Tindex>(
+                                   indices.vec<Tindex>(), var.dim_size(0)));
+    }
     const Device& device = ctx->template eigen_device<Device>();
     OP_REQUIRES_OK(
         ctx, functor::SparseApplyAdagrad<Device, T, Tindex,
@@ -2086,6 +2124,7 @@ class SparseApplyAdagradV2Op : public OpKernel {
  private:
   bool use_exclusive_lock_;
   bool update_slots_;
+  bool use_row_locking_ = false;
 };
 
 #define REGISTER_KERNELS(D, T, Tindices)                                   \
@@ -2802,12 +2841,20 @@ class SparseApplyFtrlOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
     OP_REQUIRES_OK(
         ctx, ctx->GetAttr("multiply_linear_by_lr", &multiply_linear_by_lr_));
+    // Only the resource variable ops have the attr.
+    if (ctx->HasAttr("use_row_locking")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    }
   }
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
+    // Updates that opt in lock the row stripes they update instead of holding
+    // the variables' mutexes exclusively.
+    const bool lock_row_stripes = CanLockVariableRowStripes<Device>(
+        ctx, use_exclusive_lock_, use_row_locking_, {0, 1, 2});
     auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+        ctx, use_exclusive_lock_ && !lock_row_stripes, sparse, {0, 1, 2});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -2917,6 +2964,12 @@ class SparseApplyFtrlOp : public OpKernel {
                                   l2_shrinkage->shape().DebugString()));
     }
 
+    std::optional<VariableRowStripeLocks> row_stripe_locks;
+    if (lock_row_stripes) {
+      row_stripe_locks.emplace(ctx, std::vector<int>{0, 1, 2},
+                               VariableRowStripes<Tindex>(
+                                   indices.vec<Tindex>(), var.dim_size(0)));
+    }
     const Device& device = ctx->template eigen_device<Device>();
     auto indices_vec = indices.vec<Tindex>();
     OP_REQUIRES_OK(
@@ -2936,6 +2989,7 @@ class SparseApplyFtrlOp : public OpKernel {
  private:
   bool use_exclusive_lock_;
   bool multiply_linear_by_lr_;
+  bool use_row_locking_ = false;
 };
 
 #define REGISTER_KERNELS(D, T, Tindices)                                      \
@@ -15,7 +15,10 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
+#include <cstring>
+#include <type_traits>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -68,12 +71,277 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+// Returns the dimensions and permutation of a transpose with unit dimensions
+// dropped and dimensions that stay adjacent merged, e.g. NHWC -> NCHW becomes
+// a batch of [HW, C] -> [C, HW] transposes. An identity transpose, or one of a
+// single element, becomes a rank-1 copy.
+void SimplifyTranspose(const TensorShape& shape, gtl::ArraySlice<int32> perm,
+                       internal::TransposePermsVec* new_perm,
+                       internal::TransposeDimsVec* new_dims) {
+  const int ndims = shape.dims();
+  internal::TransposePermsVec new_index(ndims, -1);
+  TensorShape squeezed;
+  for (int i = 0; i < ndims; ++i) {
+    if (shape.dim_size(i) != 1) {
+      new_index[i] = squeezed.dims();
+      squeezed.AddDim(shape.dim_size(i));
+    }
+  }
+  internal::TransposePermsVec squeezed_perm;
+  for (int32 p : perm) {
+    if (new_index[p] >= 0) squeezed_perm.push_back(new_index[p]);
+  }
+  if (squeezed.dims() <= 1) {
+    new_perm->assign(1, 0);
+    new_dims->assign(1, squeezed.num_elements());
+    return;
+  }
+  internal::ReduceTransposeDimensions(squeezed, squeezed_perm, new_perm,
+                                      new_dims);
+}
+
+// Walks the outer dimensions of a transpose in output order, tracking the
+// matching input and output offsets.
+class TransposeOuterIterator {
+ public:
+  TransposeOuterIterator(const internal::TransposeDimsVec& sizes,
+                         const internal::TransposeDimsVec& in_strides,
+                         const internal::TransposeDimsVec& out_strides,
+                         int64_t index)
+      : sizes_(sizes),
+        in_strides_(in_strides),
+        out_strides_(out_strides),
+        coords_(sizes.size()) {
+    for (int i = sizes_.size() - 1; i >= 0; --i) {
+      coords_[i] = index % sizes_[i];
+      index /= sizes_[i];
+      in_offset_ += coords_[i] * in_strides_[i];
+      out_offset_ += coords_[i] * out_strides_[i];
+    }
+  }
+
+  void Next() {
+    for (int i = sizes_.size() - 1; i >= 0; --i) {
+      in_offset_ += in_strides_[i];
+      out_offset_ += out_strides_[i];
+      if (++coords_[i] < sizes_[i]) return;
+      in_offset_ -= coords_[i] * in_strides_[i];
+      out_offset_ -= coords_[i] * out_strides_[i];
+      coords_[i] = 0;
+    }
+  }
+
+  int64_t in_offset() const { return in_offset_; }
+  int64_t out_offset() const { return out_offset_; }
+
+ private:
+  const internal::TransposeDimsVec& sizes_;
+  const internal::TransposeDimsVec& in_strides_;
+  const internal::TransposeDimsVec& out_strides_;
+  internal::TransposeDimsVec coords_;
+  int64_t in_offset_ = 0;
+  int64_t out_offset_ = 0;
+};
+
+// Side of the square micro-tiles, which are small enough to be transposed in
+// registers once the compiler unrolls the fixed-size loops.
+constexpr int kMicroTile = 8;
+
+// Side of the cache tiles, chosen so that each row of a tile spans two cache
+// lines. Must be a multiple of kMicroTile.
+template <typename T>
+constexpr int64_t CacheTileSize() {
+  return std::max<int64_t>(2 * kMicroTile, 128 / sizeof(T));
+}
+
+template <typename T>
+void TransposeMicroTile(const T* src, int64_t src_stride, T* dst,
+                        int64_t dst_stride) {
+  T tile[kMicroTile][kMicroTile];
+  for (int r = 0; r < kMicroTile; ++r) {
+    for (int c = 0; c < kMicroTile; ++c) tile[c][r] = src[r * src_stride + c];
+  }
+  for (int c = 0; c < kMicroTile; ++c) {
+    for (int r = 0; r < kMicroTile; ++r) dst[c * dst_stride + r] = tile[c][r];
+  }
+}
+
+// Sets dst[c * dst_stride + r] = src[r * src_stride + c] for a rows x cols
+// tile.
+template <typename T>
+void TransposeTile(const T* src, int64_t src_stride, T* dst,
+                   int64_t dst_stride, int64_t rows, int64_t cols) {
+  const int64_t full_rows = rows - rows % kMicroTile;
+  const int64_t full_cols = cols - cols % kMicroTile;
+  for (int64_t c = 0; c < full_cols; c += kMicroTile) {
+    for (int64_t r = 0; r < full_rows; r += kMicroTile) {
+      TransposeMicroTile(src + r * src_stride + c, src_stride,
+                         dst + c * dst_stride + r, dst_stride);
+    }
+  }
+  // Ragged edges, written along the contiguous output rows.
+  for (int64_t c = 0; c < cols; ++c) {
+    const int64_t r_begin = c < full_cols ? full_rows : 0;
+    for (int64_t r = r_begin; r < rows; ++r) {
+      dst[c * dst_stride + r] = src[r * src_stride + c];
+    }
+  }
+}
+
+template <typename T>
+void TransposeBlocked(const CPUDevice& device, const T* in,
+                      internal::TransposeDimsVec dims,
+                      internal::TransposePermsVec perm, T* out);
+
+// Copies the contiguous runs of a transpose that keeps the innermost input
+// dimension innermost.
+template <typename T>
+void TransposeRuns(const CPUDevice& device, const T* in,
+                   const internal::TransposeDimsVec& dims,
+                   const internal::TransposePermsVec& perm, T* out) {
+  const int ndims = dims.size();
+  const int64_t run = dims[ndims - 1];
+  // A short run is a single element of a wider type, which is transposed in
+  // tiles instead.
+  const int64_t run_bytes = run * sizeof(T);
+  const internal::TransposeDimsVec outer_dims(dims.begin(), dims.end() - 1);
+  const internal::TransposePermsVec outer_perm(perm.begin(), perm.end() - 1);
+  switch (run_bytes) {
+    case 2:
+      TransposeBlocked(device, reinterpret_cast<const uint16*>(in), outer_dims,
+                       outer_perm, reinterpret_cast<uint16*>(out));
+      return;
+    case 4:
+      TransposeBlocked(device, reinterpret_cast<const uint32*>(in), outer_dims,
+                       outer_perm, reinterpret_cast<uint32*>(out));
+      return;
+    case 8:
+      TransposeBlocked(device, reinterpret_cast<const uint64*>(in), outer_dims,
+                       outer_perm, reinterpret_cast<uint64*>(out));
+      return;
+  }
+
+  internal::TransposeDimsVec sizes(ndims - 1);
+  internal::TransposeDimsVec in_strides(ndims - 1);
+  internal::TransposeDimsVec out_strides(ndims - 1);
+  int64_t num_runs = 1;
+  for (int i = ndims - 2; i >= 0; --i) {
+    sizes[i] = dims[perm[i]];
+    out_strides[i] = num_runs * run;
+    num_runs *= sizes[i];
+  }
+  for (int i = 0; i < ndims - 1; ++i) {
+    int64_t stride = run;
+    for (int j = perm[i] + 1; j < ndims - 1; ++j) stride *= dims[j];
+    in_strides[i] = stride;
+  }
+  auto copy_runs = [&](int64_t begin, int64_t end) {
+    TransposeOuterIterator it(sizes, in_strides, out_strides, begin);
+    for (int64_t i = begin; i < end; ++i, it.Next()) {
+      std::memcpy(out + it.out_offset(), in + it.in_offset(), run_bytes);
+    }
+  };
+  Eigen::TensorOpCost cost(/*bytes_loaded=*/run_bytes,
+                           /*bytes_stored=*/run_bytes,
+                           /*compute_cycles=*/ndims);
+  device.parallelFor(num_runs, cost, copy_runs);
+}
+
+// Transposes `in`, of shape `dims`, by `perm`, which is simplified as by
+// SimplifyTranspose. The innermost input dimension and the input dimension
+// that becomes innermost in the output are transposed in cache tiles, which
+// are distributed over the thread pool along with the outer dimensions.
+template <typename T>
+void TransposeBlocked(const CPUDevice& device, const T* in,
+                      internal::TransposeDimsVec dims,
+                      internal::TransposePermsVec perm, T* out) {
+  const int ndims = dims.size();
+  if (ndims == 1) {
+    std::copy_n(in, dims[0], out);
+    return;
+  }
+  if (perm[ndims - 1] == ndims - 1) {
+    TransposeRuns(device, in, dims, perm, out);
+    return;
+  }
+
+  internal::TransposeDimsVec in_strides(ndims);
+  internal::TransposeDimsVec out_strides(ndims);
+  in_strides[ndims - 1] = 1;
+  out_strides[ndims - 1] = 1;
+  for (int i = ndims - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * dims[i + 1];
+    out_strides[i] = out_strides[i + 1] * dims[perm[i + 1]];
+  }
+  // Tiles are rows x cols blocks, with rows along the input dimension that is
+  // innermost in the output and cols along the innermost input dimension.
+  const int row_dim = perm[ndims - 1];
+  int col_out_dim = 0;
+  while (perm[col_out_dim] != ndims - 1) ++col_out_dim;
+  const int64_t rows = dims[row_dim];
+  const int64_t cols = dims[ndims - 1];
+  const int64_t row_stride = in_strides[row_dim];
+  const int64_t col_stride = out_strides[col_out_dim];
+
+  // The remaining dimensions, in output order.
+  internal::TransposeDimsVec outer_sizes;
+  internal::TransposeDimsVec outer_in_strides;
+  internal::TransposeDimsVec outer_out_strides;
+  for (int i = 0; i < ndims - 1; ++i) {
+    if (i == col_out_dim) continue;
+    outer_sizes.push_back(dims[perm[i]]);
+    outer_in_strides.push_back(in_strides[perm[i]]);
+    outer_out_strides.push_back(out_strides[i]);
+  }
+  int64_t num_outer = 1;
+  for (int64_t size : outer_sizes) num_outer *= size;
+
+  constexpr int64_t kTile = CacheTileSize<T>();
+  const int64_t row_tiles = (rows + kTile - 1) / kTile;
+  const int64_t col_tiles = (cols + kTile - 1) / kTile;
+  const int64_t tiles_per_outer = row_tiles * col_tiles;
+  auto transpose_tiles = [&](int64_t begin, int64_t end) {
+    TransposeOuterIterator it(outer_sizes, outer_in_strides,
+                              outer_out_strides, begin / tiles_per_outer);
+    int64_t tile = begin % tiles_per_outer;
+    for (int64_t i = begin; i < end; ++i) {
+      const int64_t r = (tile / col_tiles) * kTile;
+      const int64_t c = (tile % col_tiles) * kTile;
+      TransposeTile(in + it.in_offset() + r * row_stride + c, row_stride,
+                    out + it.out_offset() + c * col_stride + r, col_stride,
+                    std::min(kTile, rows - r), std::min(kTile, cols - c));
+      if (++tile == tiles_per_outer) {
+        tile = 0;
+        it.Next();
+      }
+    }
+  };
+  const int64_t tile_bytes =
+      std::min(kTile, rows) * std::min(kTile, cols) * sizeof(T);
+  Eigen::TensorOpCost cost(/*bytes_loaded=*/tile_bytes,
+                           /*bytes_stored=*/tile_bytes,
+                           /*compute_cycles=*/tile_bytes / sizeof(T));
+  device.parallelFor(num_outer * tiles_per_outer, cost, transpose_tiles);
+}
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+    // Plain copies of any rank go through the tiled transpose. Eigen handles
+    // conjugation and strings.
+    if constexpr (!conjugate && std::is_trivially_copyable<T>::value) {
+      if (in.NumElements() == 0) return;
+      internal::TransposePermsVec new_perm;
+      internal::TransposeDimsVec new_dims;
+      SimplifyTranspose(in.shape(), perm, &new_perm, &new_dims);
+      TransposeBlocked<T>(
+          d, reinterpret_cast<const T*>(in.tensor_data().data()), new_dims,
+          new_perm,
+          reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data())));
+      return;
+    }
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
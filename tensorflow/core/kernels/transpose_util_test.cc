@@ -13,10 +13,19 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -85,6 +94,12 @@ TEST_F(TransposeUtilTest, NormalDimensionReduction) {
   TestDimensionReduction({2, 3, 4}, {0, 1, 2}, {0}, {24});
 
   TestDimensionReduction({2, 3}, {0, 1}, {0}, {6});
+
+  TestDimensionReduction({2, 3, 4, 5}, {3, 0, 2, 1}, {3, 0, 2, 1},
+                         {2, 3, 4, 5});
+
+  TestDimensionReduction({2, 3, 4, 5, 6}, {4, 0, 1, 3, 2}, {3, 0, 2, 1},
+                         {6, 4, 5, 6});
 }
 
 TEST_F(TransposeUtilTest, LargeDimensionReduction) {
@@ -130,4 +145,93 @@ TEST_F(TransposeUtilTest, NonSingletonDimensionAlignment) {
                                                      {0, 1, 2, 5, 4, 3}));
 }
 
+template <typename T>
+T TestValue(int64_t i) {
+  return static_cast<T>(i * 7 + 3);
+}
+
+template <>
+tstring TestValue<tstring>(int64_t i) {
+  return strings::StrCat("s", i);
+}
+
+// Compares DoTranspose on CPU with the transpose computed one element at a
+// time, over shapes that exercise the tiled, run-copying and widening paths.
+class TransposeCpuTest : public ::testing::Test {
+ protected:
+  template <typename T>
+  void TestTranspose(const TensorShape& shape,
+                     const gtl::ArraySlice<int32> perm) {
+    Tensor in(DataTypeToEnum<T>::value, shape);
+    auto in_flat = in.flat<T>();
+    for (int64_t i = 0; i < in_flat.size(); ++i) {
+      in_flat(i) = TestValue<T>(i);
+    }
+    TensorShape out_shape;
+    for (int32 p : perm) out_shape.AddDim(shape.dim_size(p));
+    Tensor expected(DataTypeToEnum<T>::value, out_shape);
+    const int ndims = shape.dims();
+    std::vector<int64_t> in_strides(ndims, 1);
+    for (int i = ndims - 2; i >= 0; --i) {
+      in_strides[i] = in_strides[i + 1] * shape.dim_size(i + 1);
+    }
+    auto expected_flat = expected.flat<T>();
+    for (int64_t o = 0; o < expected_flat.size(); ++o) {
+      int64_t remaining = o;
+      int64_t in_index = 0;
+      for (int i = ndims - 1; i >= 0; --i) {
+        in_index += (remaining % out_shape.dim_size(i)) * in_strides[perm[i]];
+        remaining /= out_shape.dim_size(i);
+      }
+      expected_flat(o) = in_flat(in_index);
+    }
+
+    thread::ThreadPool pool(Env::Default(), "transpose", 4);
+    Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), 4);
+    Tensor out(DataTypeToEnum<T>::value, out_shape);
+    TF_ASSERT_OK(DoTranspose(device, in, perm, &out));
+    test::ExpectTensorEqual<T>(expected, out);
+  }
+};
+
+TEST_F(TransposeCpuTest, SmallInnerDimension) {
+  // NHWC <-> NCHW with three channels.
+  TestTranspose<uint8>({2, 37, 41, 3}, {0, 3, 1, 2});
+  TestTranspose<float>({2, 37, 41, 3}, {0, 3, 1, 2});
+  TestTranspose<float>({2, 3, 37, 41}, {0, 2, 3, 1});
+  TestTranspose<double>({2, 3, 37, 41}, {0, 2, 3, 1});
+}
+
+TEST_F(TransposeCpuTest, Matrix) {
+  TestTranspose<float>({1, 1}, {1, 0});
+  TestTranspose<float>({7, 300}, {1, 0});
+  TestTranspose<int16>({129, 65}, {1, 0});
+  TestTranspose<int64_t>({64, 64}, {1, 0});
+  TestTranspose<complex128>({33, 17}, {1, 0});
+}
+
+TEST_F(TransposeCpuTest, HighRank) {
+  // Splitting and merging attention heads.
+  TestTranspose<float>({2, 9, 4, 16}, {0, 2, 1, 3});
+  TestTranspose<float>({2, 5, 3, 4, 2, 8}, {0, 2, 4, 1, 3, 5});
+  TestTranspose<bfloat16>({3, 4, 5, 6, 7}, {4, 2, 0, 3, 1});
+  TestTranspose<int32>({2, 1, 3, 1, 4, 1, 5, 2, 3},
+                       {8, 1, 6, 0, 4, 2, 7, 5, 3});
+}
+
+TEST_F(TransposeCpuTest, KeepsInnermostDimension) {
+  // Runs of 2 and 3 elements are copied as wider elements and as runs.
+  TestTranspose<uint8>({5, 7, 2}, {1, 0, 2});
+  TestTranspose<float>({5, 7, 2}, {1, 0, 2});
+  TestTranspose<float>({5, 7, 3}, {1, 0, 2});
+  TestTranspose<float>({4, 5, 6, 40}, {2, 0, 1, 3});
+}
+
+TEST_F(TransposeCpuTest, Degenerate) {
+  TestTranspose<float>({3, 0, 5}, {2, 0, 1});
+  TestTranspose<float>({1, 1, 1}, {2, 0, 1});
+  TestTranspose<float>({4, 1, 5}, {0, 1, 2});
+  TestTranspose<tstring>({4, 3, 5}, {2, 0, 1});
+}
+
 }  // namespace tensorflow
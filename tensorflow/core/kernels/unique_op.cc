@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -23,9 +26,11 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +73,136 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Vectors with at least this many elements are uniquified in parallel, if the
+// element type allows it.
+constexpr int64_t kParallelUniqueMinElements = 1 << 17;
+
+// `ParallelUnique` uniquifies a large vector on the intra-op thread pool. The
+// values are hash-partitioned, and each partition is uniquified independently.
+// A prefix sum over the first occurrences of the values then numbers them in
+// order of first occurrence, so the result is the same as that of the serial
+// implementation. It is only provided for integers, whose hash and equality
+// are cheap and well-behaved.
+template <typename T, typename TIndex, typename Enable = void>
+struct ParallelUnique {
+  static constexpr bool kSupported = false;
+  static Status Compute(OpKernelContext* context, const Tensor& input,
+                        int64_t axis, typename TTypes<TIndex>::Vec idx_vec,
+                        int64_t& uniq_size) {
+    return errors::Unimplemented("Parallel unique is not supported for ",
+                                 DataTypeString(input.dtype()));
+  }
+};
+
+template <typename T, typename TIndex>
+struct ParallelUnique<T, TIndex, std::enable_if_t<std::is_integral_v<T>>> {
+  static constexpr bool kSupported = true;
+  static Status Compute(OpKernelContext* context, const Tensor& input,
+                        int64_t axis, typename TTypes<TIndex>::Vec idx_vec,
+                        int64_t& uniq_size) {
+    auto Tin = input.flat<T>();
+    const int64_t N = static_cast<int64_t>(Tin.size());
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    // The input is split into as many blocks as there are partitions.
+    const int log2_partitions =
+        std::min(Log2Ceiling(4 * worker_threads.num_threads), 8);
+    const int num_partitions = 1 << log2_partitions;
+    const int num_blocks = num_partitions;
+    auto block_start = [N, num_blocks](int64_t block) {
+      return N * block / num_blocks;
+    };
+    auto partition_of = [log2_partitions](T value) -> uint8 {
+      // Fibonacci hashing; the map of each partition hashes the values again.
+      return (static_cast<uint64>(value) * 0x9E3779B97F4A7C15ull) >>
+             (64 - log2_partitions);
+    };
+    auto for_each = [&worker_threads, N](
+                        int64_t num_units,
+                        const std::function<void(int64_t)>& work) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_units,
+            /*cost_per_unit=*/10 * N / num_units,
+            [&work](int64_t start, int64_t limit) {
+              for (int64_t unit = start; unit < limit; ++unit) work(unit);
+            });
+    };
+
+    // Count the elements of every partition in every block.
+    std::vector<uint8> partitions(N);
+    std::vector<int64_t> offsets(num_blocks * num_partitions, 0);
+    for_each(num_blocks, [&](int64_t block) {
+      int64_t* counts = &offsets[block * num_partitions];
+      for (int64_t i = block_start(block); i < block_start(block + 1); ++i) {
+        partitions[i] = partition_of(Tin(i));
+        ++counts[partitions[i]];
+      }
+    });
+    // Lay out the positions of each partition contiguously, in input order.
+    std::vector<int64_t> partition_starts(num_partitions + 1);
+    int64_t offset = 0;
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_starts[p] = offset;
+      for (int64_t block = 0; block < num_blocks; ++block) {
+        const int64_t count = offsets[block * num_partitions + p];
+        offsets[block * num_partitions + p] = offset;
+        offset += count;
+      }
+    }
+    partition_starts[num_partitions] = offset;
+    std::vector<TIndex> positions(N);
+    for_each(num_blocks, [&](int64_t block) {
+      int64_t* block_offsets = &offsets[block * num_partitions];
+      for (int64_t i = block_start(block); i < block_start(block + 1); ++i) {
+        positions[block_offsets[partitions[i]]++] = i;
+      }
+    });
+
+    // Point every element at the first occurrence of its value.
+    for_each(num_partitions, [&](int64_t p) {
+      absl::flat_hash_map<T, TIndex> uniq;
+      uniq.reserve(partition_starts[p + 1] - partition_starts[p]);
+      for (int64_t k = partition_starts[p]; k < partition_starts[p + 1];
+           ++k) {
+        const TIndex i = positions[k];
+        idx_vec(i) = uniq.emplace(Tin(i), i).first->second;
+      }
+    });
+
+    // Number the first occurrences in input order. `positions` now maps the
+    // position of a first occurrence to its index in the output.
+    std::vector<int64_t> block_uniq_starts(num_blocks + 1, 0);
+    for_each(num_blocks, [&](int64_t block) {
+      for (int64_t i = block_start(block); i < block_start(block + 1); ++i) {
+        block_uniq_starts[block + 1] += idx_vec(i) == i;
+      }
+    });
+    for (int64_t block = 0; block < num_blocks; ++block) {
+      block_uniq_starts[block + 1] += block_uniq_starts[block];
+    }
+    uniq_size = block_uniq_starts[num_blocks];
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, uniq_size);
+    Tensor* output = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, &output));
+    auto Tout = output->flat<T>();
+    for_each(num_blocks, [&](int64_t block) {
+      TIndex j = block_uniq_starts[block];
+      for (int64_t i = block_start(block); i < block_start(block + 1); ++i) {
+        if (idx_vec(i) == i) {
+          Tout(j) = Tin(i);
+          positions[i] = j++;
+        }
+      }
+    });
+    for_each(num_blocks, [&](int64_t block) {
+      for (int64_t i = block_start(block); i < block_start(block + 1); ++i) {
+        idx_vec(i) = positions[idx_vec(i)];
+      }
+    });
+    return OkStatus();
+  }
+};
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -143,7 +278,12 @@ class UniqueOp : public OpKernel {
     auto idx_vec = idx->template vec<TIndex>();
 
     int64_t uniq_size;
-    if (new_sizes[0] == 1 && new_sizes[2] == 1) {
+    if (ParallelUnique<T, TIndex>::kSupported && new_sizes[0] == 1 &&
+        new_sizes[2] == 1 && new_sizes[1] >= kParallelUniqueMinElements &&
+        context->device()->tensorflow_cpu_worker_threads()->num_threads > 1) {
+      OP_REQUIRES_OK(context, ParallelUnique<T, TIndex>::Compute(
+                                  context, input, axis, idx_vec, uniq_size));
+    } else if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
       // elements. Here we put T directly into the map rather than ints pointing
       // to them as in the general case.
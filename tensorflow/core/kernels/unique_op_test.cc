@@ -15,11 +15,16 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
@@ -37,6 +42,67 @@ namespace {
 
 const int kMaxStrLen = 40;
 
+class UniqueWithCountsOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type, DataType index_type) {
+    TF_ASSERT_OK(NodeDefBuilder("unique_with_counts", "UniqueWithCounts")
+                     .Input(FakeInput(type))
+                     .Attr("out_idx", index_type)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Runs the op on `values` and compares the result with a serial reference.
+  template <typename T, typename TIndex>
+  void RunAndCheck(const std::vector<T>& values) {
+    std::vector<T> expected_y;
+    std::vector<TIndex> expected_idx;
+    std::vector<TIndex> expected_count;
+    std::unordered_map<T, TIndex> seen;
+    for (const T value : values) {
+      auto it = seen.emplace(value, expected_y.size()).first;
+      if (it->second == static_cast<TIndex>(expected_y.size())) {
+        expected_y.push_back(value);
+        expected_count.push_back(0);
+      }
+      expected_idx.push_back(it->second);
+      ++expected_count[it->second];
+    }
+    const int64_t size = values.size();
+    AddInputFromArray<T>(TensorShape({size}), values);
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorEqual<T>(test::AsTensor<T>(expected_y), *GetOutput(0));
+    test::ExpectTensorEqual<TIndex>(test::AsTensor<TIndex>(expected_idx),
+                                    *GetOutput(1));
+    test::ExpectTensorEqual<TIndex>(test::AsTensor<TIndex>(expected_count),
+                                    *GetOutput(2));
+  }
+};
+
+TEST_F(UniqueWithCountsOpTest, Small) {
+  MakeOp(DT_INT64, DT_INT32);
+  RunAndCheck<int64_t, int32>({3, -1, 3, 7, -1, 0, 7, 7});
+}
+
+// Large enough for the parallel implementation.
+TEST_F(UniqueWithCountsOpTest, LargeInt64) {
+  MakeOp(DT_INT64, DT_INT32);
+  std::vector<int64_t> values(1 << 19);
+  for (int64_t i = 0; i < static_cast<int64_t>(values.size()); ++i) {
+    values[i] = (i * 7919) % 100003 - 50000;
+  }
+  RunAndCheck<int64_t, int32>(values);
+}
+
+TEST_F(UniqueWithCountsOpTest, LargeInt32AllDistinct) {
+  MakeOp(DT_INT32, DT_INT64);
+  std::vector<int32> values(1 << 18);
+  for (int32 i = 0; i < static_cast<int32>(values.size()); ++i) {
+    values[i] = values.size() - i;
+  }
+  RunAndCheck<int32, int64_t>(values);
+}
+
 TensorProto GetRandomInt32TensorProto(int dim, int max_int) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_INT32);
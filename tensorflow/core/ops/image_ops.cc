@@ -526,6 +526,46 @@ REGISTER_OP("DecodeAndCropJpeg")
       return OkStatus();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeAndResizeImages")
+    .Input("contents: string")
+    .Input("crop_windows: int32")
+    .Input("size: int32")
+    .Attr("channels: int = 3")
+    .Attr("dtype: {uint8, float} = DT_UINT8")
+    .Attr("dct_method: string = ''")
+    .Output("images: dtype")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      ShapeHandle crop_windows;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &crop_windows));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->WithValue(c->Dim(crop_windows, 1), 4, &unused_dim));
+      ShapeHandle size;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &size));
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(size, 0), 2, &unused_dim));
+
+      int32_t channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels != 1 && channels != 3) {
+        return errors::InvalidArgument("channels must be 1 or 3, got ",
+                                       channels);
+      }
+
+      DimensionHandle h = c->UnknownDim();
+      DimensionHandle w = c->UnknownDim();
+      const Tensor* size_tensor = c->input_tensor(2);
+      if (size_tensor != nullptr) {
+        auto size_vec = size_tensor->vec<int32>();
+        h = c->MakeDim(size_vec(0));
+        w = c->MakeDim(size_vec(1));
+      }
+      c->set_output(0, c->MakeShape({c->Dim(contents, 0), h, w, channels}));
+      return OkStatus();
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
@@ -1475,6 +1475,75 @@ REGISTER_OP("SparseSegmentSumGradV2")
     .Attr("Tsegmentids: {int32, int64} = DT_INT32")
     .SetShapeFn(SparseSegmentReductionGradV2ShapeFn);
 
+REGISTER_OP("_SparseSegmentWeightedSum")
+    .Input("data: Tdata")
+    .Input("indices: Tidx")
+    .Input("weights: T")
+    .Input("segment_ids: Tsegmentids")
+    .Output("output: T")
+    .Attr("Tdata: {bfloat16, half, float, double}")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("Tsegmentids: {int32, int64} = DT_INT32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle data_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
+      ShapeHandle indices_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &indices_shape));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(indices_shape, c->input(2), &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(indices_shape, c->input(3), &unused));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(data_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->Vector(InferenceContext::kUnknownDim), subshape, &out));
+      c->set_output(0, out);
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Computes SegmentSum(Gather(data, indices) * weights, segment_ids) without
+materializing the gathered rows, accumulating in T. The rows of `data` are
+scaled by the matching element of `weights`. `segment_ids` must be sorted.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_SparseSegmentWeightedSumGrad")
+    .Input("grad: T")
+    .Input("weights: T")
+    .Input("segment_ids: Tsegmentids")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tsegmentids: {int32, int64} = DT_INT32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle grad_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &grad_shape));
+      ShapeHandle segment_ids_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &segment_ids_shape));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(segment_ids_shape, c->input(1), &unused));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(grad_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(segment_ids_shape, subshape, &out));
+      c->set_output(0, out);
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Computes Gather(grad, segment_ids) * weights, the values of the gradient of
+_SparseSegmentWeightedSum with respect to the rows of `data` it gathered.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("SparseSegmentMean")
     .Input("data: T")
     .Input("indices: Tidx")
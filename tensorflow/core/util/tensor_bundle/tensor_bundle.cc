@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -422,17 +426,56 @@ Status PadAlignment(tsl::BufferedWritableFile* out, int alignment,
   return status;
 }
 
+// A TensorBuffer that points into a memory-mapped data file. Keeps the
+// mapping alive for as long as any tensor uses it.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     uint64 offset, size_t size)
+      : TensorBuffer(const_cast<char*>(
+            static_cast<const char*>(region->data()) + offset)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("BundleReaderMmap");
+  }
+  // The memory is read-only, so the buffer must never be forwarded to be
+  // written in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
-    : env_(env), options_(options), prefix_(prefix), out_(nullptr), size_(0) {
+    : env_(env), options_(options), prefix_(prefix) {
   status_ = env_->HasAtomicMove(prefix_, &use_temp_file_);
   if (!status_.ok()) return;
+  if (options_.num_data_shards < 1) {
+    status_ = errors::InvalidArgument("num_data_shards must be >= 1, got ",
+                                      options_.num_data_shards);
+    return;
+  }
 
-  data_path_ = DataFilename(prefix_, 0, 1);
+  const int num_shards = options_.num_data_shards;
+  shards_.resize(num_shards);
+  queued_bytes_.assign(num_shards, 0);
+  for (int i = 0; i < num_shards; ++i) {
+    shards_[i].path = DataFilename(prefix_, i, num_shards);
+    if (use_temp_file_) {
+      shards_[i].path =
+          strings::StrCat(shards_[i].path, ".tempstate", random::New64());
+    }
+  }
   metadata_path_ = MetaFilename(prefix_);
   if (use_temp_file_) {
-    data_path_ = strings::StrCat(data_path_, ".tempstate", random::New64());
     metadata_path_ =
         strings::StrCat(metadata_path_, ".tempstate", random::New64());
   }
@@ -442,49 +485,85 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     return;
   }
 
-  std::unique_ptr<WritableFile> wrapper;
-  status_ = env_->NewWritableFile(data_path_, &wrapper);
-  if (!status_.ok()) return;
-  out_ = std::make_unique<tsl::BufferedWritableFile>(
-      std::move(wrapper), 8 << 20 /* 8MB write buffer */);
-
-  VLOG(1) << "Writing to file " << data_path_;
-}
-
-Status BundleWriter::Add(StringPiece key, const Tensor& val) {
-  if (!status_.ok()) return status_;
-  CHECK_NE(key, kHeaderEntryKey);
-  const string key_string(key);
-  if (entries_.find(key_string) != entries_.end()) {
-    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
-    return status_;
+  for (DataShard& shard : shards_) {
+    std::unique_ptr<WritableFile> wrapper;
+    status_ = env_->NewWritableFile(shard.path, &wrapper);
+    if (!status_.ok()) return;
+    shard.out = std::make_unique<tsl::BufferedWritableFile>(
+        std::move(wrapper), 8 << 20 /* 8MB write buffer */);
+    VLOG(1) << "Writing to file " << shard.path;
+  }
+  if (num_shards > 1) {
+    // A single thread per shard keeps the writes of a data file sequential.
+    for (int i = 0; i < num_shards; ++i) {
+      writer_threads_.push_back(std::make_unique<thread::ThreadPool>(
+          env_, "bundle_writer", /*num_threads=*/1));
+    }
   }
+}
 
-  BundleEntryProto* entry = &entries_[key_string];
-  entry->set_dtype(val.dtype());
-  val.shape().AsProto(entry->mutable_shape());
-  entry->set_shard_id(0);
-  entry->set_offset(size_);
+void BundleWriter::WriteToShard(int shard_id, const Tensor& val,
+                                BundleEntryProto* entry) {
+  DataShard& shard = shards_[shard_id];
+  if (!shard.status.ok()) return;
+  const int64_t offset = shard.size;
 
   // Updates the data file.
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
-  out_->reset_crc32();
+  tsl::BufferedWritableFile* out = shard.out.get();
+  out->reset_crc32();
   if (val.dtype() == DT_STRING) {
-    status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    shard.status = WriteStringTensor(val, out, &data_bytes_written, &crc32c);
   } else if (val.dtype() == DT_VARIANT) {
-    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    shard.status = WriteVariantTensor(val, out, &data_bytes_written, &crc32c);
   } else {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32();
+    shard.status = WriteTensor(val, out, &data_bytes_written);
+    crc32c = out->crc32();
+  }
+
+  if (shard.status.ok()) {
+    {
+      mutex_lock l(entries_mu_);
+      entry->set_shard_id(shard_id);
+      entry->set_offset(offset);
+      entry->set_size(data_bytes_written);
+      entry->set_crc32c(crc32c::Mask(crc32c));
+    }
+    shard.size += data_bytes_written;
+    shard.status = PadAlignment(out, options_.data_alignment, &shard.size);
+  }
+}
+
+Status BundleWriter::Add(StringPiece key, const Tensor& val) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(key, kHeaderEntryKey);
+  const string key_string(key);
+  BundleEntryProto* entry;
+  {
+    mutex_lock l(entries_mu_);
+    if (entries_.find(key_string) != entries_.end()) {
+      status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+      return status_;
+    }
+    entry = &entries_[key_string];
+    entry->set_dtype(val.dtype());
+    val.shape().AsProto(entry->mutable_shape());
   }
 
-  if (status_.ok()) {
-    entry->set_size(data_bytes_written);
-    entry->set_crc32c(crc32c::Mask(crc32c));
-    size_ += data_bytes_written;
-    status_ = PadAlignment(out_.get(), options_.data_alignment, &size_);
+  if (writer_threads_.empty()) {
+    WriteToShard(0, val, entry);
+    status_ = shards_[0].status;
+    return status_;
   }
+  // Balances the shards by bytes so that they finish at about the same time.
+  const int shard_id = std::distance(
+      queued_bytes_.begin(),
+      std::min_element(queued_bytes_.begin(), queued_bytes_.end()));
+  queued_bytes_[shard_id] += val.TotalBytes();
+  // The copy of "val" keeps its buffer alive until it has been written.
+  writer_threads_[shard_id]->Schedule(
+      [this, shard_id, val, entry]() { WriteToShard(shard_id, val, entry); });
   return status_;
 }
 
@@ -506,20 +585,23 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   // the "slices" field of multiple metadata entries corresponding to the same
   // full tensor.
   const string full_tensor_key_string(full_tensor_key);
-  BundleEntryProto* full_entry = &entries_[full_tensor_key_string];
-  if (full_entry->dtype() != DT_INVALID) {
-    CHECK_EQ(full_entry->dtype(), slice_tensor.dtype());
-  }
-  if (full_entry->has_shape()) {
-    CHECK(TensorShape(full_entry->shape()) == full_tensor_shape);
-  }
+  {
+    mutex_lock l(entries_mu_);
+    BundleEntryProto* full_entry = &entries_[full_tensor_key_string];
+    if (full_entry->dtype() != DT_INVALID) {
+      CHECK_EQ(full_entry->dtype(), slice_tensor.dtype());
+    }
+    if (full_entry->has_shape()) {
+      CHECK(TensorShape(full_entry->shape()) == full_tensor_shape);
+    }
 
-  // Populates dtype, shape, and slices.  Intentionally leaving out shard_id and
-  // offset, which do not make sense for this full tensor entry.
-  full_entry->set_dtype(slice_tensor.dtype());
-  full_tensor_shape.AsProto(full_entry->mutable_shape());
-  TensorSliceProto* slice_proto = full_entry->add_slices();
-  slice_spec.AsProto(slice_proto);
+    // Populates dtype, shape, and slices.  Intentionally leaving out shard_id
+    // and offset, which do not make sense for this full tensor entry.
+    full_entry->set_dtype(slice_tensor.dtype());
+    full_tensor_shape.AsProto(full_entry->mutable_shape());
+    TensorSliceProto* slice_proto = full_entry->add_slices();
+    slice_spec.AsProto(slice_proto);
+  }
 
   // The slice itself is handled by a regular Add(), which includes adding its
   // own metadata entry, and writing out the slice's values.
@@ -532,16 +614,24 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
-  if (out_) {
-    status_.Update(out_->Close());
-    out_ = nullptr;
+  // Waits for the pending writes.
+  writer_threads_.clear();
+  const int num_shards = shards_.size();
+  for (DataShard& shard : shards_) {
+    status_.Update(shard.status);
+  }
+  for (int i = 0; i < num_shards; ++i) {
+    DataShard& shard = shards_[i];
+    if (!shard.out) continue;
+    status_.Update(shard.out->Close());
+    shard.out = nullptr;
     if (status_.ok()) {
       if (use_temp_file_) {
-        status_ =
-            Env::Default()->RenameFile(data_path_, DataFilename(prefix_, 0, 1));
+        status_ = Env::Default()->RenameFile(
+            shard.path, DataFilename(prefix_, i, num_shards));
       }
     } else {
-      Env::Default()->DeleteFile(data_path_).IgnoreError();
+      Env::Default()->DeleteFile(shard.path).IgnoreError();
     }
   }
   if (!status_.ok()) return status_;
@@ -557,7 +647,7 @@ Status BundleWriter::Finish() {
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
-    header.set_num_shards(1);
+    header.set_num_shards(num_shards);
     header.set_endianness(BundleHeaderProto::LITTLE);
     if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
     VersionDef* version = header.mutable_version();
@@ -567,6 +657,7 @@ Status BundleWriter::Finish() {
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
     // All others.
+    mutex_lock l(entries_mu_);
     for (const auto& p : entries_) {
       builder.Add(p.first, p.second.SerializeAsString());
     }
@@ -1024,6 +1115,61 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupZeroCopy(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const TensorShape stored_shape(entry.shape());
+
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  if (entry.slices().empty() && DataTypeCanUseMemcpy(entry.dtype()) &&
+      !need_to_swap_bytes_ && entry.size() > 0) {
+    auto it = mapped_data_.find(entry.shard_id());
+    if (it == mapped_data_.end()) {
+      std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+      const string filename =
+          DataFilename(prefix_, entry.shard_id(), num_shards_);
+      Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &new_region);
+      if (!s.ok()) {
+        VLOG(1) << "Unable to map " << filename << ", reading instead: " << s;
+      }
+      it = mapped_data_.emplace(entry.shard_id(), std::move(new_region)).first;
+    }
+    region = it->second;
+  }
+  const bool mappable =
+      region != nullptr &&
+      entry.offset() + entry.size() <= region->length() &&
+      (reinterpret_cast<uintptr_t>(region->data()) + entry.offset()) %
+              Allocator::kAllocatorAlignment ==
+          0;
+  if (!mappable) {
+    *val = Tensor(entry.dtype(), stored_shape);
+    return Lookup(key, val);
+  }
+
+  const uint64 expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                            "; stored size ", entry.size(), "; expected size ",
+                            expected_size);
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  core::RefCountPtr<TensorBuffer> buf(
+      new MappedTensorBuffer(std::move(region), entry.offset(), entry.size()));
+  *val = Tensor(entry.dtype(), stored_shape, std::move(buf));
+  return OkStatus();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -83,7 +83,9 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 #include "tensorflow/core/util/tensor_slice_set.h"
@@ -119,6 +121,14 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // Number of data files the tensors are spread across. With more than one,
+    // each data file is written by its own background thread: Add() and
+    // AddSlice() only take a reference to the tensor's buffer and queue it on
+    // the data file with the fewest queued bytes, and Finish() waits for all
+    // writes to complete. Errors while writing tensor data are then reported
+    // by Finish(). The caller must not modify an added tensor's buffer in
+    // place before Finish() returns.
+    int num_data_shards{1};
   };
   BundleWriter(Env* env, absl::string_view prefix,
                const Options& options = Options());
@@ -153,16 +163,33 @@ class BundleWriter {
   Status status() const { return status_; }
 
  private:
+  // One data file. Only accessed by its writer thread, if any, until Finish().
+  struct DataShard {
+    std::string path;  // Possibly a temporary path.
+    std::unique_ptr<tsl::BufferedWritableFile> out;
+    int64_t size = 0;  // Number of bytes written into out.
+    Status status;
+  };
+
+  // Appends "val" to shards_[shard_id] and fills in the location of the data
+  // in "entry".
+  void WriteToShard(int shard_id, const Tensor& val, BundleEntryProto* entry);
+
   Env* const env_;  // Not owned.
   const Options options_;
   const std::string prefix_;
   std::string metadata_path_;
-  std::string data_path_;
   bool use_temp_file_;
-  std::unique_ptr<tsl::BufferedWritableFile> out_;
-  int64_t size_;  // Number of bytes written into out_.
-  std::map<std::string, BundleEntryProto> entries_;
+  std::vector<DataShard> shards_;
+  // Bytes added to each shard so far, used to balance shards.
+  std::vector<int64_t> queued_bytes_;
+  // Guards the entries written to by the writer threads.
+  mutex entries_mu_;
+  std::map<std::string, BundleEntryProto> entries_ TF_GUARDED_BY(entries_mu_);
   Status status_;
+  // One single-threaded pool per shard when num_data_shards > 1. Declared
+  // last so that pending writes are drained before the shards are destroyed.
+  std::vector<std::unique_ptr<thread::ThreadPool>> writer_threads_;
 
   BundleWriter(const BundleWriter&) = delete;
   void operator=(const BundleWriter&) = delete;
@@ -251,6 +278,23 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like Lookup(), but "val" is replaced by a tensor of the stored shape and,
+  // where possible, that tensor's buffer is a read-only memory mapping of the
+  // data file instead of a copy. This is the case for non-partitioned tensors
+  // of memcpy-able dtypes that were written with the host's endianness at an
+  // offset aligned to Allocator::kAllocatorAlignment (see
+  // BundleWriter::Options::data_alignment); all other tensors, and all
+  // tensors of bundles on file systems without memory mapping, are read as
+  // by Lookup().
+  //
+  // Mapped tensors keep the mapping alive after the reader is destroyed and
+  // never report a reference count of one, so they are copied before being
+  // modified in place. Processes mapping the same bundle share its pages.
+  //
+  // Validates the stored crc32c checksum against the restored bytes.
+  // REQUIRES: status().ok()
+  Status LookupZeroCopy(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -327,6 +371,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32_t, io::InputBuffer*> data_;
+  // Memory mappings of the data files used by LookupZeroCopy(). Null for files
+  // that can't be mapped.
+  std::unordered_map<int32_t, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 #include <random>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -951,6 +952,61 @@ TEST(TensorBundleTest, SortForSequentialAccess) {
                           "tensor-1-2", "tensor-1-1", "tensor-1-0"));
 }
 
+TEST(TensorBundleTest, MultipleDataShards) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.num_data_shards = 3;
+    BundleWriter writer(env, Prefix("sharded"), opts);
+    TF_ASSERT_OK(writer.status());
+    for (int i = 0; i < 8; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("tensor", i),
+                              Constant(static_cast<float>(i),
+                                       TensorShape({i + 1, 3}))));
+    }
+    TF_EXPECT_OK(writer.Add("strs", test::AsTensor<tstring>({"a", "bc"})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice::ParseOrDie("0,2"),
+                                 test::AsTensor<int32>({1, 2})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice::ParseOrDie("2,2"),
+                                 test::AsTensor<int32>({3, 4})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  StringPiece dir = io::Dirname(Prefix("sharded"));
+  for (const char* file :
+       {"sharded.data-00000-of-00003", "sharded.data-00001-of-00003",
+        "sharded.data-00002-of-00003"}) {
+    TF_EXPECT_OK(env->FileExists(io::JoinPath(dir, file)));
+  }
+
+  // Merging renumbers the data files of the sharded bundle.
+  {
+    BundleWriter writer(env, Prefix("single"));
+    TF_EXPECT_OK(writer.Add("other", Constant_2x3<float>(-1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(env, {Prefix("single"), Prefix("sharded")},
+                            Prefix("merged")));
+
+  for (const string& prefix : {Prefix("sharded"), Prefix("merged")}) {
+    BundleReader reader(env, prefix);
+    TF_ASSERT_OK(reader.status());
+    std::set<int> shard_ids;
+    for (int i = 0; i < 8; ++i) {
+      const string key = strings::StrCat("tensor", i);
+      Expect<float>(&reader, key,
+                    Constant(static_cast<float>(i), TensorShape({i + 1, 3})));
+      BundleEntryProto entry;
+      TF_ASSERT_OK(reader.GetBundleEntryProto(key, &entry));
+      shard_ids.insert(entry.shard_id());
+    }
+    EXPECT_EQ(3, shard_ids.size());
+    Expect<tstring>(&reader, "strs", test::AsTensor<tstring>({"a", "bc"}));
+    Expect<int32>(&reader, "part", test::AsTensor<int32>({1, 2, 3, 4}));
+  }
+}
+
 TEST(TensorBundleTest, Error) {
   {  // Dup keys.
     BundleWriter writer(Env::Default(), Prefix("dup"));
@@ -1201,6 +1257,47 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, LookupZeroCopy) {
+  Env* env = Env::Default();
+  for (int alignment : {1, 64}) {
+    const string prefix = Prefix(strings::StrCat("zero_copy", alignment));
+    {
+      BundleWriter::Options opts;
+      opts.data_alignment = alignment;
+      BundleWriter writer(env, prefix, opts);
+      TF_EXPECT_OK(writer.Add("small", Constant(true, TensorShape({1}))));
+      TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(3)));
+      TF_EXPECT_OK(writer.Add("strs", test::AsTensor<tstring>({"a", "bc"})));
+      TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                   TensorSlice::ParseOrDie("0,2"),
+                                   test::AsTensor<int32>({1, 2})));
+      TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                   TensorSlice::ParseOrDie("2,2"),
+                                   test::AsTensor<int32>({3, 4})));
+      TF_ASSERT_OK(writer.Finish());
+    }
+    Tensor floats, strs, part;
+    {
+      BundleReader reader(env, prefix);
+      TF_ASSERT_OK(reader.status());
+      TF_ASSERT_OK(reader.LookupZeroCopy("floats", &floats));
+      TF_ASSERT_OK(reader.LookupZeroCopy("strs", &strs));
+      TF_ASSERT_OK(reader.LookupZeroCopy("part", &part));
+      EXPECT_TRUE(errors::IsNotFound(reader.LookupZeroCopy("none", &part)));
+    }
+    // The tensors outlive the reader.
+    test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(3));
+    test::ExpectTensorEqual<tstring>(strs,
+                                     test::AsTensor<tstring>({"a", "bc"}));
+    test::ExpectTensorEqual<int32>(part, test::AsTensor<int32>({1, 2, 3, 4}));
+    // Only aligned tensors are mapped, and mapped tensors are never
+    // modified in place.
+    EXPECT_EQ(alignment == 1, floats.RefCountIsOne());
+    EXPECT_TRUE(strs.RefCountIsOne());
+    EXPECT_TRUE(part.RefCountIsOne());
+  }
+}
+
 static void BM_BundleAlignment(::testing::benchmark::State& state) {
   {
     const int alignment = state.range(0);
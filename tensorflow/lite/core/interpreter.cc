@@ -19,6 +19,7 @@ limitations under the License.
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <functional>
 #include <map>
 #include <memory>
@@ -394,6 +395,10 @@ TfLiteStatus Interpreter::ModifyGraphWithDelegateImpl(
     TfLiteDelegate* delegate) {
   TfLiteStatus status = kTfLiteOk;
   for (auto& subgraph : subgraphs_) {
+    // Unbuilt subgraphs are delegated by EnsureSubgraphBuilt.
+    if (unbuilt_subgraphs_.count(subgraph->GetSubgraphIndex()) != 0) {
+      continue;
+    }
     if (IsValidationSubgraph(subgraph->GetName().c_str()) ||
         subgraph->IsDelegationSkippable()) {
       TFLITE_LOG(TFLITE_LOG_INFO,
@@ -411,10 +416,78 @@ TfLiteStatus Interpreter::ModifyGraphWithDelegateImpl(
   if (status == kTfLiteDelegateError) {
     TF_LITE_ENSURE_STATUS(RemoveAllDelegates());
   }
+  if (status == kTfLiteOk && !unbuilt_subgraphs_.empty()) {
+    delegates_for_unbuilt_subgraphs_.push_back(delegate);
+  }
   return status;
 }
 
+void Interpreter::SetLazySubgraphBuilder(
+    const std::vector<int>& unbuilt_subgraphs, LazySubgraphBuilder builder) {
+  unbuilt_subgraphs_.insert(unbuilt_subgraphs.begin(),
+                            unbuilt_subgraphs.end());
+  lazy_subgraph_builder_ = std::move(builder);
+}
+
+TfLiteStatus Interpreter::EnsureSubgraphBuilt(int subgraph_index) {
+  if (unbuilt_subgraphs_.count(subgraph_index) == 0) return kTfLiteOk;
+  if (lazy_subgraph_builder_ == nullptr) {
+    // A previous build failed, the model is malformed.
+    return kTfLiteError;
+  }
+
+  // Like InterpreterBuilder, build all called subgraphs before delegating any
+  // of them.
+  std::vector<int> built;
+  std::vector<int> to_build = {subgraph_index};
+  while (!to_build.empty()) {
+    const int index = to_build.back();
+    to_build.pop_back();
+    if (unbuilt_subgraphs_.count(index) == 0) continue;
+    if (lazy_subgraph_builder_(subgraphs_[index].get(), &to_build) !=
+        kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_, "Failed to build subgraph %d.",
+                           index);
+      lazy_subgraph_builder_ = nullptr;
+      return kTfLiteError;
+    }
+    unbuilt_subgraphs_.erase(index);
+    built.push_back(index);
+  }
+  std::sort(built.begin(), built.end());
+
+  for (int index : built) {
+    Subgraph* subgraph = subgraphs_[index].get();
+    if (IsValidationSubgraph(subgraph->GetName().c_str()) ||
+        subgraph->IsDelegationSkippable()) {
+      continue;
+    }
+    for (TfLiteDelegate* delegate : delegates_for_unbuilt_subgraphs_) {
+      const TfLiteStatus status = subgraph->ModifyGraphWithDelegate(delegate);
+      if (status == kTfLiteError) return kTfLiteError;
+      if (status != kTfLiteOk) {
+        // The other subgraphs are already delegated, so only fall back to the
+        // default kernels for this one.
+        TFLITE_LOG(TFLITE_LOG_INFO,
+                   "Failed to delegate lazily built subgraph %d, running it "
+                   "without delegates.",
+                   index);
+        TF_LITE_ENSURE_STATUS(subgraph->RemoveAllDelegates());
+        break;
+      }
+    }
+  }
+
+  if (unbuilt_subgraphs_.empty()) {
+    // Drop the builder's reference to the model and op resolver.
+    lazy_subgraph_builder_ = nullptr;
+    delegates_for_unbuilt_subgraphs_.clear();
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Interpreter::RemoveAllDelegates() {
+  delegates_for_unbuilt_subgraphs_.clear();
   for (auto& subgraph : subgraphs_) {
     TF_LITE_ENSURE_STATUS(subgraph->RemoveAllDelegates());
   }
@@ -529,6 +602,13 @@ impl::SignatureRunner* Interpreter::GetSignatureRunner(
     return &(iter->second);
   }
 
+  for (const auto& signature : signature_defs_) {
+    if (signature.signature_key == signature_key &&
+        EnsureSubgraphBuilt(signature.subgraph_index) != kTfLiteOk) {
+      return nullptr;
+    }
+  }
+
   // Default delegates are applied once for all subgraphs. Only returns error
   // when the status is kTfLiteError. For other statuses, it will fall back to
   // the default implementation.
@@ -35,6 +35,7 @@ limitations under the License.
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -904,6 +905,21 @@ class Interpreter {
 
   TfLiteStatus ApplyOptionsImpl(InterpreterOptions* options);
 
+  // Builds the tensors and nodes of a subgraph whose building was deferred,
+  // and appends the indices of the subgraphs it calls to `called_subgraphs`.
+  using LazySubgraphBuilder = std::function<TfLiteStatus(
+      Subgraph* subgraph, std::vector<int>* called_subgraphs)>;
+
+  // Defers building the subgraphs in `unbuilt_subgraphs` until they are first
+  // used. Used by InterpreterBuilder.
+  void SetLazySubgraphBuilder(const std::vector<int>& unbuilt_subgraphs,
+                              LazySubgraphBuilder builder);
+
+  // Builds subgraph `subgraph_index` and the subgraphs it calls if their
+  // building was deferred, and applies the delegates that were applied to the
+  // interpreter in the meantime. No-op for subgraphs that are already built.
+  TfLiteStatus EnsureSubgraphBuilt(int subgraph_index);
+
   // A pure C data structure used to communicate with the pure C plugin
   // interface. To avoid copying tensor metadata, this is also the definitive
   // structure to store tensors.
@@ -960,6 +976,14 @@ class Interpreter {
   using TfLiteDelegateCreators = std::vector<TfLiteDelegateCreator>;
   TfLiteDelegateCreators lazy_delegate_providers_;
 
+  // Set when InterpreterBuilder deferred building some subgraphs, see
+  // `InterpreterOptions::SetLazySubgraphBuilding`.
+  LazySubgraphBuilder lazy_subgraph_builder_;
+  std::set<int> unbuilt_subgraphs_;
+  // Delegates applied while some subgraphs were unbuilt, in order. They are
+  // applied to each of those subgraphs once it's built.
+  std::vector<TfLiteDelegate*> delegates_for_unbuilt_subgraphs_;
+
   // List of SignatureDefs obtained from the model.
   std::vector<internal::SignatureDef> signature_defs_;
 
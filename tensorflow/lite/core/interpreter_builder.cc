@@ -327,6 +327,47 @@ class MallocDataAllocator : public BuiltinDataAllocator {
   void Deallocate(void* data) override { free(data); }
 };
 
+// Appends the indices of the subgraphs that control flow ops in `subgraph`
+// call to `called_subgraphs`. Out of range indices are skipped, the kernels
+// report them.
+void AppendCalledSubgraphs(const SubGraph* subgraph, int num_subgraphs,
+                           std::vector<int>* called_subgraphs) {
+  if (!subgraph->operators()) return;
+  auto append = [&](int index) {
+    if (index >= 0 && index < num_subgraphs) {
+      called_subgraphs->push_back(index);
+    }
+  };
+  for (const Operator* op : *subgraph->operators()) {
+    if (const auto* options = op->builtin_options_as_IfOptions()) {
+      append(options->then_subgraph_index());
+      append(options->else_subgraph_index());
+    } else if (const auto* options = op->builtin_options_as_WhileOptions()) {
+      append(options->cond_subgraph_index());
+      append(options->body_subgraph_index());
+    } else if (const auto* options =
+                   op->builtin_options_as_CallOnceOptions()) {
+      append(options->init_subgraph_index());
+    } else if (const auto* options =
+                   op->builtin_options_2_as_StablehloWhileOptions()) {
+      append(options->cond_subgraph_index());
+      append(options->body_subgraph_index());
+    } else if (const auto* options =
+                   op->builtin_options_2_as_StablehloReduceOptions()) {
+      append(options->body_subgraph_index());
+    } else if (const auto* options =
+                   op->builtin_options_2_as_StablehloReduceWindowOptions()) {
+      append(options->body_subgraph_index());
+    } else if (const auto* options =
+                   op->builtin_options_2_as_StablehloSortOptions()) {
+      append(options->comparator_subgraph_index());
+    } else if (const auto* options =
+                   op->builtin_options_2_as_StablehloScatterOptions()) {
+      append(options->update_computation_subgraph_index());
+    }
+  }
+}
+
 }  // namespace
 
 TfLiteStatus InterpreterBuilder::ParseNodes(
@@ -722,6 +763,48 @@ TfLiteStatus InterpreterBuilder::ParseTensors(
   return status;
 }
 
+TfLiteStatus InterpreterBuilder::ParseSubgraph(
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    const SubGraph* subgraph, Subgraph* modified_subgraph,
+    TfLiteTelemetrySubgraphInfo* subgraph_info) {
+  modified_subgraph->allocation_ = allocation_;
+  auto operators = subgraph->operators();
+  auto tensors = subgraph->tensors();
+  if (!tensors) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Did not get tensors in subgraph %d.\n",
+                         modified_subgraph->GetSubgraphIndex());
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE_STATUS(modified_subgraph->AddTensors(tensors->size()));
+  // Parse inputs/outputs
+  modified_subgraph->SetInputs(FlatBufferIntArrayToVector(subgraph->inputs()));
+  modified_subgraph->SetOutputs(
+      FlatBufferIntArrayToVector(subgraph->outputs()));
+
+  // Finally setup nodes and tensors
+  // Parse tensors before nodes as ParseNodes checks input tensors for the
+  // nodes.
+  TF_LITE_ENSURE_STATUS(
+      ParseTensors(buffers, tensors, modified_subgraph, subgraph_info));
+  if (operators) {
+    TF_LITE_ENSURE_STATUS(ParseNodes(operators, modified_subgraph));
+  }
+
+  std::vector<int> variables;
+  for (int i = 0; i < modified_subgraph->tensors_size(); ++i) {
+    auto* tensor = modified_subgraph->tensor(i);
+    if (tensor->is_variable) {
+      variables.push_back(i);
+    }
+  }
+  modified_subgraph->SetVariables(std::move(variables));
+  if (subgraph->name()) {
+    modified_subgraph->SetName(subgraph->name()->c_str());
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus InterpreterBuilder::ApplyDelegates(Interpreter* interpreter) {
   // Apply Flex delegate if applicable.
   if (has_flex_op_) {
@@ -835,53 +918,73 @@ TfLiteStatus InterpreterBuilder::operator()(
     telemetry_settings->subgraph_infos.resize(subgraphs->size());
   }
 
+  // In lazy mode only the primary subgraph and the subgraphs it calls are
+  // built now.
+  std::vector<bool> build_now(subgraphs->size(),
+                              !options_.GetLazySubgraphBuilding());
+  if (options_.GetLazySubgraphBuilding()) {
+    std::vector<int> to_visit = {0};
+    while (!to_visit.empty()) {
+      const int index = to_visit.back();
+      to_visit.pop_back();
+      if (build_now[index]) continue;
+      build_now[index] = true;
+      AppendCalledSubgraphs((*subgraphs)[index], subgraphs->size(),
+                            &to_visit);
+    }
+  }
+
+  std::vector<int> unbuilt_subgraphs;
   for (int subgraph_index = 0; subgraph_index < subgraphs->size();
        ++subgraph_index) {
     const tflite::SubGraph* subgraph = (*subgraphs)[subgraph_index];
     tflite::Subgraph* modified_subgraph =
         (*interpreter)->subgraph(subgraph_index);
-    modified_subgraph->allocation_ = allocation_;
+    if (!build_now[subgraph_index]) {
+      // The name is needed to decide whether to delegate the subgraph.
+      if (subgraph->name()) {
+        modified_subgraph->SetName(subgraph->name()->c_str());
+      }
+      unbuilt_subgraphs.push_back(subgraph_index);
+      continue;
+    }
     auto* subgraph_info =
         telemetry_registered
             ? &telemetry_settings->subgraph_infos[subgraph_index]
             : nullptr;
-    auto operators = subgraph->operators();
-    auto tensors = subgraph->tensors();
-    if (!tensors) {
-      TF_LITE_REPORT_ERROR(error_reporter_,
-                           "Did not get tensors in subgraph %d.\n",
-                           subgraph_index);
-      return cleanup_and_error();
-    }
-    if (modified_subgraph->AddTensors(tensors->size()) != kTfLiteOk) {
+    if (ParseSubgraph(buffers, subgraph, modified_subgraph, subgraph_info) !=
+        kTfLiteOk) {
       return cleanup_and_error();
     }
-    // Parse inputs/outputs
-    modified_subgraph->SetInputs(
-        FlatBufferIntArrayToVector(subgraph->inputs()));
-    modified_subgraph->SetOutputs(
-        FlatBufferIntArrayToVector(subgraph->outputs()));
-
-    // Finally setup nodes and tensors
-    // Parse tensors before nodes as ParseNodes checks input tensors for the
-    // nodes.
-    if (ParseTensors(buffers, tensors, modified_subgraph, subgraph_info) !=
-        kTfLiteOk)
-      return cleanup_and_error();
-    if (operators && ParseNodes(operators, modified_subgraph) != kTfLiteOk)
-      return cleanup_and_error();
+  }
 
-    std::vector<int> variables;
-    for (int i = 0; i < modified_subgraph->tensors_size(); ++i) {
-      auto* tensor = modified_subgraph->tensor(i);
-      if (tensor->is_variable) {
-        variables.push_back(i);
-      }
-    }
-    modified_subgraph->SetVariables(std::move(variables));
-    if (subgraph->name()) {
-      modified_subgraph->SetName(subgraph->name()->c_str());
-    }
+  if (!unbuilt_subgraphs.empty()) {
+    // The builder may be gone by the time a subgraph is used, so deferred
+    // subgraphs are parsed by a builder owned by the interpreter.
+    auto lazy_builder = std::make_shared<InterpreterBuilder>(
+        model_, op_resolver_, error_reporter_, &options_, allocation_);
+    bool registrations_built = false;
+    (*interpreter)
+        ->SetLazySubgraphBuilder(
+            unbuilt_subgraphs,
+            [lazy_builder, registrations_built](
+                Subgraph* modified_subgraph,
+                std::vector<int>* called_subgraphs) mutable {
+              if (!registrations_built) {
+                TF_LITE_ENSURE_STATUS(
+                    lazy_builder->BuildLocalIndexToRegistrationMapping());
+                registrations_built = true;
+              }
+              auto* subgraphs = lazy_builder->model_->subgraphs();
+              const tflite::SubGraph* subgraph =
+                  (*subgraphs)[modified_subgraph->GetSubgraphIndex()];
+              TF_LITE_ENSURE_STATUS(lazy_builder->ParseSubgraph(
+                  lazy_builder->model_->buffers(), subgraph, modified_subgraph,
+                  /*subgraph_info=*/nullptr));
+              AppendCalledSubgraphs(subgraph, subgraphs->size(),
+                                    called_subgraphs);
+              return kTfLiteOk;
+            });
   }
 
   if (ParseSignatureDefs(model_->signature_defs(), interpreter->get()) !=
@@ -136,6 +136,11 @@ class InterpreterBuilder {
       const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
       const flatbuffers::Vector<flatbuffers::Offset<Tensor>>* tensors,
       Subgraph* subgraph, TfLiteTelemetrySubgraphInfo* subgraph_info);
+  // Builds the tensors and nodes of `modified_subgraph` from `subgraph`.
+  TfLiteStatus ParseSubgraph(
+      const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+      const SubGraph* subgraph, Subgraph* modified_subgraph,
+      TfLiteTelemetrySubgraphInfo* subgraph_info);
   TfLiteStatus ApplyDelegates(Interpreter* interpreter);
   TfLiteStatus ParseQuantization(const QuantizationParameters* src_quantization,
                                  TfLiteQuantization* quantization,
@@ -96,6 +96,56 @@ TEST(SignatureRunnerTest, TestMultiSignatures) {
   ASSERT_EQ(sub_output->data.f[2], 3);
 }
 
+TEST(SignatureRunnerTest, TestLazySubgraphBuilding) {
+  TestErrorReporter reporter;
+  auto model = FlatBufferModel::BuildFromFile(
+      "tensorflow/lite/testdata/multi_signatures.bin", &reporter);
+  ASSERT_TRUE(model);
+  ops::builtin::BuiltinOpResolver resolver;
+  InterpreterOptions options;
+  options.SetLazySubgraphBuilding();
+  InterpreterBuilder builder(*model, resolver, &options);
+
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(builder(&interpreter), kTfLiteOk);
+  ASSERT_NE(interpreter, nullptr);
+  ASSERT_EQ(interpreter->subgraphs_size(), 2);
+  const int sub_index = interpreter->GetSubgraphIndexFromSignature("sub");
+  ASSERT_NE(sub_index, 0);
+  ASSERT_NE(sub_index, -1);
+  EXPECT_GT(interpreter->primary_subgraph().tensors_size(), 0);
+  EXPECT_EQ(interpreter->subgraph(sub_index)->tensors_size(), 0);
+  EXPECT_EQ(interpreter->subgraph(sub_index)->nodes_size(), 0);
+
+  SignatureRunner* sub_runner = interpreter->GetSignatureRunner("sub");
+  ASSERT_NE(sub_runner, nullptr);
+  EXPECT_GT(interpreter->subgraph(sub_index)->tensors_size(), 0);
+  ASSERT_EQ(sub_runner->ResizeInputTensor("x", {2}), kTfLiteOk);
+  ASSERT_EQ(sub_runner->AllocateTensors(), kTfLiteOk);
+  TfLiteTensor* sub_input = sub_runner->input_tensor("x");
+  const TfLiteTensor* sub_output = sub_runner->output_tensor("output_0");
+  ASSERT_NE(sub_input, nullptr);
+  ASSERT_NE(sub_output, nullptr);
+  sub_input->data.f[0] = 2;
+  sub_input->data.f[1] = 4;
+  ASSERT_EQ(sub_runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(sub_output->data.f[0], -1);
+  EXPECT_EQ(sub_output->data.f[1], 1);
+
+  // Getting the runner again doesn't rebuild the subgraph.
+  const int sub_tensors = interpreter->subgraph(sub_index)->tensors_size();
+  EXPECT_EQ(interpreter->GetSignatureRunner("sub"), sub_runner);
+  EXPECT_EQ(interpreter->subgraph(sub_index)->tensors_size(), sub_tensors);
+
+  SignatureRunner* add_runner = interpreter->GetSignatureRunner("add");
+  ASSERT_NE(add_runner, nullptr);
+  ASSERT_EQ(add_runner->ResizeInputTensor("x", {1}), kTfLiteOk);
+  ASSERT_EQ(add_runner->AllocateTensors(), kTfLiteOk);
+  add_runner->input_tensor("x")->data.f[0] = 2;
+  ASSERT_EQ(add_runner->Invoke(), kTfLiteOk);
+  EXPECT_EQ(add_runner->output_tensor("output_0")->data.f[0], 4);
+}
+
 }  // namespace
 }  // namespace impl
 }  // namespace tflite
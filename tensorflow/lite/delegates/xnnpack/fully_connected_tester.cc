@@ -181,10 +181,50 @@ std::vector<char> FullyConnectedTester::CreateTfLiteModel() const {
 
     bias_data[oc] = value_rng();
     for (int32_t ic = 0; ic < InputChannels(); ic++) {
-      filter_data[oc * InputChannels() + ic] = value_rng();
+      filter_data[oc * InputChannels() + ic] =
+          SparseWeights() && ic % 4 >= 2 ? 0.0f : value_rng();
     }
   }
 
+  /************************ Define sparsity parameters ************************/
+  // Sparse weights use the CSR format with a dense output channel dimension,
+  // which TFLite's FULLY_CONNECTED kernel supports.
+  flatbuffers::Offset<SparsityParameters> filter_sparsity_params = 0;
+  std::vector<float> sparse_filter_values;
+  if (SparseWeights()) {
+    EXPECT_EQ(WeightsType(), WeightsType::kFP32);
+    std::vector<int32_t> segments{0};
+    std::vector<int32_t> indices;
+    for (int32_t oc = 0; oc < OutputChannels(); oc++) {
+      for (int32_t ic = 0; ic < InputChannels(); ic++) {
+        const float value = filter_data[oc * InputChannels() + ic];
+        if (value != 0.0f) {
+          indices.push_back(ic);
+          sparse_filter_values.push_back(value);
+        }
+      }
+      segments.push_back(static_cast<int32_t>(indices.size()));
+    }
+    const std::array<flatbuffers::Offset<DimensionMetadata>, 2> dim_metadata{
+        {CreateDimensionMetadata(builder, DimensionType_DENSE,
+                                 OutputChannels()),
+         CreateDimensionMetadata(
+             builder, DimensionType_SPARSE_CSR, InputChannels(),
+             SparseIndexVector_Int32Vector,
+             CreateInt32Vector(builder, builder.CreateVector(segments))
+                 .Union(),
+             SparseIndexVector_Int32Vector,
+             CreateInt32Vector(builder, builder.CreateVector(indices))
+                 .Union())}};
+    const std::array<int32_t, 2> traversal_order{{0, 1}};
+    filter_sparsity_params = CreateSparsityParameters(
+        builder,
+        builder.CreateVector<int32_t>(traversal_order.data(),
+                                      traversal_order.size()),
+        /*block_map=*/0,
+        builder.CreateVector(dim_metadata.data(), dim_metadata.size()));
+  }
+
   /****************************** Define buffers ******************************/
   std::vector<flatbuffers::Offset<tflite::Buffer>> buffers{
       {CreateBuffer(builder, builder.CreateVector({}))}};
@@ -194,13 +234,16 @@ std::vector<char> FullyConnectedTester::CreateTfLiteModel() const {
   int filter_buffer_id = 0, quantized_filter_buffer_id = 0;
   const std::vector<int32_t> filter_shape = {OutputChannels(), InputChannels()};
   switch (WeightsType()) {
-    case WeightsType::kFP32:
+    case WeightsType::kFP32: {
+      const std::vector<float>& values =
+          SparseWeights() ? sparse_filter_values : filter_data;
       filter_buffer_id = buffers.size();
       buffers.emplace_back(CreateBuffer(
           builder, builder.CreateVector(
-                       reinterpret_cast<const uint8_t*>(filter_data.data()),
-                       sizeof(float) * filter_data.size())));
+                       reinterpret_cast<const uint8_t*>(values.data()),
+                       sizeof(float) * values.size())));
       break;
+    }
     case WeightsType::kFP16: {
       std::vector<uint16_t> quantized_filter_data(filter_data.size());
       std::transform(filter_data.begin(), filter_data.end(),
@@ -324,7 +367,8 @@ std::vector<char> FullyConnectedTester::CreateTfLiteModel() const {
       builder,
       builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
       TensorType_FLOAT32,
-      /*buffer=*/filter_buffer_id));
+      /*buffer=*/filter_buffer_id, /*name=*/0, /*quantization=*/0,
+      /*is_variable=*/false, filter_sparsity_params));
 
   const int bias_tensor_id = HasBias() ? tensors.size() : -1;
   if (HasBias()) {
@@ -112,6 +112,15 @@ class FullyConnectedTester {
     return *this;
   }
 
+  // Stores FP32 weights in the sparse representation, with 2 out of every 4
+  // consecutive input channel weights pruned.
+  inline FullyConnectedTester& SparseWeights() {
+    sparse_weights_ = true;
+    return *this;
+  }
+
+  inline bool SparseWeights() const { return sparse_weights_; }
+
   inline FullyConnectedTester& NoBias() {
     bias_type_ = BiasType::kNone;
     return *this;
@@ -165,6 +174,7 @@ class FullyConnectedTester {
   int32_t input_channels_ = 1;
   int32_t output_channels_ = 1;
   bool keep_dims_ = false;
+  bool sparse_weights_ = false;
   enum WeightsType weights_type_ { WeightsType::kFP32 };
   enum BiasType bias_type_ { BiasType::kFP32 };
   ::tflite::ActivationFunctionType activation_ =
@@ -24,6 +24,7 @@ limitations under the License.
 #include <limits>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -321,6 +322,79 @@ std::vector<size_t> TfLiteDimensionsToXNNPackDimensions(
   return dims;
 }
 
+// Fraction of zero blocks from which TFLite's block-sparse FULLY_CONNECTED
+// kernels are expected to outperform XNNPACK's dense one. It matches the
+// sparsity that XNNPACK requires for sparse inference.
+constexpr float kMinProfitableWeightSparsity = 2.0f / 3.0f;
+
+// Returns true if a FULLY_CONNECTED node with static sparse weights should be
+// left to TFLite's sparse kernels rather than delegated with densified
+// weights. TFLite only has optimized kernels for 1x4 blocks of FP32 weights
+// and 1x16 blocks of INT8 weights. Other encodings, such as the unstructured
+// one N:M pruned weights end up in, run faster when densified.
+bool PreferTfLiteSparseFullyConnected(const TfLiteTensor& filter) {
+  const TfLiteSparsity& sparsity = *filter.sparsity;
+  if (sparsity.dim_metadata_size != 3 ||
+      sparsity.dim_metadata[0].format != kTfLiteDimDense ||
+      sparsity.dim_metadata[1].format != kTfLiteDimSparseCSR ||
+      sparsity.dim_metadata[1].array_indices == nullptr) {
+    return false;
+  }
+  const int block_size = sparsity.dim_metadata[2].dense_size;
+  if (!(filter.type == kTfLiteFloat32 && block_size == 4) &&
+      !(filter.type == kTfLiteInt8 && block_size == 16)) {
+    return false;
+  }
+  const int64_t num_blocks =
+      static_cast<int64_t>(sparsity.dim_metadata[0].dense_size) *
+      sparsity.dim_metadata[1].dense_size;
+  const int64_t num_nonzero_blocks =
+      sparsity.dim_metadata[1].array_indices->size;
+  return num_nonzero_blocks <=
+         (1.0f - kMinProfitableWeightSparsity) * num_blocks;
+}
+
+// Converts the static sparse tensor `sparse_tensor` to its dense
+// representation in `dense_data`.
+TfLiteStatus DensifyStaticTensor(TfLiteContext* context,
+                                 const TfLiteTensor& sparse_tensor,
+                                 char* dense_data) {
+  const int dims_count = NumDimensions(&sparse_tensor);
+  std::vector<int> vector_shape(dims_count);
+  for (int i = 0; i < dims_count; i++) {
+    vector_shape[i] = SizeOfDimension(&sparse_tensor, i);
+  }
+  const size_t dense_size = NumElements(&sparse_tensor);
+
+  switch (sparse_tensor.type) {
+    case kTfLiteFloat32: {
+      tflite::internal::sparsity::FormatConverter<float> converter(
+          vector_shape, *sparse_tensor.sparsity);
+      return converter.SparseToDense(
+          static_cast<const float*>(sparse_tensor.data.data), dense_size,
+          reinterpret_cast<float*>(dense_data), context);
+    }
+    case kTfLiteFloat16: {
+      tflite::internal::sparsity::FormatConverter<Eigen::half> converter(
+          vector_shape, *sparse_tensor.sparsity);
+      return converter.SparseToDense(
+          static_cast<const Eigen::half*>(sparse_tensor.data.data), dense_size,
+          reinterpret_cast<Eigen::half*>(dense_data), context);
+    }
+    case kTfLiteInt8: {
+      tflite::internal::sparsity::FormatConverter<int8_t> converter(
+          vector_shape, *sparse_tensor.sparsity);
+      return converter.SparseToDense(
+          static_cast<const int8_t*>(sparse_tensor.data.data), dense_size,
+          reinterpret_cast<int8_t*>(dense_data), context);
+    }
+    default:
+      TF_LITE_KERNEL_LOG(context, "unexpected datatype (%s) of sparse tensor",
+                         TfLiteTypeGetName(sparse_tensor.type));
+      return kTfLiteError;
+  }
+}
+
 // Forward declaration.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
 
@@ -921,14 +995,13 @@ class Subgraph {
 
       uint32_t flags = 0;
       const void* data = nullptr;
-      if (context->tensors[t].allocation_type == kTfLiteMmapRo) {
+      // Check for quasi-static data first, as static sparse weights are
+      // unpacked too.
+      const auto it = delegate.static_unpacked_data_map_.find(t);
+      if (it != delegate.static_unpacked_data_map_.end()) {
+        data = delegate.static_unpacked_data_.data() + it->second;
+      } else if (context->tensors[t].allocation_type == kTfLiteMmapRo) {
         data = context->tensors[t].data.raw_const;
-      } else {
-        // Check for quasi-static data.
-        const auto it = delegate.static_unpacked_data_map_.find(t);
-        if (it != delegate.static_unpacked_data_map_.end()) {
-          data = delegate.static_unpacked_data_.data() + it->second;
-        }
       }
       if (inputs.count(t) != 0) {
         flags |= XNN_VALUE_FLAG_EXTERNAL_INPUT;
@@ -2408,13 +2481,21 @@ class Subgraph {
         return VisitEluNode(subgraph, delegate, logging_context, node_index,
                             node, context->tensors, input_output_tensors);
       case kTfLiteBuiltinFullyConnected: {
-        // FullyConnected with sparse weight has version 8, which cannot be
-        // delegated to XNNPack.
-        if (registration->version == 8) {
-          TF_LITE_MAYBE_KERNEL_LOG(logging_context,
-                                   "Unsupported version %d of FullyConnected.",
-                                   registration->version);
-          return kTfLiteError;
+        // Static sparse weights are densified in PrepareOpsToDelegate, unless
+        // TFLite's sparse kernels are expected to be faster.
+        if (node->inputs->size >= 2) {
+          const TfLiteTensor& filter_tensor =
+              context->tensors[node->inputs->data[1]];
+          if (filter_tensor.sparsity != nullptr &&
+              (filter_tensor.allocation_type != kTfLiteMmapRo ||
+               PreferTfLiteSparseFullyConnected(filter_tensor))) {
+            TF_LITE_MAYBE_KERNEL_LOG(
+                logging_context,
+                "Leaving FULLY_CONNECTED node #%d with sparse weights to "
+                "TFLite's sparse kernels.",
+                node_index);
+            return kTfLiteError;
+          }
         }
 
         const TfLiteFullyConnectedParams* fc_params =
@@ -6410,6 +6491,8 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   std::unordered_set<int> quasi_static_tensors;
   // Set of quasi-static tensors consumed by the delegated nodes.
   std::unordered_set<int> quasi_static_tensors_to_unpack;
+  // Set of static sparse tensors consumed directly by the delegated nodes.
+  std::set<int> sparse_weights_to_densify;
   // Record all VarHandle nodes. At the point of visiting it, we don't know if
   // it can be delegated yet, because we don't know the type of the variable -
   // we rely on ReadVariable/AssignVariable to tell us the type. So the first
@@ -6529,8 +6612,13 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     }
 
     for (int j = 0; j < node->inputs->size; j++) {
-      if (quasi_static_tensors.count(node->inputs->data[j]) != 0) {
-        quasi_static_tensors_to_unpack.insert(node->inputs->data[j]);
+      const int t = node->inputs->data[j];
+      if (quasi_static_tensors.count(t) != 0) {
+        quasi_static_tensors_to_unpack.insert(t);
+      }
+      if (t >= 0 && context->tensors[t].sparsity != nullptr &&
+          context->tensors[t].allocation_type == kTfLiteMmapRo) {
+        sparse_weights_to_densify.insert(t);
       }
     }
 
@@ -6693,53 +6781,7 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
         // Such a condition has been checked when preparing to unpack FP16/INT8
         // tensors.
         TFLITE_DCHECK(input_tensor.sparsity != nullptr);
-        const int dims_count = NumDimensions(&output_tensor);
-        std::vector<int> vector_shape(dims_count);
-        for (int i = 0; i < dims_count; i++) {
-          vector_shape[i] = SizeOfDimension(&output_tensor, i);
-        }
-
-        switch (input_tensor.type) {
-          case kTfLiteFloat32: {
-            const size_t dense_size = context->tensors[t].bytes / sizeof(float);
-            float* unpacked_fp32_data = reinterpret_cast<float*>(unpacked_data);
-            tflite::internal::sparsity::FormatConverter<float> converter(
-                vector_shape, *input_tensor.sparsity);
-            converter.SparseToDense(
-                static_cast<const float*>(input_tensor.data.data), dense_size,
-                unpacked_fp32_data, context);
-            break;
-          }
-          case kTfLiteFloat16: {
-            const size_t dense_size =
-                context->tensors[t].bytes / sizeof(Eigen::half);
-            Eigen::half* unpacked_fp16_data =
-                reinterpret_cast<Eigen::half*>(unpacked_data);
-            tflite::internal::sparsity::FormatConverter<Eigen::half> converter(
-                vector_shape, *input_tensor.sparsity);
-            converter.SparseToDense(
-                static_cast<const Eigen::half*>(input_tensor.data.data),
-                dense_size, unpacked_fp16_data, context);
-            break;
-          }
-          case kTfLiteInt8: {
-            const size_t dense_size =
-                context->tensors[t].bytes / sizeof(int8_t);
-            int8_t* unpacked_int8_data =
-                reinterpret_cast<int8_t*>(unpacked_data);
-            tflite::internal::sparsity::FormatConverter<int8_t> converter(
-                vector_shape, *input_tensor.sparsity);
-            converter.SparseToDense(
-                static_cast<const int8_t*>(input_tensor.data.data), dense_size,
-                unpacked_int8_data, context);
-            break;
-          }
-          default: {
-            // This should not happen as we only allow FP16/INT8 input_tensor
-            // when preparing the unpacking.
-            TFLITE_DCHECK(false);
-          }
-        }
+        DensifyStaticTensor(context, input_tensor, unpacked_data);
         break;
       }
       default:
@@ -6752,6 +6794,43 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     static_unpacked_data_map_[t] = tensor_offset;
   }
 
+  // Densify static sparse weights that delegated nodes consume without a
+  // DENSIFY node, i.e. FULLY_CONNECTED weights that aren't worth running
+  // sparse (see PreferTfLiteSparseFullyConnected).
+  for (int t : sparse_weights_to_densify) {
+    const TfLiteTensor& tensor = context->tensors[t];
+    size_t element_size = 0;
+    switch (tensor.type) {
+      case kTfLiteFloat32:
+        element_size = sizeof(float);
+        break;
+      case kTfLiteInt8:
+        element_size = sizeof(int8_t);
+        break;
+      default:
+        TF_LITE_KERNEL_LOG(context,
+                           "unexpected datatype (%s) of sparse tensor %d",
+                           TfLiteTypeGetName(tensor.type), t);
+        TfLiteIntArrayFree(nodes_to_delegate);
+        return nullptr;  // Hard error.
+    }
+
+    // Align to XNN_EXTRA_BYTES bytes
+    while (static_unpacked_data_.size() % XNN_EXTRA_BYTES != 0) {
+      static_unpacked_data_.push_back(0);
+    }
+    const size_t tensor_offset = static_unpacked_data_.size();
+    static_unpacked_data_.resize(tensor_offset +
+                                 NumElements(&tensor) * element_size);
+    if (DensifyStaticTensor(context, tensor,
+                            static_unpacked_data_.data() + tensor_offset) !=
+        kTfLiteOk) {
+      TfLiteIntArrayFree(nodes_to_delegate);
+      return nullptr;  // Hard error.
+    }
+    static_unpacked_data_map_[t] = tensor_offset;
+  }
+
   // Add nodes that unpack static data consumed by delegated nodes.
   // Note: this is done purely to avoid the overhead of running these nodes
   // again in TFLite interpreter which would allocate memory for their outputs.
@@ -0,0 +1,231 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/resource/kv_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace resource {
+namespace internal {
+
+// Owns the memory of all pages of a cache and its forks. Pages are handed out
+// by index and reference counted; memory is only released when the pool dies,
+// so page pointers stay valid while a page is in use.
+class KVCachePagePool {
+ public:
+  KVCachePagePool(size_t page_bytes, int initial_pages)
+      : page_bytes_(page_bytes) {
+    Grow(initial_pages);
+  }
+
+  // Returns the index of a page with a reference count of one.
+  int Acquire() {
+    if (free_pages_.empty()) {
+      // Only forks need more than the initial pages. Grow geometrically so
+      // that forking many times stays cheap.
+      Grow(std::max<int>(1, page_data_.size() / 2));
+    }
+    const int page = free_pages_.back();
+    free_pages_.pop_back();
+    ref_counts_[page] = 1;
+    return page;
+  }
+
+  void Ref(int page) { ++ref_counts_[page]; }
+
+  void Unref(int page) {
+    if (--ref_counts_[page] == 0) free_pages_.push_back(page);
+  }
+
+  bool IsShared(int page) const { return ref_counts_[page] > 1; }
+
+  int ref_count(int page) const { return ref_counts_[page]; }
+
+  char* data(int page) { return page_data_[page]; }
+
+  size_t page_bytes() const { return page_bytes_; }
+
+ private:
+  void Grow(int num_pages) {
+    if (num_pages <= 0) return;
+    slabs_.emplace_back(new char[page_bytes_ * num_pages]);
+    char* slab = slabs_.back().get();
+    // Hand out lower indices first.
+    for (int i = num_pages - 1; i >= 0; --i) {
+      free_pages_.push_back(static_cast<int>(page_data_.size()) + i);
+    }
+    for (int i = 0; i < num_pages; ++i) {
+      page_data_.push_back(slab + i * page_bytes_);
+      ref_counts_.push_back(0);
+    }
+  }
+
+  const size_t page_bytes_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  std::vector<char*> page_data_;
+  std::vector<int> ref_counts_;
+  std::vector<int> free_pages_;
+};
+
+}  // namespace internal
+
+std::unique_ptr<KVCache> KVCache::Create(const Config& config) {
+  size_t type_size = 0;
+  if (GetSizeOfType(nullptr, config.type, &type_size) != kTfLiteOk ||
+      config.token_size <= 0 || config.max_sequence_length <= 0 ||
+      config.page_size <= 0) {
+    return nullptr;
+  }
+  const size_t token_bytes = type_size * config.token_size;
+  // Keys and values of a page are stored back to back.
+  const size_t page_bytes = 2 * token_bytes * config.page_size;
+  const int num_pages = (config.max_sequence_length + config.page_size - 1) /
+                        config.page_size;
+  return std::unique_ptr<KVCache>(new KVCache(
+      config,
+      std::make_shared<internal::KVCachePagePool>(page_bytes, num_pages)));
+}
+
+KVCache::KVCache(const Config& config,
+                 std::shared_ptr<internal::KVCachePagePool> pool)
+    : config_(config), pool_(std::move(pool)) {
+  size_t type_size = 0;
+  GetSizeOfType(nullptr, config_.type, &type_size);
+  token_bytes_ = type_size * config_.token_size;
+}
+
+KVCache::~KVCache() {
+  for (int page : pages_) pool_->Unref(page);
+}
+
+TfLiteStatus KVCache::PrepareTailPage() {
+  const int page_index = length_ / config_.page_size;
+  if (page_index == static_cast<int>(pages_.size())) {
+    pages_.push_back(pool_->Acquire());
+    return kTfLiteOk;
+  }
+  const int page = pages_[page_index];
+  if (!pool_->IsShared(page)) return kTfLiteOk;
+  // Copy-on-write: only the tokens already in the page need to move.
+  const int new_page = pool_->Acquire();
+  const int tokens_in_page = length_ % config_.page_size;
+  const size_t half = token_bytes_ * config_.page_size;
+  std::memcpy(pool_->data(new_page), pool_->data(page),
+              tokens_in_page * token_bytes_);
+  std::memcpy(pool_->data(new_page) + half, pool_->data(page) + half,
+              tokens_in_page * token_bytes_);
+  pool_->Unref(page);
+  pages_[page_index] = new_page;
+  return kTfLiteOk;
+}
+
+TfLiteStatus KVCache::Append(const void* keys, const void* values,
+                             int num_tokens) {
+  if (num_tokens < 0 || length_ + num_tokens > config_.max_sequence_length) {
+    return kTfLiteError;
+  }
+  const char* key_src = static_cast<const char*>(keys);
+  const char* value_src = static_cast<const char*>(values);
+  const size_t half = token_bytes_ * config_.page_size;
+  while (num_tokens > 0) {
+    TF_LITE_ENSURE_STATUS(PrepareTailPage());
+    const int offset = length_ % config_.page_size;
+    const int count = std::min(num_tokens, config_.page_size - offset);
+    char* page = pool_->data(pages_[length_ / config_.page_size]);
+    std::memcpy(page + offset * token_bytes_, key_src, count * token_bytes_);
+    std::memcpy(page + half + offset * token_bytes_, value_src,
+                count * token_bytes_);
+    key_src += count * token_bytes_;
+    value_src += count * token_bytes_;
+    length_ += count;
+    num_tokens -= count;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus KVCache::Append(const TfLiteTensor* keys,
+                             const TfLiteTensor* values) {
+  if (keys == nullptr || values == nullptr || keys->type != config_.type ||
+      values->type != config_.type || keys->dims == nullptr ||
+      keys->dims->size < 1 || !TfLiteIntArrayEqual(keys->dims, values->dims) ||
+      keys->bytes != keys->dims->data[0] * token_bytes_) {
+    return kTfLiteError;
+  }
+  return Append(keys->data.raw_const, values->data.raw_const,
+                keys->dims->data[0]);
+}
+
+std::unique_ptr<KVCache> KVCache::Fork() const {
+  std::unique_ptr<KVCache> fork(new KVCache(config_, pool_));
+  fork->pages_ = pages_;
+  fork->length_ = length_;
+  for (int page : pages_) pool_->Ref(page);
+  return fork;
+}
+
+void KVCache::Reset() {
+  for (int page : pages_) pool_->Unref(page);
+  pages_.clear();
+  length_ = 0;
+}
+
+KVCache::PageView KVCache::GetPage(int index) const {
+  if (index < 0 || index >= num_pages()) return {nullptr, nullptr, 0};
+  const char* page = pool_->data(pages_[index]);
+  const int num_tokens =
+      std::min(config_.page_size, length_ - index * config_.page_size);
+  return {page, page + token_bytes_ * config_.page_size, num_tokens};
+}
+
+size_t KVCache::GetMemoryUsage() {
+  size_t bytes = 0;
+  for (int page : pages_) {
+    bytes += pool_->page_bytes() / pool_->ref_count(page);
+  }
+  return bytes;
+}
+
+TfLiteStatus CreateKVCacheIfNotAvailable(ResourceMap* resources,
+                                         int resource_id,
+                                         const KVCache::Config& config) {
+  if (resources->count(resource_id) != 0) {
+    return kTfLiteOk;
+  }
+  auto cache = KVCache::Create(config);
+  if (cache == nullptr) return kTfLiteError;
+  resources->emplace(resource_id, std::move(cache));
+  return kTfLiteOk;
+}
+
+KVCache* GetKVCache(ResourceMap* resources, int resource_id) {
+  auto it = resources->find(resource_id);
+  if (it != resources->end()) {
+    return static_cast<KVCache*>(it->second.get());
+  }
+  return nullptr;
+}
+
+}  // namespace resource
+}  // namespace tflite
@@ -0,0 +1,149 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_KV_CACHE_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_KV_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/experimental/resource/resource_base.h"
+
+namespace tflite {
+namespace resource {
+
+namespace internal {
+class KVCachePagePool;
+}  // namespace internal
+
+/// WARNING: Experimental interface, subject to change.
+// A key/value cache for autoregressive decoding.
+//
+// Unlike a ResourceVariable, which is reassigned (and possibly reallocated)
+// with the whole cache on every step, a KVCache only ever appends the keys and
+// values of the new tokens in place. Storage is split into fixed-size pages
+// that are preallocated for `max_sequence_length` tokens, so appending never
+// moves previously written tokens and attention kernels can read the pages
+// directly.
+//
+// A cache can be forked (e.g. for beam search or to reuse a shared prompt):
+// the fork shares all pages with its parent and a page is only copied when
+// either side appends to a page that is still shared.
+//
+// Forks share a page pool, so a cache and all its forks must be used from the
+// same thread.
+//
+// Models append to the cache with the KV_CACHE_UPDATE custom op and read it
+// with KV_CACHE_ATTENTION (tensorflow/lite/kernels/kv_cache_update.cc and
+// kv_cache_attention.cc).
+class KVCache : public ResourceBase {
+ public:
+  struct Config {
+    // Element type of keys and values.
+    TfLiteType type = kTfLiteFloat32;
+    // Number of elements of one token's key (and value), e.g.
+    // num_kv_heads * head_dim.
+    int token_size = 0;
+    // Number of tokens the cache is preallocated for.
+    int max_sequence_length = 0;
+    // Number of tokens per page.
+    int page_size = 16;
+  };
+
+  // A contiguous run of tokens in one page. `keys` and `values` each hold
+  // `num_tokens * token_size` elements.
+  struct PageView {
+    const void* keys;
+    const void* values;
+    int num_tokens;
+  };
+
+  // Returns nullptr if `config` is invalid.
+  static std::unique_ptr<KVCache> Create(const Config& config);
+
+  KVCache(const KVCache&) = delete;
+  KVCache& operator=(const KVCache&) = delete;
+
+  ~KVCache() override;
+
+  // Appends the keys and values of `num_tokens` tokens. Both buffers hold
+  // `num_tokens * token_size` elements of the configured type. Fails without
+  // modifying the cache if the cache would exceed `max_sequence_length`.
+  TfLiteStatus Append(const void* keys, const void* values, int num_tokens);
+
+  // Same as above with tensors whose first dimension is the number of tokens
+  // and whose remaining dimensions flatten to `token_size`.
+  TfLiteStatus Append(const TfLiteTensor* keys, const TfLiteTensor* values);
+
+  // Returns a cache that shares all tokens of this one. Appending to either
+  // cache afterwards does not affect the other.
+  std::unique_ptr<KVCache> Fork() const;
+
+  // Drops all tokens, e.g. at the start of a new sequence. Pages that aren't
+  // shared with a fork are kept for reuse.
+  void Reset();
+
+  // Number of tokens in the cache.
+  int length() const { return length_; }
+
+  int num_pages() const { return static_cast<int>(pages_.size()); }
+
+  // Returns the tokens stored in page `index`, which are tokens
+  // [index * page_size, index * page_size + view.num_tokens). Returns an empty
+  // view (null pointers, no tokens) if `index` is not in [0, num_pages()).
+  PageView GetPage(int index) const;
+
+  const Config& config() const { return config_; }
+
+  bool IsInitialized() override { return true; }
+
+  // Returns the bytes of the pages this cache holds. A page shared with forks
+  // is split evenly between them, so the usage of a cache and all its forks
+  // adds up to the memory in use rather than counting shared pages once per
+  // fork.
+  size_t GetMemoryUsage() override;
+
+ private:
+  KVCache(const Config& config,
+          std::shared_ptr<internal::KVCachePagePool> pool);
+
+  // Makes sure the page that token `length_` goes to exists and is not shared.
+  TfLiteStatus PrepareTailPage();
+
+  Config config_;
+  size_t token_bytes_;
+  std::shared_ptr<internal::KVCachePagePool> pool_;
+  // Indices into the pool.
+  std::vector<int> pages_;
+  int length_ = 0;
+};
+
+// Creates a KV cache with `config` under `resource_id` unless one already
+// exists.
+// WARNING: Experimental interface, subject to change.
+TfLiteStatus CreateKVCacheIfNotAvailable(ResourceMap* resources,
+                                         int resource_id,
+                                         const KVCache::Config& config);
+
+// Returns the corresponding KV cache, or nullptr if none.
+// WARNING: Experimental interface, subject to change.
+KVCache* GetKVCache(ResourceMap* resources, int resource_id);
+
+}  // namespace resource
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_KV_CACHE_H_
@@ -0,0 +1,219 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/resource/kv_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+namespace resource {
+namespace {
+
+constexpr int kTokenSize = 3;
+
+KVCache::Config MakeConfig(int max_sequence_length, int page_size) {
+  KVCache::Config config;
+  config.type = kTfLiteFloat32;
+  config.token_size = kTokenSize;
+  config.max_sequence_length = max_sequence_length;
+  config.page_size = page_size;
+  return config;
+}
+
+// Appends tokens [first, first + count), where the key of token t is
+// {t, t, t} and its value is {-t, -t, -t}.
+TfLiteStatus AppendTokens(KVCache* cache, int first, int count) {
+  std::vector<float> keys, values;
+  for (int t = first; t < first + count; ++t) {
+    for (int i = 0; i < kTokenSize; ++i) {
+      keys.push_back(t);
+      values.push_back(-t);
+    }
+  }
+  return cache->Append(keys.data(), values.data(), count);
+}
+
+// Returns the first element of the key of every token, in order.
+std::vector<float> KeyTokens(const KVCache& cache) {
+  std::vector<float> tokens;
+  for (int p = 0; p < cache.num_pages(); ++p) {
+    const auto page = cache.GetPage(p);
+    const float* keys = static_cast<const float*>(page.keys);
+    const float* values = static_cast<const float*>(page.values);
+    for (int t = 0; t < page.num_tokens; ++t) {
+      EXPECT_EQ(keys[t * kTokenSize], -values[t * kTokenSize]);
+      tokens.push_back(keys[t * kTokenSize]);
+    }
+  }
+  return tokens;
+}
+
+TEST(KVCacheTest, InvalidConfig) {
+  EXPECT_EQ(nullptr, KVCache::Create(MakeConfig(0, 4)));
+  EXPECT_EQ(nullptr, KVCache::Create(MakeConfig(8, 0)));
+}
+
+TEST(KVCacheTest, AppendAcrossPages) {
+  auto cache = KVCache::Create(MakeConfig(10, 4));
+  ASSERT_NE(nullptr, cache);
+  EXPECT_EQ(0, cache->length());
+
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 3));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 3, 2));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 5, 1));
+  EXPECT_EQ(6, cache->length());
+  EXPECT_EQ(2, cache->num_pages());
+  EXPECT_EQ(4, cache->GetPage(0).num_tokens);
+  EXPECT_EQ(2, cache->GetPage(1).num_tokens);
+  EXPECT_EQ((std::vector<float>{0, 1, 2, 3, 4, 5}), KeyTokens(*cache));
+}
+
+TEST(KVCacheTest, AppendDoesNotMoveExistingTokens) {
+  auto cache = KVCache::Create(MakeConfig(16, 4));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 2));
+  const void* first_page = cache->GetPage(0).keys;
+  for (int t = 2; t < 16; ++t) {
+    ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), t, 1));
+  }
+  EXPECT_EQ(first_page, cache->GetPage(0).keys);
+}
+
+TEST(KVCacheTest, AppendBeyondCapacityFails) {
+  auto cache = KVCache::Create(MakeConfig(5, 4));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 4));
+  EXPECT_EQ(kTfLiteError, AppendTokens(cache.get(), 4, 2));
+  EXPECT_EQ(4, cache->length());
+  EXPECT_EQ(kTfLiteOk, AppendTokens(cache.get(), 4, 1));
+  EXPECT_EQ(5, cache->length());
+}
+
+TEST(KVCacheTest, ResetReusesMemory) {
+  auto cache = KVCache::Create(MakeConfig(8, 4));
+  EXPECT_EQ(0, cache->GetMemoryUsage());
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 8));
+  const size_t memory = cache->GetMemoryUsage();
+  cache->Reset();
+  EXPECT_EQ(0, cache->length());
+  EXPECT_EQ(0, cache->num_pages());
+  EXPECT_EQ(0, cache->GetMemoryUsage());
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 10, 8));
+  EXPECT_EQ(memory, cache->GetMemoryUsage());
+  EXPECT_EQ((std::vector<float>{10, 11, 12, 13, 14, 15, 16, 17}),
+            KeyTokens(*cache));
+}
+
+TEST(KVCacheTest, GetPageOutOfRange) {
+  auto cache = KVCache::Create(MakeConfig(8, 4));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 5));
+  ASSERT_EQ(2, cache->num_pages());
+  for (int index : {-1, 2, 100}) {
+    const auto page = cache->GetPage(index);
+    EXPECT_EQ(nullptr, page.keys);
+    EXPECT_EQ(nullptr, page.values);
+    EXPECT_EQ(0, page.num_tokens);
+  }
+}
+
+TEST(KVCacheTest, MemoryUsageSplitsSharedPages) {
+  // One page holds keys and values of 4 tokens of 3 floats.
+  constexpr size_t kPageBytes = 2 * 4 * kTokenSize * sizeof(float);
+  auto cache = KVCache::Create(MakeConfig(12, 4));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 8));
+  EXPECT_EQ(2 * kPageBytes, cache->GetMemoryUsage());
+
+  auto fork = cache->Fork();
+  EXPECT_EQ(kPageBytes, cache->GetMemoryUsage());
+  EXPECT_EQ(kPageBytes, fork->GetMemoryUsage());
+
+  // The fork's new page is its own.
+  ASSERT_EQ(kTfLiteOk, AppendTokens(fork.get(), 8, 1));
+  EXPECT_EQ(kPageBytes, cache->GetMemoryUsage());
+  EXPECT_EQ(2 * kPageBytes, fork->GetMemoryUsage());
+
+  fork.reset();
+  EXPECT_EQ(2 * kPageBytes, cache->GetMemoryUsage());
+}
+
+TEST(KVCacheTest, ForkSharesFullPagesAndCopiesOnWrite) {
+  auto cache = KVCache::Create(MakeConfig(12, 4));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 0, 6));
+
+  auto fork = cache->Fork();
+  EXPECT_EQ(6, fork->length());
+  EXPECT_EQ(cache->GetPage(0).keys, fork->GetPage(0).keys);
+  EXPECT_EQ(cache->GetPage(1).keys, fork->GetPage(1).keys);
+
+  ASSERT_EQ(kTfLiteOk, AppendTokens(cache.get(), 100, 2));
+  ASSERT_EQ(kTfLiteOk, AppendTokens(fork.get(), 200, 3));
+
+  // The full page stays shared; the partially filled one was copied.
+  EXPECT_EQ(cache->GetPage(0).keys, fork->GetPage(0).keys);
+  EXPECT_NE(cache->GetPage(1).keys, fork->GetPage(1).keys);
+  EXPECT_EQ((std::vector<float>{0, 1, 2, 3, 4, 5, 100, 101}),
+            KeyTokens(*cache));
+  EXPECT_EQ((std::vector<float>{0, 1, 2, 3, 4, 5, 200, 201, 202}),
+            KeyTokens(*fork));
+
+  // Resetting the parent must not affect the fork.
+  cache->Reset();
+  EXPECT_EQ((std::vector<float>{0, 1, 2, 3, 4, 5, 200, 201, 202}),
+            KeyTokens(*fork));
+}
+
+TEST(KVCacheTest, AppendTensor) {
+  auto cache = KVCache::Create(MakeConfig(8, 4));
+  std::vector<float> keys = {1, 1, 1, 2, 2, 2};
+  std::vector<float> values = {-1, -1, -1, -2, -2, -2};
+  TfLiteIntArray* dims = TfLiteIntArrayCreate(2);
+  dims->data[0] = 2;
+  dims->data[1] = kTokenSize;
+  TfLiteTensor key_tensor = {};
+  key_tensor.type = kTfLiteFloat32;
+  key_tensor.dims = dims;
+  key_tensor.bytes = keys.size() * sizeof(float);
+  key_tensor.data.raw = reinterpret_cast<char*>(keys.data());
+  TfLiteTensor value_tensor = key_tensor;
+  value_tensor.data.raw = reinterpret_cast<char*>(values.data());
+
+  EXPECT_EQ(kTfLiteOk, cache->Append(&key_tensor, &value_tensor));
+  EXPECT_EQ((std::vector<float>{1, 2}), KeyTokens(*cache));
+
+  value_tensor.type = kTfLiteInt32;
+  EXPECT_EQ(kTfLiteError, cache->Append(&key_tensor, &value_tensor));
+  TfLiteIntArrayFree(dims);
+}
+
+TEST(KVCacheTest, ResourceMap) {
+  ResourceMap resources;
+  EXPECT_EQ(nullptr, GetKVCache(&resources, 1));
+  EXPECT_EQ(kTfLiteOk,
+            CreateKVCacheIfNotAvailable(&resources, 1, MakeConfig(8, 4)));
+  KVCache* cache = GetKVCache(&resources, 1);
+  ASSERT_NE(nullptr, cache);
+  // An existing cache is kept.
+  EXPECT_EQ(kTfLiteOk,
+            CreateKVCacheIfNotAvailable(&resources, 1, MakeConfig(16, 4)));
+  EXPECT_EQ(cache, GetKVCache(&resources, 1));
+  EXPECT_EQ(kTfLiteError,
+            CreateKVCacheIfNotAvailable(&resources, 2, MakeConfig(0, 4)));
+}
+
+}  // namespace
+}  // namespace resource
+}  // namespace tflite
@@ -29,7 +29,8 @@ class InterpreterOptions {
       : experimental_preserve_all_tensors_(false),
         experimental_ensure_dynamic_tensors_are_released_(false),
         experimental_optimize_memory_for_large_tensors_(0),
-        experimental_disable_delegate_clustering_(false) {}
+        experimental_disable_delegate_clustering_(false),
+        experimental_lazy_subgraph_building_(false) {}
 
   /// Preserving all intermediates tensors for debugging.
   /// WARNING: This is an experimental API and subject to change.
@@ -93,11 +94,33 @@ class InterpreterOptions {
     experimental_disable_delegate_clustering_ = value;
   }
 
+  // If value == true, `InterpreterBuilder` only builds the primary subgraph
+  // and the subgraphs it calls through control flow ops. The tensors and
+  // nodes (including their builtin op data) of any other subgraph, e.g. the
+  // entry subgraph of another signature, are parsed when the subgraph is
+  // first used through `GetSignatureRunner`. Until then `subgraph(index)`
+  // returns an empty subgraph. This reduces model load latency for models
+  // with several signatures when only some of them are run.
+  // Delegates applied before a subgraph is built are applied to it when it's
+  // built. The op resolver passed to the builder must outlive the
+  // interpreter.
+  // WARNING: This is an experimental API and subject to change.
+  void SetLazySubgraphBuilding(bool value = true) {
+    experimental_lazy_subgraph_building_ = value;
+  }
+
+  // Returns true iff lazy subgraph building (see above) is enabled.
+  // WARNING: This is an experimental API and subject to change.
+  bool GetLazySubgraphBuilding() {
+    return experimental_lazy_subgraph_building_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_;
   bool experimental_ensure_dynamic_tensors_are_released_;
   int experimental_optimize_memory_for_large_tensors_;
   bool experimental_disable_delegate_clustering_;
+  bool experimental_lazy_subgraph_building_;
 };
 
 }  // namespace tflite
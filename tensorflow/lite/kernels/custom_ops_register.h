@@ -28,6 +28,8 @@ TfLiteRegistration* Register_HASHTABLE_FIND();
 TfLiteRegistration* Register_HASHTABLE_IMPORT();
 TfLiteRegistration* Register_HASHTABLE_SIZE();
 TfLiteRegistration* Register_IRFFT2D();
+TfLiteRegistration* Register_KV_CACHE_ATTENTION();
+TfLiteRegistration* Register_KV_CACHE_UPDATE();
 TfLiteRegistration* Register_MAX_POOL_3D();
 TfLiteRegistration* Register_MULTINOMIAL();
 TfLiteRegistration* Register_RANDOM_STANDARD_NORMAL();
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
+#include "tensorflow/lite/kernels/internal/optimized/integer_ops/fully_connected_int4.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
@@ -1091,6 +1092,20 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
   op_params.lhs_cacheable = IsConstantTensor(filter);
   op_params.rhs_cacheable = IsConstantTensor(input);
 
+  // Small batches are bound by reading the weights; keep them packed.
+  if (filter->type == kTfLiteInt4 && kernel_type != kReference &&
+      optimized_integer_ops::CanUseFullyConnectedInt4Gemv(
+          GetTensorShape(filter), GetTensorShape(output))) {
+    optimized_integer_ops::FullyConnectedInt4Weights(
+        op_params, /*output_multiplier=*/nullptr, /*output_shift=*/nullptr,
+        GetTensorShape(input), GetTensorData<int8_t>(input),
+        GetTensorShape(filter), GetTensorData<int8_t>(filter),
+        GetTensorShape(bias), GetTensorData<int32_t>(bias),
+        GetTensorShape(output), GetTensorData<int8_t>(output),
+        cpu_backend_context);
+    return;
+  }
+
   const int8_t* filter_data;
   std::unique_ptr<int8_t[]> unpacked_filter_data = nullptr;
 
@@ -1159,27 +1174,54 @@ void FullyConnectedPerChannelInt8(const OpData* data, const TfLiteTensor* input,
   // since it will be always assumed to be 0.
   FullyConnectedParams op_params;
   op_params.input_offset = -input->params.zero_point;
+  op_params.weights_offset = 0;
   op_params.output_offset = output->params.zero_point;
   op_params.quantized_activation_min = data->output_activation_min;
   op_params.quantized_activation_max = data->output_activation_max;
   op_params.lhs_cacheable = IsConstantTensor(filter);
   op_params.rhs_cacheable = IsConstantTensor(input);
-  if (kernel_type == kReference) {
-    reference_integer_ops::FullyConnectedPerChannel(
+
+  // Small batches are bound by reading the weights; keep them packed.
+  if (filter->type == kTfLiteInt4 && kernel_type != kReference &&
+      optimized_integer_ops::CanUseFullyConnectedInt4Gemv(
+          GetTensorShape(filter), GetTensorShape(output))) {
+    optimized_integer_ops::FullyConnectedInt4Weights(
         op_params, data->per_channel_output_multiplier.data(),
         data->per_channel_output_shift.data(), GetTensorShape(input),
         GetTensorData<int8_t>(input), GetTensorShape(filter),
         GetTensorData<int8_t>(filter), GetTensorShape(bias),
         GetTensorData<int32_t>(bias), GetTensorShape(output),
-        GetTensorData<int8_t>(output));
+        GetTensorData<int8_t>(output), cpu_backend_context);
+    return;
+  }
+
+  const int8_t* filter_data;
+  std::unique_ptr<int8_t[]> unpacked_filter_data = nullptr;
+  if (filter->type == kTfLiteInt4) {
+    unpacked_filter_data = std::make_unique<int8_t[]>(filter->bytes * 2);
+    tflite::tensor_utils::UnpackDenseInt4IntoInt8(
+        GetTensorData<int8_t>(filter), GetTensorShape(filter).FlatSize(),
+        unpacked_filter_data.get());
+    filter_data = unpacked_filter_data.get();
+  } else {
+    filter_data = GetTensorData<int8_t>(filter);
+  }
+
+  if (kernel_type == kReference) {
+    reference_integer_ops::FullyConnectedPerChannel(
+        op_params, data->per_channel_output_multiplier.data(),
+        data->per_channel_output_shift.data(), GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter), filter_data,
+        GetTensorShape(bias), GetTensorData<int32_t>(bias),
+        GetTensorShape(output), GetTensorData<int8_t>(output));
   } else {
     optimized_integer_ops::FullyConnectedPerChannel(
         op_params, data->per_channel_output_multiplier.data(),
         data->per_channel_output_shift.data(), GetTensorShape(input),
-        GetTensorData<int8_t>(input), GetTensorShape(filter),
-        GetTensorData<int8_t>(filter), GetTensorShape(bias),
-        GetTensorData<int32_t>(bias), GetTensorShape(output),
-        GetTensorData<int8_t>(output), cpu_backend_context);
+        GetTensorData<int8_t>(input), GetTensorShape(filter), filter_data,
+        GetTensorShape(bias), GetTensorData<int32_t>(bias),
+        GetTensorShape(output), GetTensorData<int8_t>(output),
+        cpu_backend_context);
   }
 }
 
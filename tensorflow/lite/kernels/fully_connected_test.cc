@@ -174,7 +174,8 @@ class BaseFullyConnectedOpModel : public SingleOpModel {
                              per_channel_quantization_offsets,
                              0});
       } else {
-        weights_ = AddInput({input.type,
+        weights_ = AddInput({filter_type == kTfLiteInt4 ? TensorType_INT4
+                                                        : input.type,
                              {units_, input_size_},
                              0,
                              0,
@@ -375,12 +376,12 @@ class PerChannelQuantizedFullyConnectedOpModel
       ActivationFunctionType activation_func = ActivationFunctionType_RELU,
       FullyConnectedOptionsWeightsFormat weights_format =
           FullyConnectedOptionsWeightsFormat_DEFAULT,
-      int input_size = -1)
+      int input_size = -1, TfLiteType filter_type = kTfLiteNoType)
       : BaseFullyConnectedOpModel(
             registration, units, batches, input, output, bias_type,
             keep_num_dims, bias_tensor_optional, activation_func,
-            weights_format, input_size, true, per_channel_quantization_scales) {
-  }
+            weights_format, input_size, true, per_channel_quantization_scales,
+            filter_type) {}
 
   void SetBias(const std::vector<float>& data) {
     PerChannelQuantizeBias(bias_, data);
@@ -748,6 +749,88 @@ TEST_P(QuantizedFullyConnectedOpTest, SimpleTestQuantizedInt4) {
   EXPECT_THAT(m.GetOutput<int8_t>(), ElementsAre(63, 63, 67, 81, 81, 86));
 }
 
+// Exercises the packed int4 GEMV path with a depth that covers both the
+// vectorized blocks and the scalar tail, and checks it against the reference
+// kernel.
+TEST_P(QuantizedFullyConnectedOpTest, QuantizedInt4MatchesReference) {
+  constexpr int kUnits = 20;
+  constexpr int kDepth = 70;
+  for (int batches : {1, 3, 6}) {
+    auto make_model = [&](TfLiteRegistration* registration) {
+      auto model = std::make_unique<QuantizedFullyConnectedOpModel>(
+          registration, kUnits, batches,
+          /*input=*/TensorData{TensorType_INT8, {batches, kDepth}, -63.5, 64},
+          /*output=*/TensorData{TensorType_INT8, {}, -127, 128},
+          TensorType_INT32, false, false, ActivationFunctionType_NONE,
+          FullyConnectedOptionsWeightsFormat_DEFAULT, -1, kTfLiteInt4);
+      std::vector<float> weights(kUnits * kDepth);
+      for (int i = 0; i < kUnits * kDepth; ++i) {
+        weights[i] = static_cast<float>((i * 7) % 15) - 7.0f;
+      }
+      model->SetWeights4bit(weights);
+      std::vector<float> bias(kUnits);
+      for (int i = 0; i < kUnits; ++i) bias[i] = i - 10;
+      model->SetBias(bias);
+      std::vector<float> input(batches * kDepth);
+      for (int i = 0; i < batches * kDepth; ++i) {
+        input[i] = static_cast<float>((i * 13) % 41) / 4.0f - 5.0f;
+      }
+      model->SetInput<int8_t>(input);
+      return model;
+    };
+
+    auto model = make_model(GetRegistration());
+    auto reference = make_model(ops::builtin::Register_FULLY_CONNECTED_REF());
+    ASSERT_EQ(model->Invoke(), kTfLiteOk);
+    ASSERT_EQ(reference->Invoke(), kTfLiteOk);
+    EXPECT_THAT(model->GetOutput<int8_t>(),
+                ElementsAreArray(reference->GetOutput<int8_t>()));
+  }
+}
+
+// Same as above with per-channel weight scales, which requantize every output
+// channel with its own multiplier.
+TEST_P(QuantizedFullyConnectedOpTest, PerChannelQuantizedInt4MatchesReference) {
+  constexpr int kUnits = 20;
+  constexpr int kDepth = 70;
+  std::vector<float> scales(kUnits);
+  for (int u = 0; u < kUnits; ++u) scales[u] = 0.05f * (1 + u % 7);
+  for (int batches : {1, 3, 6}) {
+    auto make_model = [&](TfLiteRegistration* registration) {
+      auto model = std::make_unique<PerChannelQuantizedFullyConnectedOpModel>(
+          registration, kUnits, batches,
+          /*input=*/TensorData{TensorType_INT8, {batches, kDepth}, -63.5, 64},
+          scales,
+          /*output=*/TensorData{TensorType_INT8, {}, -127, 128},
+          TensorType_INT32, false, false, ActivationFunctionType_NONE,
+          FullyConnectedOptionsWeightsFormat_DEFAULT, -1, kTfLiteInt4);
+      // Multiples of the channel scales in [-7, 7], so that quantization is
+      // exact.
+      std::vector<float> weights(kUnits * kDepth);
+      for (int i = 0; i < kUnits * kDepth; ++i) {
+        weights[i] = scales[i / kDepth] * ((i * 7) % 15 - 7);
+      }
+      model->SetWeights<int8_t>(weights);
+      std::vector<float> bias(kUnits);
+      for (int i = 0; i < kUnits; ++i) bias[i] = i - 10;
+      model->SetBias(bias);
+      std::vector<float> input(batches * kDepth);
+      for (int i = 0; i < batches * kDepth; ++i) {
+        input[i] = static_cast<float>((i * 13) % 41) / 4.0f - 5.0f;
+      }
+      model->SetInput<int8_t>(input);
+      return model;
+    };
+
+    auto model = make_model(GetRegistration());
+    auto reference = make_model(ops::builtin::Register_FULLY_CONNECTED_REF());
+    ASSERT_EQ(model->Invoke(), kTfLiteOk);
+    ASSERT_EQ(reference->Invoke(), kTfLiteOk);
+    EXPECT_THAT(model->GetOutput<int8_t>(),
+                ElementsAreArray(reference->GetOutput<int8_t>()));
+  }
+}
+
 TEST_P(QuantizedFullyConnectedOpTest, SimpleTestQuantizedInt8) {
   QuantizedFullyConnectedOpModel m(
       GetRegistration(), /*units=*/3, /*batches*/ 2,
@@ -0,0 +1,260 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_INT4_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_INT4_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_integer_ops {
+
+// Int8 x int4 fully connected for the small-batch (GEMV-like) case, which is
+// bound by the bandwidth of reading the weights. Instead of unpacking the
+// whole filter into a temporary int8 buffer and running a GEMM, each filter
+// row is read in its packed form and its nibbles are sign-extended in
+// registers right before the multiply-accumulate.
+//
+// Above kMaxBatchesForInt4Gemv batches the op becomes compute bound and the
+// unpack + cpu_backend_gemm path is faster.
+constexpr int kMaxBatchesForInt4Gemv = 4;
+
+// Returns true if `FullyConnectedInt4Weights` can handle the given shapes.
+// Rows of the packed filter must start on a byte boundary.
+inline bool CanUseFullyConnectedInt4Gemv(const RuntimeShape& filter_shape,
+                                         const RuntimeShape& output_shape) {
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int output_dim_count = output_shape.DimensionsCount();
+  if (filter_dim_count < 2 || output_dim_count < 1) return false;
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  return accum_depth % 2 == 0 && batches <= kMaxBatchesForInt4Gemv;
+}
+
+namespace int4_gemv {
+
+// Returns sum_i(w[i] * x[i]) for i in [0, depth), where `packed_w` holds
+// `depth` (even) signed 4-bit values, two per byte with the first value in the
+// low nibble (see tensor_utils::UnpackDenseInt4IntoInt8).
+inline int32_t DotProduct(const int8_t* packed_w, const int16_t* x,
+                          int depth) {
+  int i = 0;
+  int32_t sum = 0;
+#if defined(__AVX2__)
+  const __m128i low_mask = _mm_set1_epi8(0x0F);
+  const __m128i sign_bit = _mm_set1_epi8(0x08);
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 32 <= depth; i += 32) {
+    const __m128i packed = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(packed_w + i / 2));
+    // There is no 8-bit arithmetic shift, so sign-extend each nibble n as
+    // (n ^ 8) - 8.
+    const __m128i lo = _mm_sub_epi8(
+        _mm_xor_si128(_mm_and_si128(packed, low_mask), sign_bit), sign_bit);
+    const __m128i hi = _mm_sub_epi8(
+        _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(packed, 4), low_mask),
+                      sign_bit),
+        sign_bit);
+    const __m256i w0 = _mm256_cvtepi8_epi16(_mm_unpacklo_epi8(lo, hi));
+    const __m256i w1 = _mm256_cvtepi8_epi16(_mm_unpackhi_epi8(lo, hi));
+    const __m256i x0 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    const __m256i x1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 16));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(w0, x0));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(w1, x1));
+  }
+  __m128i acc128 = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                                 _mm256_extracti128_si256(acc, 1));
+  acc128 = _mm_hadd_epi32(acc128, acc128);
+  acc128 = _mm_hadd_epi32(acc128, acc128);
+  sum = _mm_cvtsi128_si32(acc128);
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  int32x4_t acc = vdupq_n_s32(0);
+  for (; i + 16 <= depth; i += 16) {
+    const int8x8_t packed = vld1_s8(packed_w + i / 2);
+    const int8x8_t lo = vshr_n_s8(vshl_n_s8(packed, 4), 4);
+    const int8x8_t hi = vshr_n_s8(packed, 4);
+    const int8x8x2_t w = vzip_s8(lo, hi);
+    const int16x8_t w0 = vmovl_s8(w.val[0]);
+    const int16x8_t w1 = vmovl_s8(w.val[1]);
+    acc = vmlal_s16(acc, vget_low_s16(w0), vld1_s16(x + i));
+    acc = vmlal_s16(acc, vget_high_s16(w0), vld1_s16(x + i + 4));
+    acc = vmlal_s16(acc, vget_low_s16(w1), vld1_s16(x + i + 8));
+    acc = vmlal_s16(acc, vget_high_s16(w1), vld1_s16(x + i + 12));
+  }
+  const int32x2_t acc2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+  sum = vget_lane_s32(vpadd_s32(acc2, acc2), 0);
+#endif
+  for (; i < depth; i += 2) {
+    const int8_t byte = packed_w[i / 2];
+    sum += (static_cast<int8_t>(byte << 4) >> 4) * x[i];
+    sum += (byte >> 4) * x[i + 1];
+  }
+  return sum;
+}
+
+struct Int4GemvTask : cpu_backend_threadpool::Task {
+  Int4GemvTask(const FullyConnectedParams& params,
+               const int32_t* output_multiplier, const int* output_shift,
+               const int8_t* filter_data, const int32_t* bias_data,
+               const int16_t* offset_input, const int32_t* offset_input_sums,
+               int8_t* output_data, int batches, int accum_depth,
+               int output_depth, int row_start, int row_end)
+      : params(params),
+        output_multiplier(output_multiplier),
+        output_shift(output_shift),
+        filter_data(filter_data),
+        bias_data(bias_data),
+        offset_input(offset_input),
+        offset_input_sums(offset_input_sums),
+        output_data(output_data),
+        batches(batches),
+        accum_depth(accum_depth),
+        output_depth(output_depth),
+        row_start(row_start),
+        row_end(row_end) {}
+
+  void Run() override {
+    const int32_t weights_offset = params.weights_offset;
+    const int32_t output_offset = params.output_offset;
+    const int32_t output_activation_min = params.quantized_activation_min;
+    const int32_t output_activation_max = params.quantized_activation_max;
+    for (int row = row_start; row < row_end; ++row) {
+      // Rows are the outer loop so that each packed row is read from memory
+      // once and reused from L1 for every batch.
+      const int8_t* packed_row = filter_data + row * (accum_depth / 2);
+      const int32_t multiplier = output_multiplier != nullptr
+                                     ? output_multiplier[row]
+                                     : params.output_multiplier;
+      const int shift =
+          output_shift != nullptr ? output_shift[row] : params.output_shift;
+      const int32_t bias = bias_data != nullptr ? bias_data[row] : 0;
+      for (int b = 0; b < batches; ++b) {
+        int32_t acc = DotProduct(packed_row, offset_input + b * accum_depth,
+                                 accum_depth);
+        acc += weights_offset * offset_input_sums[b];
+        acc += bias;
+        acc = MultiplyByQuantizedMultiplier(acc, multiplier, shift);
+        acc += output_offset;
+        acc = std::max(acc, output_activation_min);
+        acc = std::min(acc, output_activation_max);
+        output_data[b * output_depth + row] = static_cast<int8_t>(acc);
+      }
+    }
+  }
+
+  const FullyConnectedParams& params;
+  const int32_t* output_multiplier;
+  const int* output_shift;
+  const int8_t* filter_data;
+  const int32_t* bias_data;
+  const int16_t* offset_input;
+  const int32_t* offset_input_sums;
+  int8_t* output_data;
+  int batches;
+  int accum_depth;
+  int output_depth;
+  int row_start;
+  int row_end;
+};
+
+}  // namespace int4_gemv
+
+// `filter_data` holds the filter in the packed kTfLiteInt4 layout. If
+// `output_multiplier` and `output_shift` are non-null they are per output
+// channel; otherwise the per-tensor values in `params` are used.
+// Requires CanUseFullyConnectedInt4Gemv(filter_shape, output_shape).
+inline void FullyConnectedInt4Weights(
+    const FullyConnectedParams& params, const int32_t* output_multiplier,
+    const int* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data, CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnectedInt8/4bit");
+  TFLITE_DCHECK(CanUseFullyConnectedInt4Gemv(filter_shape, output_shape));
+
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int output_depth = MatchingDim(filter_shape, filter_dim_count - 2,
+                                       output_shape, output_dim_count - 1);
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+  if (bias_data) {
+    TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+  }
+
+  // Fold the input offset into an int16 copy of the input once, so that the
+  // inner loop is a plain int4 x int16 dot product. The filter offset is
+  // applied afterwards through the sum of the offset input.
+  std::vector<int16_t> offset_input(batches * accum_depth);
+  std::vector<int32_t> offset_input_sums(batches, 0);
+  for (int b = 0; b < batches; ++b) {
+    for (int d = 0; d < accum_depth; ++d) {
+      const int16_t value = static_cast<int16_t>(
+          input_data[b * accum_depth + d] + params.input_offset);
+      offset_input[b * accum_depth + d] = value;
+      offset_input_sums[b] += value;
+    }
+  }
+
+  // Split the output channels across threads; each task streams a disjoint
+  // slice of the filter.
+  constexpr int kMinRowsPerThread = 16;
+  const int max_threads =
+      cpu_backend_context != nullptr ? cpu_backend_context->max_num_threads()
+                                     : 1;
+  const int thread_count = std::max(
+      1, std::min(max_threads, output_depth / kMinRowsPerThread));
+
+  std::vector<int4_gemv::Int4GemvTask> tasks;
+  tasks.reserve(thread_count);
+  int row_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int row_end = row_start + output_depth / thread_count;
+    if (i < output_depth % thread_count) row_end++;
+    tasks.emplace_back(params, output_multiplier, output_shift, filter_data,
+                       bias_data, offset_input.data(),
+                       offset_input_sums.data(), output_data, batches,
+                       accum_depth, output_depth, row_start, row_end);
+    row_start = row_end;
+  }
+  if (thread_count == 1) {
+    tasks[0].Run();
+  } else {
+    cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                    cpu_backend_context);
+  }
+}
+
+}  // namespace optimized_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_INT4_H_
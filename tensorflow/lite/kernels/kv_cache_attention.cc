@@ -0,0 +1,203 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/kv_cache.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace kv_cache_attention {
+
+// Causal scaled dot-product attention of queries over the tokens of the KV
+// cache resource identified by input 0. The keys and values are read from the
+// cache's pages in place.
+//
+// The queries are those of the last num_queries tokens of the cache, so query
+// i attends to the first length - num_queries + i + 1 tokens. Heads are
+// grouped: query head h uses the keys and values of head
+// h / (num_heads / num_kv_heads).
+//
+// Inputs: resource id, float32 queries [num_queries, num_heads * head_dim] and
+// the int32 length of the cache, the output of KV_CACHE_UPDATE, which orders
+// this op after the update.
+// Outputs: float32 [num_queries, num_heads * head_dim].
+// Custom options: "num_heads" (required) and "num_kv_heads", which defaults to
+// num_heads.
+constexpr int kInputResourceId = 0;
+constexpr int kInputQueries = 1;
+constexpr int kInputLength = 2;
+constexpr int kOutput = 0;
+
+constexpr const char kNumHeadsStr[] = "num_heads";
+constexpr const char kNumKvHeadsStr[] = "num_kv_heads";
+
+struct OpData {
+  int num_heads = 0;
+  int num_kv_heads = 0;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  OpData* op_data = new OpData;
+  if (buffer == nullptr || length == 0) return op_data;
+  const flexbuffers::Map& m =
+      flexbuffers::GetRoot(reinterpret_cast<const uint8_t*>(buffer), length)
+          .AsMap();
+  op_data->num_heads = m[kNumHeadsStr].AsInt32();
+  op_data->num_kv_heads = m[kNumKvHeadsStr].IsNull()
+                              ? op_data->num_heads
+                              : m[kNumKvHeadsStr].AsInt32();
+  return op_data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 3);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE(context, op_data->num_heads > 0);
+  TF_LITE_ENSURE(context, op_data->num_kv_heads > 0);
+  TF_LITE_ENSURE_EQ(context, op_data->num_heads % op_data->num_kv_heads, 0);
+
+  const TfLiteTensor* resource_id;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputResourceId,
+                                          &resource_id));
+  TF_LITE_ENSURE(context, (resource_id->type == kTfLiteResource ||
+                           resource_id->type == kTfLiteInt32));
+  TF_LITE_ENSURE_EQ(context, NumElements(resource_id), 1);
+
+  const TfLiteTensor* queries;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputQueries, &queries));
+  TF_LITE_ENSURE_TYPES_EQ(context, queries->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(queries), 2);
+  TF_LITE_ENSURE_EQ(context,
+                    SizeOfDimension(queries, 1) % op_data->num_heads, 0);
+
+  const TfLiteTensor* length;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputLength, &length));
+  TF_LITE_ENSURE_TYPES_EQ(context, length->type, kTfLiteInt32);
+  TF_LITE_ENSURE_EQ(context, NumElements(length), 1);
+
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, kOutput, &output));
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+  return context->ResizeTensor(context, output,
+                               TfLiteIntArrayCopy(queries->dims));
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* resource_id;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputResourceId,
+                                          &resource_id));
+  const TfLiteTensor* queries;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputQueries, &queries));
+  const TfLiteTensor* length;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputLength, &length));
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, kOutput, &output));
+
+  Subgraph* subgraph = reinterpret_cast<Subgraph*>(context->impl_);
+  const int id = resource_id->data.i32[0];
+  const resource::KVCache* cache =
+      resource::GetKVCache(&subgraph->resources(), id);
+  if (cache == nullptr) {
+    TF_LITE_KERNEL_LOG(context, "KV cache %d does not exist.", id);
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE_TYPES_EQ(context, cache->config().type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, cache->length(), length->data.i32[0]);
+
+  const int num_queries = SizeOfDimension(queries, 0);
+  const int num_heads = op_data->num_heads;
+  const int head_dim = SizeOfDimension(queries, 1) / num_heads;
+  const int token_size = cache->config().token_size;
+  TF_LITE_ENSURE_EQ(context, token_size, op_data->num_kv_heads * head_dim);
+  TF_LITE_ENSURE(context, num_queries <= cache->length());
+  const int heads_per_kv_head = num_heads / op_data->num_kv_heads;
+  const int page_size = cache->config().page_size;
+  const float scale = 1.0f / std::sqrt(static_cast<float>(head_dim));
+
+  const float* query_data = GetTensorData<float>(queries);
+  float* output_data = GetTensorData<float>(output);
+  std::vector<float> acc(head_dim);
+  for (int q = 0; q < num_queries; ++q) {
+    const int num_visible = cache->length() - num_queries + q + 1;
+    for (int h = 0; h < num_heads; ++h) {
+      const float* query = query_data + (q * num_heads + h) * head_dim;
+      const int kv_offset = (h / heads_per_kv_head) * head_dim;
+      // Softmax in a single pass, rescaling the sums whenever the maximum
+      // score grows.
+      float max_score = -std::numeric_limits<float>::infinity();
+      float sum = 0;
+      std::fill(acc.begin(), acc.end(), 0.0f);
+      for (int p = 0; p * page_size < num_visible; ++p) {
+        const resource::KVCache::PageView page = cache->GetPage(p);
+        const int num_tokens =
+            std::min(page.num_tokens, num_visible - p * page_size);
+        const float* keys = static_cast<const float*>(page.keys);
+        const float* values = static_cast<const float*>(page.values);
+        for (int t = 0; t < num_tokens; ++t) {
+          const float* key = keys + t * token_size + kv_offset;
+          const float* value = values + t * token_size + kv_offset;
+          float score = 0;
+          for (int d = 0; d < head_dim; ++d) score += query[d] * key[d];
+          score *= scale;
+          if (score > max_score) {
+            const float rescale = std::exp(max_score - score);
+            sum *= rescale;
+            for (float& a : acc) a *= rescale;
+            max_score = score;
+          }
+          const float weight = std::exp(score - max_score);
+          sum += weight;
+          for (int d = 0; d < head_dim; ++d) acc[d] += weight * value[d];
+        }
+      }
+      float* out = output_data + (q * num_heads + h) * head_dim;
+      for (int d = 0; d < head_dim; ++d) out[d] = acc[d] / sum;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace kv_cache_attention
+
+TfLiteRegistration* Register_KV_CACHE_ATTENTION() {
+  static TfLiteRegistration r = {
+      kv_cache_attention::Init, kv_cache_attention::Free,
+      kv_cache_attention::Prepare, kv_cache_attention::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
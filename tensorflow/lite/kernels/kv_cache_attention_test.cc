@@ -0,0 +1,181 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+
+#include <cmath>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/kv_cache.h"
+#include "tensorflow/lite/kernels/custom_ops_register.h"
+#include "tensorflow/lite/kernels/test_util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+constexpr int kHeadDim = 2;
+
+class KVCacheAttentionOpModel : public SingleOpModel {
+ public:
+  KVCacheAttentionOpModel(int num_queries, int num_heads, int num_kv_heads)
+      : num_kv_heads_(num_kv_heads) {
+    resource_id_ = AddInput({TensorType_INT32, {1}});
+    queries_ =
+        AddInput({TensorType_FLOAT32, {num_queries, num_heads * kHeadDim}});
+    length_ = AddInput({TensorType_INT32, {}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+
+    flexbuffers::Builder fbb;
+    size_t map_start = fbb.StartMap();
+    fbb.Int("num_heads", num_heads);
+    fbb.Int("num_kv_heads", num_kv_heads);
+    fbb.EndMap(map_start);
+    fbb.Finish();
+    SetCustomOp("KVCacheAttention", fbb.GetBuffer(),
+                ops::custom::Register_KV_CACHE_ATTENTION);
+    BuildInterpreter(
+        {GetShape(resource_id_), GetShape(queries_), GetShape(length_)});
+  }
+
+  // Appends tokens to cache 0 directly, as KV_CACHE_UPDATE would.
+  void Append(const std::vector<float>& keys,
+              const std::vector<float>& values) {
+    resource::KVCache::Config config;
+    config.token_size = num_kv_heads_ * kHeadDim;
+    config.max_sequence_length = 16;
+    config.page_size = 2;
+    auto& resources = interpreter_->primary_subgraph().resources();
+    ASSERT_EQ(kTfLiteOk, resource::CreateKVCacheIfNotAvailable(
+                             &resources, /*resource_id=*/0, config));
+    resource::KVCache* cache = resource::GetKVCache(&resources, 0);
+    ASSERT_EQ(kTfLiteOk,
+              cache->Append(keys.data(), values.data(),
+                            keys.size() / config.token_size));
+    length_value_ = cache->length();
+  }
+
+  TfLiteStatus Attend(const std::vector<float>& queries) {
+    return Attend(queries, length_value_);
+  }
+
+  TfLiteStatus Attend(const std::vector<float>& queries, int length) {
+    PopulateTensor<int32_t>(resource_id_, {0});
+    PopulateTensor<float>(queries_, queries);
+    PopulateTensor<int32_t>(length_, {length});
+    return Invoke();
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int num_kv_heads_;
+  int length_value_ = 0;
+  int resource_id_;
+  int queries_;
+  int length_;
+  int output_;
+};
+
+// Returns causal attention of `queries` over `keys` and `values`, computed
+// with one head.
+std::vector<float> Reference(const std::vector<float>& queries,
+                             const std::vector<float>& keys,
+                             const std::vector<float>& values) {
+  const int num_queries = queries.size() / kHeadDim;
+  const int length = keys.size() / kHeadDim;
+  std::vector<float> output;
+  for (int q = 0; q < num_queries; ++q) {
+    const int num_visible = length - num_queries + q + 1;
+    std::vector<float> weights;
+    float sum = 0;
+    for (int t = 0; t < num_visible; ++t) {
+      float score = 0;
+      for (int d = 0; d < kHeadDim; ++d) {
+        score += queries[q * kHeadDim + d] * keys[t * kHeadDim + d];
+      }
+      weights.push_back(std::exp(score / std::sqrt(float{kHeadDim})));
+      sum += weights.back();
+    }
+    for (int d = 0; d < kHeadDim; ++d) {
+      float out = 0;
+      for (int t = 0; t < num_visible; ++t) {
+        out += weights[t] / sum * values[t * kHeadDim + d];
+      }
+      output.push_back(out);
+    }
+  }
+  return output;
+}
+
+TEST(KVCacheAttentionOpTest, AttendsOverPages) {
+  KVCacheAttentionOpModel m(/*num_queries=*/2, /*num_heads=*/1,
+                            /*num_kv_heads=*/1);
+  // Five tokens span three pages.
+  const std::vector<float> keys = {1, 0, 0, 1, 1, 1, -1, 0, 0.5, -2};
+  const std::vector<float> values = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  m.Append(keys, values);
+  const std::vector<float> queries = {0.3, -1, 2, 0.5};
+  ASSERT_EQ(kTfLiteOk, m.Attend(queries));
+  EXPECT_THAT(m.GetOutput(),
+              Pointwise(FloatNear(1e-5), Reference(queries, keys, values)));
+}
+
+TEST(KVCacheAttentionOpTest, FirstQuerySeesFirstToken) {
+  KVCacheAttentionOpModel m(/*num_queries=*/3, /*num_heads=*/1,
+                            /*num_kv_heads=*/1);
+  m.Append({1, 0, 0, 1, 1, 1}, {1, 2, 3, 4, 5, 6});
+  ASSERT_EQ(kTfLiteOk, m.Attend({5, 5, 5, 5, 5, 5}));
+  const std::vector<float> output = m.GetOutput();
+  EXPECT_THAT(std::vector<float>(output.begin(), output.begin() + 2),
+              ElementsAreArray({1, 2}));
+}
+
+TEST(KVCacheAttentionOpTest, GroupedHeads) {
+  KVCacheAttentionOpModel m(/*num_queries=*/1, /*num_heads=*/2,
+                            /*num_kv_heads=*/1);
+  m.Append({1, 0, 0, 1, 1, 1}, {1, 2, 3, 4, 5, 6});
+  ASSERT_EQ(kTfLiteOk, m.Attend({0.3, -1, 2, 0.5}));
+  // Both query heads read the single key/value head.
+  const std::vector<float> keys = {1, 0, 0, 1, 1, 1};
+  const std::vector<float> values = {1, 2, 3, 4, 5, 6};
+  std::vector<float> expected = Reference({0.3, -1}, keys, values);
+  const std::vector<float> second = Reference({2, 0.5}, keys, values);
+  expected.insert(expected.end(), second.begin(), second.end());
+  EXPECT_THAT(m.GetOutput(), Pointwise(FloatNear(1e-5), expected));
+}
+
+TEST(KVCacheAttentionOpTest, FailsWithoutCache) {
+  KVCacheAttentionOpModel m(/*num_queries=*/1, /*num_heads=*/1,
+                            /*num_kv_heads=*/1);
+  EXPECT_EQ(kTfLiteError, m.Attend({1, 1}, /*length=*/1));
+}
+
+TEST(KVCacheAttentionOpTest, FailsOnStaleLength) {
+  KVCacheAttentionOpModel m(/*num_queries=*/1, /*num_heads=*/1,
+                            /*num_kv_heads=*/1);
+  m.Append({1, 0, 0, 1}, {1, 2, 3, 4});
+  EXPECT_EQ(kTfLiteError, m.Attend({1, 1}, /*length=*/1));
+  EXPECT_EQ(kTfLiteOk, m.Attend({1, 1}, /*length=*/2));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,154 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cstddef>
+#include <cstdint>
+
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/kv_cache.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace kv_cache_update {
+
+// Appends the keys and values of new tokens to the KV cache resource
+// identified by input 0, creating the cache on first use, and returns the
+// number of tokens in the cache. The cached tokens are not copied out;
+// attention reads them in place, see kv_cache_attention.cc.
+//
+// Inputs: resource id, keys and values. Keys and values have the same type
+// and shape [num_tokens, ...]; the trailing dimensions are one token.
+// Outputs: int32 scalar, the length of the cache after appending.
+// Custom options: "max_sequence_length" (required) and "page_size".
+constexpr int kInputResourceId = 0;
+constexpr int kInputKeys = 1;
+constexpr int kInputValues = 2;
+constexpr int kOutputLength = 0;
+
+constexpr const char kMaxSequenceLengthStr[] = "max_sequence_length";
+constexpr const char kPageSizeStr[] = "page_size";
+
+struct OpData {
+  int max_sequence_length = 0;
+  int page_size = 16;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  OpData* op_data = new OpData;
+  if (buffer == nullptr || length == 0) return op_data;
+  const flexbuffers::Map& m =
+      flexbuffers::GetRoot(reinterpret_cast<const uint8_t*>(buffer), length)
+          .AsMap();
+  op_data->max_sequence_length = m[kMaxSequenceLengthStr].AsInt32();
+  if (!m[kPageSizeStr].IsNull()) {
+    op_data->page_size = m[kPageSizeStr].AsInt32();
+  }
+  return op_data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 3);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE(context, op_data->max_sequence_length > 0);
+  TF_LITE_ENSURE(context, op_data->page_size > 0);
+
+  const TfLiteTensor* resource_id;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputResourceId,
+                                          &resource_id));
+  TF_LITE_ENSURE(context, (resource_id->type == kTfLiteResource ||
+                           resource_id->type == kTfLiteInt32));
+  TF_LITE_ENSURE_EQ(context, NumElements(resource_id), 1);
+
+  const TfLiteTensor* keys;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputKeys, &keys));
+  const TfLiteTensor* values;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputValues, &values));
+  TF_LITE_ENSURE_TYPES_EQ(context, keys->type, values->type);
+  TF_LITE_ENSURE(context, NumDimensions(keys) >= 2);
+  TF_LITE_ENSURE(context, HaveSameShapes(keys, values));
+
+  TfLiteTensor* length;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputLength, &length));
+  TF_LITE_ENSURE_TYPES_EQ(context, length->type, kTfLiteInt32);
+  return context->ResizeTensor(context, length, TfLiteIntArrayCreate(0));
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* resource_id;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputResourceId,
+                                          &resource_id));
+  const TfLiteTensor* keys;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputKeys, &keys));
+  const TfLiteTensor* values;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputValues, &values));
+  TfLiteTensor* length;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputLength, &length));
+
+  resource::KVCache::Config config;
+  config.type = keys->type;
+  config.token_size = 1;
+  for (int i = 1; i < NumDimensions(keys); ++i) {
+    config.token_size *= SizeOfDimension(keys, i);
+  }
+  config.max_sequence_length = op_data->max_sequence_length;
+  config.page_size = op_data->page_size;
+
+  Subgraph* subgraph = reinterpret_cast<Subgraph*>(context->impl_);
+  auto& resources = subgraph->resources();
+  const int id = resource_id->data.i32[0];
+  TF_LITE_ENSURE_OK(context, resource::CreateKVCacheIfNotAvailable(
+                                 &resources, id, config));
+  resource::KVCache* cache = resource::GetKVCache(&resources, id);
+  TF_LITE_ENSURE(context, cache != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, cache->config().type, config.type);
+  TF_LITE_ENSURE_EQ(context, cache->config().token_size, config.token_size);
+
+  if (cache->Append(keys, values) != kTfLiteOk) {
+    TF_LITE_KERNEL_LOG(context,
+                       "KV cache %d can't hold %d more tokens (%d of %d used).",
+                       id, SizeOfDimension(keys, 0), cache->length(),
+                       cache->config().max_sequence_length);
+    return kTfLiteError;
+  }
+
+  length->data.i32[0] = cache->length();
+  return kTfLiteOk;
+}
+
+}  // namespace kv_cache_update
+
+TfLiteRegistration* Register_KV_CACHE_UPDATE() {
+  static TfLiteRegistration r = {kv_cache_update::Init, kv_cache_update::Free,
+                                 kv_cache_update::Prepare,
+                                 kv_cache_update::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
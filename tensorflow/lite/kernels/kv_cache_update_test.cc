@@ -0,0 +1,133 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/kv_cache.h"
+#include "tensorflow/lite/kernels/custom_ops_register.h"
+#include "tensorflow/lite/kernels/test_util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+constexpr int kTokenSize = 2;
+
+class KVCacheUpdateOpModel : public SingleOpModel {
+ public:
+  KVCacheUpdateOpModel(int max_sequence_length, int page_size) {
+    resource_id_ = AddInput({TensorType_INT32, {1}});
+    keys_ = AddInput({TensorType_FLOAT32, {1, kTokenSize}});
+    values_ = AddInput({TensorType_FLOAT32, {1, kTokenSize}});
+    length_ = AddOutput({TensorType_INT32, {}});
+
+    flexbuffers::Builder fbb;
+    size_t map_start = fbb.StartMap();
+    fbb.Int("max_sequence_length", max_sequence_length);
+    fbb.Int("page_size", page_size);
+    fbb.EndMap(map_start);
+    fbb.Finish();
+    SetCustomOp("KVCacheUpdate", fbb.GetBuffer(),
+                ops::custom::Register_KV_CACHE_UPDATE);
+    BuildInterpreter({GetShape(resource_id_), GetShape(keys_),
+                      GetShape(values_)});
+  }
+
+  // Appends tokens [first, first + count), where the key of token t is
+  // {t, t} and its value is {-t, -t}.
+  TfLiteStatus Append(int first, int count) {
+    std::vector<float> keys, values;
+    for (int t = first; t < first + count; ++t) {
+      for (int i = 0; i < kTokenSize; ++i) {
+        keys.push_back(t);
+        values.push_back(-t);
+      }
+    }
+    interpreter_->ResizeInputTensor(keys_, {count, kTokenSize});
+    interpreter_->ResizeInputTensor(values_, {count, kTokenSize});
+    EXPECT_EQ(kTfLiteOk, interpreter_->AllocateTensors());
+    PopulateTensor<int32_t>(resource_id_, {0});
+    PopulateTensor<float>(keys_, keys);
+    PopulateTensor<float>(values_, values);
+    return Invoke();
+  }
+
+  int GetLength() { return ExtractVector<int32_t>(length_)[0]; }
+
+  // Returns the keys or values of all cached tokens, read from the pages.
+  std::vector<float> GetCached(bool keys) {
+    resource::KVCache* cache = resource::GetKVCache(
+        &interpreter_->primary_subgraph().resources(), /*resource_id=*/0);
+    std::vector<float> cached;
+    if (cache == nullptr) return cached;
+    for (int p = 0; p < cache->num_pages(); ++p) {
+      const resource::KVCache::PageView page = cache->GetPage(p);
+      const float* data =
+          static_cast<const float*>(keys ? page.keys : page.values);
+      cached.insert(cached.end(), data, data + page.num_tokens * kTokenSize);
+    }
+    return cached;
+  }
+
+ private:
+  int resource_id_;
+  int keys_;
+  int values_;
+  int length_;
+};
+
+TEST(KVCacheUpdateOpTest, AppendsAcrossInvocations) {
+  KVCacheUpdateOpModel m(/*max_sequence_length=*/8, /*page_size=*/2);
+  ASSERT_EQ(kTfLiteOk, m.Append(0, 3));
+  EXPECT_EQ(3, m.GetLength());
+  EXPECT_THAT(m.GetCached(/*keys=*/true), ElementsAreArray({0, 0, 1, 1, 2, 2}));
+
+  ASSERT_EQ(kTfLiteOk, m.Append(3, 2));
+  EXPECT_EQ(5, m.GetLength());
+  EXPECT_THAT(m.GetCached(/*keys=*/true),
+              ElementsAreArray({0, 0, 1, 1, 2, 2, 3, 3, 4, 4}));
+  EXPECT_THAT(m.GetCached(/*keys=*/false),
+              ElementsAreArray({0, 0, -1, -1, -2, -2, -3, -3, -4, -4}));
+}
+
+TEST(KVCacheUpdateOpTest, EmptyAppend) {
+  KVCacheUpdateOpModel m(/*max_sequence_length=*/8, /*page_size=*/4);
+  ASSERT_EQ(kTfLiteOk, m.Append(0, 0));
+  EXPECT_EQ(0, m.GetLength());
+  ASSERT_EQ(kTfLiteOk, m.Append(7, 1));
+  ASSERT_EQ(kTfLiteOk, m.Append(0, 0));
+  EXPECT_EQ(1, m.GetLength());
+  EXPECT_THAT(m.GetCached(/*keys=*/true), ElementsAreArray({7, 7}));
+}
+
+TEST(KVCacheUpdateOpTest, FailsWhenFull) {
+  KVCacheUpdateOpModel m(/*max_sequence_length=*/4, /*page_size=*/4);
+  ASSERT_EQ(kTfLiteOk, m.Append(0, 3));
+  EXPECT_EQ(kTfLiteError, m.Append(3, 2));
+  // The failed append leaves the cache untouched.
+  ASSERT_EQ(kTfLiteOk, m.Append(3, 1));
+  EXPECT_EQ(4, m.GetLength());
+  EXPECT_THAT(m.GetCached(/*keys=*/true),
+              ElementsAreArray({0, 0, 1, 1, 2, 2, 3, 3}));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,303 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/hardware_counter_profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/profiling/profile_buffer.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using hardware_counters::CounterType;
+using hardware_counters::CounterValues;
+using hardware_counters::kNumCounterTypes;
+
+std::string JsonEscape(const std::string& s) {
+  std::string escaped;
+  escaped.reserve(s.size());
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += ' ';
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Misses per thousand instructions, or -1 if either side is unknown.
+double PerKiloInstructions(double count, double instructions) {
+  if (count < 0 || instructions <= 0) return -1;
+  return count * 1000.0 / instructions;
+}
+
+std::vector<const tensorflow::StatsCalculator::Detail*> DetailsInRunOrder(
+    const tensorflow::StatsCalculator& calculator) {
+  std::vector<const tensorflow::StatsCalculator::Detail*> details;
+  details.reserve(calculator.GetDetails().size());
+  for (const auto& it : calculator.GetDetails()) details.push_back(&it.second);
+  std::sort(details.begin(), details.end(),
+            [](const auto* a, const auto* b) {
+              return a->run_order < b->run_order;
+            });
+  return details;
+}
+
+}  // namespace
+
+std::unique_ptr<HardwareCounterProfiler> HardwareCounterProfiler::Create() {
+  auto reader = hardware_counters::CounterReader::Create();
+  if (reader == nullptr) return nullptr;
+  return std::make_unique<HardwareCounterProfiler>(std::move(reader));
+}
+
+HardwareCounterProfiler::HardwareCounterProfiler(
+    std::unique_ptr<hardware_counters::CounterReader> reader)
+    : reader_(std::move(reader)) {}
+
+bool HardwareCounterProfiler::ShouldAddEvent(EventType event_type) {
+  return event_type == EventType::OPERATOR_INVOKE_EVENT ||
+         event_type == EventType::DELEGATE_OPERATOR_INVOKE_EVENT ||
+         event_type == EventType::DELEGATE_PROFILED_OPERATOR_INVOKE_EVENT;
+}
+
+uint32_t HardwareCounterProfiler::BeginEvent(const char* tag,
+                                             EventType event_type,
+                                             int64_t event_metadata1,
+                                             int64_t event_metadata2) {
+  if (!enabled_ || !ShouldAddEvent(event_type)) return kInvalidEventHandle;
+  const uint32_t handle = static_cast<uint32_t>(events_.size());
+  events_.push_back({tag, event_type, event_metadata1, event_metadata2,
+                     CounterValues(), /*completed=*/false});
+  // Sample last so that the bookkeeping above isn't attributed to the op.
+  if (!reader_->Read(&events_.back().counters)) {
+    events_.pop_back();
+    return kInvalidEventHandle;
+  }
+  return handle;
+}
+
+void HardwareCounterProfiler::EndEvent(uint32_t event_handle) {
+  // Sample first so that the bookkeeping below isn't attributed to the op.
+  CounterValues end;
+  const bool read_ok = reader_->Read(&end);
+  if (event_handle >= events_.size()) return;
+  Event& event = events_[event_handle];
+  if (!read_ok || event.completed) return;
+  event.counters = end - event.counters;
+  event.completed = true;
+}
+
+void HardwareCounterProfiler::EndEvent(uint32_t event_handle,
+                                       int64_t event_metadata1,
+                                       int64_t event_metadata2) {
+  EndEvent(event_handle);
+  if (event_handle >= events_.size()) return;
+  events_[event_handle].event_metadata = event_metadata1;
+  events_[event_handle].extra_event_metadata = event_metadata2;
+}
+
+HardwareCounterSummarizer::HardwareCounterSummarizer() {
+  tensorflow::StatSummarizerOptions options;
+  options.show_memory = false;
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    calculators_[i] = std::make_unique<tensorflow::StatsCalculator>(options);
+  }
+  available_.fill(false);
+}
+
+void HardwareCounterSummarizer::ProcessProfiles(
+    const std::vector<HardwareCounterProfiler::Event>& events,
+    const tflite::Interpreter& interpreter) {
+  if (events.empty()) return;
+
+  std::array<int64_t, kNumCounterTypes> run_totals;
+  run_totals.fill(0);
+  int node_num = 0;
+  for (const auto& event : events) {
+    if (!event.completed) continue;
+    std::string node_name;
+    std::string type(event.tag);
+    if (event.event_type == Profiler::EventType::OPERATOR_INVOKE_EVENT) {
+      // event_metadata is the node index and extra_event_metadata is the
+      // subgraph index, see TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE.
+      const int subgraph_index = static_cast<int>(event.extra_event_metadata);
+      const int node_index = static_cast<int>(event.event_metadata);
+      auto* subgraph = const_cast<tflite::Interpreter&>(interpreter)
+                           .subgraph(subgraph_index);
+      if (subgraph != nullptr && node_index >= 0 &&
+          node_index < static_cast<int>(subgraph->nodes_size())) {
+        const auto* node_reg = subgraph->node_and_registration(node_index);
+        const char* profiling_string =
+            interpreter.OpProfilingString(node_reg->second, &node_reg->first);
+        if (profiling_string != nullptr) {
+          type += "/" + std::string(profiling_string);
+        }
+      }
+      node_name = std::to_string(subgraph_index) + ":" +
+                  std::to_string(node_index);
+    } else {
+      node_name = "Delegate/" + type + ":" +
+                  std::to_string(event.event_metadata);
+    }
+
+    for (int i = 0; i < kNumCounterTypes; ++i) {
+      if (!event.counters.IsSet(static_cast<CounterType>(i))) continue;
+      available_[i] = true;
+      calculators_[i]->AddNodeStats(node_name, type, node_num,
+                                    event.counters.values[i], 0 /*memory*/);
+      // Delegate-internal ops are already accounted for by the DELEGATE op.
+      if (event.event_type !=
+          Profiler::EventType::DELEGATE_OPERATOR_INVOKE_EVENT) {
+        run_totals[i] += event.counters.values[i];
+      }
+    }
+    ++node_num;
+  }
+
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    if (available_[i]) calculators_[i]->UpdateRunTotalUs(run_totals[i]);
+  }
+}
+
+std::string HardwareCounterSummarizer::GetOutputString() const {
+  const auto details =
+      DetailsInRunOrder(*calculators_[hardware_counters::kCycles]);
+
+  auto avg_of = [this](CounterType type, const std::string& name) -> double {
+    if (!available_[type]) return -1;
+    const auto& type_details = calculators_[type]->GetDetails();
+    auto it = type_details.find(name);
+    return it == type_details.end() ? -1 : it->second.elapsed_time.avg();
+  };
+
+  std::stringstream stream;
+  stream << "============================== Hardware counters per node "
+            "(avg over "
+         << calculators_[hardware_counters::kCycles]->num_runs()
+         << " runs) ==============================" << std::endl;
+  stream << std::setw(40) << std::left << "[node type]" << std::right;
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    stream << "\t" << std::setw(14)
+           << hardware_counters::CounterTypeName(static_cast<CounterType>(i));
+  }
+  stream << "\t" << std::setw(6) << "IPC"
+         << "\t" << std::setw(10) << "L1D MPKI"
+         << "\t" << std::setw(10) << "LLC MPKI"
+         << "\t" << std::setw(10) << "BR MPKI"
+         << "\t[name]" << std::endl;
+
+  stream << std::fixed << std::setprecision(2);
+  for (const auto* detail : details) {
+    std::array<double, kNumCounterTypes> avgs;
+    stream << std::setw(40) << std::left << detail->type << std::right;
+    for (int i = 0; i < kNumCounterTypes; ++i) {
+      avgs[i] = avg_of(static_cast<CounterType>(i), detail->name);
+      stream << "\t" << std::setw(14);
+      if (avgs[i] < 0) {
+        stream << "n/a";
+      } else {
+        stream << static_cast<int64_t>(avgs[i]);
+      }
+    }
+    const double instructions = avgs[hardware_counters::kInstructions];
+    const double ipc = (avgs[hardware_counters::kCycles] > 0 &&
+                        instructions >= 0)
+                           ? instructions / avgs[hardware_counters::kCycles]
+                           : -1;
+    const std::pair<double, int> derived[] = {
+        {ipc, 6},
+        {PerKiloInstructions(avgs[hardware_counters::kL1DataCacheMisses],
+                             instructions),
+         10},
+        {PerKiloInstructions(avgs[hardware_counters::kLastLevelCacheMisses],
+                             instructions),
+         10},
+        {PerKiloInstructions(avgs[hardware_counters::kBranchMisses],
+                             instructions),
+         10},
+    };
+    for (const auto& [value, width] : derived) {
+      stream << "\t" << std::setw(width);
+      if (value < 0) {
+        stream << "n/a";
+      } else {
+        stream << value;
+      }
+    }
+    stream << "\t" << detail->name << std::endl;
+  }
+  return stream.str();
+}
+
+std::string HardwareCounterSummarizer::GetJsonString() const {
+  std::stringstream stream;
+  stream << "{\"num_runs\":"
+         << calculators_[hardware_counters::kCycles]->num_runs()
+         << ",\"run_totals\":{";
+  bool first = true;
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    if (!available_[i]) continue;
+    if (!first) stream << ",";
+    first = false;
+    stream << "\"" << hardware_counters::CounterTypeName(
+                          static_cast<CounterType>(i))
+           << "\":" << calculators_[i]->run_total_us().avg();
+  }
+  stream << "},\"nodes\":[";
+
+  const auto details =
+      DetailsInRunOrder(*calculators_[hardware_counters::kCycles]);
+
+  first = true;
+  for (const auto* detail : details) {
+    if (!first) stream << ",";
+    first = false;
+    stream << "{\"name\":\"" << JsonEscape(detail->name) << "\",\"type\":\""
+           << JsonEscape(detail->type)
+           << "\",\"run_order\":" << detail->run_order
+           << ",\"times_called\":" << detail->times_called;
+    for (int i = 0; i < kNumCounterTypes; ++i) {
+      if (!available_[i]) continue;
+      const auto& type_details = calculators_[i]->GetDetails();
+      auto it = type_details.find(detail->name);
+      if (it == type_details.end()) continue;
+      const auto& stat = it->second.elapsed_time;
+      stream << ",\""
+             << hardware_counters::CounterTypeName(static_cast<CounterType>(i))
+             << "\":{\"avg\":" << stat.avg() << ",\"min\":" << stat.min()
+             << ",\"max\":" << stat.max()
+             << ",\"std\":" << stat.std_deviation() << "}";
+    }
+    stream << "}";
+  }
+  stream << "]}";
+  return stream.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,124 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTER_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTER_PROFILER_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/util/stats_calculator.h"
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/profiling/hardware_counters.h"
+
+namespace tflite {
+namespace profiling {
+
+// A profiler that samples hardware performance counters (cycles, instructions,
+// cache and branch misses) around every operator and delegate invocation.
+//
+// It is meant to be installed next to a BufferedProfiler through
+// Interpreter::AddProfiler() so that the time-based and counter-based reports
+// describe the same runs. Like BufferedProfiler, it must only be used from the
+// thread that invokes the interpreter.
+class HardwareCounterProfiler : public tflite::Profiler {
+ public:
+  struct Event {
+    const char* tag;
+    EventType event_type;
+    int64_t event_metadata;
+    int64_t extra_event_metadata;
+    // Counter values at BeginEvent; replaced by the delta at EndEvent.
+    hardware_counters::CounterValues counters;
+    bool completed;
+  };
+
+  // Returns nullptr if hardware counters can't be read on this machine.
+  static std::unique_ptr<HardwareCounterProfiler> Create();
+
+  explicit HardwareCounterProfiler(
+      std::unique_ptr<hardware_counters::CounterReader> reader);
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+
+  void EndEvent(uint32_t event_handle) override;
+
+  void EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+  void StartProfiling() { enabled_ = true; }
+  void StopProfiling() { enabled_ = false; }
+  void Reset() {
+    enabled_ = false;
+    events_.clear();
+  }
+
+  const std::vector<Event>& events() const { return events_; }
+
+  const hardware_counters::CounterReader& reader() const { return *reader_; }
+
+ private:
+  static bool ShouldAddEvent(EventType event_type);
+
+  bool enabled_ = false;
+  std::unique_ptr<hardware_counters::CounterReader> reader_;
+  std::vector<Event> events_;
+};
+
+// Aggregates the events of HardwareCounterProfiler across runs. There is one
+// tensorflow::StatsCalculator per counter type, keyed by the same node names
+// so that every node gets min/max/avg/std for each counter.
+class HardwareCounterSummarizer {
+ public:
+  HardwareCounterSummarizer();
+
+  // Process counter events of one run.
+  void ProcessProfiles(
+      const std::vector<HardwareCounterProfiler::Event>& events,
+      const tflite::Interpreter& interpreter);
+
+  bool HasProfiles() const {
+    return calculators_[hardware_counters::kCycles]->num_runs() >= 1;
+  }
+
+  // Returns a table with the average of each counter per node in run order,
+  // including derived IPC and misses per thousand instructions.
+  std::string GetOutputString() const;
+
+  // Returns the same statistics as a JSON document.
+  std::string GetJsonString() const;
+
+  const tensorflow::StatsCalculator& GetStatsCalculator(
+      hardware_counters::CounterType type) const {
+    return *calculators_[type];
+  }
+
+ private:
+  std::array<std::unique_ptr<tensorflow::StatsCalculator>,
+             hardware_counters::kNumCounterTypes>
+      calculators_;
+  // Whether each counter was available on the machine the events came from.
+  std::array<bool, hardware_counters::kNumCounterTypes> available_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTER_PROFILER_H_
@@ -0,0 +1,132 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/hardware_counter_profiler.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/profiling/hardware_counters.h"
+#include "tensorflow/lite/profiling/profile_buffer.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using hardware_counters::kCycles;
+using hardware_counters::kInstructions;
+using EventType = Profiler::EventType;
+
+HardwareCounterProfiler::Event MakeEvent(const char* tag, EventType type,
+                                         int64_t metadata,
+                                         int64_t extra_metadata,
+                                         int64_t cycles,
+                                         int64_t instructions) {
+  HardwareCounterProfiler::Event event{tag,
+                                       type,
+                                       metadata,
+                                       extra_metadata,
+                                       hardware_counters::CounterValues(),
+                                       /*completed=*/true};
+  event.counters.values[kCycles] = cycles;
+  event.counters.values[kInstructions] = instructions;
+  return event;
+}
+
+TEST(HardwareCounterSummarizer, JsonFromSyntheticEvents) {
+  // The interpreter has no nodes, so operators are named by index only.
+  Interpreter interpreter;
+  HardwareCounterSummarizer summarizer;
+  EXPECT_FALSE(summarizer.HasProfiles());
+
+  for (int64_t cycles : {100, 300}) {
+    std::vector<HardwareCounterProfiler::Event> events = {
+        MakeEvent("ADD", EventType::OPERATOR_INVOKE_EVENT, /*metadata=*/0,
+                  /*extra_metadata=*/0, cycles, 2 * cycles),
+        // Delegate-internal ops are reported but not added to the run totals.
+        MakeEvent("CONV", EventType::DELEGATE_OPERATOR_INVOKE_EVENT,
+                  /*metadata=*/1, /*extra_metadata=*/0, 50, 40),
+        MakeEvent("MUL", EventType::OPERATOR_INVOKE_EVENT, /*metadata=*/2,
+                  /*extra_metadata=*/0, 1000, 1000),
+    };
+    // Events that didn't end are skipped.
+    events.back().completed = false;
+    summarizer.ProcessProfiles(events, interpreter);
+  }
+
+  ASSERT_TRUE(summarizer.HasProfiles());
+  EXPECT_EQ(2, summarizer.GetStatsCalculator(kCycles).num_runs());
+  EXPECT_EQ(
+      "{\"num_runs\":2,"
+      "\"run_totals\":{\"cycles\":200,\"instructions\":400},"
+      "\"nodes\":["
+      "{\"name\":\"0:0\",\"type\":\"ADD\",\"run_order\":0,"
+      "\"times_called\":2,"
+      "\"cycles\":{\"avg\":200,\"min\":100,\"max\":300,\"std\":100},"
+      "\"instructions\":{\"avg\":400,\"min\":200,\"max\":600,\"std\":200}},"
+      "{\"name\":\"Delegate/CONV:1\",\"type\":\"CONV\",\"run_order\":1,"
+      "\"times_called\":2,"
+      "\"cycles\":{\"avg\":50,\"min\":50,\"max\":50,\"std\":0},"
+      "\"instructions\":{\"avg\":40,\"min\":40,\"max\":40,\"std\":0}}]}",
+      summarizer.GetJsonString());
+}
+
+TEST(HardwareCounterSummarizer, NoEvents) {
+  Interpreter interpreter;
+  HardwareCounterSummarizer summarizer;
+  summarizer.ProcessProfiles({}, interpreter);
+  EXPECT_FALSE(summarizer.HasProfiles());
+  EXPECT_EQ("{\"num_runs\":0,\"run_totals\":{},\"nodes\":[]}",
+            summarizer.GetJsonString());
+}
+
+TEST(HardwareCounterProfiler, RecordsOperatorEvents) {
+  auto profiler = HardwareCounterProfiler::Create();
+  if (profiler == nullptr) {
+    GTEST_SKIP() << "Hardware counters are not available.";
+  }
+  // Events are only recorded while profiling.
+  profiler->EndEvent(profiler->BeginEvent(
+      "ADD", EventType::OPERATOR_INVOKE_EVENT, 0, 0));
+  EXPECT_TRUE(profiler->events().empty());
+
+  profiler->StartProfiling();
+  const uint32_t op = profiler->BeginEvent(
+      "ADD", EventType::OPERATOR_INVOKE_EVENT, /*event_metadata1=*/3,
+      /*event_metadata2=*/0);
+  // Other event types are ignored.
+  EXPECT_EQ(kInvalidEventHandle,
+            profiler->BeginEvent("Invoke", EventType::DEFAULT, 0, 0));
+  volatile int64_t sum = 0;
+  for (int i = 0; i < 100000; ++i) sum += i;
+  profiler->EndEvent(op);
+  profiler->StopProfiling();
+
+  ASSERT_EQ(1, profiler->events().size());
+  const auto& event = profiler->events()[0];
+  EXPECT_TRUE(event.completed);
+  EXPECT_EQ(3, event.event_metadata);
+  ASSERT_TRUE(event.counters.IsSet(kCycles));
+  EXPECT_GT(event.counters.values[kCycles], 0);
+
+  profiler->Reset();
+  EXPECT_TRUE(profiler->events().empty());
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
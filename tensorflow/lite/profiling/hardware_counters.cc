@@ -0,0 +1,155 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/hardware_counters.h"
+
+#include <cstdint>
+#include <memory>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif  // __linux__
+
+namespace tflite {
+namespace profiling {
+namespace hardware_counters {
+namespace {
+
+#ifdef __linux__
+struct CounterConfig {
+  uint32_t type;
+  uint64_t config;
+};
+
+// Indexed by CounterType.
+constexpr CounterConfig kCounterConfigs[kNumCounterTypes] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int OpenCounter(CounterType counter, int group_fd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = kCounterConfigs[counter].type;
+  attr.config = kCounterConfigs[counter].config;
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // pid == 0 and cpu == -1: the calling thread on any CPU.
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, /*pid=*/0,
+                                  /*cpu=*/-1, group_fd, /*flags=*/0));
+}
+#endif  // __linux__
+
+}  // namespace
+
+const char* CounterTypeName(CounterType type) {
+  switch (type) {
+    case kCycles:
+      return "cycles";
+    case kInstructions:
+      return "instructions";
+    case kL1DataCacheMisses:
+      return "l1d_misses";
+    case kLastLevelCacheMisses:
+      return "llc_misses";
+    case kBranchMisses:
+      return "branch_misses";
+    default:
+      return "unknown";
+  }
+}
+
+CounterReader::CounterReader() {
+  fds_.fill(-1);
+  group_index_.fill(-1);
+}
+
+CounterReader::~CounterReader() {
+#ifdef __linux__
+  // Close members before the group leader.
+  for (int i = kNumCounterTypes - 1; i >= 0; --i) {
+    if (fds_[i] >= 0) close(fds_[i]);
+  }
+#endif  // __linux__
+}
+
+std::unique_ptr<CounterReader> CounterReader::Create() {
+#ifdef __linux__
+  std::unique_ptr<CounterReader> reader(new CounterReader());
+  // Cycles lead the group; without it there is no point in reading the rest.
+  int leader = OpenCounter(kCycles, /*group_fd=*/-1);
+  if (leader < 0) return nullptr;
+  reader->fds_[kCycles] = leader;
+  reader->group_index_[kCycles] = reader->num_opened_++;
+  for (int i = kCycles + 1; i < kNumCounterTypes; ++i) {
+    const int fd = OpenCounter(static_cast<CounterType>(i), leader);
+    // Individual events may be missing on some PMUs; keep the others.
+    if (fd < 0) continue;
+    reader->fds_[i] = fd;
+    reader->group_index_[i] = reader->num_opened_++;
+  }
+  if (ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0 ||
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) {
+    return nullptr;
+  }
+  return reader;
+#else
+  return nullptr;
+#endif  // __linux__
+}
+
+bool CounterReader::Read(CounterValues* values) const {
+#ifdef __linux__
+  // Layout for PERF_FORMAT_GROUP with both time fields:
+  //   { nr, time_enabled, time_running, value[nr] }
+  uint64_t buffer[3 + kNumCounterTypes];
+  const ssize_t expected = sizeof(uint64_t) * (3 + num_opened_);
+  if (read(fds_[kCycles], buffer, sizeof(buffer)) != expected) return false;
+  const uint64_t time_enabled = buffer[1];
+  const uint64_t time_running = buffer[2];
+  if (time_running == 0) return false;
+  const double scale = static_cast<double>(time_enabled) / time_running;
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    if (group_index_[i] < 0) {
+      values->values[i] = CounterValues::kValueNotSet;
+      continue;
+    }
+    const uint64_t raw = buffer[3 + group_index_[i]];
+    values->values[i] = time_enabled == time_running
+                            ? static_cast<int64_t>(raw)
+                            : static_cast<int64_t>(raw * scale);
+  }
+  return true;
+#else
+  return false;
+#endif  // __linux__
+}
+
+}  // namespace hardware_counters
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,106 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTERS_H_
+#define TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTERS_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace tflite {
+namespace profiling {
+namespace hardware_counters {
+
+// The hardware events sampled around each profiled op.
+enum CounterType {
+  kCycles = 0,
+  kInstructions,
+  kL1DataCacheMisses,
+  kLastLevelCacheMisses,
+  kBranchMisses,
+  kNumCounterTypes,
+};
+
+// Returns a short, stable name for `type` (e.g. "cycles"). These names are
+// used as column headers and as JSON keys.
+const char* CounterTypeName(CounterType type);
+
+// A snapshot of all counters. Counters that could not be opened on the current
+// machine hold kValueNotSet.
+struct CounterValues {
+  static constexpr int64_t kValueNotSet = -1;
+
+  CounterValues() { values.fill(kValueNotSet); }
+
+  bool IsSet(CounterType type) const { return values[type] != kValueNotSet; }
+
+  // Returns the per-counter difference; a counter that is unset on either side
+  // is unset in the result.
+  CounterValues operator-(const CounterValues& other) const {
+    CounterValues res;
+    for (int i = 0; i < kNumCounterTypes; ++i) {
+      if (values[i] != kValueNotSet && other.values[i] != kValueNotSet) {
+        res.values[i] = values[i] - other.values[i];
+      }
+    }
+    return res;
+  }
+
+  std::array<int64_t, kNumCounterTypes> values;
+};
+
+// Reads hardware performance counters of the calling thread through the Linux
+// perf_event interface. All counters are opened as a single group so that they
+// are scheduled on the PMU together and can be read with one syscall.
+//
+// Only user-space events of the thread that created the reader are counted;
+// work that an op hands off to a thread pool is not attributed to it. Run the
+// benchmark with a single thread for exact per-op attribution.
+//
+// This class is *not thread safe*.
+class CounterReader {
+ public:
+  // Returns nullptr if hardware counters are not available, e.g. on non-Linux
+  // platforms, under virtualization without a virtual PMU, or when restricted
+  // by /proc/sys/kernel/perf_event_paranoid.
+  static std::unique_ptr<CounterReader> Create();
+
+  ~CounterReader();
+
+  CounterReader(const CounterReader&) = delete;
+  CounterReader& operator=(const CounterReader&) = delete;
+
+  // Returns true if `type` could be opened on this machine.
+  bool IsAvailable(CounterType type) const { return fds_[type] >= 0; }
+
+  // Reads the current (monotonically increasing) value of all counters. If the
+  // kernel had to multiplex the group, values are scaled by the ratio of
+  // enabled to running time.
+  bool Read(CounterValues* values) const;
+
+ private:
+  CounterReader();
+
+  std::array<int, kNumCounterTypes> fds_;
+  // Position of each opened counter in the group read buffer.
+  std::array<int, kNumCounterTypes> group_index_;
+  int num_opened_ = 0;
+};
+
+}  // namespace hardware_counters
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_HARDWARE_COUNTERS_H_
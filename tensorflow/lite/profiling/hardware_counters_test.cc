@@ -0,0 +1,71 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/hardware_counters.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace profiling {
+namespace hardware_counters {
+namespace {
+
+TEST(CounterValues, Sub) {
+  CounterValues begin, end;
+  begin.values[kCycles] = 100;
+  end.values[kCycles] = 350;
+  begin.values[kInstructions] = 10;
+  // end.values[kInstructions] is left unset.
+
+  const auto delta = end - begin;
+  EXPECT_TRUE(delta.IsSet(kCycles));
+  EXPECT_EQ(250, delta.values[kCycles]);
+  EXPECT_FALSE(delta.IsSet(kInstructions));
+  EXPECT_FALSE(delta.IsSet(kBranchMisses));
+}
+
+TEST(CounterTypeName, AllNamed) {
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    EXPECT_STRNE("unknown", CounterTypeName(static_cast<CounterType>(i)));
+  }
+}
+
+TEST(CounterReader, ReadIsMonotonic) {
+  auto reader = CounterReader::Create();
+  if (reader == nullptr) {
+    GTEST_SKIP() << "Hardware counters are not available.";
+  }
+  EXPECT_TRUE(reader->IsAvailable(kCycles));
+
+  CounterValues begin, end;
+  ASSERT_TRUE(reader->Read(&begin));
+  volatile int64_t sum = 0;
+  for (int i = 0; i < 100000; ++i) sum += i;
+  ASSERT_TRUE(reader->Read(&end));
+
+  const auto delta = end - begin;
+  for (int i = 0; i < kNumCounterTypes; ++i) {
+    const auto type = static_cast<CounterType>(i);
+    EXPECT_EQ(reader->IsAvailable(type), delta.IsSet(type));
+    if (delta.IsSet(type)) EXPECT_GE(delta.values[i], 0);
+  }
+  EXPECT_GT(delta.values[kCycles], 0);
+}
+
+}  // namespace
+}  // namespace hardware_counters
+}  // namespace profiling
+}  // namespace tflite
@@ -48,6 +48,7 @@ limitations under the License.
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
+#include "tensorflow/lite/tools/benchmark/hardware_counter_listener.h"
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
 #include "tensorflow/lite/tools/delegates/delegate_provider.h"
 #include "tensorflow/lite/tools/logging.h"
@@ -370,6 +371,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("enable_op_hardware_counters",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("hardware_counters_output_json_file",
+                          BenchmarkParam::Create<std::string>(""));
 
   default_params.AddParam("print_preinvoke_state",
                           BenchmarkParam::Create<bool>(false));
@@ -452,6 +457,14 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
           "prints to stdout."),
+      CreateFlag<bool>(
+          "enable_op_hardware_counters", &params_,
+          "sample hardware performance counters (cycles, instructions, "
+          "cache and branch misses) per op and delegate partition. Only "
+          "supported on Linux; counts the invoking thread only."),
+      CreateFlag<std::string>(
+          "hardware_counters_output_json_file", &params_,
+          "File path to export per-op hardware counters as JSON."),
       CreateFlag<bool>(
           "print_preinvoke_state", &params_,
           "print out the interpreter internals just before calling Invoke. The "
@@ -518,6 +531,10 @@ void BenchmarkTfLiteModel::LogParams() {
                       verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_op_hardware_counters",
+                      "Enable op hardware counters", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "hardware_counters_output_json_file",
+                      "JSON File to export hardware counters to", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_preinvoke_state",
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
@@ -775,6 +792,7 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   }
 
   AddOwnedListener(MayCreateProfilingListener());
+  AddOwnedListener(MayCreateHardwareCounterListener());
   AddOwnedListener(std::unique_ptr<BenchmarkListener>(
       new InterpreterStatePrinter(interpreter_.get())));
 
@@ -960,6 +978,15 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
           !params_.Get<std::string>("profiling_output_csv_file").empty())));
 }
 
+std::unique_ptr<BenchmarkListener>
+BenchmarkTfLiteModel::MayCreateHardwareCounterListener() const {
+  if (!params_.Get<bool>("enable_op_hardware_counters")) return nullptr;
+
+  return HardwareCounterListener::Create(
+      interpreter_.get(),
+      params_.Get<std::string>("hardware_counters_output_json_file"));
+}
+
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
 
 }  // namespace benchmark
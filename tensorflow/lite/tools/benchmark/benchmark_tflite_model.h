@@ -103,6 +103,10 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   // necessary.
   virtual std::unique_ptr<BenchmarkListener> MayCreateProfilingListener() const;
 
+  // Create a BenchmarkListener that samples hardware performance counters per
+  // op if requested and supported on the platform.
+  std::unique_ptr<BenchmarkListener> MayCreateHardwareCounterListener() const;
+
   void CleanUp();
 
   utils::InputTensorData LoadInputTensorData(
@@ -0,0 +1,79 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/hardware_counter_listener.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+
+std::unique_ptr<HardwareCounterListener> HardwareCounterListener::Create(
+    Interpreter* interpreter, const std::string& json_file_path) {
+  TFLITE_TOOLS_CHECK(interpreter);
+  auto profiler = profiling::HardwareCounterProfiler::Create();
+  if (profiler == nullptr) {
+    TFLITE_LOG(WARN) << "Hardware performance counters are not available on "
+                        "this platform, or access is restricted by "
+                        "/proc/sys/kernel/perf_event_paranoid.";
+    return nullptr;
+  }
+  return std::unique_ptr<HardwareCounterListener>(new HardwareCounterListener(
+      interpreter, json_file_path, std::move(profiler)));
+}
+
+HardwareCounterListener::HardwareCounterListener(
+    Interpreter* interpreter, const std::string& json_file_path,
+    std::unique_ptr<profiling::HardwareCounterProfiler> profiler)
+    : interpreter_(interpreter),
+      json_file_path_(json_file_path),
+      profiler_(std::move(profiler)) {
+  interpreter_->AddProfiler(profiler_.get());
+}
+
+void HardwareCounterListener::OnSingleRunStart(RunType run_type) {
+  if (run_type == REGULAR) {
+    profiler_->Reset();
+    profiler_->StartProfiling();
+  }
+}
+
+void HardwareCounterListener::OnSingleRunEnd() {
+  profiler_->StopProfiling();
+  summarizer_.ProcessProfiles(profiler_->events(), *interpreter_);
+  profiler_->Reset();
+}
+
+void HardwareCounterListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  if (!summarizer_.HasProfiles()) return;
+  TFLITE_LOG(INFO) << "Operator-wise Hardware Counters for Regular Benchmark "
+                      "Runs:";
+  TFLITE_LOG(INFO) << summarizer_.GetOutputString();
+  if (json_file_path_.empty()) return;
+  std::ofstream output_file(json_file_path_);
+  if (!output_file.good()) {
+    TFLITE_LOG(ERROR) << "Failed to open " << json_file_path_;
+    return;
+  }
+  output_file << summarizer_.GetJsonString() << std::endl;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,59 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_HARDWARE_COUNTER_LISTENER_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_HARDWARE_COUNTER_LISTENER_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/lite/profiling/hardware_counter_profiler.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_model.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Samples hardware performance counters around every op and delegate
+// partition during the regular benchmark runs, and dumps per-op averages at
+// the end of the benchmark. The profiler is added next to any other profiler
+// installed on `interpreter`, so it can be used together with
+// ProfilingListener.
+class HardwareCounterListener : public BenchmarkListener {
+ public:
+  // Returns nullptr (after logging why) if counters aren't available.
+  static std::unique_ptr<HardwareCounterListener> Create(
+      Interpreter* interpreter, const std::string& json_file_path = "");
+
+  void OnSingleRunStart(RunType run_type) override;
+
+  void OnSingleRunEnd() override;
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+ private:
+  HardwareCounterListener(
+      Interpreter* interpreter, const std::string& json_file_path,
+      std::unique_ptr<profiling::HardwareCounterProfiler> profiler);
+
+  Interpreter* interpreter_;
+  std::string json_file_path_;
+  std::unique_ptr<profiling::HardwareCounterProfiler> profiler_;
+  profiling::HardwareCounterSummarizer summarizer_;
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_HARDWARE_COUNTER_LISTENER_H_
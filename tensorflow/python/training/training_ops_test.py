@@ -506,6 +506,139 @@ class TrainingOpsTest(TensorFlowTestCase):
     thread1.join()
     thread2.join()
 
+  @test_util.run_v2_only
+  def testResourceSparseApplyAdagradDuplicateIndices(self):
+    for dtype, use_locking in itertools.product([np.float32, np.float64],
+                                                [False, True]):
+      x = np.arange(60).reshape([6, 10]).astype(dtype)
+      y = np.ones([6, 10]).astype(dtype)
+      lr = np.array(0.5).astype(dtype)
+      grad = (np.arange(50).reshape([5, 10]) / 10).astype(dtype)
+      indices = np.array([3, 1, 3, 3, 0]).astype(np.int32)
+      var = variables.Variable(x)
+      accum = variables.Variable(y)
+      self.evaluate(
+          gen_training_ops.resource_sparse_apply_adagrad(
+              var.handle,
+              accum.handle,
+              lr,
+              grad,
+              indices,
+              use_locking=use_locking))
+
+      # Updates of the same row are applied one after another.
+      for i, index in enumerate(indices):
+        y[index] += grad[i] * grad[i]
+        x[index] -= lr * grad[i] / np.sqrt(y[index])
+      self.assertAllCloseAccordingToType(x, self.evaluate(var))
+      self.assertAllCloseAccordingToType(y, self.evaluate(accum))
+
+  @test_util.run_v2_only
+  def testResourceSparseApplyFtrlV2DuplicateIndices(self):
+    for dtype, lr_power, multiply_linear_by_lr in itertools.product(
+        [np.float32, np.float64], [-0.5, -0.25], [False, True]):
+      x = (np.arange(60).reshape([6, 10]) / 60).astype(dtype)
+      y = np.full([6, 10], 0.1).astype(dtype)
+      z = (np.arange(60).reshape([6, 10]) / -30).astype(dtype)
+      lr = np.array(0.5).astype(dtype)
+      l1 = np.array(0.1).astype(dtype)
+      l2 = np.array(0.2).astype(dtype)
+      l2_shrinkage = np.array(0.05).astype(dtype)
+      grad = (np.arange(50).reshape([5, 10]) / -10).astype(dtype)
+      indices = np.array([3, 1, 3, 3, 0]).astype(np.int64)
+      var = variables.Variable(x)
+      accum = variables.Variable(y)
+      linear = variables.Variable(z)
+      self.evaluate(
+          gen_training_ops.resource_sparse_apply_ftrl_v2(
+              var.handle,
+              accum.handle,
+              linear.handle,
+              grad,
+              indices,
+              lr,
+              l1,
+              l2,
+              l2_shrinkage,
+              np.array(lr_power).astype(dtype),
+              multiply_linear_by_lr=multiply_linear_by_lr))
+
+      # Updates of the same row are applied one after another.
+      scale = lr if multiply_linear_by_lr else 1
+      for i, index in enumerate(indices):
+        g = grad[i] + 2 * l2_shrinkage * x[index]
+        new_y = y[index] + grad[i] * grad[i]
+        sigma = new_y**-lr_power - y[index]**-lr_power
+        z[index] += g * scale - sigma / lr * scale * x[index]
+        quadratic = (new_y**-lr_power / lr + 2 * l2) * scale
+        x[index] = (np.clip(z[index], -l1 * scale, l1 * scale) -
+                    z[index]) / quadratic
+        y[index] = new_y
+      self.assertAllCloseAccordingToType(x, self.evaluate(var))
+      self.assertAllCloseAccordingToType(y, self.evaluate(accum))
+      self.assertAllCloseAccordingToType(z, self.evaluate(linear))
+
+  def _testResourceSparseApplyAdagradConcurrentLockedUpdates(
+      self, use_row_locking):
+    dtype = np.float32
+    num_threads = 4
+    num_iter = 100
+    x = np.zeros([64, 8]).astype(dtype)
+    y = np.ones([64, 8]).astype(dtype)
+    lr = np.array(0.01).astype(dtype)
+    grad = np.ones([32, 8]).astype(dtype)
+    var = variables.Variable(x)
+    accum = variables.Variable(y)
+
+    @def_function.function
+    def fn_resource_sparse_apply_adagrad(indices):
+      ret = constant_op.constant(0, dtypes.int32)
+      for i in math_ops.range(num_iter):
+        adagrad_op = gen_training_ops.resource_sparse_apply_adagrad(
+            var.handle,
+            accum.handle,
+            lr,
+            grad,
+            indices,
+            use_locking=True,
+            use_row_locking=use_row_locking)
+        with ops.control_dependencies([adagrad_op]):
+          ret += i
+      return ret
+
+    # Threads update overlapping rows with the same gradient, so that the
+    # result only depends on how many updates every row received.
+    all_indices = [
+        np.arange(16 * t, 16 * t + 32).astype(np.int32) % 64
+        for t in range(num_threads)
+    ]
+    threads = [
+        threading.Thread(
+            target=lambda i=indices: self.evaluate(
+                fn_resource_sparse_apply_adagrad(i)))
+        for indices in all_indices
+    ]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+
+    # Every row is updated 2 * num_iter times.
+    for _ in range(2 * num_iter):
+      y += 1
+      x -= lr / np.sqrt(y)
+    self.assertAllClose(y, self.evaluate(accum))
+    self.assertAllClose(x, self.evaluate(var), rtol=1e-4)
+
+  @test_util.run_v2_only
+  def testResourceSparseApplyAdagradConcurrentLockedUpdates(self):
+    self._testResourceSparseApplyAdagradConcurrentLockedUpdates(
+        use_row_locking=False)
+
+  @test_util.run_v2_only
+  def testResourceSparseApplyAdagradConcurrentRowLockedUpdates(self):
+    self._testResourceSparseApplyAdagradConcurrentLockedUpdates(
+        use_row_locking=True)
 
 if __name__ == '__main__':
   googletest.main()